@@ -10,28 +10,91 @@
 namespace Xmaxplatform {
 namespace Chain {
 
-	void block_raw::add_confirmation(const block_confirmation& conf, uint32_t skip)
+	bool block_raw::add_confirmation(const block_confirmation& conf, uint32_t skip)
 	{
+		const int index = confirmation_index(conf);
+		if (confirmed_builders.test(index))
+			return false;
+
+		public_key_type signer;
 		if (NO_BIT_FLAG(skip, Config::skip_confirmation))
-		{
-			for (const auto& item : confirmations)
-			{
-				//FC_ASSERT(item.verifier != conf.verifier, "confirmation had exist.");
-				return;
-			}
+			signer = public_key_type(conf.get_signer_key());
 
-			auto key = current_builders.get_sign_key(conf.verifier);
+		return add_confirmation(conf, signer, skip);
+	}
 
-			XMAX_ASSERT(conf.is_signer_valid(key), confirmation_validate_exception, "confirmation fail.");
+	bool block_raw::add_confirmation(const block_confirmation& conf, const public_key_type& signer, uint32_t skip)
+	{
+		const int index = confirmation_index(conf);
+		if (confirmed_builders.test(index))
+			return false;
+
+		if (NO_BIT_FLAG(skip, Config::skip_confirmation))
+		{
+			XMAX_ASSERT(current_builders.builders[index].block_signing_key == signer, confirmation_validate_exception, "confirmation fail.");
 		}
 
+		confirmed_builders.set(index);
 		confirmations.emplace_back(conf);
+		return true;
+	}
+
+	uint32_t block_raw::required_confirmations() const
+	{
+		return current_builders.number() * 2 / 3;
 	}
 
 	bool block_raw::enough_confirmation() const
 	{
-		int minconf = current_builders.number() * 2 / 3;
-		return confirmations.size() >= minconf;
+		// one confirmation per builder, the count is the number of builders confirmed.
+		return confirmations.size() >= required_confirmations();
+	}
+
+	int block_raw::confirmation_index(const block_confirmation& conf)
+	{
+		sync_confirmed_builders();
+
+		const int index = current_builders.index_of(conf.verifier);
+		XMAX_ASSERT(index >= 0, confirmation_validate_exception, "${verifier} is not a builder of block ${id}", ("verifier", conf.verifier)("id", block_id));
+		return index;
+	}
+
+	void block_raw::sync_confirmed_builders()
+	{
+		if (confirmed_builders.size() == current_builders.builders.size())
+			return;
+
+		confirmed_builders.clear();
+		confirmed_builders.resize(current_builders.builders.size());
+
+		vector<block_confirmation> unique;
+		for (const auto& conf : confirmations)
+		{
+			const int index = current_builders.index_of(conf.verifier);
+			if (index >= 0 && !confirmed_builders.test(index))
+			{
+				confirmed_builders.set(index);
+				unique.push_back(conf);
+			}
+		}
+		confirmations = std::move(unique);
+	}
+
+	bool block_pack::has_validated_cache() const
+	{
+		return validated && block && transactions.size() == block->receipts.size();
+	}
+
+	vector<transaction_request_ptr> block_pack::make_requests(const signed_block& b)
+	{
+		vector<transaction_request_ptr> requests;
+		requests.reserve(b.receipts.size());
+		for (const auto& trx : b.receipts)
+		{
+			XMAX_ASSERT(trx.trx.contains<transaction_package>(), block_validate_exception, "encountered unexpected package type.");
+			requests.push_back(std::make_shared<transaction_request>(trx.trx.get<transaction_package>()));
+		}
+		return requests;
 	}
 
 	void block_pack::init_default(chain_timestamp time, const builder_info& builder, const builder_rule& cur_blders)
@@ -0,0 +1,490 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#include <chain_snapshot.hpp>
+#include <authoritys.hpp>
+#include <builder_rule.hpp>
+
+#include <objects/account_object.hpp>
+#include <objects/code_object.hpp>
+#include <objects/authority_object.hpp>
+#include <objects/linked_permission_object.hpp>
+#include <objects/key_value_object.hpp>
+#include <objects/transaction_object.hpp>
+#include <objects/block_summary_object.hpp>
+#include <objects/static_config_object.hpp>
+#include <objects/dynamic_states_object.hpp>
+#include <objects/xmx_token_object.hpp>
+#include <objects/vote_objects.hpp>
+#include <objects/builder_object.hpp>
+#include <objects/resource_token_object.hpp>
+#include <objects/global_status_objects.hpp>
+#include <objects/erc20_token_object.hpp>
+#include <objects/erc20_token_account_object.hpp>
+#include <objects/erc721_token_object.hpp>
+#include <objects/erc721_token_account_object.hpp>
+#include <objects/xmx_cash_object.hpp>
+#include <objects/linked_cash_object.hpp>
+
+namespace Xmaxplatform { namespace Chain {
+
+	namespace snapshot_detail
+	{
+		static const size_t buffer_size = 1024 * 1024;
+
+		// fc::raw can not build the members that live in the shared memory segment,
+		// they are written here and everything else goes to fc::raw.
+		template<typename Stream, typename T> void write(Stream& s, const T& v);
+		template<typename Stream, typename T> void write(Stream& s, const Basechain::oid<T>& v);
+		template<typename Stream> void write(Stream& s, const mapped_string& v);
+		template<typename Stream, typename T> void write(Stream& s, const mapped_vector<T>& v);
+		template<typename Stream> void write(Stream& s, const mapped_vector<char>& v);
+		template<typename Stream> void write(Stream& s, const mapped_authoritys& v);
+		template<typename Stream> void write(Stream& s, const mapped_builder_rule& v);
+
+		template<typename Stream, typename T> void read(Stream& s, T& v);
+		template<typename Stream, typename T> void read(Stream& s, Basechain::oid<T>& v);
+		template<typename Stream> void read(Stream& s, mapped_string& v);
+		template<typename Stream, typename T> void read(Stream& s, mapped_vector<T>& v);
+		template<typename Stream> void read(Stream& s, mapped_vector<char>& v);
+		template<typename Stream> void read(Stream& s, mapped_authoritys& v);
+		template<typename Stream> void read(Stream& s, mapped_builder_rule& v);
+
+		template<typename Stream, typename Class>
+		struct write_visitor
+		{
+			write_visitor(Stream& _s, const Class& _c)
+				: s(_s), c(_c) {}
+
+			template<typename T, typename C, T(C::*p)>
+			void operator()(const char*) const
+			{
+				snapshot_detail::write(s, c.*p);
+			}
+
+			Stream& s;
+			const Class& c;
+		};
+
+		template<typename Stream, typename Class>
+		struct read_visitor
+		{
+			read_visitor(Stream& _s, Class& _c)
+				: s(_s), c(_c) {}
+
+			template<typename T, typename C, T(C::*p)>
+			void operator()(const char*) const
+			{
+				snapshot_detail::read(s, c.*p);
+			}
+
+			Stream& s;
+			Class& c;
+		};
+
+		template<typename Stream, typename T>
+		void write_reflected(Stream& s, const T& v)
+		{
+			fc::reflector<T>::visit(write_visitor<Stream, T>(s, v));
+		}
+
+		template<typename Stream, typename T>
+		void read_reflected(Stream& s, T& v)
+		{
+			fc::reflector<T>::visit(read_visitor<Stream, T>(s, v));
+		}
+
+		template<typename Stream, typename T>
+		void write(Stream& s, const T& v)
+		{
+			fc::raw::pack(s, v);
+		}
+
+		template<typename Stream, typename T>
+		void write(Stream& s, const Basechain::oid<T>& v)
+		{
+			fc::raw::pack(s, v._id);
+		}
+
+		template<typename Stream>
+		void write(Stream& s, const mapped_string& v)
+		{
+			fc::raw::pack(s, unsigned_int((uint32_t)v.size()));
+			if (v.size())
+				s.write(v.data(), v.size());
+		}
+
+		template<typename Stream, typename T>
+		void write(Stream& s, const mapped_vector<T>& v)
+		{
+			fc::raw::pack(s, unsigned_int((uint32_t)v.size()));
+			for (const T& item : v)
+				snapshot_detail::write(s, item);
+		}
+
+		template<typename Stream>
+		void write(Stream& s, const mapped_vector<char>& v)
+		{
+			fc::raw::pack(s, unsigned_int((uint32_t)v.size()));
+			if (v.size())
+				s.write(v.data(), v.size());
+		}
+
+		template<typename Stream>
+		void write(Stream& s, const mapped_authoritys& v)
+		{
+			write_reflected(s, v);
+		}
+
+		template<typename Stream>
+		void write(Stream& s, const mapped_builder_rule& v)
+		{
+			write_reflected(s, v);
+		}
+
+		template<typename Stream, typename T>
+		void read(Stream& s, T& v)
+		{
+			fc::raw::unpack(s, v);
+		}
+
+		template<typename Stream, typename T>
+		void read(Stream& s, Basechain::oid<T>& v)
+		{
+			fc::raw::unpack(s, v._id);
+		}
+
+		template<typename Stream>
+		void read(Stream& s, mapped_string& v)
+		{
+			unsigned_int size;
+			fc::raw::unpack(s, size);
+			v.resize(size.value);
+			if (size.value)
+				s.read(&v[0], size.value);
+		}
+
+		template<typename Stream, typename T>
+		void read(Stream& s, mapped_vector<T>& v)
+		{
+			unsigned_int size;
+			fc::raw::unpack(s, size);
+			v.clear();
+			v.reserve(size.value);
+			for (uint32_t i = 0; i < size.value; ++i)
+			{
+				T item;
+				snapshot_detail::read(s, item);
+				v.push_back(std::move(item));
+			}
+		}
+
+		template<typename Stream>
+		void read(Stream& s, mapped_vector<char>& v)
+		{
+			unsigned_int size;
+			fc::raw::unpack(s, size);
+			v.resize(size.value);
+			if (size.value)
+				s.read(v.data(), size.value);
+		}
+
+		template<typename Stream>
+		void read(Stream& s, mapped_authoritys& v)
+		{
+			read_reflected(s, v);
+		}
+
+		template<typename Stream>
+		void read(Stream& s, mapped_builder_rule& v)
+		{
+			read_reflected(s, v);
+		}
+
+		// objects go out in id order, so the import appends each one at the end of the primary index.
+		// the index is written as it was at revision, later changes are taken back from its undo history.
+		template<typename MultiIndexType>
+		void write_index(snapshot_ostream& s, const Basechain::database& db, int64_t revision)
+		{
+			typedef typename MultiIndexType::value_type value_type;
+			const auto& index = db.get_index<MultiIndexType>();
+
+			snapshot_section section;
+			section.type_id = value_type::type_id;
+			section.next_id = index.next_id_at(revision)._id;
+			index.walk_revision(revision, [&](const value_type&) { ++section.count; });
+			fc::raw::pack(s, section);
+
+			index.walk_revision(revision, [&](const value_type& obj) {
+				fc::raw::pack(s, obj.id._id);
+				write_reflected(s, obj);
+			});
+		}
+
+		template<typename MultiIndexType>
+		void read_index(snapshot_istream& s, Basechain::database& db, const snapshot_section& section)
+		{
+			typedef typename MultiIndexType::value_type value_type;
+			auto& index = db.get_mutable_index<MultiIndexType>();
+
+			FC_ASSERT(index.indices().empty(), "index ${type} is not empty", ("type", section.type_id));
+
+			for (uint64_t i = 0; i < section.count; ++i)
+			{
+				int64_t id = 0;
+				fc::raw::unpack(s, id);
+				index.load(id, [&](value_type& obj) {
+					read_reflected(s, obj);
+				});
+			}
+			index.set_next_id(section.next_id);
+		}
+
+		// version 1 kept the contract inside the account, as an optional (code_version)(code)(abi).
+		// each contract becomes a shared code_object while the accounts are loaded.
+		void read_v1_accounts(snapshot_istream& s, Basechain::database& db, const snapshot_section& section)
+		{
+			auto& index = db.get_mutable_index<account_index>();
+			FC_ASSERT(index.indices().empty(), "index ${type} is not empty", ("type", section.type_id));
+
+			for (uint64_t i = 0; i < section.count; ++i)
+			{
+				int64_t id = 0;
+				fc::raw::unpack(s, id);
+
+				fc::sha256 code_hash;
+				std::vector<char> code;
+				std::vector<char> abi;
+				index.load(id, [&](account_object& obj) {
+					fc::raw::unpack(s, obj.name);
+					fc::raw::unpack(s, obj.type);
+					fc::raw::unpack(s, obj.creation_date);
+
+					bool has_contract = false;
+					fc::raw::unpack(s, has_contract);
+					if (has_contract)
+					{
+						fc::sha256 code_version;
+						fc::raw::unpack(s, code_version);
+						fc::raw::unpack(s, code);
+						fc::raw::unpack(s, abi);
+						code_hash = make_code_hash(code.data(), code.size(), abi.data(), abi.size());
+					}
+					obj.code_hash = code_hash;
+				});
+
+				if (code_hash != fc::sha256())
+				{
+					acquire_code(db, code_hash, code.data(), code.size(), abi.data(), abi.size());
+				}
+			}
+			index.set_next_id(section.next_id);
+		}
+
+		template<typename MultiIndexType>
+		struct index_tag
+		{
+			typedef MultiIndexType type;
+		};
+
+		// every index setup_xmax_indexes registers.
+		template<typename Visitor>
+		void visit_indexes(Visitor&& visitor)
+		{
+			visitor(index_tag<account_index>());
+			visitor(index_tag<code_index>());
+			visitor(index_tag<authority_index>());
+			visitor(index_tag<linked_permission_index>());
+
+			visitor(index_tag<key_value_index>());
+			visitor(index_tag<keystr_value_index>());
+			visitor(index_tag<key128x128_value_index>());
+			visitor(index_tag<key64x64x64_value_index>());
+
+			visitor(index_tag<transaction_multi_index>());
+			visitor(index_tag<block_summary_multi_index>());
+
+			visitor(index_tag<static_config_multi_index>());
+			visitor(index_tag<dynamic_states_multi_index>());
+			visitor(index_tag<xmx_token_multi_index>());
+
+			visitor(index_tag<voter_info_index>());
+			visitor(index_tag<builder_info_index>());
+			visitor(index_tag<builder_multi_index>());
+			visitor(index_tag<resource_token_multi_index>());
+
+			visitor(index_tag<global_trx_status_index>());
+			visitor(index_tag<global_msg_status_index>());
+
+			visitor(index_tag<erc20_token_multi_index>());
+			visitor(index_tag<erc20_token_account_multi_index>());
+			visitor(index_tag<erc721_token_multi_index>());
+			visitor(index_tag<erc721_token_account_multi_index>());
+
+			visitor(index_tag<xmx_cash_index>());
+			visitor(index_tag<linked_cash_index>());
+		}
+	}
+
+	snapshot_ostream::snapshot_ostream(const fc::path& file)
+		: _buffer(snapshot_detail::buffer_size)
+	{
+		_file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+		_file.open(file.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	}
+
+	void snapshot_ostream::write(const char* data, size_t size)
+	{
+		_total += size;
+		if (_buffer.size() - _pos < size)
+		{
+			flush_buffer();
+			if (size >= _buffer.size())
+			{
+				_encoder.write(data, size);
+				_file.write(data, size);
+				return;
+			}
+		}
+		memcpy(_buffer.data() + _pos, data, size);
+		_pos += size;
+	}
+
+	void snapshot_ostream::flush_buffer()
+	{
+		if (_pos == 0)
+			return;
+		_encoder.write(_buffer.data(), _pos);
+		_file.write(_buffer.data(), _pos);
+		_pos = 0;
+	}
+
+	fc::sha256 snapshot_ostream::finish()
+	{
+		flush_buffer();
+		fc::sha256 checksum = _encoder.result();
+		_file.write(checksum.data(), checksum.data_size());
+		_file.close();
+		return checksum;
+	}
+
+	snapshot_istream::snapshot_istream(const fc::path& file)
+		: _buffer(snapshot_detail::buffer_size)
+	{
+		uint64_t file_size = fc::file_size(file);
+		FC_ASSERT(file_size >= sizeof(fc::sha256), "snapshot ${file} is truncated", ("file", file.generic_string()));
+		_body_size = file_size - sizeof(fc::sha256);
+
+		_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+		_file.open(file.generic_string().c_str(), std::ios::in | std::ios::binary);
+	}
+
+	void snapshot_istream::read(char* data, size_t size)
+	{
+		FC_ASSERT(_total + size <= _body_size, "snapshot is truncated");
+		_total += size;
+		while (size > 0)
+		{
+			if (_pos == _end)
+				fill_buffer();
+
+			size_t n = std::min(size, _end - _pos);
+			memcpy(data, _buffer.data() + _pos, n);
+			_pos += n;
+			data += n;
+			size -= n;
+		}
+	}
+
+	void snapshot_istream::fill_buffer()
+	{
+		// the trailing checksum stays in the file for finish.
+		uint64_t left = _body_size - (uint64_t)_file.tellg();
+		size_t n = (size_t)std::min<uint64_t>(_buffer.size(), left);
+		_file.read(_buffer.data(), n);
+		_encoder.write(_buffer.data(), n);
+		_pos = 0;
+		_end = n;
+	}
+
+	void snapshot_istream::finish()
+	{
+		FC_ASSERT(_total == _body_size, "snapshot has ${n} bytes after the last section", ("n", _body_size - _total));
+
+		fc::sha256 expected;
+		_file.seekg(_body_size);
+		_file.read(expected.data(), expected.data_size());
+		FC_ASSERT(_encoder.result() == expected, "snapshot checksum mismatch");
+	}
+
+	uint64_t write_snapshot(const fc::path& file, const Basechain::database& db, const snapshot_header& header, const block_pack& root)
+	{
+		snapshot_header head = header;
+		head.index_count = 0;
+		snapshot_detail::visit_indexes([&](auto) { ++head.index_count; });
+
+		FC_ASSERT(head.index_count == db.index_count(),
+			"database has ${n} indices, snapshot knows ${m}", ("n", db.index_count())("m", head.index_count));
+
+		snapshot_ostream s(file);
+		fc::raw::pack(s, head);
+		fc::raw::pack(s, root);
+
+		snapshot_detail::visit_indexes([&](auto index) {
+			snapshot_detail::write_index<typename decltype(index)::type>(s, db, head.block_num);
+		});
+
+		fc::raw::pack(s, snapshot_section());
+		s.finish();
+		return s.tellp() + sizeof(fc::sha256);
+	}
+
+	snapshot_header read_snapshot(const fc::path& file, Basechain::database& db, block_pack& root)
+	{
+		snapshot_istream s(file);
+
+		snapshot_header head;
+		fc::raw::unpack(s, head.magic);
+		FC_ASSERT(head.magic == snapshot_magic, "${file} is not a snapshot", ("file", file.generic_string()));
+		fc::raw::unpack(s, head.version);
+		FC_ASSERT(head.version >= 1 && head.version <= snapshot_version, "unsupported snapshot version ${v}", ("v", head.version));
+		fc::raw::unpack(s, head.chain_id);
+		fc::raw::unpack(s, head.block_num);
+		fc::raw::unpack(s, head.block_id);
+		fc::raw::unpack(s, head.index_count);
+
+		fc::raw::unpack(s, root);
+
+		uint32_t loaded = 0;
+		snapshot_section section;
+		fc::raw::unpack(s, section);
+		while (section.type_id != snapshot_end_type)
+		{
+			bool known = false;
+			if (head.version == 1 && section.type_id == account_object::type_id)
+			{
+				snapshot_detail::read_v1_accounts(s, db, section);
+				known = true;
+			}
+			snapshot_detail::visit_indexes([&](auto index) {
+				typedef typename decltype(index)::type index_type;
+				if (!known && index_type::value_type::type_id == section.type_id)
+				{
+					snapshot_detail::read_index<index_type>(s, db, section);
+					known = true;
+				}
+			});
+			FC_ASSERT(known, "snapshot has unknown index ${type}", ("type", section.type_id));
+
+			++loaded;
+			fc::raw::unpack(s, section);
+		}
+		FC_ASSERT(loaded == head.index_count, "snapshot lists ${n} indices, holds ${m}", ("n", head.index_count)("m", loaded));
+
+		s.finish();
+		return head;
+	}
+
+}
+}
@@ -3,7 +3,17 @@
 *  @copyright defined in xmax/LICENSE
 */
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <fc/io/raw.hpp>
+#include <fc/compress/zlib.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <chain_utils.hpp>
 #include <chain_stream.hpp>
 
 #define LOG_READ  (std::ios::in | std::ios::binary)
@@ -13,6 +23,8 @@
 
 namespace block_detail
 {
+	namespace bip = boost::interprocess;
+
 	enum IO_Code
 	{
 		IO_Read,
@@ -48,104 +60,363 @@ namespace block_detail
 		stream_seek(stream, 0, std::ios::end, code);
 	}
 
-	static void to_last_block_desc(std::fstream& stream, IO_Code code)
+	static void read_eof(std::fstream& stream, block_end_eof_type& eof)
 	{
-		stream_seek(stream, -sizeof(block_end_eof_type) - sizeof(block_desc), std::ios::end, code);
+		stream.read((char*)&eof, sizeof(block_end_eof_type));
 	}
 
-	static void to_last_block_index(std::fstream& stream, IO_Code code)
+	static void read_block_desc(std::fstream& stream, block_desc& val)
 	{
-		stream_seek(stream, -sizeof(block_index), std::ios::end, code);
+		stream.read((char*)&val, sizeof(block_desc));
+
 	}
-	static void to_end_eof(std::fstream& stream, IO_Code code)
+
+
+	static void read_block_index(std::fstream& stream, block_index& val)
+	{
+		stream.read((char*)&val, sizeof(block_index));
+	}
+	static void write_block_index(std::fstream& stream, const block_index& val)
 	{
-		stream_seek(stream, -sizeof(block_end_eof_type), std::ios::end, code);
+		stream.write((char*)&val, sizeof(block_index));
 	}
 
-	static void read_eof(std::fstream& stream, block_end_eof_type& eof)
+	static fc::path segment_file(const fc::path& log_dir, uint64_t segment)
 	{
-		stream.read((char*)&eof, sizeof(block_end_eof_type));
+		return log_dir / ("blocks_" + std::to_string(segment) + ".log");
 	}
-	static void write_eof(std::fstream& stream)
+
+	// a block packed for the log, built before the writer lock is taken.
+	struct encoded_block
+	{
+		signed_block_ptr	block;
+		std::vector<char>	data;
+		uint32_t			codec = codec_raw;
+		uint32_t			raw_size = 0;
+	};
+
+	static encoded_block encode_block(const signed_block_ptr& blockptr, bool compress)
 	{
-		stream.write((char*)&block_end_eof, sizeof(block_end_eof_type));
+		encoded_block encoded;
+		encoded.block = blockptr;
+		encoded.data = fc::raw::pack(*blockptr);
+		encoded.raw_size = encoded.data.size();
+
+		if (compress)
+		{
+			// inflating costs ~10us per block whatever its size, only keep it when it saves a quarter.
+			std::vector<char> packed = fc::zlib_compress(encoded.data.data(), encoded.data.size(), 1);
+			if (!packed.empty() && packed.size() * 4 <= encoded.data.size() * 3)
+			{
+				encoded.data = std::move(packed);
+				encoded.codec = codec_zlib;
+			}
+		}
+		return encoded;
 	}
 
-	static void read_block_desc(std::fstream& stream, block_desc& val)
+	static void decode_block(const char* data, uint64_t size, uint32_t codec, uint32_t raw_size, signed_block& block)
 	{
-		stream.read((char*)&val, sizeof(block_desc));
+		if (codec == codec_raw)
+		{
+			fc::datastream<const char*> ds(data, size);
+			fc::raw::unpack(ds, block);
+			return;
+		}
+
+		FC_ASSERT(codec == codec_zlib, "Unknown block codec ${codec}", ("codec", codec));
 
+		// readers decode on many threads, keep one buffer per thread.
+		thread_local std::vector<char> buffer;
+		buffer.resize(raw_size);
+		FC_ASSERT(fc::zlib_decompress(data, size, buffer.data(), raw_size), "Broken compressed block");
+
+		fc::datastream<const char*> ds(buffer.data(), raw_size);
+		fc::raw::unpack(ds, block);
 	}
 
-	static void write_block_desc(std::fstream& stream, const block_desc& val)
+	struct write_chunk
 	{
-		stream.write((char*)&val, sizeof(block_desc));
+		uint64_t			segment = 0;
+		std::vector<char>	data;
+	};
+
+	// in-memory tail of the log, appended blocks wait here until the next group commit.
+	struct write_tail
+	{
+		std::vector<write_chunk>		chunks;
+		std::vector<char>				index_data;
+		std::vector<signed_block_ptr>	blocks;
+		uint64_t						data_size = 0;
+
+		bool empty() const
+		{
+			return blocks.empty();
+		}
+
+		void clear()
+		{
+			chunks.clear();
+			index_data.clear();
+			blocks.clear();
+			data_size = 0;
+		}
+	};
+
+	template<typename T>
+	static void append_raw(std::vector<char>& buffer, const T& val)
+	{
+		const char* data = (const char*)&val;
+		buffer.insert(buffer.end(), data, data + sizeof(T));
 	}
 
-	static void read_block_index(std::fstream& stream, block_index& val)
+	static uint64_t block_record_end(const block_index& index)
 	{
-		stream.read((char*)&val, sizeof(block_index));
+		return index.pos + sizeof(block_desc) + index.size + sizeof(block_end_eof_type);
 	}
-	static void read_block_indices(std::fstream& stream, block_index val[], int64_t count)
+
+	// serialize [desc][block][eof] at pos of segment and its index entry into the tail.
+	static block_index write_block(write_tail& tail, uint64_t segment, uint64_t pos, const encoded_block& encoded)
 	{
-		stream.read((char*)val, sizeof(block_index) * count);
+		block_desc desc;
+		desc.num = encoded.block->block_num();
+		desc.pos = pos;
+		desc.size = encoded.data.size();
+		desc.codec = encoded.codec;
+		desc.raw_size = encoded.raw_size;
+
+		block_index index;
+		index.pos = pos;
+		index.num = desc.num;
+		index.size = desc.size;
+		index.id = encoded.block->id();
+		index.codec = desc.codec;
+		index.raw_size = desc.raw_size;
+
+		if (tail.chunks.empty() || tail.chunks.back().segment != segment)
+		{
+			tail.chunks.emplace_back();
+			tail.chunks.back().segment = segment;
+		}
+
+		std::vector<char>& data = tail.chunks.back().data;
+		append_raw(data, desc);
+		data.insert(data.end(), encoded.data.begin(), encoded.data.end());
+		append_raw(data, block_end_eof);
+
+		append_raw(tail.index_data, index);
+		tail.blocks.push_back(encoded.block);
+		tail.data_size += block_record_end(index) - index.pos;
+
+		return index;
 	}
 
-	static void write_block_index(std::fstream& stream, const block_index& val)
+	// check that the record of an index entry fully reached its segment.
+	static bool check_block_record(std::fstream& stream, const block_index& index, uint64_t end)
 	{
-		stream.write((char*)&val, sizeof(block_index));
+		try
+		{
+			if (block_record_end(index) > end)
+				return false;
+
+			block_desc desc;
+			block_end_eof_type eof;
+
+			stream_seek(stream, index.pos, IO_Read);
+			read_block_desc(stream, desc);
+			stream_seek(stream, index.pos + sizeof(block_desc) + index.size, IO_Read);
+			read_eof(stream, eof);
+
+			return eof == block_end_eof && desc.pos == index.pos && desc.size == index.size && desc.num == index.num
+				&& desc.codec == index.codec && desc.raw_size == index.raw_size;
+		}
+		catch (...)
+		{
+			stream.clear();
+		}
+		return false;
 	}
 
-	static uint64_t write_block(std::fstream& block_stream, std::fstream& index_stream, const signed_block_ptr& blockptr)
+	// parse one [desc][block][eof] record at pos, return false if the record is torn or broken.
+	static bool scan_block(std::fstream& stream, uint64_t pos, uint64_t end, block_index& index)
 	{
-		auto data = fc::raw::pack(*blockptr);
-		xmax_type_block_num num = blockptr->block_num();
-		xmax_type_block_id id = blockptr->id();
+		try
+		{
+			if (pos + sizeof(block_desc) > end)
+				return false;
 
-		block_detail::stream_end(block_stream, IO_Write);
-		block_detail::stream_end(index_stream, IO_Write);
+			block_desc desc;
+			stream_seek(stream, pos, IO_Read);
+			read_block_desc(stream, desc);
 
-		uint64_t pos = block_stream.tellp();
-		uint64_t idx_pos = index_stream.tellp();
+			index.num = desc.num;
+			index.pos = desc.pos;
+			index.size = desc.size;
+			index.codec = desc.codec;
+			index.raw_size = desc.raw_size;
 
-		block_desc desc;
-		desc.num = num;
-		desc.pos = pos;
-		desc.size = data.size();
+			if (desc.pos != pos || block_record_end(index) > end)
+				return false;
 
-		block_index index;
-		index.pos = pos;
-		index.num = num;
-		index.size = data.size();
-		index.id = id;
+			std::vector<char> data(desc.size);
+			block_end_eof_type eof;
+			stream.read(data.data(), data.size());
+			read_eof(stream, eof);
 
-		FC_ASSERT(idx_pos == sizeof(block_index) * (desc.num - 1),
-			"Append to index file occuring at wrong position.",
-			("position", idx_pos)
-			("expected", (desc.num - 1) * sizeof(uint64_t)));
+			if (eof != block_end_eof)
+				return false;
 
+			signed_block block;
+			decode_block(data.data(), data.size(), desc.codec, desc.raw_size, block);
+			if (desc.num != block.block_num())
+				return false;
 
-		block_stream.seekp(desc.pos);
+			index.id = block.id();
+			return true;
+		}
+		catch (...)
+		{
+			stream.clear();
+		}
+		return false;
+	}
 
-		block_stream.write(data.data(), data.size());
-		write_block_desc(block_stream, desc);
-		block_stream.flush();
-		write_eof(block_stream);
-		block_stream.flush();
+	// parse one record of the single file blocks.log, [block][desc][eof].
+	static bool scan_legacy_block(std::fstream& stream, uint64_t pos, uint64_t end, signed_block& block, uint64_t& next)
+	{
+		try
+		{
+			stream_seek(stream, pos, IO_Read);
+			fc::raw::unpack(stream, block);
 
-		write_block_index(index_stream, index);
-		index_stream.flush();
+			uint64_t desc_pos = stream.tellg();
+			if (desc_pos + sizeof(block_desc) + sizeof(block_end_eof_type) > end)
+				return false;
 
-		return pos;
+			block_desc desc;
+			block_end_eof_type eof;
+			read_block_desc(stream, desc);
+			read_eof(stream, eof);
+
+			if (eof != block_end_eof || desc.pos != pos || desc.size != desc_pos - pos || desc.num != block.block_num())
+				return false;
+
+			next = desc_pos + sizeof(block_desc) + sizeof(block_end_eof_type);
+			return true;
+		}
+		catch (...)
+		{
+			stream.clear();
+		}
+		return false;
 	}
 
-	static signed_block_ptr read_block(std::fstream& stream, uint64_t pos)
+	struct mapped_segment
+	{
+		bip::file_mapping		mapping;
+		mutable bip::mapped_region	region;	// mutable for advise, a paging hint leaves the mapping as it is.
+		uint64_t				size = 0;
+	};
+
+	using mapped_segment_ptr = std::shared_ptr<const mapped_segment>;
+
+	static mapped_segment_ptr map_segment(const fc::path& file, uint64_t size)
+	{
+		auto segment = std::make_shared<mapped_segment>();
+		segment->mapping = bip::file_mapping(file.generic_string().c_str(), bip::read_only);
+		segment->region = bip::mapped_region(segment->mapping, bip::read_only, 0, size);
+		segment->size = size;
+		return segment;
+	}
+
+	struct mapped_log
+	{
+		bip::file_mapping				index_mapping;
+		bip::mapped_region				index_region;
+		uint64_t						block_count = 0;
+		uint64_t						segment_blocks = 1;
+		uint64_t						first_segment = 0;
+		uint64_t						base_block = 0;
+		std::vector<mapped_segment_ptr>	segments;	// from first_segment on.
+
+		const block_index& index_at(uint64_t num) const
+		{
+			// slot 0 holds the index header.
+			return static_cast<const block_index*>(index_region.get_address())[num];
+		}
+
+		uint64_t first_block() const
+		{
+			return std::max(first_segment * segment_blocks, base_block) + 1;
+		}
+
+		// empty pointer if the segment of the block was pruned or the block precedes the log.
+		signed_block_ptr block_at(const block_index& index) const
+		{
+			if (index.num <= base_block)
+			{
+				return signed_block_ptr();
+			}
+
+			uint64_t segment = (index.num - 1) / segment_blocks;
+			if (segment < first_segment || segment - first_segment >= segments.size())
+			{
+				return signed_block_ptr();
+			}
+
+			const char* data = static_cast<const char*>(segments[segment - first_segment]->region.get_address()) + index.pos + sizeof(block_desc);
+
+			signed_block_ptr block_ptr = std::make_shared<signed_block>();
+			decode_block(data, index.size, index.codec, index.raw_size, *block_ptr);
+			return block_ptr;
+		}
+	};
+
+	using mapped_log_ptr = std::shared_ptr<const mapped_log>;
+
+	// map the first count blocks of the log, positional reads only.
+	// full segments never change, so their mappings are taken over from the previous log.
+	static mapped_log_ptr map_log(const mapped_log_ptr& previous, const fc::path& log_dir, const fc::path& index_file,
+		uint64_t count, uint64_t segment_blocks, uint64_t first_segment, uint64_t base_block)
 	{
-		stream_seek(stream, pos, IO_Read);
-		signed_block_ptr block_ptr = std::make_shared<signed_block>();
+		auto log = std::make_shared<mapped_log>();
+		log->segment_blocks = segment_blocks;
+		log->first_segment = first_segment;
+		log->base_block = base_block;
+		if (count > 0)
+		{
+			log->index_mapping = bip::file_mapping(index_file.generic_string().c_str(), bip::read_only);
+			log->index_region = bip::mapped_region(log->index_mapping, bip::read_only, 0, sizeof(block_index) * (count + 1));
 
-		fc::raw::unpack(stream, block_ptr);
-		return block_ptr;
+			log->block_count = count;
+
+			uint64_t last_segment = (count - 1) / segment_blocks;
+			for (uint64_t segment = first_segment; segment <= last_segment; ++segment)
+			{
+				uint64_t last_num = std::min(count, (segment + 1) * segment_blocks);
+				if (last_num <= base_block)
+				{
+					// no block of the log is in this segment yet.
+					log->segments.push_back(mapped_segment_ptr());
+					continue;
+				}
+				uint64_t size = block_record_end(log->index_at(last_num));
+
+				mapped_segment_ptr mapped;
+				if (previous && segment >= previous->first_segment && segment - previous->first_segment < previous->segments.size())
+				{
+					mapped = previous->segments[segment - previous->first_segment];
+					if (mapped && mapped->size < size)
+						mapped.reset();
+				}
+				if (!mapped)
+				{
+					mapped = map_segment(segment_file(log_dir, segment), size);
+				}
+				log->segments.push_back(mapped);
+			}
+		}
+		return log;
 	}
 }
 
@@ -161,19 +432,60 @@ static void clear_file_stream(const fc::path& file, std::fstream& stream)
 	open_file_stream(file, stream);
 }
 
+static void truncate_file_stream(const fc::path& file, std::fstream& stream, uint64_t size)
+{
+	stream.close();
+	boost::filesystem::resize_file(file, size);
+	open_file_stream(file, stream);
+}
+
 namespace Xmaxplatform { namespace Chain {
 
 	class chain_stream_impl
 	{
 	public:
-		std::fstream             block_stream;
+		std::fstream             block_stream;		// segment write_segment.
 		std::fstream             index_stream;
-		fc::path                 block_file;
+		fc::path                 log_dir;
 		fc::path                 index_file;
 		signed_block_ptr         head_block;
+		block_log_config         config;
+		uint64_t                 segment_blocks = 1;
+
+		// writer side, guarded by write_mutex.
+		std::mutex                         write_mutex;
+		block_detail::index_header         header;
+		block_detail::write_tail           tail;
+		uint64_t                           write_segment = 0;
+		uint64_t                           write_pos = 0;
+		uint64_t                           write_count = 0;
+
+		// pending tail blocks, readable until they are committed.
+		mutable std::mutex                 tail_mutex;
+		std::vector<signed_block_ptr>      tail_blocks;
+
+		std::thread                        flush_thread;
+		std::condition_variable            flush_cond;
+		bool                               flush_stop = false;
+
+		// readers never touch the streams, they work on a read-only mapping of the files.
+		std::atomic<uint64_t>              block_count{ 0 };
+		std::atomic<uint64_t>              first_segment{ 0 };
+		std::atomic<uint64_t>              base_block{ 0 };
+		mutable std::mutex                 remap_mutex;
+		mutable block_detail::mapped_log_ptr mapped;
+		std::atomic<bool>                  sequential{ false };
+
+		chain_stream_impl(const block_log_config& _config)
+			: config(_config)
+		{
+		}
 
 		~chain_stream_impl()
 		{
+			stop_flush_thread();
+			flush();
+
 			if (block_stream.is_open())
 			{
 				block_stream.close();
@@ -192,6 +504,8 @@ namespace Xmaxplatform { namespace Chain {
 
 		void open(const fc::path& data_dir)
 		{
+			stop_flush_thread();
+
 			if (block_stream.is_open())
 				block_stream.close();
 			if (index_stream.is_open())
@@ -199,153 +513,798 @@ namespace Xmaxplatform { namespace Chain {
 
 			if (!fc::is_directory(data_dir))
 				fc::create_directories(data_dir);
-			block_file = data_dir / "blocks.log";
+			log_dir = data_dir;
 			index_file = data_dir / "blocks.index";
 
-			//ilog("Opening block log at ${path}", ("path", block_file.generic_string()));
-			open_file_stream(block_file, block_stream);
-			open_file_stream(index_file, index_stream);
+			reset_mapping(0);
+			tail.clear();
+			tail_blocks.clear();
 
-			uint64_t log_size = fc::file_size(block_file);
-			uint64_t index_size = fc::file_size(index_file);
+			//ilog("Opening block log at ${path}", ("path", log_dir.generic_string()));
+			open_file_stream(index_file, index_stream);
 
-			if (0 == log_size && 0 < index_size)
+			if (!read_index_header())
 			{
-				ilog("Index is nonempty, remove and recreate it");
+				if (fc::file_size(index_file) > 0)
+				{
+					ilog("Index has no segment header, remove and recreate it");
+				}
 				clear_file_stream(index_file, index_stream);
+
+				header = block_detail::index_header();
+				header.segment_blocks = std::max<uint32_t>(config.segment_blocks, 1);
+
+				// segments may outlive their index, start from the oldest one left
+				// and take the segment size from the first block of a later segment.
+				// the oldest one may start after a snapshot, so it is only used when it is alone.
+				std::vector<uint64_t> segments = list_segments();
+				if (!segments.empty())
+				{
+					header.first_segment = segments.front();
+				}
+				for (size_t i = segments.size() > 1 ? 1 : 0; i < segments.size(); ++i)
+				{
+					uint64_t segment = segments[i];
+					uint64_t first_num = 0;
+					if (segment > 0 && read_first_block_num(segment, first_num))
+					{
+						if (first_num > 1 && (first_num - 1) % segment == 0)
+						{
+							header.segment_blocks = (first_num - 1) / segment;
+						}
+						break;
+					}
+				}
+				uint64_t first_num = 0;
+				if (!segments.empty() && read_first_block_num(segments.front(), first_num)
+					&& first_num > header.first_segment * header.segment_blocks + 1)
+				{
+					header.base_block = first_num - 1;
+				}
+				append_index_header();
+				append_pruned_indices(1, missing_blocks());
 			}
-			else if (0 == index_size && 0 < log_size)
+			else if (header.segment_blocks != config.segment_blocks)
 			{
-				ilog("Block is nonempty, remove and recreate it");
-				clear_file_stream(block_file, block_stream);
+				ilog("Block log keeps its segment size ${n}", ("n", header.segment_blocks));
 			}
-			else if (0 < index_size && 0 < log_size)
+
+			segment_blocks = header.segment_blocks;
+			first_segment.store(header.first_segment);
+			base_block.store(header.base_block);
+			remove_pruned_segments();
+
+			recover_tail();
+
+			fc::path legacy_file = data_dir / "blocks.log";
+			if (fc::exists(legacy_file))
 			{
-				//fc::raw::pack(
-				// check match between index and log.
-				// empty now.
-				block_detail::to_end_eof(block_stream, block_detail::IO_Read);
-				block_detail::block_end_eof_type eof;
-				block_detail::read_eof(block_stream, eof);
+				import_legacy_log(legacy_file);
+			}
 
-				FC_ASSERT(eof == block_detail::block_end_eof, "Block log is corrupted");
+			reset_mapping(write_count);
+			set_head(write_count > 0 ? read_block(write_count) : signed_block_ptr());
 
-				block_detail::to_last_block_desc(block_stream, block_detail::IO_Read);
-				block_detail::to_last_block_index(index_stream, block_detail::IO_Read);
+			if (config.durability == block_log_config::flush_interval)
+			{
+				flush_stop = false;
+				flush_thread = std::thread([this]() { flush_loop(); });
+			}
+		}
 
-				block_detail::block_desc desc;
+		bool read_index_header()
+		{
+			if (fc::file_size(index_file) < sizeof(block_detail::index_header))
+			{
+				return false;
+			}
+			block_detail::stream_seek(index_stream, 0, block_detail::IO_Read);
+			index_stream.read((char*)&header, sizeof(block_detail::index_header));
+
+			if (header.magic != block_detail::index_magic || header.segment_blocks == 0)
+			{
+				return false;
+			}
+			if (header.version == 1)
+			{
+				// version 1 logs all start at block 1.
+				header.version = block_detail::index_version;
+				header.base_block = 0;
+				update_index_header();
+			}
+			return header.version == block_detail::index_version;
+		}
+
+		// leading index entries without a record, pruned or before the base block.
+		uint64_t missing_blocks() const
+		{
+			return std::max(header.first_segment * header.segment_blocks, header.base_block);
+		}
+
+		// only for an empty index.
+		void append_index_header()
+		{
+			block_detail::stream_end(index_stream, block_detail::IO_Write);
+			index_stream.write((const char*)&header, sizeof(block_detail::index_header));
+			index_stream.flush();
+		}
+
+		// the index stream appends, so the header is rewritten in place by its own stream.
+		void update_index_header()
+		{
+			std::fstream stream;
+			stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+			stream.open(index_file.generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary);
+			stream.write((const char*)&header, sizeof(block_detail::index_header));
+			stream.flush();
+		}
+
+		// pruned blocks keep an entry without a record, so indices stay addressable by number.
+		void append_pruned_indices(uint64_t from, uint64_t to)
+		{
+			block_detail::stream_end(index_stream, block_detail::IO_Write);
+			for (uint64_t num = from; num <= to; ++num)
+			{
 				block_detail::block_index index;
+				index.num = num;
+				block_detail::write_block_index(index_stream, index);
+			}
+			index_stream.flush();
+		}
+
+		void open_segment(uint64_t segment)
+		{
+			if (block_stream.is_open())
+			{
+				if (write_segment == segment)
+					return;
+				block_stream.close();
+			}
+			open_file_stream(block_detail::segment_file(log_dir, segment), block_stream);
+			write_segment = segment;
+		}
+
+		bool read_first_block_num(uint64_t segment, uint64_t& num)
+		{
+			fc::path file = block_detail::segment_file(log_dir, segment);
+			if (fc::file_size(file) < sizeof(block_detail::block_desc))
+			{
+				return false;
+			}
+			open_segment(segment);
+
+			block_detail::block_desc desc;
+			block_detail::stream_seek(block_stream, 0, block_detail::IO_Read);
+			block_detail::read_block_desc(block_stream, desc);
+			num = desc.num;
+			return desc.pos == 0;
+		}
+
+		bool check_segment_record(const block_detail::block_index& index)
+		{
+			uint64_t segment = (index.num - 1) / segment_blocks;
+			fc::path file = block_detail::segment_file(log_dir, segment);
+			if (!fc::exists(file))
+			{
+				return false;
+			}
+			open_segment(segment);
+			return block_detail::check_block_record(block_stream, index, fc::file_size(file));
+		}
+
+		// segment numbers of the blocks_<n>.log files on disk.
+		std::vector<uint64_t> list_segments() const
+		{
+			std::vector<uint64_t> segments;
+			for (boost::filesystem::directory_iterator it(log_dir), end; it != end; ++it)
+			{
+				std::string name = it->path().filename().string();
+				if (name.size() <= 11 || name.compare(0, 7, "blocks_") != 0 || name.compare(name.size() - 4, 4, ".log") != 0)
+					continue;
+
+				std::string number = name.substr(7, name.size() - 11);
+				if (number.find_first_not_of("0123456789") != std::string::npos)
+					continue;
 
-				block_detail::read_block_desc(block_stream, desc);
+				segments.push_back(std::stoull(number));
+			}
+			std::sort(segments.begin(), segments.end());
+			return segments;
+		}
+
+		// segments a prune could not delete, e.g. still mapped by a reader.
+		void remove_pruned_segments()
+		{
+			for (uint64_t segment : list_segments())
+			{
+				if (segment < header.first_segment)
+				{
+					remove_segment_file(block_detail::segment_file(log_dir, segment));
+				}
+			}
+		}
+
+		void remove_segment_file(const fc::path& file)
+		{
+			try
+			{
+				fc::remove(file);
+			}
+			catch (...)
+			{
+				wlog("Unable to remove pruned segment ${path}, retry on next open", ("path", file.generic_string()));
+			}
+		}
+
+		// make the segments and blocks.index agree after a crash:
+		// drop index entries whose record is torn, index complete records the index missed,
+		// and cut whatever is left behind the last complete record.
+		void recover_tail()
+		{
+			uint64_t index_size = fc::file_size(index_file);
+			uint64_t count = index_size / sizeof(block_detail::block_index) - 1;
+			uint64_t pruned = missing_blocks();
+			uint64_t pos = 0;
+
+			while (count > pruned)
+			{
+				block_detail::block_index index;
+				block_detail::stream_seek(index_stream, sizeof(block_detail::block_index) * count, block_detail::IO_Read);
 				block_detail::read_block_index(index_stream, index);
 
-				FC_ASSERT(desc.pos == index.pos, "Block log is corrupted");
+				if (index.num == count && check_segment_record(index))
+				{
+					pos = block_detail::block_record_end(index);
+					break;
+				}
+				--count;
+			}
+
+			if (index_size != sizeof(block_detail::block_index) * (count + 1))
+			{
+				wlog("Drop ${size} bytes of broken block index tail", ("size", index_size - sizeof(block_detail::block_index) * (count + 1)));
+				truncate_file_stream(index_file, index_stream, sizeof(block_detail::block_index) * (count + 1));
+			}
+			if (count < pruned)
+			{
+				append_pruned_indices(count + 1, pruned);
+				count = pruned;
+			}
+
+			// the next block starts a new segment at every segment boundary.
+			uint64_t segment = count / segment_blocks;
+			if (count % segment_blocks == 0)
+			{
+				pos = 0;
+			}
 
-				head_block = read_head();
+			uint64_t indexed = count;
+			block_detail::stream_end(index_stream, block_detail::IO_Write);
+			while (true)
+			{
+				fc::path file = block_detail::segment_file(log_dir, segment);
+				if (!fc::exists(file))
+				{
+					break;
+				}
+				open_segment(segment);
+
+				block_detail::block_index index;
+				if (!block_detail::scan_block(block_stream, pos, fc::file_size(file), index) || index.num != count + 1)
+				{
+					break;
+				}
+				block_detail::write_block_index(index_stream, index);
+				pos = block_detail::block_record_end(index);
+				++count;
+
+				if (count % segment_blocks == 0)
+				{
+					++segment;
+					pos = 0;
+				}
+			}
+			index_stream.flush();
+
+			if (count != indexed)
+			{
+				wlog("Recovered ${n} block indices from block log", ("n", count - indexed));
+			}
+
+			fc::path file = block_detail::segment_file(log_dir, segment);
+			if (fc::exists(file) && fc::file_size(file) > pos)
+			{
+				wlog("Drop ${size} bytes of broken block log tail", ("size", fc::file_size(file) - pos));
+				open_segment(segment);
+				truncate_file_stream(file, block_stream, pos);
 			}
+			for (uint64_t next = segment + 1; fc::exists(block_detail::segment_file(log_dir, next)); ++next)
+			{
+				wlog("Drop block log segment ${n} behind the broken tail", ("n", next));
+				if (block_stream.is_open() && write_segment == next)
+					block_stream.close();
+				fc::remove(block_detail::segment_file(log_dir, next));
+			}
+
+			write_count = count;
+			write_pos = pos;
+			open_segment(segment);
+		}
+
+		// move blocks of the single file blocks.log into segments.
+		void import_legacy_log(const fc::path& legacy_file)
+		{
+			ilog("Importing block log ${path} into segments", ("path", legacy_file.generic_string()));
+
+			uint64_t end = fc::file_size(legacy_file);
+			uint64_t pos = 0;
+			uint64_t imported = 0;
+			bool complete = true;
+			{
+				std::fstream legacy;
+				legacy.exceptions(std::fstream::failbit | std::fstream::badbit);
+				legacy.open(legacy_file.generic_string().c_str(), LOG_READ);
+
+				std::lock_guard<std::mutex> guard(write_mutex);
+				while (pos < end)
+				{
+					signed_block_ptr block = std::make_shared<signed_block>();
+					if (!block_detail::scan_legacy_block(legacy, pos, end, *block, pos))
+					{
+						complete = false;
+						break;
+					}
+					if (block->block_num() <= write_count)
+					{
+						continue;
+					}
+					if (block->block_num() != write_count + 1)
+					{
+						complete = false;
+						break;
+					}
+					append_encoded(block_detail::encode_block(block, config.compress));
+					++imported;
+				}
+				commit_tail();
+			}
+
+			if (complete)
+			{
+				fc::remove(legacy_file);
+			}
+			else
+			{
+				wlog("Block log ${path} is broken at ${pos}, keep it as blocks.log.broken", ("path", legacy_file.generic_string())("pos", pos));
+				fc::rename(legacy_file, log_dir / "blocks.log.broken");
+			}
+			ilog("Imported ${n} blocks", ("n", imported));
+		}
+
+		void rebuild_index()
+		{
+			ilog("Rebuilding block index from ${path}", ("path", log_dir.generic_string()));
+
+			std::lock_guard<std::mutex> guard(write_mutex);
+			commit_tail();
+
+			reset_mapping(0);
+			clear_file_stream(index_file, index_stream);
+			set_head(signed_block_ptr());
+
+			append_index_header();
+			append_pruned_indices(1, missing_blocks());
+			recover_tail();
+
+			reset_mapping(write_count);
+			if (write_count > 0)
+			{
+				set_head(read_block(write_count));
+			}
+
+			ilog("Rebuilt ${count} block indices", ("count", write_count));
 		}
 
 		uint64_t append_block(const signed_block_ptr& blockptr)
 		{
+			// packing and compression do not need the writer lock.
+			block_detail::encoded_block encoded = block_detail::encode_block(blockptr, config.compress);
+
+			std::lock_guard<std::mutex> guard(write_mutex);
+			return append_encoded(encoded);
+		}
+
+		// caller holds write_mutex.
+		uint64_t append_encoded(const block_detail::encoded_block& encoded)
+		{
+			xmax_type_block_num num = encoded.block->block_num();
+
+			FC_ASSERT(num == write_count + 1,
+				"Append to block log occuring at wrong position.",
+				("num", num)
+				("expected", write_count + 1));
+
+			uint64_t segment = (num - 1) / segment_blocks;
+			uint64_t pos = (num - 1) % segment_blocks == 0 ? 0 : write_pos;
+
+			block_detail::block_index index = block_detail::write_block(tail, segment, pos, encoded);
+
+			write_pos = block_detail::block_record_end(index);
+			write_count = num;
+			{
+				std::lock_guard<std::mutex> tail_guard(tail_mutex);
+				tail_blocks.push_back(encoded.block);
+			}
+			set_head(encoded.block);
+
+			if (should_commit())
+			{
+				commit_tail();
+			}
+
+			return index.pos;
+		}
+
+		bool should_commit() const
+		{
+			if (tail.data_size >= config.max_tail_size)
+			{
+				return true;
+			}
+
+			switch (config.durability)
+			{
+			case block_log_config::flush_every_block:
+				return true;
+			case block_log_config::flush_every_n_blocks:
+				return tail.blocks.size() >= std::max<uint32_t>(config.flush_blocks, 1);
+			default:
+				break;
+			}
+			return false;
+		}
+
+		// one write and one flush per touched file for the whole tail. caller holds write_mutex.
+		void commit_tail()
+		{
+			if (tail.empty())
+			{
+				return;
+			}
 
-			uint64_t pos = block_detail::write_block(block_stream, index_stream, blockptr);
+			for (const block_detail::write_chunk& chunk : tail.chunks)
+			{
+				open_segment(chunk.segment);
+				block_detail::stream_end(block_stream, block_detail::IO_Write);
+				block_stream.write(chunk.data.data(), chunk.data.size());
+				block_stream.flush();
+			}
 
-			head_block = blockptr;
+			block_detail::stream_end(index_stream, block_detail::IO_Write);
+			index_stream.write(tail.index_data.data(), tail.index_data.size());
+			index_stream.flush();
 
-			return pos;
+			// publish only after the records and their indices are flushed.
+			block_count.store(write_count, std::memory_order_release);
+			{
+				std::lock_guard<std::mutex> tail_guard(tail_mutex);
+				tail_blocks.clear();
+			}
+			tail.clear();
+
+			if (config.retain_blocks > 0 && write_count > config.retain_blocks)
+			{
+				prune_segments(write_count - config.retain_blocks + 1);
+			}
 		}
 
-		signed_block_ptr read_head() const
+		// drop whole segments below the one holding keep_from. caller holds write_mutex, tail committed.
+		void prune_segments(uint64_t keep_from)
 		{
-			std::fstream& stream = const_cast<std::fstream&>(block_stream);
+			keep_from = std::min(keep_from, write_count);
+			if (keep_from == 0)
+			{
+				return;
+			}
 
-			block_detail::to_last_block_desc(stream, block_detail::IO_Read);
+			uint64_t from = header.first_segment;
+			uint64_t to = (keep_from - 1) / segment_blocks;
+			if (to <= from)
+			{
+				return;
+			}
 
-			block_detail::block_desc desc;
+			header.first_segment = to;
+			update_index_header();
+			first_segment.store(to, std::memory_order_release);
+			{
+				// readers holding the old mapping keep it until they are done.
+				std::lock_guard<std::mutex> guard(remap_mutex);
+				std::atomic_store(&mapped, block_detail::mapped_log_ptr());
+			}
 
-			block_detail::read_block_desc(stream, desc);
+			if (block_stream.is_open() && write_segment < to)
+			{
+				block_stream.close();
+			}
+			for (uint64_t segment = from; segment < to; ++segment)
+			{
+				fc::path file = block_detail::segment_file(log_dir, segment);
+				if (fc::exists(file))
+				{
+					remove_segment_file(file);
+				}
+			}
 
-			return read_block_impl(desc.pos);
+			ilog("Pruned block log below block ${num}", ("num", to * segment_blocks + 1));
 		}
-		signed_block_ptr read_block_impl(uint64_t pos) const
+
+		void prune(uint32_t keep_from)
 		{
-			std::fstream& stream = const_cast<std::fstream&>(block_stream);
-			return block_detail::read_block(stream, pos);
+			std::lock_guard<std::mutex> guard(write_mutex);
+			commit_tail();
+			prune_segments(keep_from);
 		}
 
-		signed_block_ptr read_block(uint32_t num) const
+		// the index entries up to base are left sparse, they read as zero and no block is found for them.
+		void reset_after(uint64_t base)
 		{
-			std::fstream& idxstream = const_cast<std::fstream&>(index_stream);
+			std::lock_guard<std::mutex> guard(write_mutex);
+			commit_tail();
 
-			block_detail::to_last_block_index(idxstream, block_detail::IO_Read);
-			block_detail::block_index last_idx;
-			block_detail::read_block_index(idxstream, last_idx);
+			ilog("Restart block log ${path} after block ${num}, ${count} blocks dropped",
+				("path", log_dir.generic_string())("num", base)("count", write_count - std::min(write_count, missing_blocks())));
 
-			if (last_idx.num > num)
+			reset_mapping(0);
+			set_head(signed_block_ptr());
+			if (block_stream.is_open())
 			{
-				block_detail::to_last_block_index(idxstream, block_detail::IO_Read);
-				uint64_t bias = sizeof(block_detail::block_index) * (last_idx.num - num);
-				block_detail::block_index idx;
-				block_detail::stream_seek(idxstream, -bias, std::ios::cur, block_detail::IO_Read);
-				block_detail::read_block_index(idxstream, idx);
-				return read_block_impl(idx.pos);
+				block_stream.close();
 			}
-			else if (last_idx.num == num)
+			for (uint64_t segment : list_segments())
 			{
-				return read_block_impl(last_idx.pos);
+				fc::remove(block_detail::segment_file(log_dir, segment));
 			}
-			return signed_block_ptr();
+
+			clear_file_stream(index_file, index_stream);
+			header.first_segment = base / segment_blocks;
+			header.base_block = base;
+			append_index_header();
+			truncate_file_stream(index_file, index_stream, sizeof(block_detail::block_index) * (base + 1));
+
+			first_segment.store(header.first_segment, std::memory_order_release);
+			base_block.store(base, std::memory_order_release);
+			write_count = base;
+			write_pos = 0;
+			open_segment(header.first_segment);
+			reset_mapping(base);
 		}
 
-		std::vector<block_detail::block_index> read_indices(int64_t begin_num, int64_t block_count) const
+		void flush()
 		{
-			std::vector<block_detail::block_index> idxs;
+			std::lock_guard<std::mutex> guard(write_mutex);
+			commit_tail();
+		}
 
-			std::fstream& idxstream = const_cast<std::fstream&>(index_stream);
-			block_detail::to_last_block_index(idxstream, block_detail::IO_Read);
+		void flush_loop()
+		{
+			std::unique_lock<std::mutex> guard(write_mutex);
+			while (!flush_stop)
+			{
+				flush_cond.wait_for(guard, std::chrono::milliseconds(config.flush_interval_ms));
+				commit_tail();
+			}
+		}
 
-			if (idxstream.tellg() <= 0)
+		void stop_flush_thread()
+		{
+			if (flush_thread.joinable())
 			{
-				return idxs;
+				{
+					std::lock_guard<std::mutex> guard(write_mutex);
+					flush_stop = true;
+				}
+				flush_cond.notify_all();
+				flush_thread.join();
 			}
+		}
+
+		void set_head(const signed_block_ptr& blockptr)
+		{
+			std::atomic_store(&head_block, blockptr);
+		}
+
+		signed_block_ptr get_head() const
+		{
+			return std::atomic_load(&head_block);
+		}
 
-			block_detail::block_index last_idx;
-			block_detail::read_block_index(idxstream, last_idx);
+		void reset_mapping(uint64_t count)
+		{
+			std::lock_guard<std::mutex> guard(remap_mutex);
+			std::atomic_store(&mapped, block_detail::mapped_log_ptr());
+			block_count.store(count, std::memory_order_release);
+		}
 
-			int64_t cc = last_idx.num - begin_num + 1;
-			if (cc < 1)
+		block_detail::mapped_log_ptr current_log() const
+		{
+			uint64_t count = block_count.load(std::memory_order_acquire);
+			uint64_t first = first_segment.load(std::memory_order_acquire);
+
+			block_detail::mapped_log_ptr log = std::atomic_load(&mapped);
+			if (log && log->block_count >= count && log->first_segment == first)
 			{
-				return idxs;
+				return log;
 			}
-			int64_t count = (cc < block_count) ? cc : block_count;
 
-			block_detail::to_last_block_index(idxstream, block_detail::IO_Read);
+			// the log grew or was pruned since the last mapping, remap it once for all readers.
+			std::lock_guard<std::mutex> guard(remap_mutex);
+			log = std::atomic_load(&mapped);
+			count = block_count.load(std::memory_order_acquire);
+			first = first_segment.load(std::memory_order_acquire);
+			if (!log || log->block_count < count || log->first_segment != first)
+			{
+				log = block_detail::map_log(log, log_dir, index_file, count, segment_blocks, first, base_block.load(std::memory_order_acquire));
+				advise_segments(*log, sequential.load());
+				std::atomic_store(&mapped, log);
+			}
+			return log;
+		}
 
-			uint64_t bias = sizeof(block_detail::block_index) * (last_idx.num - begin_num);
+		static void advise_segments(const block_detail::mapped_log& log, bool seq)
+		{
+			for (const auto& segment : log.segments)
+			{
+				if (segment)
+					segment->region.advise(seq ? boost::interprocess::mapped_region::advice_sequential : boost::interprocess::mapped_region::advice_normal);
+			}
+		}
 
-			idxs.resize(count);
+		void advise_sequential(bool seq)
+		{
+			sequential.store(seq);
+			advise_segments(*current_log(), seq);
+		}
 
-			block_detail::stream_seek(idxstream, -bias, std::ios::cur, block_detail::IO_Read);
-			block_detail::read_block_indices(idxstream, &idxs[0], count);
+		// blocks appended but not committed yet.
+		signed_block_ptr read_tail_block(uint32_t num) const
+		{
+			std::lock_guard<std::mutex> tail_guard(tail_mutex);
+			if (tail_blocks.empty())
+			{
+				return signed_block_ptr();
+			}
 
-			return idxs;
+			uint32_t first = tail_blocks.front()->block_num();
+			if (num < first || num - first >= tail_blocks.size())
+			{
+				return signed_block_ptr();
+			}
+			return tail_blocks[num - first];
 		}
 
-		int64_t last_block_num() const
+		signed_block_ptr read_block(uint32_t num) const
 		{
-			std::fstream& idxstream = const_cast<std::fstream&>(index_stream);
+			block_detail::mapped_log_ptr log = current_log();
+			if (num == 0)
+			{
+				return signed_block_ptr();
+			}
+			if (num > log->block_count)
+			{
+				if (signed_block_ptr block = read_tail_block(num))
+				{
+					return block;
+				}
+				// the tail may have been committed meanwhile.
+				log = current_log();
+				if (num > log->block_count)
+				{
+					return signed_block_ptr();
+				}
+			}
+			return log->block_at(log->index_at(num));
+		}
 
-			block_detail::to_last_block_index(idxstream, block_detail::IO_Read);
+		signed_block_ptr read_block(const xmax_type_block_id& id) const
+		{
+			// block id carries its number, so the index entry can be addressed directly.
+			uint32_t num = utils::num_from_id(id);
 
-			if (idxstream.tellg() <= 0)
+			block_detail::mapped_log_ptr log = current_log();
+			if (num == 0)
+			{
+				return signed_block_ptr();
+			}
+			if (num > log->block_count)
+			{
+				signed_block_ptr block = read_block(num);
+				return (block && block->id() == id) ? block : signed_block_ptr();
+			}
+
+			const block_detail::block_index& idx = log->index_at(num);
+			if (idx.id != id)
+			{
+				return signed_block_ptr();
+			}
+			return log->block_at(idx);
+		}
+
+		uint32_t for_each_block(uint32_t first, uint32_t last, const std::function<bool(const signed_block_ptr&)>& visit) const
+		{
+			block_detail::mapped_log_ptr log = current_log();
+			first = (uint32_t)std::max<uint64_t>(first, log->first_block());
+			if (first > last)
 			{
 				return 0;
 			}
 
-			block_detail::block_index last_idx;
-			block_detail::read_block_index(idxstream, last_idx);
+			uint32_t visited = 0;
+			uint32_t mapped_last = (uint32_t)std::min<uint64_t>(last, log->block_count);
+			for (uint32_t num = first; num <= mapped_last; ++num)
+			{
+				++visited;
+				if (!visit(log->block_at(log->index_at(num))))
+				{
+					return visited;
+				}
+			}
+
+			for (uint32_t num = std::max(first, mapped_last + 1); num <= last; ++num)
+			{
+				signed_block_ptr block = read_block(num);
+				if (!block)
+				{
+					break;
+				}
+				++visited;
+				if (!visit(block))
+				{
+					break;
+				}
+			}
+			return visited;
+		}
+
+		std::vector<signed_block_ptr> read_block_range(uint32_t first, uint32_t last) const
+		{
+			std::vector<signed_block_ptr> blocks;
+			for_each_block(first, last, [&](const signed_block_ptr& block) {
+				blocks.push_back(block);
+				return true;
+			});
+			return blocks;
+		}
+
+		std::vector<block_detail::block_index> read_indices(int64_t begin_num, int64_t block_count) const
+		{
+			std::vector<block_detail::block_index> idxs;
+
+			block_detail::mapped_log_ptr log = current_log();
+
+			int64_t last_num = (int64_t)log->block_count;
+			if (begin_num < 1 || begin_num > last_num)
+			{
+				return idxs;
+			}
+
+			int64_t cc = last_num - begin_num + 1;
+			int64_t count = (cc < block_count) ? cc : block_count;
+
+			idxs.assign(&log->index_at(begin_num), &log->index_at(begin_num) + count);
+
+			return idxs;
+		}
+
+		int64_t last_block_num() const
+		{
+			signed_block_ptr head = get_head();
+			return head ? head->block_num() : (int64_t)base_block.load(std::memory_order_acquire);
+		}
 
-			return last_idx.num;
+		uint32_t first_block_num() const
+		{
+			return (uint32_t)(std::max(first_segment.load(std::memory_order_acquire) * segment_blocks, base_block.load(std::memory_order_acquire)) + 1);
 		}
 
 	};
@@ -353,8 +1312,8 @@ namespace Xmaxplatform { namespace Chain {
 
 
 
-	chain_stream::chain_stream(const fc::path& data_dir)
-		:stream_impl(std::make_unique<chain_stream_impl>()) {
+	chain_stream::chain_stream(const fc::path& data_dir, const block_log_config& config)
+		:stream_impl(std::make_unique<chain_stream_impl>(config)) {
 		stream_impl->init();
 		stream_impl->open(data_dir);
 	}
@@ -372,7 +1331,7 @@ namespace Xmaxplatform { namespace Chain {
 	}
 	signed_block_ptr chain_stream::get_head() const
 	{
-		return stream_impl->head_block;
+		return stream_impl->get_head();
 	}
 
 	signed_block_ptr chain_stream::read_by_num(uint32_t num) const
@@ -380,6 +1339,56 @@ namespace Xmaxplatform { namespace Chain {
 		return stream_impl->read_block(num);
 	}
 
+	signed_block_ptr chain_stream::read_block(uint32_t num) const
+	{
+		return stream_impl->read_block(num);
+	}
+
+	std::vector<signed_block_ptr> chain_stream::read_block_range(uint32_t first, uint32_t last) const
+	{
+		return stream_impl->read_block_range(first, last);
+	}
+
+	uint32_t chain_stream::for_each_block(uint32_t first, uint32_t last, const std::function<bool(const signed_block_ptr&)>& visit) const
+	{
+		return stream_impl->for_each_block(first, last, visit);
+	}
+
+	signed_block_ptr chain_stream::read_by_id(const xmax_type_block_id& id) const
+	{
+		return stream_impl->read_block(id);
+	}
+
+	void chain_stream::rebuild_index()
+	{
+		stream_impl->rebuild_index();
+	}
+
+	void chain_stream::prune(uint32_t keep_from)
+	{
+		stream_impl->prune(keep_from);
+	}
+
+	void chain_stream::reset_after(uint32_t base_block)
+	{
+		stream_impl->reset_after(base_block);
+	}
+
+	void chain_stream::advise_sequential(bool sequential)
+	{
+		stream_impl->advise_sequential(sequential);
+	}
+
+	uint32_t chain_stream::first_block_num() const
+	{
+		return stream_impl->first_block_num();
+	}
+
+	void chain_stream::flush()
+	{
+		stream_impl->flush();
+	}
+
 	int64_t chain_stream::last_block_num() const
 	{
 		return stream_impl->last_block_num();
@@ -390,4 +1399,4 @@ namespace Xmaxplatform { namespace Chain {
 		return stream_impl->read_indices(begin_num, block_count);
 	}
 }
-}
\ No newline at end of file
+}
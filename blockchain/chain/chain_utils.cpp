@@ -4,6 +4,7 @@
 */
 
 #include <chain_utils.hpp>
+#include <objects/transaction_object.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/bitutil.hpp>
 #include <fc/crypto/ripemd160.hpp>
@@ -92,6 +93,23 @@ namespace Chain {
 			return to_address(pk);
 		}
 
+		uint32_t prune_expired_transactions(Basechain::database& db, const fc::time_point_sec& now, uint32_t limit)
+		{
+			const auto& idx = db.get_index<transaction_multi_index, by_expiration>();
+
+			uint32_t removed = 0;
+			auto itr = idx.begin();
+			while (removed < limit && itr != idx.end() && itr->expiration < now)
+			{
+				// remove goes through the undo stack of the active session.
+				const transaction_object& obj = *itr;
+				++itr;
+				db.remove(obj);
+				++removed;
+			}
+			return removed;
+		}
+
 	}
 }
 }
\ No newline at end of file
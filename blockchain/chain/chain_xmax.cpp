@@ -13,6 +13,7 @@
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/range/adaptor/map.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -36,6 +37,7 @@
 #include <objects/transaction_object.hpp>
 #include <objects/block_summary_object.hpp>
 #include <objects/account_object.hpp>
+#include <objects/code_object.hpp>
 
 #include <objects/vote_objects.hpp>
 #include <objects/resource_token_object.hpp>
@@ -45,6 +47,7 @@
 #include <transaction_context_xmax.hpp>
 #include <pending_block.hpp>
 #include <chain_stream.hpp>
+#include <chain_snapshot.hpp>
 
 #include <vm_xmax.hpp>
 
@@ -79,22 +82,30 @@ namespace Xmaxplatform { namespace Chain {
 
 		const uint32_t                   pending_txn_depth_limit;
 		uint64_t                         skip_flags = 0;
+		bool                             replaying = false;
 
 		map<handler_key, native_handler>  message_handlers;
 		map<handler_key, uint64>  message_handler_gasstep;
 		map<native_scope, Basetypes::abi>  abi_handlers;
 
-		std::priority_queue<transaction_request_ptr,std::vector<transaction_request_ptr>, gas_sort<transaction_request_ptr>>  pending_transactions;
+		transaction_pool					pending_transactions;
+		signature_recovery					recovery;
+		std::shared_ptr<bool>				alive = std::make_shared<bool>(true);	// tasks posted to the apply thread may outlive the chain.
+		confirmation_verifier				confirmations;
 
 
-		chain_context(const chain_xmax::xmax_config& _config, uint32_t _txn_depth_limit)
+		chain_context(const chain_xmax::xmax_config& _config, uint32_t _txn_depth_limit, const std::function<void()>& on_verified)
 			: config(_config)
-			, chain_log(_config.block_log_dir)
+			, chain_log(_config.block_log_dir, _config.block_log)
 			, pending_txn_depth_limit(_txn_depth_limit)
 			, block_db(config.block_memory_dir,
 				config.open_flag ? database::read_only : database::read_write,
-				config.shared_memory_size)
+				config.shared_memory_size,
+				config.state_map)
 			, fork_db(config.block_memory_dir)
+			, pending_transactions(config.transaction_pool)
+			, recovery(config.chain_id, config.signature_threads)
+			, confirmations(config.signature_threads > 0, on_verified)
 		{
 			//--------------------------------------
 //#pragma message("-------------------------------------- skip some for test. --------------------------------------") 
@@ -110,6 +121,16 @@ namespace Xmaxplatform { namespace Chain {
 
 		void start()
 		{
+			// no session is open between blocks, the segment can be remapped.
+			if (config.shared_memory_min_free && config.shared_memory_grow_size && !config.open_flag)
+			{
+				const uint64_t free_before = block_db.get_free_memory();
+				if (block_db.grow_if_needed(config.shared_memory_min_free, config.shared_memory_grow_size))
+				{
+					ilog("chain state grew to ${size} MB, ${free} MB free before, growth ${count}",
+						("size", block_db.get_segment_size() / (1024 * 1024))("free", free_before / (1024 * 1024))("count", block_db.grow_count()));
+				}
+			}
 			building_block = block_db.start_undo_session(true);
 			building_status = build_status();
 		}
@@ -229,8 +250,16 @@ namespace Xmaxplatform { namespace Chain {
 
 				_context->fork_db.add_block(pack);
 				_context->fork_db.force_confirm(pack->block_id, block_num);
-				 
-				_context->chain_log.append_block(_context->block_head->block);
+
+				// a replay rebuilds the genesis block the block log starts with.
+				if (_context->chain_log.last_block_num() >= block_num)
+				{
+					FC_ASSERT(_context->chain_log.read_block(block_num)->id() == pack->block_id, "genesis block differs from the block log");
+				}
+				else
+				{
+					_context->chain_log.append_block(_context->block_head->block);
+				}
 
 				_context->building_block->push_db();
 				_context->building_block.reset();
@@ -272,21 +301,72 @@ namespace Xmaxplatform { namespace Chain {
 			{
 				wlog("block_num != revision, try to roll-back the db revision");
 				_context->block_db.undo_all();
+
+				// committed state past the saved fork db, e.g. a replay stopped between checkpoints.
+				// those blocks are irreversible, continue from the block log.
+				int64_t committed = _context->block_db.revision();
+				if (committed > block_num)
+				{
+					wlog("state is committed up to block ${num}, continue from the block log", ("num", committed));
+
+					signed_block_ptr head = _context->chain_log.read_block(committed);
+					FC_ASSERT(head, "block ${num} is not in the block log", ("num", committed));
+
+					const auto& static_config = get_static_config();
+					const auto& dynamic_states = get_dynamic_states();
+					FC_ASSERT(dynamic_states.head_block_id == head->id(), "state head differs from the block log");
+
+					pack_head = std::make_shared<block_pack>();
+					pack_head->refresh(head, static_config.current_builders, static_config.next_builders, dynamic_states.round_slot, true, true, true);
+					_context->fork_db.add_block(pack_head);
+					_context->fork_db.force_confirm(pack_head->block_id, pack_head->block_num);
+
+					_context->block_head = pack_head;
+					block_num = committed;
+				}
 				_context->block_db.set_revision(block_num);
 			}
-			_context->last_irreversible_block_num = revision;
+			_context->last_irreversible_block_num = block_num;
+
+			// import_snapshot restarts the block log at the snapshot block, any other gap is lost history.
+			FC_ASSERT(_context->chain_log.last_block_num() >= block_num,
+				"block log ends at block ${log}, the chain state is at block ${num}",
+				("log", _context->chain_log.last_block_num())("num", block_num));
 		}
 
         chain_xmax::chain_xmax(chain_init& init, const xmax_config& config, const finalize_block_func& finalize_func)
-		: _context(new chain_context(config, 1000)) {
+		: _context(new chain_context(config, 1000, [this]() { _wake_for_confirmations(); })) {
+
+			// objects are read in place, a state written with another layout of them can only be rebuilt.
+			if (_context->block_db.created())
+			{
+				_context->block_db.set_state_version(Config::chain_state_version);
+			}
+			FC_ASSERT(_context->block_db.get_state_version() == Config::chain_state_version,
+				"chain state in ${dir} has format ${found}, this node reads format ${expected}, start with replay-blockchain or a snapshot",
+				("dir", config.block_memory_dir.generic_string())("found", _context->block_db.get_state_version())("expected", Config::chain_state_version));
 
             setup_xmax_indexes(_context->block_db);
             init.register_handlers(*this, _context->block_db);
 
+			if (!config.open_flag)
+			{
+				FC_ASSERT(_context->block_db.clean_shutdown(),
+					"chain state in ${dir} was not closed cleanly, start with replay-blockchain or a snapshot",
+					("dir", config.block_memory_dir.generic_string()));
+				_context->block_db.start_background_flush(config.flush_interval_ms, config.flush_durable);
+			}
+
 			if (finalize_func) {
 				on_finalize_block.connect(*finalize_func);
 			}
 
+			if (!config.wasm_cache_dir.empty() && config.wasm_cache_size)
+			{
+				vm_xmax::get().open_code_cache(config.wasm_cache_dir, config.wasm_cache_size);
+			}
+			vm_xmax::get().set_module_cache_size(config.wasm_module_cache_size);
+
 			initialize_chain(init);
 			
         }
@@ -369,8 +449,11 @@ namespace Xmaxplatform { namespace Chain {
 		signed_block_ptr chain_xmax::block_from_id(xmax_type_block_id id) const
 		{
 			try {
-				// empty now. fill later.
-				return signed_block_ptr();
+				if (block_pack_ptr pack = _context->fork_db.get_block(id))
+				{
+					return pack->block;
+				}
+				return _context->chain_log.read_by_id(id);
 			}FC_LOG_AND_RETHROW()
 		}
 		xmax_type_block_id chain_xmax::block_id_from_num(uint32_t num) const
@@ -510,7 +593,23 @@ namespace Xmaxplatform { namespace Chain {
 			{
 				if (!_context->building_block.valid())
 				{
-					_context->pending_transactions.push(request);
+					switch (_context->pending_transactions.add(request))
+					{
+					case pool_added:
+						break;
+					case pool_duplicate:
+						FC_THROW_EXCEPTION(tx_duplicate, "transaction ${id} is already pending", ("id", request->id));
+					case pool_payer_limit:
+						FC_THROW_EXCEPTION(tx_payer_limit, "gas payer ${payer} has too many pending transactions",
+							("payer", request->signed_trx.gas_payer)("max", _context->config.transaction_pool.max_per_payer));
+					case pool_full:
+						FC_THROW_EXCEPTION(tx_pool_full, "no room for transaction ${id} with gas ${gas}",
+							("id", request->id)("gas", request->signed_trx.gas));
+					}
+
+					// only a queued transaction waits long enough for a worker to recover its keys first.
+					if (!(_context->skip_flags & Config::skip_transaction_signatures))
+						_context->recovery.post(request);
 					return make_response();
 				}
 
@@ -539,12 +638,12 @@ namespace Xmaxplatform { namespace Chain {
 		{
 			try {
 				transaction_response_ptr response;
-				transaction_context_xmax Impl(*this, request->signed_trx);
+				transaction_context_xmax Impl(*this, *request);
 
 				utils::check_gaspayer(_context->block_db, request);
 
-				if (check_auth)
-					utils::check_authorization(_context->block_db, request->signed_trx.messages, request->signed_trx.get_signature_keys(_context->config.chain_id), nullptr);
+				if (check_auth && !(_context->skip_flags & Config::skip_authority_check))
+					utils::check_authorization(_context->block_db, request->signed_trx.messages, request->get_signature_keys(_context->config.chain_id), nullptr);
 
 				Impl.exec();
 
@@ -552,11 +651,19 @@ namespace Xmaxplatform { namespace Chain {
 
 				transfer_gas(_context->block_db, request, gas_used);
 
-				record_transaction(request->signed_trx);
+				record_transaction(*request);
 
 				response = Impl.get_response();
 
-				response->receipt = apply_transaction_receipt(request->signed_trx);
+				{
+					const auto& obj = _context->block_db.get<global_msg_status_object>();
+					Impl.assign_message_indexes(obj.counter + 1);
+					_context->block_db.modify(obj, [&](auto& mrs) {
+						mrs.counter += Impl.msg_receipts.size();
+					});
+				}
+
+				response->receipt = apply_transaction_receipt(*request);
 
 				Impl.squash();
 				fc::move_append(_context->building_block->message_receipts, std::move(Impl.msg_receipts));
@@ -586,11 +693,11 @@ namespace Xmaxplatform { namespace Chain {
 
 			return response;
 		}
-		transaction_receipt& chain_xmax::apply_transaction_receipt(const signed_transaction& trx)
+		transaction_receipt& chain_xmax::apply_transaction_receipt(const transaction_request& request)
 		{
 			block_pack& block_pk = *_context->building_block->pack;
 
-			block_pk.block->receipts.emplace_back(transaction_receipt(transaction_package(trx)));
+			block_pk.block->receipts.emplace_back(transaction_receipt(request.package));
 
 			transaction_receipt& receipt = block_pk.block->receipts.back();
 			uint64_t idx = 0;
@@ -610,7 +717,8 @@ namespace Xmaxplatform { namespace Chain {
 		
 		void chain_xmax::push_confirmation(const block_confirmation& conf)
 		{
-			process_confirmation(conf);
+			_context->confirmations.post(conf);
+			process_confirmations();
 		}
 
 		//--------------------------------------------------
@@ -625,6 +733,191 @@ namespace Xmaxplatform { namespace Chain {
 			_context->block_db.flush();
 		}
 
+		static fc::path replay_marker_path(const chain_xmax::xmax_config& config)
+		{
+			return config.block_memory_dir / "replay.marker";
+		}
+
+		bool chain_xmax::prepare_replay(const xmax_config& config)
+		{
+			// a crash leaves nothing to resume from.
+			if (fc::exists(replay_marker_path(config)) && database::closed_cleanly(config.block_memory_dir))
+			{
+				ilog("resume the interrupted replay in ${dir}", ("dir", config.block_memory_dir.generic_string()));
+				return true;
+			}
+
+			ilog("clear chain state in ${dir} for replay", ("dir", config.block_memory_dir.generic_string()));
+			for (const char* name : { "shared_memory.bin", "shared_memory.meta", "fork_memory.bin", "fork_journal.bin" })
+			{
+				fc::remove_all(config.block_memory_dir / name);
+			}
+
+			fc::create_directories(config.block_memory_dir);
+			std::ofstream(replay_marker_path(config).generic_string().c_str(), std::ios::out | std::ios::trunc);
+			return false;
+		}
+
+		uint32_t chain_xmax::replay(const replay_options& options)
+		{
+			const int64_t last_num = _context->chain_log.last_block_num();
+			const uint32_t start_num = head_block_num() + 1;
+
+			FC_ASSERT(_context->chain_log.first_block_num() <= start_num,
+				"the block log was pruned, block ${num} can not be replayed", ("num", start_num));
+
+			auto old_flags = _context->skip_flags;
+			auto restore = fc::make_scoped_exit([&]() {
+				_context->skip_flags = old_flags;
+				_context->replaying = false;
+				_context->chain_log.advise_sequential(false);
+				_context->block_db.advise(database::access_normal);
+			});
+			if (options.trusted)
+			{
+				_context->skip_flags |= Config::skip_producer_signature
+					| Config::skip_transaction_signatures
+					| Config::skip_tapos_check
+					| Config::skip_authority_check;
+			}
+			_context->replaying = true;
+
+			// the block log is read front to back, the state is hit at random and readahead around each fault is wasted.
+			_context->chain_log.advise_sequential(true);
+			_context->block_db.advise(database::access_random);
+
+			ilog("replay blocks ${first} to ${last} from the block log${trusted}",
+				("first", start_num)("last", last_num)("trusted", options.trusted ? ", trusted" : ""));
+
+			auto checkpoint = [&]() {
+				_context->block_db.flush();
+				_context->fork_db.close();
+			};
+
+			const auto replay_start = std::chrono::steady_clock::now();
+			auto report_start = replay_start;
+			uint32_t report_count = 0;
+			uint32_t applied = 0;
+			for (int64_t num = start_num; num <= last_num; ++num)
+			{
+				signed_block_ptr block = _context->chain_log.read_block(num);
+				FC_ASSERT(block, "block ${num} is missing from the block log", ("num", num));
+
+				block_pack_ptr pack = _apply_block(block, true);
+
+				// blocks in the log are irreversible already.
+				_context->fork_db.force_confirm(pack->block_id, pack->block_num);
+
+				++applied;
+				++report_count;
+				if (options.checkpoint_blocks > 0 && num % options.checkpoint_blocks == 0)
+				{
+					checkpoint();
+				}
+
+				auto now = std::chrono::steady_clock::now();
+				double seconds = std::chrono::duration<double>(now - report_start).count();
+				if (seconds >= options.report_seconds)
+				{
+					ilog("replay at block ${num} of ${last}, ${bps} blocks/s",
+						("num", num)("last", last_num)("bps", (uint64_t)(report_count / seconds)));
+					report_start = now;
+					report_count = 0;
+				}
+			}
+
+			checkpoint();
+			fc::remove_all(replay_marker_path(_context->config));
+
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+			ilog("replayed ${count} blocks in ${sec} s, ${bps} blocks/s",
+				("count", applied)("sec", (uint64_t)seconds)("bps", seconds > 0 ? (uint64_t)(applied / seconds) : applied));
+			return applied;
+		}
+
+		uint64_t chain_xmax::export_snapshot(const fc::path& file)
+		{
+			// the chain does not take the database write lock, a block in progress would be torn.
+			FC_ASSERT(!_context->building_block, "can not export a snapshot while a block is being built");
+
+			const auto start = std::chrono::steady_clock::now();
+
+			// a node started from the snapshot takes its root as irreversible. the reversible blocks stay applied,
+			// the state is written as it was at the last irreversible block from the undo history they left.
+			const uint32_t lib_num = _context->last_irreversible_block_num;
+			block_pack_ptr root = _context->fork_db.get_main_block_by_num(lib_num);
+			FC_ASSERT(root, "last irreversible block ${num} is not in the fork database", ("num", lib_num));
+
+			snapshot_header header;
+			header.chain_id = _context->config.chain_id;
+			header.block_num = root->block_num;
+			header.block_id = root->block_id;
+
+			fc::path temp = file.generic_string() + ".tmp";
+			uint64_t size = _context->block_db.with_read_lock([&]() {
+				return write_snapshot(temp, _context->block_db, header, *root);
+			});
+			fc::rename(temp, file);
+
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			ilog("exported snapshot of block ${num} to ${file}, ${size} bytes in ${ms} ms, head at block ${head}",
+				("num", header.block_num)("file", file.generic_string())("size", size)("ms", (uint64_t)(seconds * 1000))("head", head_block_num()));
+			return size;
+		}
+
+		uint32_t chain_xmax::import_snapshot(const xmax_config& config, const fc::path& file)
+		{
+			FC_ASSERT(fc::exists(file), "snapshot ${file} does not exist", ("file", file.generic_string()));
+
+			ilog("clear chain state in ${dir} for snapshot ${file}",
+				("dir", config.block_memory_dir.generic_string())("file", file.generic_string()));
+			for (const char* name : { "shared_memory.bin", "shared_memory.meta", "fork_memory.bin", "fork_journal.bin", "replay.marker" })
+			{
+				fc::remove_all(config.block_memory_dir / name);
+			}
+			fc::create_directories(config.block_memory_dir);
+
+			const auto start = std::chrono::steady_clock::now();
+
+			block_pack_ptr root = std::make_shared<block_pack>();
+			snapshot_header header;
+			{
+				database db(config.block_memory_dir, database::read_write, config.shared_memory_size);
+				db.set_state_version(Config::chain_state_version);
+				setup_xmax_indexes(db);
+
+				header = read_snapshot(file, db, *root);
+				FC_ASSERT(header.chain_id == config.chain_id, "snapshot is from another chain",
+					("snapshot", header.chain_id)("config", config.chain_id));
+
+				db.set_revision(header.block_num);
+				db.flush();
+			}
+
+			// a block log holding the snapshot block goes on, any other starts over after it.
+			{
+				chain_stream log(config.block_log_dir, config.block_log);
+				signed_block_ptr logged = log.last_block_num() >= header.block_num ? log.read_block(header.block_num) : signed_block_ptr();
+				if (!logged || logged->id() != header.block_id)
+				{
+					log.reset_after(header.block_num);
+				}
+			}
+
+			// the root becomes the only, irreversible block of the fork db, initialize_impl starts from there.
+			root->main_chain = true;
+			root->irreversible_confirmed = true;
+			{
+				forkdatabase fork_db(config.block_memory_dir);
+				fork_db.add_block(root);
+				fork_db.close();
+			}
+
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			ilog("imported snapshot of block ${num} in ${ms} ms", ("num", header.block_num)("ms", (uint64_t)(seconds * 1000)));
+			return header.block_num;
+		}
+
 		block_pack_ptr chain_xmax::build_block(
                 chain_timestamp when,
 				const private_key_type& sign_private_key
@@ -699,25 +992,31 @@ namespace Xmaxplatform { namespace Chain {
 			
 		}
 
-		block_pack_ptr chain_xmax::_apply_block(signed_block_ptr block, bool updatefork)
+		block_pack_ptr chain_xmax::_apply_block(signed_block_ptr block, bool updatefork, const block_pack_ptr& known)
 		{
-			_validate_block_desc(block);
-
-			vector<transaction_request_ptr> transactions;
+			// a block this node validated before keeps its requests, keys and merkle root, the checks passed on the same state.
+			const bool cached = known && known->block == block && known->has_validated_cache();
 
-			for (auto trx : block->receipts)
+			auto old_flags = _context->skip_flags;
+			auto restore_flags = fc::make_scoped_exit([&]() {
+				_context->skip_flags = old_flags;
+			});
+			if (cached)
 			{
-				if (trx.trx.contains<transaction_package>())
-				{
-					const auto& package = trx.trx.get<transaction_package>();
-					transactions.push_back(std::make_shared<transaction_request>(package));
-				}
-				else
-				{
-					XMAX_ASSERT(false, block_validate_exception, "encountered unexpected package type.");
-				}
+				_context->skip_flags |= Config::skip_producer_signature
+					| Config::skip_transaction_signatures
+					| Config::skip_tapos_check
+					| Config::skip_authority_check;
 			}
 
+			_validate_block_desc(block);
+
+			vector<transaction_request_ptr> transactions = cached ? known->transactions : block_pack::make_requests(*block);
+
+			// keys of later transactions are recovered while the earlier ones apply.
+			if (!(_context->skip_flags & Config::skip_transaction_signatures))
+				_context->recovery.post(transactions);
+
 			auto exec_start = std::chrono::high_resolution_clock::now();
 			_abort_build();
 
@@ -728,7 +1027,10 @@ namespace Xmaxplatform { namespace Chain {
 				apply_transaction(request);
 			}
 
-			_generate_block();
+			if (cached)
+				_context->building_block->pack->new_header.trxs_mroot = known->new_header.trxs_mroot;
+			else
+				_generate_block();
 
 			_validate_block(block);
 
@@ -739,14 +1041,18 @@ namespace Xmaxplatform { namespace Chain {
 
 			const auto& new_block = _context->building_block->pack->block;
 
-			ilog("apply block #${num} of '${builder}' at ${time}, exectime_ms=${extm}, trxs=${trxs}, msgs=${msgs}",
-				("builder", new_block->builder)
-				("time", new_block->timestamp)
-				("num", new_block->block_num())
-				("extm", exec_ms.count())
-				("trxs", _context->building_status.trx_counter)
-				("msgs", _context->building_status.msg_counter)
-			);
+			// a replay reports progress by itself.
+			if (!_context->replaying)
+			{
+				ilog("apply block #${num} of '${builder}' at ${time}, exectime_ms=${extm}, trxs=${trxs}, msgs=${msgs}",
+					("builder", new_block->builder)
+					("time", new_block->timestamp)
+					("num", new_block->block_num())
+					("extm", exec_ms.count())
+					("trxs", _context->building_status.trx_counter)
+					("msgs", _context->building_status.msg_counter)
+				);
+			}
 
 
 			_push_block(updatefork);
@@ -804,7 +1110,11 @@ namespace Xmaxplatform { namespace Chain {
 					try
 					{
 						block_pack_ptr pack = *rit;
-						_apply_block(pack->block, false);
+						block_pack_ptr applied = _apply_block(pack->block, false, pack);
+
+						// switching back to this branch later skips the checks done now.
+						pack->transactions = applied->transactions;
+						pack->validated = true;
 						_context->block_head = pack;
 						_context->fork_db.change_main_chain_flag((*rit)->block_id, true);
 					}
@@ -856,6 +1166,9 @@ namespace Xmaxplatform { namespace Chain {
 				_context->building_block.reset();
 			});
 
+			// confirmations the worker verified since the last one.
+			process_confirmations();
+
 			_context->start();
 
 			try {
@@ -945,7 +1258,8 @@ namespace Xmaxplatform { namespace Chain {
 
 			const builder_object* builder = find_builder_object(block->builder);
 
-			FC_ASSERT(block->is_signer_valid(builder->signing_key), "bad block, sign data is not  from the key '${key}'", ("key", builder->signing_key.operator fc::string()));
+			if (!(_context->skip_flags & Config::skip_producer_signature))
+				FC_ASSERT(block->is_signer_valid(builder->signing_key), "bad block, sign data is not  from the key '${key}'", ("key", builder->signing_key.operator fc::string()));
 		}
 
 		void chain_xmax::_validate_block(const signed_block_ptr next_block)
@@ -1022,6 +1336,10 @@ namespace Xmaxplatform { namespace Chain {
 				_context->building_block->push_db();
 				_context->building_block.reset();
 
+				// transactions the block included or outlived are no longer pending.
+				_context->pending_transactions.remove_included(*new_block);
+				_context->pending_transactions.remove_expired(new_block->timestamp.time_point());
+
 			} FC_CAPTURE_AND_RETHROW((new_block->block_num()))
 		
 		}
@@ -1083,6 +1401,9 @@ namespace Xmaxplatform { namespace Chain {
 			}
 
 
+			// transactions expired before this block can no longer be applied, drop their dedup records.
+			utils::prune_expired_transactions(_context->block_db, last_block.timestamp.time_point(), Config::max_transaction_prune_per_block);
+
             // update dynamic states
             _context->block_db.modify( dy_state, [&]( dynamic_states_object& dgp ){
                 dgp.head_block_number = last_block.block_num();
@@ -1098,15 +1419,44 @@ namespace Xmaxplatform { namespace Chain {
 				
         }
 
+		// segment usage and the largest indices.
+		static void log_state_stats(const database& db)
+		{
+			const uint64_t mb = 1024 * 1024;
+			const Basechain::segment_stats segment = db.get_segment_stats();
+			std::vector<Basechain::index_stats> indices = db.get_index_stats();
+			std::sort(indices.begin(), indices.end(), [](const Basechain::index_stats& a, const Basechain::index_stats& b) {
+				return a.approx_bytes > b.approx_bytes;
+			});
+
+			std::string largest;
+			for (size_t i = 0; i < indices.size() && i < 5; ++i)
+			{
+				largest += (i ? ", " : "") + indices[i].type_name + " " + std::to_string(indices[i].object_count)
+					+ " objects " + std::to_string(indices[i].approx_bytes / mb) + " MB";
+			}
+			ilog("chain state ${used} of ${size} MB used, undo depth ${depth}, largest: ${largest}",
+				("used", segment.used / mb)("size", segment.size / mb)
+				("depth", indices.empty() ? 0 : indices.front().undo_sessions.size())("largest", largest));
+		}
+
 		void chain_xmax::_irreversible_block(const block_pack_ptr& pack)
 		{
  			uint32_t block_num = pack->block->block_num();
 
 			_context->last_irreversible_block_num = block_num;
 
-			_context->chain_log.append_block(pack->block);
+			// a replayed block is in the log already.
+			if (block_num > _context->chain_log.last_block_num())
+				_context->chain_log.append_block(pack->block);
 
 			_context->block_db.commit(block_num);
+			_context->block_db.request_flush();
+
+			if (_context->config.state_stats_log_blocks && block_num % _context->config.state_stats_log_blocks == 0)
+			{
+				log_state_stats(_context->block_db);
+			}
 
 			if (_context->config.irreversible_log)
 			{
@@ -1116,10 +1466,22 @@ namespace Xmaxplatform { namespace Chain {
 
 		void chain_xmax::on_irreversible(block_pack_ptr pack)
 		{
-			auto pre_block = _context->chain_log.get_head();
+			if (pack->block_num <= _context->chain_log.last_block_num())
+			{
+				auto logged = _context->chain_log.read_block(pack->block_num);
+				FC_ASSERT(!logged || logged->id() == pack->block_id, "irreversible block differs from the block log", ("num", pack->block_num));
+			}
+			else
+			{
+				FC_ASSERT(pack->block_num == _context->chain_log.last_block_num() + 1, "error block",
+					("new block number", pack->block_num)("pre block number", _context->chain_log.last_block_num()));
 
-			FC_ASSERT(pack->block_num - 1 == pre_block->block_num(), "error block", ("new block number", pack->block_num)("pre block number", pre_block->block_num()));
-			FC_ASSERT(pack->block->previous == pre_block->id(), "new block doesn't link to pre block head");
+				// a log restarted after a snapshot has no block to link to yet, the fork db linked it to the snapshot root.
+				if (auto pre_block = _context->chain_log.get_head())
+				{
+					FC_ASSERT(pack->block->previous == pre_block->id(), "new block doesn't link to pre block head");
+				}
+			}
 
 			_irreversible_block(pack);
 		}
@@ -1171,9 +1533,9 @@ namespace Xmaxplatform { namespace Chain {
 			}
 
 			const auto& code_account = _context->block_db.get<account_object, by_name>(code);
-			if (code_account.contract)
+			if (const code_object* contract = find_account_code(_context->block_db, code_account))
 			{
-				return (Basetypes::abi_serializer::to_abi(code_account.contract->abi, abi));
+				return (Basetypes::abi_serializer::to_abi(contract->abi, abi));
 			}
 			return false;
 		}
@@ -1187,23 +1549,44 @@ namespace Xmaxplatform { namespace Chain {
 			return nullptr;
 		}
 
-		void chain_xmax::process_confirmation(const block_confirmation& conf)
+		// worker thread: the verified confirmations are taken on the apply thread right away instead of at the next push or block.
+		void chain_xmax::_wake_for_confirmations()
 		{
-			_context->fork_db.add_confirmation(conf, _context->skip_flags);
+			if (!_context->config.post_apply)
+				return;
+
+			std::weak_ptr<bool> alive = _context->alive;
+			_context->config.post_apply([this, alive]() {
+				if (alive.lock())
+					process_confirmations();
+			});
+		}
+
+		void chain_xmax::process_confirmations()
+		{
+			for (const auto& item : _context->confirmations.take())
+			{
+				try {
+					_context->fork_db.add_confirmation(item.conf, item.signer, _context->skip_flags);
+				}
+				catch (const fc::exception& e) {
+					wlog("drop confirmation of ${id} by ${v}: ${e}", ("id", item.conf.block_id)("v", item.conf.verifier)("e", e.to_string()));
+				}
+			}
 		}
 
-		void chain_xmax::validate_uniqueness(const Chain::signed_transaction& trx)const {
+		void chain_xmax::validate_uniqueness(const xmax_type_transaction_id& trx_id)const {
 			if (!should_check_for_duplicate_transactions()) return;
 
-			auto transaction = _context->block_db.find<transaction_object, by_trx_id>(trx.id());
+			auto transaction = _context->block_db.find<transaction_object, by_trx_id>(trx_id);
 			XMAX_ASSERT(transaction == nullptr, tx_duplicate, "Transaction is not unique");
 		}
 
-		void chain_xmax::record_transaction(const Chain::signed_transaction& trx) {
+		void chain_xmax::record_transaction(const transaction_request& request) {
 			//Insert transaction into unique transactions database.
 			_context->block_db.create<transaction_object>([&](transaction_object& transaction) {
-				transaction.trx_id = trx.id(); /// TODO: consider caching ID
-				transaction.expiration = trx.expiration;
+				transaction.trx_id = request.id;
+				transaction.expiration = request.signed_trx.expiration;
 			});
 		}
 
@@ -1272,7 +1655,7 @@ namespace Xmaxplatform { namespace Chain {
 				validate_expiration(request->signed_trx);
 				validate_tapos(request->signed_trx);
 				validate_referenced_accounts(request->signed_trx);
-				validate_uniqueness(request->signed_trx);
+				validate_uniqueness(request->id);
 
 				return true;
 			} FC_CAPTURE_AND_LOG((request->signed_trx))
@@ -1403,30 +1786,39 @@ namespace Xmaxplatform { namespace Chain {
 		}
 
 
-		vector<signed_block> chain_xmax::get_syncblock_from_lastnum(const uint32_t& lastnum)
+		uint32_t chain_xmax::for_each_block(uint32_t first, uint32_t last, const std::function<bool(const signed_block_ptr&)>& visit) const
 		{
-			vector<signed_block> blockList;
-			uint32_t currNum = _context->block_head->block_num;
-			blockList.reserve(currNum - lastnum + 1);
-			while (currNum)
-			{	
-	
-				if (lastnum < currNum)
-				{
-					signed_block_ptr pSb = block_from_num(currNum);
-					blockList.insert(blockList.begin(), *pSb);
-					currNum--;
-				}
-				else
-				{
-					break;
-				}
-			}
+			last = std::min(last, head_block_num());
+			if (first > last)
+				return 0;
 
-			FC_ASSERT(blockList.size() > 0);
+			uint32_t next = first;
+			bool more = true;
 
-			return blockList;
-			
+			const int64_t logged = std::min<int64_t>(last, _context->chain_log.last_block_num());
+			if (first <= logged)
+			{
+				// the log only clamps the range, a caller asking for pruned blocks has to be told.
+				XMAX_ASSERT(first >= _context->chain_log.first_block_num(), unknown_block_exception,
+					"blocks before ${log_first} are not in the block log, ${first} was asked for",
+					("log_first", _context->chain_log.first_block_num())("first", first));
+
+				_context->chain_log.for_each_block(first, (uint32_t)logged, [&](const signed_block_ptr& block) {
+					++next;
+					return more = visit(block);
+				});
+			}
+
+			// blocks past the log are reversible, only the main chain is sent.
+			while (more && next <= last && next > logged)
+			{
+				block_pack_ptr pack = _context->fork_db.get_main_block_by_num(next);
+				if (!pack)
+					break;
+				++next;
+				more = visit(pack->block);
+			}
+			return next - first;
 		}
 
 		const uint32_t chain_xmax::block_max_message_count = 500;
@@ -1434,20 +1826,10 @@ namespace Xmaxplatform { namespace Chain {
 		void chain_xmax::select_transactions_by_gas()
 		{
 			_selected_transaction_count = 0;
-			uint32_t _selected_message_count = 0;
-			while (!_context->pending_transactions.empty())
+			for (const transaction_request_ptr& request : _context->pending_transactions.select_by_gas(chain_xmax::block_max_message_count))
 			{
-				transaction_request_ptr top = _context->pending_transactions.top();
-
-				if (_selected_message_count + top->signed_trx.messages.size()>chain_xmax::block_max_message_count)
-				{
-					break;
-				}
-				_selected_transaction_pool[_selected_transaction_count] = top;
+				_selected_transaction_pool[_selected_transaction_count] = request;
 				_selected_transaction_count++;
-				_selected_message_count += top->signed_trx.messages.size();
-				_context->pending_transactions.pop();
-
 			}
 		}
 
@@ -0,0 +1,130 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <fc/log/logger.hpp>
+
+#include <confirmation_verifier.hpp>
+
+namespace Xmaxplatform { namespace Chain {
+
+	class confirmation_verifier_context
+	{
+	public:
+		std::thread							worker;
+		std::function<void()>				on_verified;
+
+		mutable std::mutex					queue_mutex;
+		std::condition_variable				queue_cond;
+		std::vector<block_confirmation>		queue;
+		std::vector<verified_confirmation>	verified;
+		size_t								verifying = 0;
+		bool								stopping = false;
+
+		static std::vector<verified_confirmation> verify(std::vector<block_confirmation>& batch)
+		{
+			std::vector<verified_confirmation> result;
+			result.reserve(batch.size());
+			for (auto& conf : batch)
+			{
+				verified_confirmation item;
+				try {
+					item.signer = public_key_type(conf.get_signer_key());
+				}
+				catch (const fc::exception& e) {
+					// the empty signer fails the check against the builder key.
+					dlog("confirmation of ${id} by ${v} has a bad signature: ${e}", ("id", conf.block_id)("v", conf.verifier)("e", e.to_string()));
+				}
+				item.conf = std::move(conf);
+				result.push_back(std::move(item));
+			}
+			return result;
+		}
+
+		void work()
+		{
+			for (;;)
+			{
+				std::vector<block_confirmation> batch;
+				{
+					std::unique_lock<std::mutex> lock(queue_mutex);
+					queue_cond.wait(lock, [this]() { return stopping || !queue.empty(); });
+					if (stopping)
+						return;
+					batch.swap(queue);
+					verifying = batch.size();
+				}
+
+				auto result = verify(batch);
+				{
+					std::lock_guard<std::mutex> lock(queue_mutex);
+					verified.insert(verified.end(), std::make_move_iterator(result.begin()), std::make_move_iterator(result.end()));
+					verifying = 0;
+				}
+
+				if (on_verified)
+					on_verified();
+			}
+		}
+	};
+
+	confirmation_verifier::confirmation_verifier(bool worker, const std::function<void()>& on_verified)
+		: _context(new confirmation_verifier_context())
+	{
+		_context->on_verified = on_verified;
+		if (worker)
+		{
+			_context->worker = std::thread([this]() { _context->work(); });
+		}
+	}
+
+	confirmation_verifier::~confirmation_verifier()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_context->queue_mutex);
+			_context->stopping = true;
+		}
+		_context->queue_cond.notify_all();
+		if (_context->worker.joinable())
+			_context->worker.join();
+	}
+
+	void confirmation_verifier::post(const block_confirmation& conf)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_context->queue_mutex);
+			_context->queue.push_back(conf);
+		}
+		_context->queue_cond.notify_one();
+	}
+
+	std::vector<verified_confirmation> confirmation_verifier::take()
+	{
+		std::vector<verified_confirmation> result;
+		if (!_context->worker.joinable())
+		{
+			std::vector<block_confirmation> batch;
+			{
+				std::lock_guard<std::mutex> lock(_context->queue_mutex);
+				batch.swap(_context->queue);
+			}
+			return confirmation_verifier_context::verify(batch);
+		}
+
+		std::lock_guard<std::mutex> lock(_context->queue_mutex);
+		result.swap(_context->verified);
+		return result;
+	}
+
+	size_t confirmation_verifier::pending() const
+	{
+		std::lock_guard<std::mutex> lock(_context->queue_mutex);
+		return _context->queue.size() + _context->verifying;
+	}
+
+}
+}
@@ -10,6 +10,7 @@
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/composite_key.hpp>
 
+#include <fstream>
 #include <fc/io/fstream.hpp>
 #include <fc/reflect/reflect.hpp>
 
@@ -29,9 +30,32 @@ namespace Chain {
 			size = 0;
 		}
 	};
+
+	//
+	// ----------- fork journal -------------------------
+	// [record 1] ... [record n], record: [type][payload size][payload]
+	// every change of the fork db is appended, a restart replays the records in order.
+	// the journal is rewritten from the live packs once it holds far more records than packs.
+	//
+	enum fork_journal_type : uint8_t
+	{
+		journal_pack = 1,		// block_pack, added or changed.
+		journal_remove,			// block id.
+		journal_confirm,		// block id, passed to set_last_confirmed.
+		journal_main_chain,		// fork_journal_flag.
+		journal_irreversible,	// block id.
+		journal_confirmation,	// block_confirmation, checked already, added to its pack.
+	};
+
+	struct fork_journal_flag
+	{
+		xmax_type_block_id	block_id;
+		bool				main_chain = false;
+	};
 }
 }
 FC_REFLECT(Xmaxplatform::Chain::fork_db_head, (size)(head_id))
+FC_REFLECT(Xmaxplatform::Chain::fork_journal_flag, (block_id)(main_chain))
 
 
 namespace Xmaxplatform {
@@ -78,7 +102,9 @@ namespace Chain {
 		fc::path				datadir;
 		irreversible_block_handle irreversible;
 
-		std::vector<block_pack_ptr> allblocks; // for test..
+		std::ofstream			journal;
+		uint64_t				journal_records = 0;
+		bool					restoring = false;
 
 		block_pack_ptr get_block(xmax_type_block_id block_id) const
 		{
@@ -106,8 +132,7 @@ namespace Chain {
 			auto result = packs.insert(block_pack);
 			FC_ASSERT(result.second, "unable to insert block state, duplicate state detected");
 
-
-			allblocks.push_back(block_pack);
+			append(journal_pack, *block_pack);
 
 			update_head();
 
@@ -164,11 +189,13 @@ namespace Chain {
 				if (itr != packs.end())
 				{
 					packs.erase(itr);
+					append(journal_remove, remove_blocks[i]);
 				}
 
-				auto& child = idx.lower_bound(remove_blocks[i]);
+				auto child = idx.lower_bound(remove_blocks[i]);
+				auto last = idx.upper_bound(remove_blocks[i]);
 
-				while (child != idx.end())
+				while (child != last)
 				{
 					remove_blocks.push_back((*child)->block_id);
 					++child;
@@ -196,6 +223,8 @@ namespace Chain {
 
 			FC_ASSERT(confirmed_pack != packs.end(), "unknown block id ${id}", ("id", last_id));
 
+			append(journal_confirm, last_id);
+
 			Chain::xmax_type_block_num block_num = (*confirmed_pack)->block_num;
 
 			packs.modify(confirmed_pack, [&](auto& val)
@@ -290,6 +319,7 @@ namespace Chain {
 				irreversible(ptr);
 
 				ptr->irreversible_confirmed = true;
+				append(journal_irreversible, it);
 			}
 
 			// remove blocks no need.
@@ -299,40 +329,219 @@ namespace Chain {
 				if (itr != packs.end())
 				{
 					packs.erase(itr);
+					append(journal_remove, it);
 				}
 			}
 
 		}
-	};
 
+		// a new confirmation of block_pack, confirmed once 2/3 of its builders did.
+		void on_confirmation(const block_pack_ptr& block_pack, const block_confirmation& conf)
+		{
+			append(journal_confirmation, conf);
+			if (block_pack->enough_confirmation())
+			{
+				if (block_pack->last_confirmed_num < block_pack->block_num)
+				{
+					set_last_confirmed(block_pack->block_id);
+				}
+			}
+			commit_journal();
+		}
+
+		void change_main_chain_flag(block_pack_index::iterator it, bool main_chain_flag)
+		{
+			// modify can trigger re-sort of Boost MultiIndex.
+			packs.modify(it, [&main_chain_flag](block_pack_ptr& p) {
+				p->main_chain = main_chain_flag;
+			});
 
-	forkdatabase::forkdatabase(const fc::path& data_dir)
-		: _context(std::make_unique<fork_context>())
-	{
-		_context->datadir = data_dir;
+			fork_journal_flag flag;
+			flag.block_id = (*it)->block_id;
+			flag.main_chain = main_chain_flag;
+			append(journal_main_chain, flag);
+		}
 
-		if (!fc::is_directory(_context->datadir))
-			fc::create_directories(_context->datadir);
+		fc::path journal_path() const
+		{
+			return boost::filesystem::absolute(datadir / "fork_journal.bin");
+		}
 
-		auto abs_path = boost::filesystem::absolute(_context->datadir / "fork_memory.bin");
-		if (fc::exists(abs_path)) {
+		template<typename T>
+		void append(fork_journal_type type, const T& value)
+		{
+			if (restoring || !journal.is_open())
+				return;
+
+			std::vector<char> payload = fc::raw::pack(value);
+			fc::raw::pack(journal, uint8_t(type));
+			fc::raw::pack(journal, uint32_t(payload.size()));
+			journal.write(payload.data(), payload.size());
+			++journal_records;
+		}
+
+		// end of a change from outside, the records reach the file before the caller goes on.
+		void commit_journal()
+		{
+			if (!journal.is_open())
+				return;
+
+			journal.flush();
+			FC_ASSERT(journal.good(), "unable to write ${file}", ("file", journal_path().generic_string()));
+
+			// every block leaves a few records behind, the packs they describe are pruned long ago.
+			if (journal_records > packs.size() * 8 + 1024)
+				compact_journal();
+		}
+
+		// replace the journal by one record per live pack.
+		void compact_journal()
+		{
+			const fc::path file = journal_path();
+			fc::path tmp = file;
+			tmp.replace_extension(".tmp");
+
+			if (journal.is_open())
+				journal.close();
+
+			journal.open(tmp.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			journal_records = 0;
+			for (const auto& b : packs)
+			{
+				append(journal_pack, *b);
+			}
+			journal.flush();
+			FC_ASSERT(journal.good(), "unable to write ${file}", ("file", tmp.generic_string()));
+			journal.close();
+			boost::filesystem::rename(tmp, file);
+
+			journal.open(file.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app);
+		}
+
+		// replay the journal, a torn tail from a crash is cut off.
+		void restore_journal()
+		{
+			const fc::path file = journal_path();
 			string content;
-			fc::read_file_contents(abs_path, content);
+			fc::read_file_contents(file, content);
 
-			fc::datastream<const char*> ds(content.data(), content.size());
+			restoring = true;
+			uint64_t good = 0;
+			try
+			{
+				fc::datastream<const char*> ds(content.data(), content.size());
+				while (ds.remaining() > 0)
+				{
+					uint8_t type = 0;
+					uint32_t size = 0;
+					fc::raw::unpack(ds, type);
+					fc::raw::unpack(ds, size);
+					FC_ASSERT(size <= ds.remaining(), "torn record");
+
+					fc::datastream<const char*> rs(ds.pos(), size);
+					apply_record(type, rs);
+					ds.skip(size);
+
+					good = ds.tellp();
+					++journal_records;
+				}
+			}
+			catch (const fc::exception& e)
+			{
+				elog("${e}", ("e", e.to_detail_string()));
+				elog("dirty fork journal, drop ${n} bytes from the tail.", ("n", content.size() - good));
+			}
+			restoring = false;
+
+			if (good < content.size())
+				boost::filesystem::resize_file(file, good);
+
+			if (!packs.empty())
+				update_head();
+		}
+
+		void apply_record(uint8_t type, fc::datastream<const char*>& ds)
+		{
+			switch (type)
+			{
+			case journal_pack:
+			{
+				auto pack = std::make_shared<block_pack>();
+				fc::raw::unpack(ds, *pack);
+				auto itr = packs.find(pack->block_id);
+				if (itr != packs.end())
+					packs.replace(itr, pack);
+				else
+					packs.insert(pack);
+				break;
+			}
+			case journal_remove:
+			{
+				xmax_type_block_id id;
+				fc::raw::unpack(ds, id);
+				auto itr = packs.find(id);
+				if (itr != packs.end())
+					packs.erase(itr);
+				break;
+			}
+			case journal_confirm:
+			{
+				xmax_type_block_id id;
+				fc::raw::unpack(ds, id);
+				set_last_confirmed(id);
+				break;
+			}
+			case journal_main_chain:
+			{
+				fork_journal_flag flag;
+				fc::raw::unpack(ds, flag);
+				auto itr = packs.find(flag.block_id);
+				FC_ASSERT(itr != packs.end(), "unknown block id ${id}", ("id", flag.block_id));
+				change_main_chain_flag(itr, flag.main_chain);
+				break;
+			}
+			case journal_irreversible:
+			{
+				xmax_type_block_id id;
+				fc::raw::unpack(ds, id);
+				auto ptr = get_block(id);
+				FC_ASSERT(ptr, "unknown block id ${id}", ("id", id));
+				ptr->irreversible_confirmed = true;
+				break;
+			}
+			case journal_confirmation:
+			{
+				block_confirmation conf;
+				fc::raw::unpack(ds, conf);
+				auto ptr = get_block(conf.block_id);
+				FC_ASSERT(ptr, "unknown block id ${id}", ("id", conf.block_id));
+				ptr->add_confirmation(conf, Config::skip_confirmation);
+				break;
+			}
+			default:
+				FC_ASSERT(false, "unknown fork journal record ${type}", ("type", type));
+			}
+		}
 
+		// fork_memory.bin of older versions held the whole fork db.
+		void load_legacy(const fc::path& file)
+		{
+			string content;
+			fc::read_file_contents(file, content);
+
+			fc::datastream<const char*> ds(content.data(), content.size());
 
 			try
 			{
-				fork_db_head head;
-				fc::raw::unpack(ds, head);
-				for (uint32_t i = 0, n = head.size; i < n; ++i) {
+				fork_db_head legacy_head;
+				fc::raw::unpack(ds, legacy_head);
+				for (uint32_t i = 0, n = legacy_head.size; i < n; ++i) {
 					block_pack s;
 					fc::raw::unpack(ds, s);
 
-					auto result = _context->packs.insert(std::make_shared<block_pack>(std::move(s)));
+					packs.insert(std::make_shared<block_pack>(std::move(s)));
 				}
-				_context->head = get_block(head.head_id);
+				head = get_block(legacy_head.head_id);
 
 			}
 			catch (const fc::out_of_range_exception& e)
@@ -341,29 +550,40 @@ namespace Chain {
 
 				elog("dirty fork db file.");
 			}
-
-			fc::remove(abs_path);
 		}
+	};
 
 
+	forkdatabase::forkdatabase(const fc::path& data_dir)
+		: _context(std::make_unique<fork_context>())
+	{
+		_context->datadir = data_dir;
+
+		if (!fc::is_directory(_context->datadir))
+			fc::create_directories(_context->datadir);
+
+		auto legacy_path = boost::filesystem::absolute(_context->datadir / "fork_memory.bin");
+		if (fc::exists(_context->journal_path())) {
+			_context->restore_journal();
+			_context->journal.open(_context->journal_path().generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app);
+		}
+		else if (fc::exists(legacy_path)) {
+			_context->load_legacy(legacy_path);
+			_context->compact_journal();
+		}
+		else {
+			_context->journal.open(_context->journal_path().generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		}
+		fc::remove(legacy_path);
+
+		FC_ASSERT(_context->journal.is_open(), "unable to open ${file}", ("file", _context->journal_path().generic_string()));
 	}
 
 	void forkdatabase::close()
 	{
-		if (_context->packs.size() == 0) 
-			return;
-		auto abs_path = boost::filesystem::absolute(_context->datadir / "fork_memory.bin");
-		std::ofstream file(abs_path.generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc);
-
-		fork_db_head head;
-		head.size = _context->packs.size();
-		head.head_id = _context->head->block_id;
-		fc::raw::pack(file, head);
-		for (auto b : _context->packs)
-		{
-			fc::raw::pack(file, *b);
-		}
-	
+		// the journal holds every change already, only the last records may still sit in the buffer.
+		if (_context->journal.is_open())
+			_context->journal.flush();
 	}
 
 	forkdatabase::~forkdatabase()
@@ -374,33 +594,40 @@ namespace Chain {
 	void forkdatabase::add_block(block_pack_ptr block_pack)
 	{
 		_context->add_block(block_pack);
+		_context->commit_journal();
 	}
 
 	block_pack_ptr forkdatabase::add_block(signed_block_ptr block)
 	{
-		return _context->add_block(block);
+		block_pack_ptr pack = _context->add_block(block);
+		_context->commit_journal();
+		return pack;
 	}
 
 	void forkdatabase::add_confirmation(const block_confirmation& conf, uint32_t skip)
 	{
 		auto block_pack = get_block(conf.block_id);
 		FC_ASSERT(block_pack, "Unknown block id ${id}", ("id", conf.block_id));
-		if (block_pack)
+		if (block_pack->add_confirmation(conf, skip))
 		{
-			block_pack->add_confirmation(conf, skip);
-			if (block_pack->enough_confirmation())
-			{
-				if (block_pack->last_confirmed_num < block_pack->block_num)
-				{
-					_context->set_last_confirmed(block_pack->block_id);
-				}
-			}
+			_context->on_confirmation(block_pack, conf);
+		}
+	}
+
+	void forkdatabase::add_confirmation(const block_confirmation& conf, const public_key_type& signer, uint32_t skip)
+	{
+		auto block_pack = get_block(conf.block_id);
+		FC_ASSERT(block_pack, "Unknown block id ${id}", ("id", conf.block_id));
+		if (block_pack->add_confirmation(conf, signer, skip))
+		{
+			_context->on_confirmation(block_pack, conf);
 		}
 	}
 
 	void forkdatabase::force_confirm(const xmax_type_block_id& last_confirmed_id, uint32_t last_confirmed_num)
 	{
 		_context->force_confirm(last_confirmed_id, last_confirmed_num);
+		_context->commit_journal();
 	}
 
 	block_pack_ptr forkdatabase::get_block(xmax_type_block_id block_id) const
@@ -418,9 +645,15 @@ namespace Chain {
 		return _context->head;
 	}
 
+	size_t forkdatabase::size() const
+	{
+		return _context->packs.size();
+	}
+
 	void forkdatabase::remove_chain(const xmax_type_block_id& begin_id)
 	{
 		_context->remove_chain(begin_id);
+		_context->commit_journal();
 	}
 
 	void forkdatabase::change_main_chain_flag(xmax_type_block_id id, bool main_chain_flag)
@@ -432,11 +665,8 @@ namespace Chain {
 		{
 			return;
 		}
-		// modify can trigger re-sort of Boost MultiIndex.
-		_context->packs.modify(it, [&main_chain_flag] (block_pack_ptr& p){
-			p->main_chain = main_chain_flag;
-		});
-
+		_context->change_main_chain_flag(it, main_chain_flag);
+		_context->commit_journal();
 	}
 
 	fetch_branch forkdatabase::fetch_branch_from_fork(const xmax_type_block_id& firstid, const xmax_type_block_id& secondid) const
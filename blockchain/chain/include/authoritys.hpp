@@ -12,6 +12,11 @@ namespace Chain {
 	struct permission_weight
 	{
 	public:
+		permission_weight()
+			: weight(0)
+		{
+
+		}
 		permission_weight(auth_weight w)
 			: weight(w)
 		{
@@ -24,6 +29,10 @@ namespace Chain {
 
 	struct key_permission : public permission_weight
 	{
+		key_permission()
+		{
+
+		}
 		key_permission(auth_weight w, const public_key_type& pk)
 			: permission_weight(w)
 			, key(pk)
@@ -35,6 +44,10 @@ namespace Chain {
 
 	struct account_auth
 	{
+		account_auth()
+		{
+
+		}
 		account_auth(account_name acc, authority_name per)
 			: account(acc), authority(per)
 		{
@@ -46,6 +59,10 @@ namespace Chain {
 
 	struct account_permission : public permission_weight
 	{
+		account_permission()
+		{
+
+		}
 		account_permission(auth_weight w, account_name acc, authority_name per)
 			: permission_weight(w)
 			, auth(acc, per)
@@ -82,4 +99,10 @@ namespace Chain {
 		mapped_vector<account_permission>	accounts;
 	};
 }
-}
\ No newline at end of file
+}
+
+FC_REFLECT(Xmaxplatform::Chain::permission_weight, (weight))
+FC_REFLECT_DERIVED(Xmaxplatform::Chain::key_permission, (Xmaxplatform::Chain::permission_weight), (key))
+FC_REFLECT(Xmaxplatform::Chain::account_auth, (account)(authority))
+FC_REFLECT_DERIVED(Xmaxplatform::Chain::account_permission, (Xmaxplatform::Chain::permission_weight), (auth))
+FC_REFLECT(Xmaxplatform::Chain::mapped_authoritys, (threshold)(keys)(accounts))
@@ -4,6 +4,8 @@
 */
 #pragma once
 
+#include <boost/dynamic_bitset.hpp>
+
 #include <block.hpp>
 #include <transaction_request.hpp>
 
@@ -50,15 +52,27 @@ namespace Chain {
 		xmax_type_block_id					dpos_irreversible_id;
 		std::vector<block_brief>			last_block_of_builders;
 
+		// bit i is set once builder i of current_builders confirmed. not packed, rebuilt from confirmations after an unpack.
+		boost::dynamic_bitset<>				confirmed_builders;
+
 		const xmax_type_block_id& prev_id() const
 		{
 			return new_header.previous;
 		}
 
-		void add_confirmation(const block_confirmation& conf, uint32_t skip);
+		// false for a second confirmation of the same builder.
+		bool add_confirmation(const block_confirmation& conf, uint32_t skip);
+
+		// signer was recovered from the signature already, e.g. by the confirmation_verifier.
+		bool add_confirmation(const block_confirmation& conf, const public_key_type& signer, uint32_t skip);
+
+		uint32_t required_confirmations() const;
 
 		bool enough_confirmation() const;
 
+	private:
+		int confirmation_index(const block_confirmation& conf);
+		void sync_confirmed_builders();
 	};
 
 	struct block_pack : public block_raw
@@ -82,6 +96,13 @@ namespace Chain {
 
 		void set_next_builders(const builder_rule& next);
 
+		// applied and checked by this node, transactions holds the requests with their keys recovered.
+		// a re-apply, e.g. when a fork switch comes back to this block, only replays the state transitions.
+		bool has_validated_cache() const;
+
+		// one request per transaction of the block, in block order.
+		static vector<transaction_request_ptr> make_requests(const signed_block& b);
+
 	private:
 		void set_dpos_irreversible(xmax_type_block_num num, const xmax_type_block_id& id);
 		void generate_dpos(const block_pack& pre_pack);
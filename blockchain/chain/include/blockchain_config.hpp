@@ -50,11 +50,15 @@ using fc::ecc::private_key;
         const static uint32 default_max_inline_msg_size = 4 * 1024;
         const static uint32 default_max_gen_trx_size = 64 * 1024;
 		const static uint32 max_message_apply_depth = 5;
+		const static uint32_t max_transaction_prune_per_block = 2000;	// expired dedup records swept per block.
+		const static uint32_t chain_state_version = 1;	// object layout in shared_memory.bin, 1: contracts moved to the code index.
 
         const static share_type initial_token_supply = asset::from_string("1000000000.00000000 SUP").amount;
 
         const static int default_per_code_account_max_db_limit_mbytes = 5;
         const static int default_row_overhead_db_limit_bytes = 8 + 8 + 8 + 8; // storage for scope/code/table + 8 extra
+        const static uint64_t default_wasm_module_cache_size = 512 * 1024 * 1024; // machine code and memory of instantiated contracts
+        const static uint64_t default_wasm_instruction_limit = 1000000; // weighted wasm operators a contract call may run
 
 
         const static uint32_t chain_timestamp_unit_ms = 1000;
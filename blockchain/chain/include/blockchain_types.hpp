@@ -187,6 +187,8 @@ namespace Xmaxplatform { namespace Chain {
 
 			global_trx_status_object_type,
 			global_msg_status_object_type,
+
+			code_object_type,
             OBJECT_TYPE_COUNT ///< Sentry value which contains the number of different object types
         };
    
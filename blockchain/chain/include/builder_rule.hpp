@@ -83,6 +83,19 @@ namespace Xmaxplatform { namespace Chain {
 			return empty_public_key;
 		}
 
+		// position of name in builders, -1 when it is not a builder of this rule.
+		int index_of(account_name name) const
+		{
+			for (int i = 0; i < (int)builders.size(); ++i)
+			{
+				if (builders[i].builder_name == name)
+				{
+					return i;
+				}
+			}
+			return -1;
+		}
+
     };
 
 	inline bool operator == (const builder_rule& a, const builder_rule& b)
@@ -151,3 +164,4 @@ namespace Xmaxplatform { namespace Chain {
 }}
 FC_REFLECT(Xmaxplatform::Chain::builder_info, (builder_name)(block_signing_key))
 FC_REFLECT(Xmaxplatform::Chain::builder_rule, (version)(builders))
+FC_REFLECT(Xmaxplatform::Chain::mapped_builder_rule, (version)(builders))
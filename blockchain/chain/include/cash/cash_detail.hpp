@@ -76,4 +76,9 @@ namespace Chain {
 	//}
 
 }
-}
\ No newline at end of file
+}
+
+FC_REFLECT_ENUM(Xmaxplatform::Chain::paytype, (pay_to_addr)(mint_to_addr))
+FC_REFLECT(Xmaxplatform::Chain::cash_input, (prevout)(slot))
+FC_REFLECT(Xmaxplatform::Chain::cash_output, (amount)(to))
+FC_REFLECT(Xmaxplatform::Chain::cash_attachment, (locktime))
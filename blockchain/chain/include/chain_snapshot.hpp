@@ -0,0 +1,127 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <fstream>
+#include <fc/filesystem.hpp>
+#include <fc/crypto/sha256.hpp>
+#include <blockchain_types.hpp>
+#include <block_pack.hpp>
+
+namespace Xmaxplatform { namespace Chain {
+
+	//
+	// ----------- snapshot file -------------------------
+	// [header][root block pack][section 1] ... [section n][end section][sha256]
+	// section: [section header][id 1][object 1] ... [id n][object n]
+	// everything is fc::raw, the sha256 covers all bytes before it.
+	// objects are written field by field from their reflection, so the file does not depend on
+	// the compiler, boost build or memory layout that produced shared_memory.bin.
+	//
+
+	static const uint32_t snapshot_magic = 0x70616e73;	// "snap"
+	static const uint32_t snapshot_version = 2;	// 2: contracts moved from accounts to the code index.
+	static const uint16_t snapshot_end_type = 0xffff;
+
+	struct snapshot_header
+	{
+		uint32_t			magic = snapshot_magic;
+		uint32_t			version = snapshot_version;
+		chain_id_type		chain_id;
+		uint32_t			block_num = 0;	// the last irreversible block, the state and the root block pack are at it.
+		xmax_type_block_id	block_id;
+		uint32_t			index_count = 0;
+	};
+
+	struct snapshot_section
+	{
+		uint16_t	type_id = snapshot_end_type;
+		int64_t		next_id = 0;	// id the index hands out next, removed tail objects leave a gap.
+		uint64_t	count = 0;
+	};
+
+	// buffered file output for fc::raw, hashes every byte it writes.
+	class snapshot_ostream
+	{
+	public:
+		snapshot_ostream(const fc::path& file);
+
+		void write(const char* data, size_t size);
+
+		bool put(char c)
+		{
+			write(&c, 1);
+			return true;
+		}
+
+		uint64_t tellp() const
+		{
+			return _total;
+		}
+
+		// append the checksum and close the file.
+		fc::sha256 finish();
+
+	private:
+		void flush_buffer();
+
+		std::ofstream			_file;
+		fc::sha256::encoder		_encoder;
+		std::vector<char>		_buffer;
+		size_t					_pos = 0;
+		uint64_t				_total = 0;
+	};
+
+	// buffered file input for fc::raw, hashes every byte it reads.
+	class snapshot_istream
+	{
+	public:
+		snapshot_istream(const fc::path& file);
+
+		void read(char* data, size_t size);
+
+		bool get(char& c)
+		{
+			read(&c, 1);
+			return true;
+		}
+
+		bool get(unsigned char& c)
+		{
+			return get(*(char*)&c);
+		}
+
+		uint64_t tellg() const
+		{
+			return _total;
+		}
+
+		// read the trailing checksum and compare it with the bytes read so far.
+		void finish();
+
+	private:
+		void fill_buffer();
+
+		std::ifstream			_file;
+		fc::sha256::encoder		_encoder;
+		std::vector<char>		_buffer;
+		size_t					_pos = 0;
+		size_t					_end = 0;
+		uint64_t				_total = 0;
+		uint64_t				_body_size = 0;
+	};
+
+	// write every registered index of db after header and root, the caller holds a read lock.
+	// the state goes out as it was at header.block_num, revisions above it stay in db untouched.
+	// returns the size of the file.
+	uint64_t write_snapshot(const fc::path& file, const Basechain::database& db, const snapshot_header& header, const block_pack& root);
+
+	// load a snapshot into the empty indices of db, objects keep their ids.
+	snapshot_header read_snapshot(const fc::path& file, Basechain::database& db, block_pack& root);
+
+}
+}
+
+FC_REFLECT(Xmaxplatform::Chain::snapshot_header, (magic)(version)(chain_id)(block_num)(block_id)(index_count))
+FC_REFLECT(Xmaxplatform::Chain::snapshot_section, (type_id)(next_id)(count))
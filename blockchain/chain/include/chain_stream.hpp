@@ -3,16 +3,18 @@
 *  @copyright defined in xmax/LICENSE
 */
 #pragma once
+#include <functional>
 #include <fc/filesystem.hpp>
 #include <block.hpp>
 
 namespace block_detail
 {
 	//
-	// ----------- block stream -------------------------
-	// [block 1][desc 1][eof][block 2][desc 2][eof] ... [block n][desc n][eof]
+	// ----------- block segments (blocks_<n>.log) -----
+	// segment n holds blocks [n * segment_blocks + 1, (n + 1) * segment_blocks]
+	// [desc 1][block 1][eof][desc 2][block 2][eof] ... [desc n][block n][eof]
 	// ------------ index stream ------------------------
-	// [index 1][index 2] ... [index n]
+	// [header][index 1][index 2] ... [index n]
 	//
 
 
@@ -20,49 +22,111 @@ namespace block_detail
 	typedef uint32_t block_end_eof_type;
 	static const block_end_eof_type block_end_eof = 0xb10cedef;
 
+	static const uint32_t index_magic = 0x78626978;
+	static const uint32_t index_version = 2;	// 2: base_block, version 1 headers have none.
+
+	enum block_codec : uint32_t
+	{
+		codec_raw = 0,
+		codec_zlib = 1,
+	};
+
 	struct alignas(64) block_desc
 	{
 		uint64_t num;
 		uint64_t pos;
 		uint64_t size;
+		uint32_t codec;
+		uint32_t raw_size;
 		block_desc()
 			: num(0)
 			, pos(0)
 			, size(0)
+			, codec(codec_raw)
+			, raw_size(0)
 		{
 
 		}
 	};
 
+	// pos is the record start inside the segment of the block, size is the stored (maybe compressed) size.
 	struct alignas(64) block_index
 	{
 		uint64_t num;
 		uint64_t pos;
 		uint64_t size;
 		xmax_type_block_id id;
+		uint32_t codec;
+		uint32_t raw_size;
 
 		block_index()
 			: pos(0)
 			, num(0)
 			, size(0)
+			, codec(codec_raw)
+			, raw_size(0)
 		{
 
 		}
 	};
+
+	// first slot of blocks.index, segments below first_segment are pruned.
+	// blocks up to base_block were never in the log, it was started after a snapshot of that block.
+	struct alignas(64) index_header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t segment_blocks;
+		uint64_t first_segment;
+		uint64_t base_block;
+
+		index_header()
+			: magic(index_magic)
+			, version(index_version)
+			, segment_blocks(0)
+			, first_segment(0)
+			, base_block(0)
+		{
+
+		}
+	};
+
+	static_assert(sizeof(index_header) == sizeof(block_index), "index header must fill one index slot");
 }
 
-FC_REFLECT(block_detail::block_desc, (num)(pos)(size))
+FC_REFLECT(block_detail::block_desc, (num)(pos)(size)(codec)(raw_size))
 
-FC_REFLECT(block_detail::block_index, (num)(pos)(size)(id))
+FC_REFLECT(block_detail::block_index, (num)(pos)(size)(id)(codec)(raw_size))
 
 namespace Xmaxplatform { namespace Chain {
 
 	class chain_stream_impl;
 
+	struct block_log_config
+	{
+		enum durability_mode
+		{
+			flush_every_block,		// commit at every appended (irreversible) block.
+			flush_every_n_blocks,	// commit once flush_blocks blocks are buffered.
+			flush_interval,			// commit from a background thread every flush_interval_ms.
+			flush_on_demand,		// commit only on flush(), close, or when the tail is full.
+		};
+
+		durability_mode	durability = flush_every_block;
+		uint32_t		flush_blocks = 100;
+		uint32_t		flush_interval_ms = 500;
+		uint64_t		max_tail_size = 16 * 1024 * 1024;
+
+		uint32_t		segment_blocks = 10000;	// blocks per segment, fixed when the log is created.
+		bool			compress = false;		// zlib each block, blocks that shrink less than a quarter stay raw.
+												// trades read latency (inflate per read) for disk.
+		uint32_t		retain_blocks = 0;		// drop segments older than the last retain_blocks blocks, 0 keeps all.
+	};
+
 	class chain_stream
 	{
 	public:
-		chain_stream(const fc::path& data_dir);
+		chain_stream(const fc::path& data_dir, const block_log_config& config = block_log_config());
 
 		~chain_stream();
 
@@ -72,6 +136,37 @@ namespace Xmaxplatform { namespace Chain {
 
 		signed_block_ptr read_by_num(uint32_t num) const;
 
+		// readers below are safe to call from any thread while the writer appends.
+		signed_block_ptr read_block(uint32_t num) const;
+
+		// blocks [first, last], clamped to the end of the log.
+		std::vector<signed_block_ptr> read_block_range(uint32_t first, uint32_t last) const;
+
+		// blocks [first, last] in order, one at a time, without collecting them. visit returns false to stop.
+		// returns the number of blocks visited.
+		uint32_t for_each_block(uint32_t first, uint32_t last, const std::function<bool(const signed_block_ptr&)>& visit) const;
+
+		// returns an empty pointer if the block is not in the log.
+		signed_block_ptr read_by_id(const xmax_type_block_id& id) const;
+
+		// regenerate blocks.index by scanning the segments, dropping a broken tail.
+		void rebuild_index();
+
+		// drop the segments holding only blocks below keep_from, their indices stay.
+		void prune(uint32_t keep_from);
+
+		// drop every block, the next one appended is base_block + 1. for a node started from a snapshot of base_block.
+		void reset_after(uint32_t base_block);
+
+		// readahead hint for the mapped segments, set while blocks are read in order, e.g. by a replay.
+		void advise_sequential(bool sequential);
+
+		// first block still readable, blocks below it are pruned or precede the snapshot the log started at.
+		uint32_t first_block_num() const;
+
+		// commit the buffered tail to the segments and blocks.index.
+		void flush();
+
 		int64_t last_block_num() const;
 
 		std::vector<block_detail::block_index> read_indices(int64_t begin_num, int64_t block_count) const;
@@ -59,6 +59,10 @@ namespace Xmaxplatform {
 
 			address to_address(const xmax_type_signature& sig, const xmax_type_summary& digest);
 
+			// remove at most limit transaction dedup records that expired before now, oldest first.
+			// returns the count removed.
+			uint32_t prune_expired_transactions(Basechain::database& db, const fc::time_point_sec& now, uint32_t limit);
+
 		}
 	}
 }
\ No newline at end of file
@@ -15,6 +15,10 @@
 #include <blockchain_types.hpp>
 #include <block.hpp>
 #include <block_pack.hpp>
+#include <chain_stream.hpp>
+#include <transaction_pool.hpp>
+#include <signature_recovery.hpp>
+#include <confirmation_verifier.hpp>
 #include <blockchain_setup.hpp>
 #include <native_handler.hpp>
 #include <objects/static_config_object.hpp>
@@ -45,6 +49,12 @@ namespace Xmaxplatform { namespace Chain {
 		   bool open_flag = false;
 		   bool builder_mode = true;
 		   uint64_t  shared_memory_size = 0;
+		   uint32_t  flush_interval_ms = 0;	// background flush cadence, 0 flushes at irreversible blocks only.
+		   bool      flush_durable = false;	// background flush waits until chain state is on disk.
+		   Basechain::map_options state_map;	// huge pages, prefault and mlock of the chain state.
+		   uint64_t  shared_memory_min_free = 0;	// grow the chain state at a block start when less is free, 0 never grows.
+		   uint64_t  shared_memory_grow_size = 0;
+		   uint32_t  state_stats_log_blocks = 0;	// log chain state usage every this many irreversible blocks, 0 never.
 		   bool transaction_log = false;
 		   bool confirm_log = false;
 		   bool irreversible_log = false;
@@ -52,11 +62,25 @@ namespace Xmaxplatform { namespace Chain {
 		   Basechain::bfs::path block_memory_dir;
 		   Basechain::bfs::path fork_memory_dir;
 		   Basechain::bfs::path block_log_dir;
+		   Basechain::bfs::path wasm_cache_dir;	// compiled contracts, empty compiles every contract at each start.
+		   uint64_t  wasm_cache_size = 0;
+		   uint64_t  wasm_module_cache_size = Config::default_wasm_module_cache_size;	// instantiated contracts kept in memory.
+		   block_log_config block_log;
+		   transaction_pool_config transaction_pool;
+		   uint32_t signature_threads = 0;	// key recovery workers, 0 recovers on the apply thread.
+		   std::function<void(const std::function<void()>&)> post_apply;	// runs a task on the apply thread, the workers wake it with verified confirmations.
 
 		   Chain::chain_id_type      chain_id;
 		   uint32_t	skip_flags = Config::skip_nothing;
 	   };
 
+	   struct replay_options
+	   {
+		   bool trusted = false;				// skip signatures, TaPoS and authority, the block log only holds irreversible blocks.
+		   uint32_t checkpoint_blocks = 1000;	// flush state and fork db every this many blocks.
+		   uint32_t report_seconds = 5;			// progress log interval.
+	   };
+
       public:
 
          chain_xmax(chain_init& init, const xmax_config& config, const finalize_block_func& finalize_func);
@@ -113,7 +137,10 @@ namespace Xmaxplatform { namespace Chain {
 
 	   flat_set<public_key_type> get_required_keys(const signed_transaction& transaction, const flat_set<public_key_type>& candidateKeys)const;
 
-	   vector<signed_block>	get_syncblock_from_lastnum(const uint32_t& lastnum);
+	   // blocks [first, last] of the main chain in ascending order, irreversible ones from the block log and the rest
+	   // from the fork db, one at a time. visit returns false to stop, returns the number of blocks visited.
+	   // throws unknown_block_exception when first was pruned from the block log.
+	   uint32_t for_each_block(uint32_t first, uint32_t last, const std::function<bool(const signed_block_ptr&)>& visit) const;
 
 	   void parse_transaction(signed_transaction& result, const fc::variant& v) const;
 
@@ -145,7 +172,7 @@ namespace Xmaxplatform { namespace Chain {
 	   void _pop_block();
 	   void _check_fork();
 
-	   block_pack_ptr _apply_block(signed_block_ptr block, bool updatefork);
+	   block_pack_ptr _apply_block(signed_block_ptr block, bool updatefork, const block_pack_ptr& known = block_pack_ptr());
 
 	   void _validate_block_desc(signed_block_ptr block);
 	   void _update_final_state(const block_pack_ptr& pack);
@@ -158,19 +185,20 @@ namespace Xmaxplatform { namespace Chain {
 	   transaction_response_ptr make_response() const;
 	   transaction_response_ptr make_response(const fc::exception& e) const;
 
-	   transaction_receipt& apply_transaction_receipt(const signed_transaction& trx);
+	   transaction_receipt& apply_transaction_receipt(const transaction_request& request);
 
-	   void process_confirmation(const block_confirmation& conf);
+	   void process_confirmations();
+	   void _wake_for_confirmations();
 
 	   void require_account(const account_name& name) const;
 
-	   void validate_uniqueness(const Chain::signed_transaction& trx)const;
+	   void validate_uniqueness(const xmax_type_transaction_id& trx_id)const;
 	   void validate_tapos(const transaction& trx)const;
 	   void validate_referenced_accounts(const transaction& trx)const;
 	   void validate_expiration(const transaction& trx) const;
 	   void validate_scope(const transaction& trx) const;
 
-	   void record_transaction(const signed_transaction& trx);
+	   void record_transaction(const transaction_request& request);
 
 
 	   bool should_check_for_duplicate_transactions()const;
@@ -189,6 +217,21 @@ namespace Xmaxplatform { namespace Chain {
 
 	   void flushdb();
 
+	   // wipe the chain state ahead of a replay, unless an interrupted replay left its marker to resume from.
+	   // returns true when resuming.
+	   static bool prepare_replay(const xmax_config& config);
+
+	   // apply the blocks of the block log after the state head, returns the count applied.
+	   uint32_t replay(const replay_options& options);
+
+	   // write the state at the last irreversible block to file, between blocks only. the chain stays at its head,
+	   // the reversible blocks are taken back from the undo history as the state is read. returns the size of the file.
+	   uint64_t export_snapshot(const fc::path& file);
+
+	   // replace the chain state in config.block_memory_dir with a snapshot, before the chain is constructed.
+	   // returns the head block number of the snapshot.
+	   static uint32_t import_snapshot(const xmax_config& config, const fc::path& file);
+
 	   block_pack_ptr build_block(
                chain_timestamp when,
 			   const private_key_type& sign_private_key
@@ -0,0 +1,42 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <functional>
+#include <block.hpp>
+
+namespace Xmaxplatform { namespace Chain {
+
+	class confirmation_verifier_context;
+
+	struct verified_confirmation
+	{
+		block_confirmation	conf;
+		public_key_type		signer;		// recovered from the signature, empty if the recovery failed.
+	};
+
+	// recovers the signers of block confirmations off the apply thread.
+	// a worker takes everything queued as one batch, the apply thread collects the results with take.
+	class confirmation_verifier
+	{
+	public:
+		// no worker: take recovers the queued confirmations itself.
+		// on_verified runs on the worker after each batch, so the apply thread can be woken to take the results.
+		confirmation_verifier(bool worker, const std::function<void()>& on_verified = std::function<void()>());
+		~confirmation_verifier();
+
+		void post(const block_confirmation& conf);
+
+		// confirmations whose signer is known, in the order they were posted.
+		std::vector<verified_confirmation> take();
+
+		// confirmations posted but not verified yet.
+		size_t pending() const;
+
+	private:
+		std::unique_ptr<confirmation_verifier_context> _context;
+	};
+
+}
+}
@@ -36,6 +36,9 @@ namespace Chain {
 
 		void add_confirmation(const block_confirmation& conf, uint32_t skip);
 
+		// signer was recovered from the signature already.
+		void add_confirmation(const block_confirmation& conf, const public_key_type& signer, uint32_t skip);
+
 		void force_confirm(const xmax_type_block_id& last_confirmed_id, uint32_t last_confirmed_num);
 
 		block_pack_ptr get_block(xmax_type_block_id block_id) const;
@@ -44,6 +47,9 @@ namespace Chain {
 
 		block_pack_ptr get_head() const;
 
+		// number of packs held, blocks below the last irreversible one are pruned.
+		size_t size() const;
+
 		void remove_chain(const xmax_type_block_id& begin_id);
 
 		void change_main_chain_flag(xmax_type_block_id id, bool main_chain_flag);
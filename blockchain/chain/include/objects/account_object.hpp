@@ -5,14 +5,12 @@
 #pragma once
 #include <blockchain_types.hpp>
 #include <account_type.hpp>
-#include <mapped_ptr.hpp>
-#include <objects/account_contract.hpp>
 #include "multi_index_includes.hpp"
 
 namespace Xmaxplatform { namespace Chain {
 
    class account_object : public Basechain::object<account_object_type, account_object> {
-	   OBJECT_CCTOR(account_object, (contract))
+	   OBJECT_CCTOR(account_object)
    public:
 	  using acc_type = fc::enum_type<uint8_t, account_type>;
       id_type             id;
@@ -20,16 +18,12 @@ namespace Xmaxplatform { namespace Chain {
 	  acc_type			  type = 0;
       time                creation_date;
 
-	  mapped_ptr<account_contract> contract;
+	  fc::sha256		  code_hash;	// the code_object of the contract, empty without one.
 
-	  template<typename T>
-	  void set_contract(const T& code, const Xmaxplatform::Basetypes::abi& abi)
+	  bool has_contract() const
 	  {
-		  set_contract((const char*)(code.data()), code.size(), abi);
+		  return code_hash != fc::sha256();
 	  }
-
-   private:
-	   void set_contract(const char* code, size_t len, const Xmaxplatform::Basetypes::abi& abi);
    };
    using account_id_type = account_object::id_type;
 
@@ -48,4 +42,4 @@ BASECHAIN_SET_INDEX_TYPE(Xmaxplatform::Chain::account_object, Xmaxplatform::Chai
 
 FC_REFLECT(Basechain::oid<Xmaxplatform::Chain::account_object>, (_id))
 
-FC_REFLECT(Xmaxplatform::Chain::account_object, (id)(name)(type)(creation_date)(contract))
+FC_REFLECT(Xmaxplatform::Chain::account_object, (id)(name)(type)(creation_date)(code_hash))
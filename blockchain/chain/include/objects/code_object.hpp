@@ -0,0 +1,54 @@
+/**
+ *  @file
+ *  @copyright defined in xmax/LICENSE
+ */
+#pragma once
+#include <blockchain_types.hpp>
+#include "multi_index_includes.hpp"
+
+namespace Basechain {
+	class database;
+}
+
+namespace Xmaxplatform { namespace Chain {
+
+	class account_object;
+
+	/**
+	*  contract code and abi, stored once per distinct contract and shared by every account
+	*  deploying it.  accounts refer to it by code_hash, so an account update does not copy the code.
+	*/
+	class code_object : public Basechain::object<code_object_type, code_object> {
+		OBJECT_CCTOR(code_object, (code)(abi))
+	public:
+		id_type				id;
+		fc::sha256			code_hash;		// hash of code and abi, see make_code_hash.
+		uint32_t			ref_count = 0;	// accounts using this contract.
+		mapped_vector<char>	code;
+		mapped_vector<char>	abi;			// packed Basetypes::abi.
+	};
+
+	struct by_code_hash;
+	using code_index = Basechain::shared_multi_index_container<
+		code_object,
+		indexed_by<
+			ordered_unique<tag<by_id>, member<code_object, code_object::id_type, &code_object::id>>,
+			ordered_unique<tag<by_code_hash>, member<code_object, fc::sha256, &code_object::code_hash>>
+		>
+	>;
+
+	fc::sha256 make_code_hash(const char* code, size_t code_size, const char* abi, size_t abi_size);
+
+	// point account at a contract, creating or sharing its code_object and releasing the previous one.
+	void set_account_code(Basechain::database& db, const account_object& account, const char* code, size_t len, const Basetypes::abi& abi);
+
+	// the contract of account, nullptr when it has none.
+	const code_object* find_account_code(const Basechain::database& db, const account_object& account);
+
+	// count one more user of the contract with code_hash, adding it when it is new.
+	const code_object& acquire_code(Basechain::database& db, const fc::sha256& code_hash, const char* code, size_t code_size, const char* abi, size_t abi_size);
+} } // Xmaxplatform::Chain
+
+BASECHAIN_SET_INDEX_TYPE(Xmaxplatform::Chain::code_object, Xmaxplatform::Chain::code_index)
+
+FC_REFLECT(Xmaxplatform::Chain::code_object, (code_hash)(ref_count)(code)(abi))
@@ -49,7 +49,5 @@ FC_REFLECT(Xmaxplatform::Chain::dynamic_states_object,
            (state_time)
 		   (total_slot)
            (block_builder)
-		   (round_begin_time)
 		   (round_slot)
-		   (builders_elect_state)
           )
@@ -62,3 +62,5 @@ namespace Xmaxplatform {
 } // namespace Xmaxplatform::chain
 
 BASECHAIN_SET_INDEX_TYPE(Xmaxplatform::Chain::erc20_token_account_object, Xmaxplatform::Chain::erc20_token_account_multi_index)
+
+FC_REFLECT(Xmaxplatform::Chain::erc20_token_account_object, (token_name)(owner_name)(balance))
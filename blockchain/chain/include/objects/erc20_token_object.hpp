@@ -75,3 +75,5 @@ namespace Xmaxplatform {
 } // namespace Xmaxplatform::chain
 
 BASECHAIN_SET_INDEX_TYPE(Xmaxplatform::Chain::erc20_token_object, Xmaxplatform::Chain::erc20_token_multi_index)
+
+FC_REFLECT(Xmaxplatform::Chain::erc20_token_object, (token_name)(owner_name)(total_supply)(decimal)(revoked)(stopmint))
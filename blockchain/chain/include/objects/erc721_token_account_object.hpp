@@ -81,3 +81,5 @@ namespace Xmaxplatform {
 } // namespace Xmaxplatform::chain
 
 BASECHAIN_SET_INDEX_TYPE(Xmaxplatform::Chain::erc721_token_account_object, Xmaxplatform::Chain::erc721_token_account_multi_index)
+
+FC_REFLECT(Xmaxplatform::Chain::erc721_token_account_object, (token_name)(token_id)(token_owner)(token_url))
@@ -69,3 +69,5 @@ namespace Xmaxplatform {
 } // namespace Xmaxplatform::chain
 
 BASECHAIN_SET_INDEX_TYPE(Xmaxplatform::Chain::erc721_token_object, Xmaxplatform::Chain::erc721_token_multi_index)
+
+FC_REFLECT(Xmaxplatform::Chain::erc721_token_object, (token_name)(owner_name)(revoked)(stopmint))
@@ -255,3 +255,7 @@ BASECHAIN_SET_INDEX_TYPE(Xmaxplatform::Chain::key64x64x64_value_object, Xmaxplat
 BASECHAIN_SET_INDEX_TYPE(Xmaxplatform::Chain::key128x128x128_value_object, Xmaxplatform::Chain::key128x128x128_value_index)
 
 FC_REFLECT(Xmaxplatform::Chain::key_value_object, (id)(scope)(code)(table)(primary_key)(value) )
+FC_REFLECT(Xmaxplatform::Chain::keystr_value_object, (id)(scope)(code)(table)(primary_key)(value) )
+FC_REFLECT(Xmaxplatform::Chain::key128x128_value_object, (id)(scope)(code)(table)(primary_key)(secondary_key)(value) )
+FC_REFLECT(Xmaxplatform::Chain::key64x64x64_value_object, (id)(scope)(code)(table)(primary_key)(secondary_key)(tertiary_key)(value) )
+FC_REFLECT(Xmaxplatform::Chain::key128x128x128_value_object, (id)(scope)(code)(table)(primary_key)(secondary_key)(tertiary_key)(value) )
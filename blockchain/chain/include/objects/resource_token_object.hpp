@@ -42,3 +42,5 @@ class resource_token_object : public Basechain::object<resource_token_object_typ
 } } // namespace Xmaxplatform::chain
 
 BASECHAIN_SET_INDEX_TYPE(Xmaxplatform::Chain::resource_token_object, Xmaxplatform::Chain::resource_token_multi_index)
+
+FC_REFLECT(Xmaxplatform::Chain::resource_token_object, (owner_name)(locked_token)(unlocked_token)(last_unlocked_time))
@@ -47,5 +47,4 @@ FC_REFLECT(Xmaxplatform::Chain::static_config_object,
 			(setup)
 			(current_builders)
 			(next_builders)
-			(new_builders)
           )
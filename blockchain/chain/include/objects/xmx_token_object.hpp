@@ -40,3 +40,5 @@ using xmx_token_multi_index = Basechain::shared_multi_index_container<
 } } // namespace Xmaxplatform::chain
 
 BASECHAIN_SET_INDEX_TYPE(Xmaxplatform::Chain::xmx_token_object, Xmaxplatform::Chain::xmx_token_multi_index)
+
+FC_REFLECT(Xmaxplatform::Chain::xmx_token_object, (owner_name)(main_token))
@@ -0,0 +1,35 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <transaction_request.hpp>
+
+namespace Xmaxplatform { namespace Chain {
+
+	class signature_recovery_context;
+
+	// recovers signing keys of transaction requests on worker threads, ahead of the apply thread.
+	// the keys land in the request's cache, apply picks them up with get_signature_keys.
+	class signature_recovery
+	{
+	public:
+		// threads 0 posts nothing, keys are then recovered on the apply thread.
+		signature_recovery(const chain_id_type& chain_id, uint32_t threads);
+		~signature_recovery();
+
+		void post(const transaction_request_ptr& request);
+
+		void post(const std::vector<transaction_request_ptr>& requests);
+
+		uint32_t thread_count() const;
+
+		// requests posted but not taken by a worker yet.
+		size_t queued() const;
+
+	private:
+		std::unique_ptr<signature_recovery_context> _context;
+	};
+
+}
+}
@@ -12,19 +12,23 @@ namespace Chain {
 
 	class chain_xmax;
 	class signed_transaction;
+	class transaction_request;
 
 	using Basechain::database;
 
 	class transaction_context_xmax
 	{
 	public:
-		transaction_context_xmax(chain_xmax& _chain, const signed_transaction& _trx, fc::time_point _start = fc::time_point::now());
+		transaction_context_xmax(chain_xmax& _chain, const transaction_request& _request, fc::time_point _start = fc::time_point::now());
 
 
 		void exec();
 
 		void squash();
 
+		// number the message receipts from first_idx, in execution order.
+		void assign_message_indexes(uint64_t first_idx);
+
 
 	public:
 
@@ -46,6 +50,7 @@ namespace Chain {
 
 		chain_xmax&						chain;
 		const signed_transaction&		trx;
+		xmax_type_transaction_id		trx_id;
 
 		database::session			dbsession;
 		fc::time_point	start_time;
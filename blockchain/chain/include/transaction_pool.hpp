@@ -0,0 +1,64 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <block.hpp>
+#include <transaction_request.hpp>
+
+namespace Xmaxplatform { namespace Chain {
+
+	class transaction_pool_context;
+
+	struct transaction_pool_config
+	{
+		uint64_t	max_bytes = 256 * 1024 * 1024;	// estimated memory of all queued transactions.
+		uint32_t	max_per_payer = 1000;			// queued transactions per gas payer, 0 is unlimited.
+	};
+
+	enum transaction_pool_status
+	{
+		pool_added,
+		pool_duplicate,		// same transaction id already queued.
+		pool_payer_limit,	// gas payer reached max_per_payer.
+		pool_full,			// no room left, even after evicting cheaper transactions.
+	};
+
+	// pending transactions waiting for a block, highest gas first.
+	class transaction_pool
+	{
+	public:
+		transaction_pool(const transaction_pool_config& config = transaction_pool_config());
+		~transaction_pool();
+
+		transaction_pool_status add(const transaction_request_ptr& request);
+
+		bool contains(const xmax_type_transaction_id& id) const;
+
+		transaction_request_ptr get(const xmax_type_transaction_id& id) const;
+
+		bool remove(const xmax_type_transaction_id& id);
+
+		// drop the transactions a block included, returns the count removed.
+		size_t remove_included(const signed_block& block);
+
+		// drop transactions expired at now, returns the count removed.
+		size_t remove_expired(const fc::time_point& now);
+
+		// take transactions out of the pool by gas, until the next one would exceed max_messages.
+		std::vector<transaction_request_ptr> select_by_gas(uint32_t max_messages);
+
+		size_t size() const;
+
+		uint64_t bytes() const;
+
+		size_t payer_count(const account_name& payer) const;
+
+		void clear();
+
+	private:
+		std::unique_ptr<transaction_pool_context> _context;
+	};
+
+}
+}
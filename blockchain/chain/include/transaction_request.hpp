@@ -4,6 +4,7 @@
 */
 #pragma once
 
+#include <mutex>
 #include <transaction.hpp>
 
 namespace Xmaxplatform { namespace Chain {
@@ -11,24 +12,45 @@ namespace Xmaxplatform { namespace Chain {
 	class transaction_request
 	{
 	public:
-		signed_transaction signed_trx;
+		const transaction_package package;
 
-		transaction_package package;
+		// the transaction inside package, no second copy is kept.
+		const signed_transaction& signed_trx;
 
-		transaction_request(const signed_transaction& trx) 
-		: package(trx) {
-			signed_trx = package.unpack_trx();
-		}
+		// packed Basetypes::transaction, the bytes both the id and the signing digest hash over.
+		const std::vector<char> packed_trx;
 
-		transaction_request(const transaction_package& p)
-			: package(p) {
-			signed_trx = package.unpack_trx();
-		}
+		const xmax_type_transaction_id id;
+
+		transaction_request(const signed_transaction& trx);
+
+		transaction_request(const transaction_package& p);
+
+		transaction_request(transaction_package&& p);
+
+		transaction_request(const transaction_request&) = delete;
+		transaction_request& operator=(const transaction_request&) = delete;
+
+		// same as signed_trx.sig_digest(chain_id), hashed once per request for the chain it was first asked for.
+		xmax_type_summary sig_digest(const chain_id_type& chain_id) const;
+
+		// recovered once per request for the chain it was first asked for, safe to call from any thread.
+		// a caller racing the recovery waits for it instead of recovering again.
+		flat_set<public_key_type> get_signature_keys(const chain_id_type& chain_id) const;
 
 		static inline bool sort_by_gas(const std::shared_ptr<transaction_request>& ltrx, const std::shared_ptr<transaction_request>& rtrx)
 		{
 			return ltrx->signed_trx.gas < rtrx->signed_trx.gas;
 		}
+
+	private:
+		mutable std::once_flag		_digest_once;
+		mutable chain_id_type		_digest_chain_id;
+		mutable xmax_type_summary	_digest;
+
+		mutable std::once_flag				_keys_once;
+		mutable chain_id_type				_keys_chain_id;
+		mutable flat_set<public_key_type>	_keys;
 	};
 
 	template<class trxptr>
@@ -47,4 +69,4 @@ namespace Xmaxplatform { namespace Chain {
 
 
 }
-}
\ No newline at end of file
+}
@@ -6,12 +6,15 @@
 #include <blockchain_exceptions.hpp>
 #include <message_xmax.hpp>
 #include <message_context_xmax.hpp>
+#include <wasm_module_cache.hpp>
 #include <IR/Module.h>
 #include <Runtime/Runtime.h>
+#include <WASM/WASM.h>
 namespace Xmaxplatform { namespace Chain {
 
 class chain_xmax;
 class wasm_memory;
+class wasm_code_cache;
 
 /**
  * @class vm_xmax
@@ -35,9 +38,11 @@ class vm_xmax {
       struct ModuleState {
          Runtime::ModuleInstance* instance = nullptr;
          IR::Module*              module = nullptr;
-         int                      mem_start = 0;
-         int                      mem_end = 1<<16;
-         vector<char>             init_memory;
+         Runtime::GlobalInstance* gas = nullptr;
+         // the entry points, resolved with their invoke thunks when the module loads. empty if not exported.
+         Runtime::FunctionInvoker apply;
+         Runtime::FunctionInvoker init;
+         Runtime::FunctionInvoker alloc;
          fc::sha256               code_version;
          TableMap                 table_key_types;
          bool                     tables_fixed = false;
@@ -46,13 +51,30 @@ class vm_xmax {
       static vm_xmax& get();
 
       void init( message_context_xmax& c );
+      // execution_time is not enforced, a contract runs until it has used instruction_limit.
       void apply( message_context_xmax& c, uint32_t execution_time, bool received_block );
       void validate( message_context_xmax& c );
       void precondition( message_context_xmax& c );
 
-      int64_t current_execution_time();
+      // each call into a contract may use up to limit gas, the operators it runs weighted by operator_costs.
+      // the count does not depend on the machine, so every node stops a contract at the same operator.
+      void set_instruction_limit( uint64_t limit ) { instruction_limit = limit; }
+      uint64_t executed_instructions() const { return _executed_instructions; }
 
-	  void checktime();
+      // the costs are part of consensus and compiled into the contracts, set them before the first one loads.
+      void set_operator_costs( const WASM::OperatorCosts& costs );
+      const WASM::OperatorCosts& operator_costs() const { return _operator_costs; }
+      static WASM::OperatorCosts default_operator_costs();
+
+      // keep compiled contracts in dir, up to max_size bytes. instances loaded before keep their code.
+      void open_code_cache( const fc::path& dir, uint64_t max_size );
+      wasm_code_cache* code_cache() const { return _code_cache.get(); }
+
+      // bytes of machine code and memory the instantiated contracts may hold.
+      void set_module_cache_size( uint64_t max_size ) { _modules.set_max_size(max_size); }
+      const wasm_module_cache<ModuleState>& module_cache() const { return _modules; }
+
+      void gas_exhausted();
 
       static key_type to_key_type(const Basetypes::type_name& type_name);
       static std::string to_type_name(key_type key_type);
@@ -69,7 +91,7 @@ class vm_xmax {
       bool                       tables_fixed = false;
       int64_t                    table_storage = 0;
 
-      uint32_t                   checktime_limit = 0;
+      uint64_t                   instruction_limit = Config::default_wasm_instruction_limit;
 
       int32_t                    per_code_account_max_db_limit_mbytes = Config::default_per_code_account_max_db_limit_mbytes;
       uint32_t                   row_overhead_db_limit_bytes = Config::default_row_overhead_db_limit_bytes;
@@ -78,19 +100,26 @@ class vm_xmax {
       void load( const account_name& name, const Basechain::database& db );
 
       char* vm_allocate( int bytes );   
-      void  vm_call( const char* name );
+      template<typename... Args>
+      Runtime::Result vm_invoke( const Runtime::FunctionInvoker& entry, Args... args );
+      void  vm_call( const Runtime::FunctionInvoker& entry, const char* name );
       void  vm_validate();
       void  vm_precondition();
       void  vm_apply();
       void  vm_onInit();
       U32   vm_pointer_to_offset( char* );
+      void  release_modules( std::vector<ModuleState>& dropped );
 
 
 
-      map<account_name, ModuleState> instances;
-      fc::time_point checktimeStart;
+      wasm_module_cache<ModuleState> _modules;
+      WASM::OperatorCosts _operator_costs;
+      std::string _operator_costs_digest;
+      uint64_t _executed_instructions = 0;
+      std::unique_ptr<wasm_code_cache> _code_cache;
 
       vm_xmax();
+      ~vm_xmax();
 };
 
 
@@ -0,0 +1,68 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <fc/filesystem.hpp>
+#include <fc/crypto/sha256.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <Runtime/Runtime.h>
+
+namespace Xmaxplatform { namespace Chain {
+
+	//
+	// ----------- code cache file (<key>.jit) -----------
+	// [header][object code]
+	// the header is fc::raw, the sha256 covers the object code.
+	// the key already names the compiler, so the object code is only checked for damage.
+	//
+
+	static const uint32_t wasm_code_cache_magic = 0x74696a78;	// "xjit"
+	static const uint32_t wasm_code_cache_version = 1;
+
+	struct wasm_code_cache_header
+	{
+		uint32_t		magic = wasm_code_cache_magic;
+		uint32_t		version = wasm_code_cache_version;
+		std::string		key;
+		uint64_t		size = 0;
+		fc::sha256		digest;
+	};
+
+	struct wasm_code_cache_stats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t rejected = 0;	// files that failed the checks and were removed.
+		uint64_t evicted = 0;
+	};
+
+	// machine code the jit compiled for contracts, kept on disk across restarts.
+	// a load marks the file as used, a store evicts the least recently used files past max_size.
+	class wasm_code_cache : public Runtime::ObjectCache
+	{
+	public:
+		wasm_code_cache(const fc::path& dir, uint64_t max_size);
+
+		bool load(const std::string& key, std::vector<U8>& object) override;
+		void store(const std::string& key, const std::vector<U8>& object) override;
+
+		// bytes of the files in the cache directory.
+		uint64_t size() const { return _size; }
+		const wasm_code_cache_stats& stats() const { return _stats; }
+
+	private:
+		fc::path file_of(const std::string& key) const;
+		void remove(const fc::path& file);
+		void evict(const fc::path& keep);
+
+		fc::path				_dir;
+		uint64_t				_max_size;
+		uint64_t				_size = 0;
+		wasm_code_cache_stats	_stats;
+	};
+
+}
+}
+
+FC_REFLECT(Xmaxplatform::Chain::wasm_code_cache_header, (magic)(version)(key)(size)(digest))
@@ -0,0 +1,181 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <functional>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <fc/crypto/sha256.hpp>
+#include <blockchain_types.hpp>
+
+namespace Xmaxplatform { namespace Chain {
+
+	struct wasm_module_cache_stats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evicted = 0;	// least recently used modules dropped for the size limit.
+		uint64_t replaced = 0;	// modules dropped when the last account using them changed its code.
+	};
+
+	// the instantiated contracts, keyed by code hash and shared by the accounts that run the same code.
+	// modules past max_size are dropped least recently used first, a module no account uses any more is
+	// dropped at once. release frees what was dropped, all in one call.
+	// an account is bound to a module while it is cached, the binding goes with the module.
+	template<typename Module>
+	class wasm_module_cache
+	{
+	public:
+		typedef std::function<void(std::vector<Module>& dropped)> release_func;
+
+		wasm_module_cache(uint64_t max_size, release_func release)
+			: _max_size(max_size)
+			, _release(release)
+		{
+		}
+
+		~wasm_module_cache()
+		{
+			std::vector<Module> dropped;
+			for (auto& item : _modules)
+			{
+				dropped.push_back(std::move(item.second.module));
+			}
+			_modules.clear();
+			if (!dropped.empty())
+				_release(dropped);
+		}
+
+		wasm_module_cache(const wasm_module_cache&) = delete;
+		wasm_module_cache& operator=(const wasm_module_cache&) = delete;
+
+		// the module account runs now, nullptr if it has to be instantiated and inserted.
+		Module* find(const account_name& account, const fc::sha256& code_hash)
+		{
+			std::vector<Module> dropped;
+			bind(account, code_hash, dropped);
+			if (!dropped.empty())
+				_release(dropped);
+
+			auto it = _modules.find(code_hash);
+			if (it == _modules.end())
+			{
+				++_stats.misses;
+				return nullptr;
+			}
+			++_stats.hits;
+			_lru.splice(_lru.begin(), _lru, it->second.lru);
+			return &it->second.module;
+		}
+
+		// size is what the module holds in memory. the module inserted last is never evicted.
+		Module& insert(const account_name& account, const fc::sha256& code_hash, Module&& module, uint64_t size)
+		{
+			std::vector<Module> dropped;
+			bind(account, code_hash, dropped);
+
+			auto it = _modules.find(code_hash);
+			if (it != _modules.end())
+				drop(it, dropped);
+
+			entry& item = _modules[code_hash];
+			item.module = std::move(module);
+			item.size = size;
+			item.lru = _lru.insert(_lru.begin(), code_hash);
+			item.accounts.insert(account);
+			_accounts[account] = code_hash;
+			_size += size;
+
+			while (_size > _max_size && _lru.size() > 1)
+			{
+				drop(_modules.find(_lru.back()), dropped);
+				++_stats.evicted;
+			}
+			if (!dropped.empty())
+				_release(dropped);
+			return item.module;
+		}
+
+		void set_max_size(uint64_t max_size) { _max_size = max_size; }
+		uint64_t max_size() const { return _max_size; }
+
+		// bytes the cached modules hold.
+		uint64_t size() const { return _size; }
+		size_t count() const { return _modules.size(); }
+		// accounts bound to a cached module.
+		size_t account_count() const { return _accounts.size(); }
+		const wasm_module_cache_stats& stats() const { return _stats; }
+
+		template<typename Visit>
+		void for_each(Visit visit) const
+		{
+			for (const auto& item : _modules)
+			{
+				visit(item.second.module);
+			}
+		}
+
+	private:
+		struct entry
+		{
+			Module									module;
+			uint64_t								size = 0;
+			std::set<account_name>					accounts;	// accounts bound to this code.
+			typename std::list<fc::sha256>::iterator	lru;
+		};
+
+		// an account that moved to other code leaves its old module, which goes once no account is left.
+		void bind(const account_name& account, const fc::sha256& code_hash, std::vector<Module>& dropped)
+		{
+			auto binding = _accounts.find(account);
+			if (binding != _accounts.end())
+			{
+				if (binding->second == code_hash)
+					return;
+
+				auto old = _modules.find(binding->second);
+				_accounts.erase(binding);
+				old->second.accounts.erase(account);
+				if (old->second.accounts.empty())
+				{
+					drop(old, dropped);
+					++_stats.replaced;
+				}
+			}
+
+			// a module not cached yet is bound by insert.
+			auto it = _modules.find(code_hash);
+			if (it != _modules.end())
+			{
+				it->second.accounts.insert(account);
+				_accounts.emplace(account, code_hash);
+			}
+		}
+
+		void drop(typename std::map<fc::sha256, entry>::iterator it, std::vector<Module>& dropped)
+		{
+			for (const auto& account : it->second.accounts)
+			{
+				_accounts.erase(account);
+			}
+			_size -= it->second.size;
+			_lru.erase(it->second.lru);
+			dropped.push_back(std::move(it->second.module));
+			_modules.erase(it);
+		}
+
+		uint64_t						_max_size;
+		uint64_t						_size = 0;
+		release_func					_release;
+		std::map<fc::sha256, entry>		_modules;
+		std::list<fc::sha256>			_lru;		// most recently used first.
+		std::map<account_name, fc::sha256>	_accounts;
+		wasm_module_cache_stats			_stats;
+	};
+
+}
+}
@@ -15,6 +15,7 @@
 #include <boost/lexical_cast.hpp>
 #include <fc/utf8.hpp>
 #include <objects/account_object.hpp>
+#include <objects/code_object.hpp>
 #if WIN32
 #include <fc/int128.hpp>
 #endif
@@ -249,23 +250,25 @@ namespace Xmaxplatform {
 		void jsvm_xmax::load(const account_name& name, const Basechain::database& db)
 		{
 			const auto& obj = db.get<account_object, by_name>(name);
+			const auto& contract = db.get<code_object, by_code_hash>(obj.code_hash);
 
 			V8_ParseWithOutPlugin();
 			
-			LoadScript(name, obj.contract->code.data(), obj.contract->abi, obj.contract->code_version);
+			LoadScript(name, contract.code.data(), contract.abi, obj.code_hash);
 		}
 
 		void jsvm_xmax::load(const account_name& name, const Basechain::database& db, std::function<void(Local<Context>&)> foo)
 		{
 			//-----find object-----
 			const auto& obj = db.get<account_object, by_name>(name);
-			char* code = (char*)obj.contract->code.data();
+			const auto& contract = db.get<code_object, by_code_hash>(obj.code_hash);
+			char* code = (char*)contract.code.data();
 
 			//----load abi if its first time
 			auto& state = instances[name];
-			if (state.code_version != obj.contract->code_version)
+			if (state.code_version != obj.code_hash)
 			{
-				state.code_version = obj.contract->code_version;
+				state.code_version = obj.code_hash;
 				state.table_key_types.clear();
 				try
 				{
@@ -273,7 +276,7 @@ namespace Xmaxplatform {
 
 					//init abi
 					Basetypes::abi byteabi;
-					if (Basetypes::abi_serializer::to_abi(obj.contract->abi, byteabi))
+					if (Basetypes::abi_serializer::to_abi(contract.abi, byteabi))
 					{
 						state.tables_fixed = true;
 						for (auto& table : byteabi.tables)
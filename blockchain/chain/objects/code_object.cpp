@@ -0,0 +1,86 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#include <basechain.hpp>
+#include <objects/code_object.hpp>
+#include <objects/account_object.hpp>
+
+
+namespace Xmaxplatform {
+namespace Chain {
+
+	fc::sha256 make_code_hash(const char* code, size_t code_size, const char* abi, size_t abi_size)
+	{
+		// the abi is part of the key, vm caches keep table types read from it.
+		fc::sha256::encoder enc;
+		fc::raw::pack(enc, unsigned_int((uint32_t)code_size));
+		enc.write(code, code_size);
+		enc.write(abi, abi_size);
+		return enc.result();
+	}
+
+	const code_object& acquire_code(Basechain::database& db, const fc::sha256& code_hash, const char* code, size_t code_size, const char* abi, size_t abi_size)
+	{
+		if (const code_object* existing = db.find<code_object, by_code_hash>(code_hash))
+		{
+			db.modify(*existing, [](code_object& obj) {
+				++obj.ref_count;
+			});
+			return *existing;
+		}
+
+		return db.create<code_object>([&](code_object& obj) {
+			obj.code_hash = code_hash;
+			obj.ref_count = 1;
+			obj.code.resize(code_size);
+			if (code_size)
+				memcpy(obj.code.data(), code, code_size);
+			obj.abi.resize(abi_size);
+			if (abi_size)
+				memcpy(obj.abi.data(), abi, abi_size);
+		});
+	}
+
+	static void release_code(Basechain::database& db, const fc::sha256& code_hash)
+	{
+		const code_object& obj = db.get<code_object, by_code_hash>(code_hash);
+		if (obj.ref_count <= 1)
+		{
+			db.remove(obj);
+		}
+		else
+		{
+			db.modify(obj, [](code_object& o) {
+				--o.ref_count;
+			});
+		}
+	}
+
+	void set_account_code(Basechain::database& db, const account_object& account, const char* code, size_t len, const Basetypes::abi& abi)
+	{
+		std::vector<char> packed_abi = fc::raw::pack(abi);
+		fc::sha256 code_hash = make_code_hash(code, len, packed_abi.data(), packed_abi.size());
+
+		if (code_hash == account.code_hash)
+			return;
+
+		acquire_code(db, code_hash, code, len, packed_abi.data(), packed_abi.size());
+		if (account.has_contract())
+		{
+			release_code(db, account.code_hash);
+		}
+
+		db.modify(account, [&](account_object& a) {
+			a.code_hash = code_hash;
+		});
+	}
+
+	const code_object* find_account_code(const Basechain::database& db, const account_object& account)
+	{
+		if (!account.has_contract())
+			return nullptr;
+		return &db.get<code_object, by_code_hash>(account.code_hash);
+	}
+}
+}
@@ -0,0 +1,111 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+#include <fc/log/logger.hpp>
+
+#include <signature_recovery.hpp>
+
+namespace Xmaxplatform { namespace Chain {
+
+	class signature_recovery_context
+	{
+	public:
+		chain_id_type						chain_id;
+		std::vector<std::thread>			workers;
+
+		mutable std::mutex					queue_mutex;
+		std::condition_variable				queue_cond;
+		std::deque<transaction_request_ptr>	queue;
+		bool								stopping = false;
+
+		void work()
+		{
+			for (;;)
+			{
+				transaction_request_ptr request;
+				{
+					std::unique_lock<std::mutex> lock(queue_mutex);
+					queue_cond.wait(lock, [this]() { return stopping || !queue.empty(); });
+					if (stopping)
+						return;
+					request = std::move(queue.front());
+					queue.pop_front();
+				}
+
+				try {
+					request->get_signature_keys(chain_id);
+				}
+				catch (const fc::exception& e) {
+					// a bad signature is reported again by the apply thread when it asks.
+					dlog("signature recovery of ${id} failed: ${e}", ("id", request->id)("e", e.to_string()));
+				}
+				catch (const std::exception& e) {
+					dlog("signature recovery of ${id} failed: ${e}", ("id", request->id)("e", e.what()));
+				}
+			}
+		}
+	};
+
+	signature_recovery::signature_recovery(const chain_id_type& chain_id, uint32_t threads)
+		: _context(new signature_recovery_context())
+	{
+		_context->chain_id = chain_id;
+		for (uint32_t i = 0; i < threads; ++i)
+		{
+			_context->workers.emplace_back([this]() { _context->work(); });
+		}
+	}
+
+	signature_recovery::~signature_recovery()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_context->queue_mutex);
+			_context->stopping = true;
+		}
+		_context->queue_cond.notify_all();
+		for (auto& worker : _context->workers)
+		{
+			worker.join();
+		}
+	}
+
+	void signature_recovery::post(const transaction_request_ptr& request)
+	{
+		if (_context->workers.empty())
+			return;
+		{
+			std::lock_guard<std::mutex> lock(_context->queue_mutex);
+			_context->queue.push_back(request);
+		}
+		_context->queue_cond.notify_one();
+	}
+
+	void signature_recovery::post(const std::vector<transaction_request_ptr>& requests)
+	{
+		if (_context->workers.empty() || requests.empty())
+			return;
+		{
+			std::lock_guard<std::mutex> lock(_context->queue_mutex);
+			_context->queue.insert(_context->queue.end(), requests.begin(), requests.end());
+		}
+		_context->queue_cond.notify_all();
+	}
+
+	uint32_t signature_recovery::thread_count() const
+	{
+		return _context->workers.size();
+	}
+
+	size_t signature_recovery::queued() const
+	{
+		std::lock_guard<std::mutex> lock(_context->queue_mutex);
+		return _context->queue.size();
+	}
+
+}
+}
@@ -10,6 +10,7 @@
 #include <objects/transaction_object.hpp>
 #include <objects/block_summary_object.hpp>
 #include <objects/account_object.hpp>
+#include <objects/code_object.hpp>
 #include <objects/static_config_object.hpp>
 #include <objects/dynamic_states_object.hpp>
 
@@ -30,6 +31,7 @@ namespace Chain {
 
 	void setup_system_indexes(Basechain::database& db) {
 		db.add_index<account_index>();
+		db.add_index<code_index>();
 		db.add_index<authority_index>();
 		db.add_index<linked_permission_index>();
 
@@ -6,14 +6,15 @@
 #include <chain_xmax.hpp>
 #include <jsvm_xmax.hpp>
 #include <transaction_context_xmax.hpp>
-#include <objects/global_status_objects.hpp>
+#include <transaction_request.hpp>
 
 namespace Xmaxplatform {
 namespace Chain {
 
-	transaction_context_xmax::transaction_context_xmax(chain_xmax& _chain, const signed_transaction& _trx, fc::time_point _start /* = fc::time_point::now() */)
+	transaction_context_xmax::transaction_context_xmax(chain_xmax& _chain, const transaction_request& _request, fc::time_point _start /* = fc::time_point::now() */)
 		: chain(_chain)
-		, trx(_trx)
+		, trx(_request.signed_trx)
+		, trx_id(_request.id)
 		, start_time(_start)
 		, dbsession(_chain.get_mutable_database().start_undo_session(true))
 		, gas_used(0)
@@ -36,6 +37,17 @@ namespace Chain {
 		dbsession.squash();
 	}
 
+	void transaction_context_xmax::assign_message_indexes(uint64_t first_idx)
+	{
+		// responses were emplaced in the same order the receipts were pushed.
+		FC_ASSERT(msg_receipts.size() == response->message_responses.size());
+		for (size_t i = 0; i < msg_receipts.size(); ++i)
+		{
+			msg_receipts[i].message_idx = first_idx + i;
+			response->message_responses[i].msg_receipt.message_idx = first_idx + i;
+		}
+	}
+
 	void transaction_context_xmax::exec_message(const Chain::message_xmax& msg, uint32_t apply_depth, uint64& usedgas, uint64 gas, uint64 gaslimit)
 	{
 
@@ -99,7 +111,7 @@ namespace Chain {
 			}
 			else
 			{				
-				XMAX_ASSERT(acc.contract, transaction_exception, "contract of '${name}' is not found.", ("name", context.code.to_string()));
+				XMAX_ASSERT(acc.has_contract(), transaction_exception, "contract of '${name}' is not found.", ("name", context.code.to_string()));
 	
 				idump((context.code)(context.msg.type));
 				const uint32_t execution_time = 10000;//TODO
@@ -117,17 +129,10 @@ namespace Chain {
 			}
 		} FC_CAPTURE_AND_RETHROW((context.msg))
 
-		uint64_t idx = 0;
-		{
-			const auto& obj = context.mutable_db.get<global_msg_status_object>();
-			context.mutable_db.modify(obj, [&](auto& mrs) {
-				++mrs.counter;
-			});
-			idx = obj.counter;
-		}
+		// message_idx is left to assign_message_indexes, so executing touches no global counter.
 		message_receipt receipt;
 		receipt.to_code = context.code;
-		receipt.message_idx = idx;
+		receipt.message_idx = 0;
 		receipt.message_id = xmax_type_message_id::hash(context.msg);
 
 		msg_receipts.push_back(receipt);
@@ -135,7 +140,7 @@ namespace Chain {
 		message_response msg;
 		msg.msg_receipt = receipt;
 		msg.msg_body = context.msg;
-		msg.owner_id = trx.id();
+		msg.owner_id = trx_id;
 
 		return msg;
 	}
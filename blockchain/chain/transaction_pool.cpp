@@ -0,0 +1,224 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/composite_key.hpp>
+
+#include <transaction_pool.hpp>
+
+namespace Xmaxplatform {
+namespace Chain {
+
+	using namespace boost::multi_index;
+	using boost::multi_index_container;
+
+	struct pool_entry
+	{
+		transaction_request_ptr		request;
+		xmax_type_transaction_id	id;
+		uint64						gas = 0;
+		fc::time_point				expiration;
+		account_name				payer;
+		uint64_t					bytes = 0;
+		uint64_t					sequence = 0;	// arrival order, first come first served at equal gas.
+	};
+
+	struct by_trx_id;
+	struct by_gas;
+	struct by_expiration;
+	struct by_payer;
+
+	typedef multi_index_container <
+		pool_entry,
+		indexed_by<
+			hashed_unique< tag<by_trx_id>, member<pool_entry, xmax_type_transaction_id, &pool_entry::id>, std::hash<xmax_type_transaction_id> >,
+			ordered_non_unique< tag<by_gas>,
+				composite_key< pool_entry,
+					member<pool_entry, uint64, &pool_entry::gas>,
+					member<pool_entry, uint64_t, &pool_entry::sequence>
+				>,
+				composite_key_compare< std::greater<uint64>, std::less<uint64_t> >
+			>,
+			ordered_non_unique< tag<by_expiration>, member<pool_entry, fc::time_point, &pool_entry::expiration> >,
+			ordered_non_unique< tag<by_payer>, member<pool_entry, account_name, &pool_entry::payer> >
+		>
+	> pool_entry_index;
+
+	class transaction_pool_context
+	{
+	public:
+		transaction_pool_config		config;
+		pool_entry_index			entries;
+		uint64_t					total_bytes = 0;
+		uint64_t					next_sequence = 0;
+
+		// make room for an entry of bytes with gas, only evicting cheaper transactions.
+		bool make_room(uint64_t bytes, uint64 gas)
+		{
+			if (bytes > config.max_bytes)
+				return false;
+
+			auto& idx = entries.get<by_gas>();
+
+			uint64_t freed = 0;
+			auto itr = idx.end();
+			while (total_bytes - freed + bytes > config.max_bytes)
+			{
+				if (itr == idx.begin())
+					return false;
+				--itr;
+				if (itr->gas >= gas)
+					return false;
+				freed += itr->bytes;
+			}
+
+			while (itr != idx.end())
+			{
+				itr = idx.erase(itr);
+			}
+			total_bytes -= freed;
+			return true;
+		}
+	};
+
+	transaction_pool::transaction_pool(const transaction_pool_config& config)
+		: _context(new transaction_pool_context())
+	{
+		_context->config = config;
+	}
+
+	transaction_pool::~transaction_pool()
+	{
+
+	}
+
+	transaction_pool_status transaction_pool::add(const transaction_request_ptr& request)
+	{
+		const signed_transaction& trx = request->signed_trx;
+
+		pool_entry entry;
+		entry.id = request->id;
+
+		if (_context->entries.find(entry.id) != _context->entries.end())
+			return pool_duplicate;
+
+		if (_context->config.max_per_payer > 0 && payer_count(trx.gas_payer) >= _context->config.max_per_payer)
+			return pool_payer_limit;
+
+		entry.request = request;
+		entry.gas = trx.gas;
+		entry.expiration = trx.expiration;
+		entry.payer = trx.gas_payer;
+		// the package body plus the cached packed bytes.
+		entry.bytes = request->packed_trx.size() * 2 + sizeof(transaction_request) + sizeof(pool_entry);
+
+		if (!_context->make_room(entry.bytes, entry.gas))
+			return pool_full;
+
+		entry.sequence = _context->next_sequence++;
+		_context->total_bytes += entry.bytes;
+		_context->entries.insert(std::move(entry));
+		return pool_added;
+	}
+
+	bool transaction_pool::contains(const xmax_type_transaction_id& id) const
+	{
+		return _context->entries.find(id) != _context->entries.end();
+	}
+
+	transaction_request_ptr transaction_pool::get(const xmax_type_transaction_id& id) const
+	{
+		auto itr = _context->entries.find(id);
+		if (itr != _context->entries.end())
+			return itr->request;
+		return transaction_request_ptr();
+	}
+
+	bool transaction_pool::remove(const xmax_type_transaction_id& id)
+	{
+		auto itr = _context->entries.find(id);
+		if (itr == _context->entries.end())
+			return false;
+
+		_context->total_bytes -= itr->bytes;
+		_context->entries.erase(itr);
+		return true;
+	}
+
+	size_t transaction_pool::remove_included(const signed_block& block)
+	{
+		size_t removed = 0;
+		for (const transaction_receipt& receipt : block.receipts)
+		{
+			xmax_type_transaction_id id = receipt.trx.contains<transaction_package>()
+				? receipt.trx.get<transaction_package>().body.id()
+				: receipt.trx.get<xmax_type_transaction_id>();
+
+			if (remove(id))
+				++removed;
+		}
+		return removed;
+	}
+
+	size_t transaction_pool::remove_expired(const fc::time_point& now)
+	{
+		auto& idx = _context->entries.get<by_expiration>();
+
+		size_t removed = 0;
+		auto itr = idx.begin();
+		while (itr != idx.end() && itr->expiration < now)
+		{
+			_context->total_bytes -= itr->bytes;
+			itr = idx.erase(itr);
+			++removed;
+		}
+		return removed;
+	}
+
+	std::vector<transaction_request_ptr> transaction_pool::select_by_gas(uint32_t max_messages)
+	{
+		auto& idx = _context->entries.get<by_gas>();
+
+		std::vector<transaction_request_ptr> selected;
+		uint32_t message_count = 0;
+		auto itr = idx.begin();
+		while (itr != idx.end())
+		{
+			uint32_t messages = itr->request->signed_trx.messages.size();
+			if (message_count + messages > max_messages)
+				break;
+
+			message_count += messages;
+			selected.push_back(itr->request);
+			_context->total_bytes -= itr->bytes;
+			itr = idx.erase(itr);
+		}
+		return selected;
+	}
+
+	size_t transaction_pool::size() const
+	{
+		return _context->entries.size();
+	}
+
+	uint64_t transaction_pool::bytes() const
+	{
+		return _context->total_bytes;
+	}
+
+	size_t transaction_pool::payer_count(const account_name& payer) const
+	{
+		return _context->entries.get<by_payer>().count(payer);
+	}
+
+	void transaction_pool::clear()
+	{
+		_context->entries.clear();
+		_context->total_bytes = 0;
+	}
+}
+}
@@ -0,0 +1,98 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#include <fc/io/raw.hpp>
+
+#include <transaction_request.hpp>
+
+namespace Xmaxplatform { namespace Chain {
+
+	namespace {
+		std::vector<char> pack_transaction(const signed_transaction& trx)
+		{
+			return fc::raw::pack(static_cast<const Basetypes::transaction&>(trx));
+		}
+
+		xmax_type_transaction_id packed_transaction_id(const std::vector<char>& packed)
+		{
+			// matches signed_transaction::id().
+			auto h = xmax_type_summary::hash(packed.data(), packed.size());
+			xmax_type_transaction_id result;
+			memcpy(result._hash, h._hash, std::min(sizeof(result), sizeof(h)));
+			return result;
+		}
+	}
+
+	transaction_request::transaction_request(const signed_transaction& trx)
+		: package(trx)
+		, signed_trx(package.body)
+		, packed_trx(pack_transaction(signed_trx))
+		, id(packed_transaction_id(packed_trx))
+	{
+	}
+
+	transaction_request::transaction_request(const transaction_package& p)
+		: package(p)
+		, signed_trx(package.body)
+		, packed_trx(pack_transaction(signed_trx))
+		, id(packed_transaction_id(packed_trx))
+	{
+	}
+
+	transaction_request::transaction_request(transaction_package&& p)
+		: package(std::move(p))
+		, signed_trx(package.body)
+		, packed_trx(pack_transaction(signed_trx))
+		, id(packed_transaction_id(packed_trx))
+	{
+	}
+
+	xmax_type_summary transaction_request::sig_digest(const chain_id_type& chain_id) const
+	{
+		auto calc = [&]() {
+			xmax_type_summary::encoder enc;
+			fc::raw::pack(enc, chain_id);
+			enc.write(packed_trx.data(), packed_trx.size());
+			return enc.result();
+		};
+
+		std::call_once(_digest_once, [&]() {
+			_digest_chain_id = chain_id;
+			_digest = calc();
+		});
+
+		if (_digest_chain_id == chain_id)
+			return _digest;
+		return calc();
+	}
+
+	flat_set<public_key_type> transaction_request::get_signature_keys(const chain_id_type& chain_id) const
+	{
+		try {
+			auto recover = [&]() {
+				const xmax_type_summary digest = sig_digest(chain_id);
+
+				flat_set<public_key_type> keys;
+				keys.reserve(signed_trx.signatures.size());
+				for (const auto& signature : signed_trx.signatures)
+				{
+					keys.insert(public_key_type(fc::ecc::public_key(signature, digest)));
+				}
+				return keys;
+			};
+
+			// a throw leaves the flag unset, the next caller recovers again.
+			std::call_once(_keys_once, [&]() {
+				_keys = recover();
+				_keys_chain_id = chain_id;
+			});
+
+			if (_keys_chain_id == chain_id)
+				return _keys;
+			return recover();
+		} FC_CAPTURE_AND_RETHROW()
+	}
+
+}
+}
@@ -27,10 +27,11 @@ namespace Xmaxplatform {namespace Chain {
 		vm_event_log();
 	}
 
-	void vm_checktime()
+	// called by the code serializeWithInjection adds when a contract has used up its gas.
+	void vm_gas_exhausted()
 	{
-		vm_xmax::get().checktime();
-	}BIND_VM_NATIVE_FUCTION(vm_checktime, ds_void, checktime)
+		vm_xmax::get().gas_exhausted();
+	}BIND_VM_NATIVE_FUCTION(vm_gas_exhausted, ds_void, gas_exhausted)
 
 	void vm_prints(const std::string& str)
 	{
@@ -7,8 +7,10 @@
 #include <vm_xmax.hpp>
 #include <chain_xmax.hpp>
 #include <vm_native_interface.hpp>
+#include <wasm_code_cache.hpp>
 #include <objects/key_value_object.hpp>
 #include <objects/account_object.hpp>
+#include <objects/code_object.hpp>
 #include <objects/xmx_token_object.hpp>
 #include <abi_serializer.hpp>
 #include <chrono>
@@ -73,7 +75,71 @@ namespace Xmaxplatform { namespace Chain {
       time last_unstaking_time;
    })
 
-   vm_xmax::vm_xmax() {
+   vm_xmax::vm_xmax()
+   : _modules(Config::default_wasm_module_cache_size, [this]( std::vector<ModuleState>& dropped ) { release_modules(dropped); }) {
+      set_operator_costs( default_operator_costs() );
+   }
+
+   vm_xmax::~vm_xmax() {
+   }
+
+   // bump when serializeWithInjection changes the code it adds, the cached machine code includes it.
+   const uint32_t code_injection_version = 2;
+
+   WASM::OperatorCosts vm_xmax::default_operator_costs() {
+      WASM::OperatorCosts costs;
+      costs.defaultCost = 1;
+      for( auto opcode : { Opcode::i32_load, Opcode::i64_load, Opcode::i32_load8_s, Opcode::i32_load8_u, Opcode::i32_load16_s,
+                           Opcode::i32_load16_u, Opcode::i64_load8_s, Opcode::i64_load8_u, Opcode::i64_load16_s, Opcode::i64_load16_u,
+                           Opcode::i64_load32_s, Opcode::i64_load32_u, Opcode::i32_store, Opcode::i64_store, Opcode::i32_store8,
+                           Opcode::i32_store16, Opcode::i64_store8, Opcode::i64_store16, Opcode::i64_store32 } ) {
+         costs.costs[opcode] = 2;
+      }
+      for( auto opcode : { Opcode::i32_mul, Opcode::i64_mul } ) {
+         costs.costs[opcode] = 3;
+      }
+      for( auto opcode : { Opcode::i32_div_s, Opcode::i32_div_u, Opcode::i32_rem_s, Opcode::i32_rem_u,
+                           Opcode::i64_div_s, Opcode::i64_div_u, Opcode::i64_rem_s, Opcode::i64_rem_u } ) {
+         costs.costs[opcode] = 8;
+      }
+      costs.costs[Opcode::call] = 5;
+      costs.costs[Opcode::call_indirect] = 10;
+      costs.costs[Opcode::grow_memory] = 1000;
+      return costs;
+   }
+
+   void vm_xmax::set_operator_costs( const WASM::OperatorCosts& costs ) {
+      FC_ASSERT( _modules.count() == 0, "operator costs are compiled into the loaded contracts" );
+      _operator_costs = costs;
+
+      // the machine code cache keys on the costs it was compiled with.
+      std::string text = std::to_string(costs.defaultCost);
+      for( const auto& cost : costs.costs ) {
+         text += "," + std::to_string(uint32_t(cost.first)) + "=" + std::to_string(cost.second);
+      }
+      _operator_costs_digest = fc::sha256::hash(text).str();
+   }
+
+   void vm_xmax::open_code_cache( const fc::path& dir, uint64_t max_size ) {
+      _code_cache.reset(new wasm_code_cache(dir, max_size));
+   }
+
+   void vm_xmax::release_modules( std::vector<ModuleState>& dropped ) {
+      for( auto& state : dropped ) {
+         delete state.module;
+         state.module   = nullptr;
+         state.instance = nullptr;
+      }
+
+      // an instance nothing cached refers to is garbage, collecting it frees its memory, table and machine code.
+      std::vector<ObjectInstance*> roots;
+      _modules.for_each( [&roots]( const ModuleState& state ) { roots.push_back( asObject(state.instance) ); } );
+      Runtime::freeUnreferencedObjects( std::move(roots) );
+
+      const auto& stats = _modules.stats();
+      dlog( "vm_xmax released ${n} modules, ${count} cached in ${size} KB, hits:${hits} misses:${misses} evicted:${evicted} replaced:${replaced}",
+            ("n",dropped.size())("count",_modules.count())("size",_modules.size()/1024)
+            ("hits",stats.hits)("misses",stats.misses)("evicted",stats.evicted)("replaced",stats.replaced) );
    }
 
    vm_xmax::key_type vm_xmax::to_key_type(const Basetypes::type_name& type_name)
@@ -107,20 +173,10 @@ namespace Xmaxplatform { namespace Chain {
       }
    }
 
-#ifdef NDEBUG
-   const int CHECKTIME_LIMIT = 3000;
-#else
-   const int CHECKTIME_LIMIT = 36000;
-#endif
-
-   void vm_xmax::checktime()
+   void vm_xmax::gas_exhausted()
    {
-	   int64_t duration = current_execution_time();
-
-      if (duration > checktime_limit) {
-         wlog("checktime called ${d}", ("d", duration));
-         throw checktime_exceeded();
-      }
+      wlog("contract ran out of gas, limit ${l}", ("l", instruction_limit));
+      throw script_runout();
    }
 
 
@@ -149,22 +205,41 @@ namespace Xmaxplatform { namespace Chain {
      }
    };
 
-   int64_t vm_xmax::current_execution_time()
-   {
-      return (fc::time_point::now() - checktimeStart).count();
+   // whether an entry point takes the parameters vm_xmax calls it with.
+   static bool takes( const FunctionInvoker& entry, const std::initializer_list<ValueType>& parameters ) {
+      return entry.type->parameters.size() == parameters.size()
+          && std::equal( parameters.begin(), parameters.end(), entry.type->parameters.begin() );
    }
 
+   template<typename... Args>
+   Runtime::Result vm_xmax::vm_invoke( const FunctionInvoker& entry, Args... args ) {
+      // a slot for each argument and one for the result, the layout the invoke thunk reads.
+      U64 slots[sizeof...(Args) + 1] = { U64(args)... };
 
-   char* vm_xmax::vm_allocate( int bytes ) {
-      FunctionInstance* alloc_function = asFunctionNullable(getInstanceExport(current_module,"alloc"));
-      const FunctionType* functionType = getFunctionType(alloc_function);
-      FC_ASSERT( functionType->parameters.size() == 1 );
-      std::vector<Value> invokeArgs(1);
-      invokeArgs[0] = U32(bytes);
+      const I64 limit = I64(std::min<uint64_t>(instruction_limit, INT64_MAX));
+      setGlobalValue(current_state->gas, Value(limit));
+
+      // the gas goes below zero only on the charge that calls gas_exhausted.
+      auto count_executed = [&]() {
+         const I64 left = getGlobalValue(current_state->gas).i64;
+         _executed_instructions = uint64_t(limit - std::max<I64>(left, 0));
+      };
+      try {
+         Runtime::Result result = Runtime::invokeFunction(entry,slots);
+         count_executed();
+         return result;
+      } catch( ... ) {
+         count_executed();
+         throw;
+      }
+   }
 
-      checktimeStart = fc::time_point::now();
 
-      auto result = Runtime::invokeFunction(alloc_function,invokeArgs);
+   char* vm_xmax::vm_allocate( int bytes ) {
+      const FunctionInvoker& alloc_function = current_state->alloc;
+      FC_ASSERT( alloc_function.function && takes( alloc_function, { ValueType::i32 } ) );
+
+      auto result = vm_invoke(alloc_function,U32(bytes));
 
       return &memoryRef<char>( current_memory, result.i32 );
    }
@@ -173,39 +248,24 @@ namespace Xmaxplatform { namespace Chain {
       return U32(ptr - &memoryRef<char>(current_memory,0));
    }
 
-   void  vm_xmax::vm_call( const char* name ) {
+   void  vm_xmax::vm_call( const FunctionInvoker& entry, const char* name ) {
    try {
       std::unique_ptr<wasm_memory> wasm_memory_mgmt;
       try {
-         /*
-         name += "_" + std::string( current_validate_context->msg.code ) + "_";
-         name += std::string( current_validate_context->msg.type );
-         */
-         /// TODO: cache this somehow
-         FunctionInstance* call = asFunctionNullable(getInstanceExport(current_module,name) );
-         if( !call ) {
+         if( !entry.function ) {
             //wlog( "unable to find call ${name}", ("name",name));
             return;
          }
-         //FC_ASSERT( apply, "no entry point found for ${call}", ("call", std::string(name))  );
 
-         FC_ASSERT( getFunctionType(call)->parameters.size() == 2 );
+         FC_ASSERT( takes( entry, { ValueType::i64, ValueType::i64 } ) );
 
-  //       idump((current_validate_context->msg.code)(current_validate_context->msg.type)(current_validate_context->code));
-         std::vector<Value> args = { Value(uint64_t(current_validate_context->msg.code)),
-                                     Value(uint64_t(current_validate_context->msg.type)) };
+         // only the pages the last call wrote are restored.
+         Runtime::resetMemory( current_memory );
 
-         auto& state = *current_state;
-         char* memstart = &memoryRef<char>( current_memory, 0 );
-         memset( memstart + state.mem_end, 0, ((1<<16) - state.mem_end) );
-         memcpy( memstart, state.init_memory.data(), state.mem_end);
-
-         checktimeStart = fc::time_point::now();
          wasm_memory_mgmt.reset(new wasm_memory(*this));
 
-         Runtime::invokeFunction(call,args);
+         vm_invoke(entry,uint64_t(current_validate_context->msg.code),uint64_t(current_validate_context->msg.type));
          wasm_memory_mgmt.reset();
-         checktime();
       } catch( const Runtime::Exception& e ) {
           edump((std::string(describeExceptionCause(e.cause))));
           edump((e.callStack));
@@ -213,25 +273,19 @@ namespace Xmaxplatform { namespace Chain {
       }
    } FC_CAPTURE_AND_RETHROW( (name)(current_validate_context->msg.type) ) }
 
-   void  vm_xmax::vm_apply()        { vm_call("apply" );          }
+   void  vm_xmax::vm_apply()        { vm_call(current_state->apply, "apply"); }
 
    void  vm_xmax::vm_onInit()
    { try {
       try {
-         FunctionInstance* apply = asFunctionNullable(getInstanceExport(current_module,"init"));
-         if( !apply ) {
+         if( !current_state->init.function ) {
             elog( "no onInit method found" );
             return; /// if not found then it is a no-op
          }
 
-         checktimeStart = fc::time_point::now();
-
-         const FunctionType* functionType = getFunctionType(apply);
-         FC_ASSERT( functionType->parameters.size() == 0 );
-
-         std::vector<Value> args(0);
+         FC_ASSERT( takes( current_state->init, {} ) );
 
-         Runtime::invokeFunction(apply,args);
+         vm_invoke(current_state->init);
       } catch( const Runtime::Exception& e ) {
          edump((std::string(describeExceptionCause(e.cause))));
          edump((e.callStack));
@@ -268,7 +322,6 @@ namespace Xmaxplatform { namespace Chain {
       current_validate_context       = &c;
       current_precondition_context   = &c;
       current_message_context          = &c;
-      checktime_limit                = execution_time;
 
       load( c.code, c.db );
       // if this is a received_block, then ignore the table_key_types
@@ -283,7 +336,6 @@ namespace Xmaxplatform { namespace Chain {
       current_validate_context       = &c;
       current_precondition_context   = &c;
       current_message_context          = &c;
-      checktime_limit                = CHECKTIME_LIMIT;
 
       load( c.code, c.db );
 
@@ -297,56 +349,53 @@ namespace Xmaxplatform { namespace Chain {
 
    void vm_xmax::load( const account_name& name, const Basechain::database& db ) {
       const auto& recipient = db.get<account_object,by_name>( name );
+      const auto& contract = db.get<code_object,by_code_hash>( recipient.code_hash );
   //    idump(("recipient")(name(name))(recipient.code_version));
 
-      auto& state = instances[name];
-      if( state.code_version != recipient.contract->code_version ) {
-        if( state.instance ) {
-/// TODO: free existing instance and module
-//#warning TODO: free existing module if the code has been updated, currently leak memory
-           state.instance     = nullptr;
-           state.module       = nullptr;
-           state.code_version = fc::sha256();
-        }
-        state.module = new IR::Module();
-        state.table_key_types.clear();
+      ModuleState* cached = _modules.find( name, recipient.code_hash );
+      if( !cached ) {
+        ModuleState state;
+        std::unique_ptr<IR::Module> module( new IR::Module() );
+        state.module = module.get();
 
         try
         {
 //          wlog( "LOADING CODE" );
           const auto start = fc::time_point::now();
-          Serialization::MemoryInputStream stream((const U8*)recipient.contract->code.data(),recipient.contract->code.size());
-          WASM::serializeWithInjection(stream,*state.module);
+          Serialization::MemoryInputStream stream((const U8*)contract.code.data(),contract.code.size());
+          WASM::serializeWithInjection(stream,*state.module,_operator_costs);
 
           RootResolver rootResolver;
           LinkResult linkResult = linkModule(*state.module,rootResolver);
-          state.instance = instantiateModule( *state.module, std::move(linkResult.resolvedImports) );
+          if( _code_cache ) {
+             // the same code compiled by the same jit for the same cpu gives the same machine code.
+             const fc::sha256 cache_key = fc::sha256::hash( recipient.code_hash.str() + "|" + Runtime::getObjectCodeFingerprint()
+                                                            + "|" + std::to_string(code_injection_version) + "|" + _operator_costs_digest );
+             state.instance = instantiateModule( *state.module, std::move(linkResult.resolvedImports), _code_cache.get(), cache_key.str() );
+          } else {
+             state.instance = instantiateModule( *state.module, std::move(linkResult.resolvedImports) );
+          }
           FC_ASSERT( state.instance );
+          state.gas = getInstanceGlobal( state.instance, WASM::getGasGlobalIndex(*state.module) );
+          state.apply = getFunctionInvoker( asFunctionNullable(getInstanceExport(state.instance,"apply")) );
+          state.init  = getFunctionInvoker( asFunctionNullable(getInstanceExport(state.instance,"init")) );
+          state.alloc = getFunctionInvoker( asFunctionNullable(getInstanceExport(state.instance,"alloc")) );
           const auto llvm_time = fc::time_point::now();
 
           current_memory = Runtime::getDefaultMemory(state.instance);
 
-          char* memstart = &memoryRef<char>( current_memory, 0 );
-         // state.init_memory.resize(1<<16); /// TODO: actually get memory size
+          // every call starts from the memory the module was instantiated with.
+          Runtime::snapshotMemory(current_memory);
           const auto allocated_memory = Runtime::getDefaultMemorySize(state.instance);
-          for( uint64_t i = 0; i < allocated_memory; ++i )
-          {
-             if( memstart[i] )
-             {
-                state.mem_end = i+1;
-             }
-          }
-          //ilog( "INIT MEMORY: ${size}", ("size", state.mem_end) );
 
-          state.init_memory.resize(state.mem_end);
-          memcpy( state.init_memory.data(), memstart, state.mem_end ); //state.init_memory.size() );
-          //std::cerr <<"\n";
-          state.code_version = recipient.contract->code_version;
+          state.code_version = recipient.code_hash;
 //          idump((state.code_version));
+          // the image and, at most, a written copy of each of its pages.
+          const uint64_t state_size = Runtime::getMachineCodeSize(state.instance) + 2 * allocated_memory + contract.code.size();
           const auto init_time = fc::time_point::now();
 
             Basetypes::abi abi;
-          if( Basetypes::abi_serializer::to_abi(recipient.contract->abi, abi) )
+          if( Basetypes::abi_serializer::to_abi(contract.abi, abi) )
           {
              state.tables_fixed = true;
              for(auto& table : abi.tables)
@@ -361,6 +410,9 @@ namespace Xmaxplatform { namespace Chain {
           }
           ilog("vm_xmax::load name = ${n} times llvm:${llvm} ms, init:${init} ms, abi:${abi} ms",
                ("n",name)("llvm",(llvm_time-start).count()/1000)("init",(init_time-llvm_time).count()/1000)("abi",(fc::time_point::now()-init_time).count()/1000));
+
+          module.release();
+          cached = &_modules.insert( name, recipient.code_hash, std::move(state), state_size );
         }
         catch(Serialization::FatalSerializationException exception)
         {
@@ -380,11 +432,11 @@ namespace Xmaxplatform { namespace Chain {
           throw;
         }
       }
-      current_module      = state.instance;
+      current_module      = cached->instance;
       current_memory      = getDefaultMemory( current_module );
-      current_state       = &state;
-      table_key_types     = &state.table_key_types;
-      tables_fixed        = state.tables_fixed;
+      current_state       = cached;
+      table_key_types     = &cached->table_key_types;
+      tables_fixed        = cached->tables_fixed;
       table_storage       = 0;
    }
 
@@ -0,0 +1,167 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <wasm_code_cache.hpp>
+
+namespace Xmaxplatform { namespace Chain {
+
+	namespace bfs = boost::filesystem;
+
+	static const char* wasm_code_cache_ext = ".jit";
+	static const char* wasm_code_cache_temp_ext = ".tmp";
+
+	wasm_code_cache::wasm_code_cache(const fc::path& dir, uint64_t max_size)
+		: _dir(dir)
+		, _max_size(max_size)
+	{
+		fc::create_directories(_dir);
+
+		for (bfs::directory_iterator it(_dir), end; it != end; ++it)
+		{
+			if (!bfs::is_regular_file(it->status()))
+				continue;
+			// a store interrupted before its rename. anything else in the directory is not ours.
+			if (it->path().extension() == wasm_code_cache_temp_ext)
+			{
+				boost::system::error_code ec;
+				bfs::remove(it->path(), ec);
+			}
+			else if (it->path().extension() == wasm_code_cache_ext)
+			{
+				_size += bfs::file_size(it->path());
+			}
+		}
+		ilog("wasm code cache ${dir}: ${size} KB", ("dir", _dir.generic_string())("size", _size / 1024));
+	}
+
+	fc::path wasm_code_cache::file_of(const std::string& key) const
+	{
+		return _dir / (key + wasm_code_cache_ext);
+	}
+
+	void wasm_code_cache::remove(const fc::path& file)
+	{
+		boost::system::error_code ec;
+		const uint64_t size = bfs::file_size(file, ec);
+		if (!ec && bfs::remove(file, ec))
+			_size -= std::min(_size, size);
+	}
+
+	bool wasm_code_cache::load(const std::string& key, std::vector<U8>& object)
+	{
+		const fc::path file = file_of(key);
+		if (!fc::exists(file))
+		{
+			++_stats.misses;
+			return false;
+		}
+
+		bool good = false;
+		try
+		{
+			std::ifstream stream(file.generic_string().c_str(), std::ios::in | std::ios::binary);
+			wasm_code_cache_header header;
+			fc::raw::unpack(stream, header);
+
+			const uint64_t file_size = fc::file_size(file);
+			if (header.magic == wasm_code_cache_magic && header.version == wasm_code_cache_version
+				&& header.key == key && header.size == file_size - uint64_t(stream.tellg()))
+			{
+				object.resize(header.size);
+				stream.read((char*)object.data(), object.size());
+				good = stream.good() && fc::sha256::hash((const char*)object.data(), object.size()) == header.digest;
+			}
+		}
+		catch (const fc::exception& e)
+		{
+			wlog("wasm code cache ${file} is not readable: ${e}", ("file", file.generic_string())("e", e.to_string()));
+		}
+
+		if (!good)
+		{
+			wlog("wasm code cache ${file} is damaged, removed", ("file", file.generic_string()));
+			object.clear();
+			remove(file);
+			++_stats.rejected;
+			++_stats.misses;
+			return false;
+		}
+
+		// the write time orders files for eviction.
+		boost::system::error_code ec;
+		bfs::last_write_time(file, std::time(nullptr), ec);
+		++_stats.hits;
+		return true;
+	}
+
+	void wasm_code_cache::store(const std::string& key, const std::vector<U8>& object)
+	{
+		const fc::path file = file_of(key);
+		const fc::path temp = _dir / (key + wasm_code_cache_temp_ext);
+
+		wasm_code_cache_header header;
+		header.key = key;
+		header.size = object.size();
+		header.digest = fc::sha256::hash((const char*)object.data(), object.size());
+
+		try
+		{
+			{
+				std::ofstream stream(temp.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+				fc::raw::pack(stream, header);
+				stream.write((const char*)object.data(), object.size());
+				stream.flush();
+				FC_ASSERT(stream.good(), "failed to write ${file}", ("file", temp.generic_string()));
+			}
+
+			// a reader sees the whole file or none.
+			remove(file);
+			fc::rename(temp, file);
+			_size += fc::file_size(file);
+		}
+		catch (const fc::exception& e)
+		{
+			// the cache only saves compile time, the code already runs.
+			wlog("wasm code cache store of ${key} failed: ${e}", ("key", key)("e", e.to_string()));
+			boost::system::error_code ec;
+			bfs::remove(temp, ec);
+			return;
+		}
+
+		evict(file);
+	}
+
+	void wasm_code_cache::evict(const fc::path& keep)
+	{
+		if (_size <= _max_size)
+			return;
+
+		const bfs::path& kept = keep;
+		std::vector<std::pair<std::time_t, bfs::path>> files;
+		for (bfs::directory_iterator it(_dir), end; it != end; ++it)
+		{
+			if (it->path().extension() == wasm_code_cache_ext && it->path() != kept)
+				files.emplace_back(bfs::last_write_time(it->path()), it->path());
+		}
+		std::sort(files.begin(), files.end());
+
+		for (const auto& item : files)
+		{
+			if (_size <= _max_size)
+				break;
+			remove(item.second);
+			++_stats.evicted;
+		}
+	}
+
+}
+}
@@ -11,6 +11,7 @@
 
 #include <objects/object_utility.hpp>
 #include <objects/account_object.hpp>
+#include <objects/code_object.hpp>
 #include <objects/authority_object.hpp>
 #include <objects/linked_permission_object.hpp>
 #include <objects/xmx_token_object.hpp>
@@ -184,10 +185,7 @@ void xmax_system_addcontract(Chain::message_context_xmax& context)
 	abi_serializer(msgdata.code_abi).validate();
 
 	const auto& contract = db.get<account_object, by_name>(contract_name);
-	db.modify(contract, [&](account_object& a) {
-
-		a.set_contract(msgdata.code, msgdata.code_abi);
-	});
+	set_account_code(db, contract, (const char*)msgdata.code.data(), msgdata.code.size(), msgdata.code_abi);
 
 	message_context_xmax init_context(context.mutable_chain, context.mutable_db, context.trx, context.msg, contract_name, 0);
 	jsvm_xmax::get().init(init_context);
@@ -491,10 +489,7 @@ void xmax_system_setjscode(Chain::message_context_xmax& context)
 	abi_serializer(msg.code_abi).validate();
 
 	const auto& contract = db.get<account_object, by_name>(msg.account);
-	db.modify(contract, [&](account_object& a) {
-
-		a.set_contract(msg.code, msg.code_abi);
-	});
+	set_account_code(db, contract, (const char*)msg.code.data(), msg.code.size(), msg.code_abi);
 
 	message_context_xmax init_context(context.mutable_chain, context.mutable_db, context.trx, context.msg, msg.account,0);
 	jsvm_xmax::get().init(init_context);
@@ -518,12 +513,9 @@ void xmax_system_setcode(message_context_xmax& context) {
 
 	const auto& contract = db.get<account_object, by_name>(msg.account);
 	//   wlog( "set code: ${size}", ("size",msg.code.size()));
-	db.modify(contract, [&](account_object& a) {
-
-		a.set_contract(msg.code, msg.code_abi);
-	});
+	set_account_code(db, contract, (const char*)msg.code.data(), msg.code.size(), msg.code_abi);
 
-	message_context_xmax init_context(context.mutable_chain, context.mutable_db, context.trx, context.msg, 0);
+	message_context_xmax init_context(context.mutable_chain, context.mutable_db, context.trx, context.msg, msg.account, 0);
 	vm_xmax::get().init(init_context);
 }
 
@@ -1,6 +1,14 @@
 #include <basechain.hpp>
 #include <boost/array.hpp>
 
+#ifdef WIN32
+#include <boost/interprocess/detail/win32_api.hpp>
+#else
+#include <sys/mman.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 
 namespace  Basechain {
@@ -35,7 +43,146 @@ namespace  Basechain {
       bool                    windows = false;
    };
 
-   database::database(const bfs::path& dir, open_flags flags, uint64_t shared_file_size) {
+   // present while a process has the database open for writing, a clean close removes it.
+   static const char* dirty_marker_name = "shared_memory.dirty";
+
+   // durable waits until the range is on disk, otherwise writeback of the dirty pages is only started.
+   static bool sync_range( void* addr, size_t size, bool durable )
+   {
+#ifdef WIN32
+      return bip::winapi::flush_view_of_file( addr, size );
+#else
+      return ::msync( addr, size, durable ? MS_SYNC : MS_ASYNC ) == 0;
+#endif
+   }
+
+   static void sync_file( bip::managed_mapped_file& file, uint64_t slice_size, bool durable, const std::atomic<bool>* stop )
+   {
+      char* base = static_cast<char*>( file.get_address() );
+      const size_t size = file.get_size();
+
+      for( size_t offset = 0; offset < size && !( stop && *stop ); offset += slice_size )
+      {
+         if( !sync_range( base + offset, std::min<size_t>( slice_size, size - offset ), durable ) )
+            std::cerr << "flush of the database failed at offset " << offset << std::endl;
+      }
+   }
+
+   static bool advise_range( void* addr, size_t size, database::access_pattern pattern )
+   {
+#ifdef WIN32
+      return true;
+#else
+      int advice = MADV_NORMAL;
+      switch( pattern )
+      {
+         case database::access_sequential: advice = MADV_SEQUENTIAL; break;
+         case database::access_random:     advice = MADV_RANDOM;     break;
+         case database::access_willneed:   advice = MADV_WILLNEED;   break;
+         default: break;
+      }
+      return ::madvise( addr, size, advice ) == 0;
+#endif
+   }
+
+   static void apply_map_options( bip::managed_mapped_file& file, const map_options& options )
+   {
+      char* base = static_cast<char*>( file.get_address() );
+      const size_t size = file.get_size();
+
+      if( options.huge_pages )
+      {
+         // only a hint, file backed mappings get huge pages where the kernel supports them for the
+         // file system, e.g. tmpfs with shmem_enabled=advise.
+#if defined(MADV_HUGEPAGE)
+         if( ::madvise( base, size, MADV_HUGEPAGE ) != 0 )
+            std::cerr << "huge pages for the database are not available: " << strerror( errno ) << std::endl;
+#else
+         std::cerr << "huge pages for the database are not supported on this platform" << std::endl;
+#endif
+      }
+
+      if( options.lock )
+      {
+         // mlock faults every page in as well.
+#ifdef WIN32
+         BOOST_THROW_EXCEPTION( std::runtime_error( "locking the database in memory is not supported on this platform" ) );
+#else
+         if( ::mlock( base, size ) != 0 )
+            BOOST_THROW_EXCEPTION( std::runtime_error( std::string( "could not lock the database in memory: " ) + strerror( errno ) ) );
+#endif
+      }
+      else if( options.prefault )
+      {
+         // read faults only, a write fault would dirty every page and the next flush would write the whole file.
+         advise_range( base, size, database::access_willneed );
+         const size_t page = bip::mapped_region::get_page_size();
+         volatile char sink = 0;
+         for( size_t offset = 0; offset < size; offset += page )
+            sink += base[offset];
+         (void)sink;
+      }
+   }
+
+   background_flusher::background_flusher( bip::managed_mapped_file& segment, bip::managed_mapped_file& meta, uint32_t interval_ms, uint64_t slice_size, bool durable )
+   :_segment(segment),_meta(meta),_interval_ms(interval_ms),_slice_size(slice_size),_durable(durable),_stop(false),_passes(0)
+   {
+      _thread = std::thread( [this]() { run(); } );
+   }
+
+   background_flusher::~background_flusher()
+   {
+      {
+         std::lock_guard<std::mutex> lock( _mutex );
+         _stop = true;
+      }
+      _cond.notify_all();
+      _thread.join();
+   }
+
+   void background_flusher::request()
+   {
+      {
+         std::lock_guard<std::mutex> lock( _mutex );
+         _pending = true;
+      }
+      _cond.notify_all();
+   }
+
+   void background_flusher::run()
+   {
+      std::unique_lock<std::mutex> lock( _mutex );
+      while( !_stop )
+      {
+         // on a cadence requests wait for the next pass, a durable pass leaves the pages it writes clean
+         // and the next change to each of them faults, so durable passes back to back slow down the writer.
+         if( _interval_ms )
+            _cond.wait_for( lock, std::chrono::milliseconds( _interval_ms ), [this]() { return _stop.load(); } );
+         else
+            _cond.wait( lock, [this]() { return _stop || _pending; } );
+
+         if( _stop )
+            break;
+
+         // requests made during a pass start another one.
+         _pending = false;
+         lock.unlock();
+         flush_pass();
+         lock.lock();
+      }
+   }
+
+   void background_flusher::flush_pass()
+   {
+      std::lock_guard<std::mutex> hold( _pass_mutex );
+      sync_file( _segment, _slice_size, _durable, &_stop );
+      sync_file( _meta, _slice_size, _durable, &_stop );
+      ++_passes;
+   }
+
+   database::database(const bfs::path& dir, open_flags flags, uint64_t shared_file_size, const map_options& options)
+   :_map_options(options)
+   {
       bool write = flags & database::read_write;
 
       if (!bfs::exists(dir)) {
@@ -46,8 +193,9 @@ namespace  Basechain {
 
       _data_dir = dir;
       auto abs_path = bfs::absolute( dir / "shared_memory.bin" );
+      const bool existed = bfs::exists( abs_path );
 
-      if( bfs::exists( abs_path ) )
+      if( existed )
       {
          if( write )
          {
@@ -82,8 +230,10 @@ namespace  Basechain {
 #endif
                                                        ) );
          _segment->find_or_construct< environment_check >( "environment" )();
+         _created = true;
       }
 
+      apply_map_options( *_segment, _map_options );
 
       abs_path = bfs::absolute( dir / "shared_memory.meta" );
 
@@ -115,11 +265,26 @@ namespace  Basechain {
          _flock = bip::file_lock( abs_path.generic_string().c_str() );
          if( !_flock.try_lock() )
             BOOST_THROW_EXCEPTION( std::runtime_error( "could not gain write access to the shared memory file" ) );
+
+         auto marker = dir / dirty_marker_name;
+         _clean_shutdown = !existed || closed_cleanly( dir );
+         std::ofstream( marker.generic_string().c_str(), std::ios::out | std::ios::trunc );
+         _writer = true;
       }
    }
 
    database::~database()
    {
+      _flusher.reset();
+      if( _writer && _segment )
+      {
+         // the marker goes only after everything is on disk.
+         const uint64_t page = bip::mapped_region::get_page_size();
+         sync_file( *_segment, page * 16384, true, nullptr );
+         sync_file( *_meta, page * 16384, true, nullptr );
+         boost::system::error_code ec;
+         bfs::remove( _data_dir / dirty_marker_name, ec );
+      }
       _segment.reset();
       _meta.reset();
       _index_list.clear();
@@ -134,6 +299,118 @@ namespace  Basechain {
          _meta->flush();
    }
 
+   void database::grow( uint64_t grow_size )
+   {
+      if( _read_only )
+         BOOST_THROW_EXCEPTION( std::logic_error( "cannot grow a database opened read only" ) );
+
+      std::unique_lock<std::mutex> hold;
+      if( _flusher )
+         hold = _flusher->hold();
+
+      // the flusher keeps a reference to *_segment, so the object stays and swaps its mapping.
+      auto abs_path = bfs::absolute( _data_dir / "shared_memory.bin" );
+      {
+         bip::managed_mapped_file unmapped;
+         _segment->swap( unmapped );
+      }
+
+      const bool grown = bip::managed_mapped_file::grow( abs_path.generic_string().c_str(), grow_size );
+
+      bip::managed_mapped_file mapped( bip::open_only, abs_path.generic_string().c_str() );
+      _segment->swap( mapped );
+      apply_map_options( *_segment, _map_options );
+
+      for( auto* index : _index_list )
+         index->remap( *_segment );
+
+      if( !grown )
+         BOOST_THROW_EXCEPTION( std::runtime_error( "could not grow database file by " + std::to_string( grow_size ) + " bytes" ) );
+      ++_grow_count;
+   }
+
+   bool database::grow_if_needed( uint64_t min_free, uint64_t grow_size )
+   {
+      if( _read_only || get_free_memory() >= min_free )
+         return false;
+      grow( grow_size );
+      return true;
+   }
+
+   segment_stats database::get_segment_stats()const
+   {
+      segment_stats stats;
+      stats.size = _segment->get_size();
+      stats.free = _segment->get_segment_manager()->get_free_memory();
+      stats.used = stats.size - stats.free;
+      stats.grow_count = _grow_count;
+      return stats;
+   }
+
+   std::vector<index_stats> database::get_index_stats()const
+   {
+      std::vector<index_stats> result;
+      result.reserve( _index_list.size() );
+      for( const auto* index : _index_list )
+         result.push_back( index->stats() );
+      return result;
+   }
+
+   void database::advise( access_pattern pattern )
+   {
+      if( _segment && !advise_range( _segment->get_address(), _segment->get_size(), pattern ) )
+         std::cerr << "paging hint for the database failed: " << strerror( errno ) << std::endl;
+   }
+
+   bool database::closed_cleanly( const bfs::path& dir )
+   {
+      return !bfs::exists( dir / dirty_marker_name );
+   }
+
+   uint32_t database::get_state_version()const
+   {
+      auto version = _segment->find< uint32_t >( "state_version" );
+      return version.first ? *version.first : 0;
+   }
+
+   void database::set_state_version( uint32_t version )
+   {
+      if( _read_only )
+         BOOST_THROW_EXCEPTION( std::logic_error( "cannot set the state version of a database opened read only" ) );
+      *_segment->find_or_construct< uint32_t >( "state_version" )() = version;
+   }
+
+   void database::start_background_flush( uint32_t interval_ms, bool durable, uint64_t slice_size )
+   {
+      if( !_writer )
+         BOOST_THROW_EXCEPTION( std::logic_error( "cannot flush a database opened read only" ) );
+      if( slice_size == 0 )
+         BOOST_THROW_EXCEPTION( std::logic_error( "background flush slice size must not be zero" ) );
+
+      // msync wants page aligned slices.
+      const uint64_t page = bip::mapped_region::get_page_size();
+      slice_size = ( slice_size + page - 1 ) / page * page;
+
+      _flusher.reset();
+      _flusher.reset( new background_flusher( *_segment, *_meta, interval_ms, slice_size, durable ) );
+   }
+
+   void database::request_flush()
+   {
+      if( _flusher )
+         _flusher->request();
+   }
+
+   void database::stop_background_flush()
+   {
+      _flusher.reset();
+   }
+
+   uint64_t database::background_flush_passes()const
+   {
+      return _flusher ? _flusher->passes() : 0;
+   }
+
    void database::set_require_locking( bool enable_require_locking )
    {
 #ifdef BASECHAIN_CHECK_LOCKING
@@ -13,6 +13,7 @@
 #include <boost/interprocess/sync/file_lock.hpp>
 
 #include <boost/multi_index_container.hpp>
+#include <boost/mpl/size.hpp>
 
 #include <boost/chrono.hpp>
 #include <boost/config.hpp>
@@ -23,9 +24,14 @@
 
 #include <array>
 #include <atomic>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
 #include <stdexcept>
+#include <thread>
 #include <typeindex>
 #include <typeinfo>
 
@@ -151,6 +157,37 @@ namespace  Basechain {
          int64_t                      revision = 0;
    };
 
+   /** changes recorded by one undo session of an index */
+   struct undo_session_stats
+   {
+      int64_t  revision = 0;
+      uint64_t new_ids = 0;
+      uint64_t old_values = 0;
+      uint64_t removed_values = 0;
+   };
+
+   /**
+    * Size of one index.  approx_bytes counts the objects, their multi_index nodes and the copies the
+    * undo stack keeps, memory an object allocates by itself (strings, vectors) is not included.
+    */
+   struct index_stats
+   {
+      std::string                      type_name;
+      uint32_t                         type_id = 0;
+      uint64_t                         object_count = 0;
+      uint64_t                         approx_bytes = 0;
+      int64_t                          revision = 0;
+      std::vector<undo_session_stats>  undo_sessions;   // oldest first, the size is the undo depth.
+   };
+
+   struct segment_stats
+   {
+      uint64_t size = 0;
+      uint64_t free = 0;
+      uint64_t used = 0;
+      uint32_t grow_count = 0;
+   };
+
    /**
     * The code we want to implement is this:
     *
@@ -187,6 +224,7 @@ namespace  Basechain {
          typedef bip::managed_mapped_file::segment_manager             segment_manager_type;
          typedef MultiIndexType                                        index_type;
          typedef typename index_type::value_type                       value_type;
+         typedef typename value_type::id_type                          id_type;
          typedef bip::allocator< generic_index, segment_manager_type > allocator_type;
          typedef undo_state< value_type >                              undo_state_type;
 
@@ -222,6 +260,30 @@ namespace  Basechain {
             return *insert_result.first;
          }
 
+         /**
+          * Construct an element that keeps a given ID, used to restore a snapshot into an index without
+          * undo history.  Elements arriving in ID order are appended at the end of the primary index.
+          */
+         template<typename Constructor>
+         const value_type& load( id_type id, Constructor&& c ) {
+            if( _stack.size() != 0 ) BOOST_THROW_EXCEPTION( std::logic_error("cannot load objects while there is an existing undo stack") );
+
+            auto constructor = [&]( value_type& v ) {
+               c( v );
+               v.id = id;
+            };
+
+            auto size = _indices.size();
+            auto itr = _indices.emplace_hint( _indices.end(), constructor, _indices.get_allocator() );
+
+            if( _indices.size() == size ) {
+               BOOST_THROW_EXCEPTION( std::logic_error("could not load object, most likely a uniqueness constraint was violated") );
+            }
+
+            if( !( id < _next_id ) ) _next_id = id._id + 1;
+            return *itr;
+         }
+
          template<typename Modifier>
          void modify( const value_type& obj, Modifier&& m ) {
             on_modify( obj );
@@ -304,6 +366,79 @@ namespace  Basechain {
 
          const index_type& indicies()const { return _indices; }
          int64_t revision()const { return _revision; }
+         id_type next_id()const { return _next_id; }
+
+         /**
+          *  Visits the objects as they were at revision, in id order.  The undo history of later
+          *  revisions is read, not undone, so the index is left as it is.
+          */
+         template<typename Visitor>
+         void walk_revision( int64_t revision, Visitor&& visit )const {
+            // the oldest session that touched an object after revision knows how it was at revision.
+            std::map< id_type, const value_type* > restored;
+            std::set< id_type > touched;
+            for( const auto& state : _stack ) {
+               if( state.revision <= revision ) continue;
+               for( auto id : state.new_ids )
+                  touched.insert( id );
+               for( const auto& item : state.old_values )
+                  if( touched.insert( item.first ).second ) restored.emplace( item.first, &item.second );
+               for( const auto& item : state.removed_values )
+                  if( touched.insert( item.first ).second ) restored.emplace( item.first, &item.second );
+            }
+
+            auto next = restored.begin();
+            for( const auto& obj : _indices ) {
+               for( ; next != restored.end() && next->first < obj.id; ++next )
+                  visit( *next->second );
+               if( next != restored.end() && next->first == obj.id ) {
+                  visit( *next->second );
+                  ++next;
+               }
+               else if( !touched.count( obj.id ) ) {
+                  visit( obj );
+               }
+            }
+            for( ; next != restored.end(); ++next )
+               visit( *next->second );
+         }
+
+         /** the id handed out next at revision */
+         id_type next_id_at( int64_t revision )const {
+            for( const auto& state : _stack )
+               if( state.revision > revision ) return state.old_next_id;
+            return _next_id;
+         }
+
+         void collect_stats( index_stats& stats )const {
+            // an ordered index node holds three pointers next to the value.
+            const uint64_t node_overhead = 3 * sizeof( bip::offset_ptr<void> );
+            const uint64_t index_count = boost::mpl::size< typename index_type::index_type_list >::value;
+            const uint64_t object_bytes = sizeof( value_type ) + index_count * node_overhead;
+            const uint64_t value_bytes = sizeof( std::pair<const id_type, value_type> ) + node_overhead;
+            const uint64_t id_bytes = sizeof( id_type ) + node_overhead;
+
+            stats.type_id = value_type::type_id;
+            stats.object_count = _indices.size();
+            stats.approx_bytes = _indices.size() * object_bytes;
+            stats.revision = _revision;
+            stats.undo_sessions.clear();
+            for( const auto& state : _stack ) {
+               undo_session_stats session;
+               session.revision = state.revision;
+               session.new_ids = state.new_ids.size();
+               session.old_values = state.old_values.size();
+               session.removed_values = state.removed_values.size();
+               stats.approx_bytes += ( session.old_values + session.removed_values ) * value_bytes + session.new_ids * id_bytes;
+               stats.undo_sessions.push_back( session );
+            }
+         }
+
+         void set_next_id( id_type next_id )
+         {
+            if( _stack.size() != 0 ) BOOST_THROW_EXCEPTION( std::logic_error("cannot set next id while there is an existing undo stack") );
+            _next_id = next_id;
+         }
 
 
          /**
@@ -580,31 +715,50 @@ namespace  Basechain {
 
          virtual void remove_object( int64_t id ) = 0;
 
+         /** find the index again after the segment was mapped at a new address */
+         virtual void remap( bip::managed_mapped_file& segment ) = 0;
+
+         virtual index_stats stats()const = 0;
+
          void* get()const { return _idx_ptr; }
-      private:
+      protected:
          void* _idx_ptr;
    };
 
    template<typename BaseIndex>
    class index_impl : public abstract_index {
       public:
-         index_impl( BaseIndex& base ):abstract_index( &base ),_base(base){}
+         index_impl( BaseIndex& base ):abstract_index( &base ),_base(&base){}
 
          virtual unique_ptr<abstract_session> start_undo_session( bool enabled ) override {
-            return unique_ptr<abstract_session>(new session_impl<typename BaseIndex::session>( _base.start_undo_session( enabled ) ) );
+            return unique_ptr<abstract_session>(new session_impl<typename BaseIndex::session>( _base->start_undo_session( enabled ) ) );
          }
 
-         virtual void     set_revision( uint64_t revision ) override { _base.set_revision( revision ); }
-         virtual int64_t  revision()const  override { return _base.revision(); }
-         virtual void     undo()const  override { _base.undo(); }
-         virtual void     squash()const  override { _base.squash(); }
-         virtual void     commit( int64_t revision )const  override { _base.commit(revision); }
-         virtual void     undo_all() const override {_base.undo_all(); }
+         virtual void     set_revision( uint64_t revision ) override { _base->set_revision( revision ); }
+         virtual int64_t  revision()const  override { return _base->revision(); }
+         virtual void     undo()const  override { _base->undo(); }
+         virtual void     squash()const  override { _base->squash(); }
+         virtual void     commit( int64_t revision )const  override { _base->commit(revision); }
+         virtual void     undo_all() const override {_base->undo_all(); }
          virtual uint32_t type_id()const override { return BaseIndex::value_type::type_id; }
 
-         virtual void     remove_object( int64_t id ) override { return _base.remove_object( id ); }
+         virtual void     remove_object( int64_t id ) override { return _base->remove_object( id ); }
+
+         virtual index_stats stats()const override {
+            index_stats result;
+            result.type_name = boost::core::demangle( typeid( typename BaseIndex::value_type ).name() );
+            _base->collect_stats( result );
+            return result;
+         }
+
+         virtual void     remap( bip::managed_mapped_file& segment ) override {
+            std::string type_name = boost::core::demangle( typeid( typename BaseIndex::value_type ).name() );
+            _base = segment.find< BaseIndex >( type_name.c_str() ).first;
+            if( !_base ) BOOST_THROW_EXCEPTION( std::runtime_error( "unable to find index for " + type_name + " after remapping the database" ) );
+            _idx_ptr = _base;
+         }
       private:
-         BaseIndex& _base;
+         BaseIndex* _base;
    };
 
    template<typename IndexType>
@@ -614,6 +768,54 @@ namespace  Basechain {
    };
 
 
+   /**
+    * How database maps shared_memory.bin.  huge_pages asks the kernel for transparent huge pages,
+    * prefault reads every page in while opening, lock keeps the segment resident with mlock.
+    */
+   struct map_options
+   {
+      bool huge_pages = false;
+      bool prefault   = false;
+      bool lock       = false;
+   };
+
+   /**
+    * Writes the mapped files back to disk from its own thread, so the thread changing the database
+    * never waits on writeback.  A pass syncs the segment one slice at a time, the kernel only writes
+    * the pages that are dirty.  Passes run every interval_ms, or on request() when interval_ms is 0.
+    * A durable pass waits until the pages are on disk, otherwise it only starts their writeback.
+    */
+   class background_flusher
+   {
+      public:
+         background_flusher( bip::managed_mapped_file& segment, bip::managed_mapped_file& meta, uint32_t interval_ms, uint64_t slice_size, bool durable );
+         ~background_flusher();
+
+         void     request();
+         uint64_t passes()const { return _passes.load(); }
+
+         /** no pass touches the segment while the returned lock is held, e.g. while it is remapped */
+         std::unique_lock<std::mutex> hold() { return std::unique_lock<std::mutex>( _pass_mutex ); }
+
+      private:
+         void run();
+         void flush_pass();
+
+         bip::managed_mapped_file&  _segment;
+         bip::managed_mapped_file&  _meta;
+         const uint32_t             _interval_ms;
+         const uint64_t             _slice_size;
+         const bool                 _durable;
+
+         std::mutex                 _mutex;
+         std::mutex                 _pass_mutex;
+         std::condition_variable    _cond;
+         bool                       _pending = false;
+         std::atomic<bool>          _stop;
+         std::atomic<uint64_t>      _passes;
+         std::thread                _thread;
+   };
+
    class read_write_mutex_manager
    {
       public:
@@ -657,12 +859,51 @@ namespace  Basechain {
             read_write    = 1
          };
 
-         database(const bfs::path& dir, open_flags write = read_only, uint64_t shared_file_size = 0);
+         enum access_pattern {
+            access_normal,
+            access_sequential,
+            access_random,
+            access_willneed
+         };
+
+         database(const bfs::path& dir, open_flags write = read_only, uint64_t shared_file_size = 0, const map_options& options = map_options());
          ~database();
          database(database&&) = default;
          database& operator=(database&&) = default;
          bool is_read_only() const { return _read_only; }
          void flush();
+
+         /**
+          * Paging hint for the whole segment, e.g. access_willneed to start reading it in before a
+          * replay, access_normal afterwards.  No effect on Windows.
+          */
+         void advise( access_pattern pattern );
+
+         /**
+          * Hand flushing to a background_flusher instead of calling flush() on this thread,
+          * request_flush() starts a pass early, e.g. when a revision becomes irreversible.
+          */
+         void start_background_flush( uint32_t interval_ms, bool durable = false, uint64_t slice_size = 64 * 1024 * 1024 );
+         void request_flush();
+         void stop_background_flush();
+         uint64_t background_flush_passes()const;
+
+         /**
+          * False when the last process writing this database did not close it, the segment may hold
+          * a half applied change.  Closing waits until the files are on disk before it clears the marker.
+          */
+         bool clean_shutdown()const { return _clean_shutdown; }
+         static bool closed_cleanly( const bfs::path& dir );
+
+         /** true when this database created shared_memory.bin instead of opening an existing one */
+         bool created()const { return _created; }
+
+         /**
+          * Version of the object layout the owner of the database keeps in the segment, 0 for a segment
+          * written before a version was set.  The database does not interpret it.
+          */
+         uint32_t get_state_version()const;
+         void set_state_version( uint32_t version );
          void set_require_locking( bool enable_require_locking );
 
 #ifdef BASECHAIN_CHECK_LOCKING
@@ -772,6 +1013,8 @@ namespace  Basechain {
              _index_list.push_back( new_index );
          }
 
+         size_t index_count()const { return _index_list.size(); }
+
          auto get_segment_manager() -> decltype( ((bip::managed_mapped_file*)nullptr)->get_segment_manager()) {
             return _segment->get_segment_manager();
          }
@@ -781,6 +1024,27 @@ namespace  Basechain {
             return _segment->get_segment_manager()->get_free_memory();
          }
 
+         size_t get_segment_size()const
+         {
+            return _segment->get_size();
+         }
+
+         /**
+          * Grow shared_memory.bin by grow_size bytes while the node runs.  The segment is unmapped and
+          * mapped again, so no undo session may be open and no reference to an object may be kept.
+          */
+         void grow( uint64_t grow_size );
+
+         /** grow() when less than min_free bytes are left, returns whether the file grew */
+         bool grow_if_needed( uint64_t min_free, uint64_t grow_size );
+
+         uint32_t grow_count()const { return _grow_count; }
+
+         segment_stats get_segment_stats()const;
+
+         /** statistics of every registered index, in registration order */
+         std::vector<index_stats> get_index_stats()const;
+
          template<typename MultiIndexType>
          const generic_index<MultiIndexType>& get_index()const
          {
@@ -938,7 +1202,13 @@ namespace  Basechain {
          unique_ptr<bip::managed_mapped_file>                        _meta;
          read_write_mutex_manager*                                   _rw_manager = nullptr;
          bool                                                        _read_only = false;
+         bool                                                        _writer = false;
+         bool                                                        _clean_shutdown = true;
+         bool                                                        _created = false;
          bip::file_lock                                              _flock;
+         unique_ptr<background_flusher>                              _flusher;
+         map_options                                                 _map_options;
+         uint32_t                                                    _grow_count = 0;
 
          /**
           * This is a sparse list of known indicies kept to accelerate creation of undo sessions
@@ -83,6 +83,11 @@ namespace chain_get
 			if (verbose)
 			{
 				auto block = stream.read_by_num(idx.num);
+				if (!block)
+				{
+					info << "\n{" << "pruned" << "}";
+					continue;
+				}
 
 				int msgs = 0;
 
@@ -1,10 +1,17 @@
 #pragma once
 
 #include <fc/string.hpp>
+#include <vector>
 
 namespace fc 
 {
 
   string zlib_compress(const string& in);
 
+  // level 0 (store) to 10 (best), 1 is the fastest real compression.
+  std::vector<char> zlib_compress(const char* in, size_t in_size, int level);
+
+  // out_size must be the exact uncompressed size, returns false on broken input.
+  bool zlib_decompress(const char* in, size_t in_size, char* out, size_t out_size);
+
 } // namespace fc
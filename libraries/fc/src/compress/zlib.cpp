@@ -12,4 +12,22 @@ namespace fc
     free(compressed_message);
     return result;
   }
+
+  std::vector<char> zlib_compress(const char* in, size_t in_size, int level)
+  {
+    int flags = tdefl_create_comp_flags_from_zip_params(level, MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+    size_t compressed_length = 0;
+    char* compressed = (char*)tdefl_compress_mem_to_heap(in, in_size, &compressed_length, flags);
+    if (!compressed)
+      return std::vector<char>();
+    std::vector<char> result(compressed, compressed + compressed_length);
+    free(compressed);
+    return result;
+  }
+
+  bool zlib_decompress(const char* in, size_t in_size, char* out, size_t out_size)
+  {
+    size_t written = tinfl_decompress_mem_to_mem(out, out_size, in, in_size, TINFL_FLAG_PARSE_ZLIB_HEADER);
+    return written == out_size;
+  }
 }
@@ -141,9 +141,6 @@ bool blockbuilder_plugin::import_key(const account_name& builder, const Basetype
 
     void blockbuilder_plugin_impl::next_block() {
 
-		Chain::chain_xmax& chain = app().get_plugin<blockchain_plugin>().getchain();
-		chain.flushdb();
-
 		// Next build time.
 		// If we would wait less than "1/10 of block_interval", wait for the whole block interval.
 		fc::time_point now = fc::time_point::now();
@@ -365,11 +362,4 @@ bool blockbuilder_plugin::import_key(const account_name& builder, const Basetype
 		chain.push_confirmation(msg);
 	}
 
-	Chain::vector<Chain::signed_block> blockbuilder_plugin::get_sync_blocklist(const uint32_t& lastnum)
-	{
-		Chain::chain_xmax& chain = app().get_plugin<blockchain_plugin>().getchain();
-		std::vector<signed_block> blocklist = chain.get_syncblock_from_lastnum(lastnum);		
-		return blocklist;
-	}
-
 } // namespace Xmaxplatform
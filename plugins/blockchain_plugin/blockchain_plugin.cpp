@@ -19,6 +19,7 @@
 #include <objects/erc20_token_account_object.hpp>
 #include <objects/erc721_token_account_object.hpp>
 #include <objects/erc721_token_object.hpp>
+#include <objects/code_object.hpp>
 
 namespace Xmaxplatform {
 	namespace bfs = boost::filesystem;
@@ -28,6 +29,10 @@ namespace Xmaxplatform {
         bfs::path genesis_file;
 		Chain::chain_id_type      chain_id;
 		Chain::chain_xmax::xmax_config config;
+		bool replay = false;
+		Chain::chain_xmax::replay_options replay_options;
+		bfs::path snapshot;
+		bfs::path snapshot_dir;
         std::unique_ptr<Chain::chain_xmax> chain;
 
     };
@@ -44,10 +49,30 @@ namespace Xmaxplatform {
 
     void blockchain_plugin::set_program_options(options_description &cli, options_description &cfg) {
         ilog("blockchain_plugin::set_program_options");
+		cli.add_options()
+			("replay-blockchain", bpo::bool_switch()->default_value(false),
+				"clear chain state and apply every block of the block log again")
+			("snapshot", bpo::value<bfs::path>(),
+				"clear chain state and start from this snapshot file, blocks before it are not in the block log")
+			;
         cfg.add_options()
                 ("genesis-json", bpo::value<boost::filesystem::path>(), "File to read Genesis State from")
 				("block-log-dir", bpo::value<boost::filesystem::path>()->default_value("blocks"),
 				"the location of the block log (absolute path or relative to application data dir)")
+				("block-log-flush", bpo::value<std::string>()->default_value("block"),
+				"when the block log is committed to disk: block, count, interval or demand")
+				("block-log-flush-blocks", bpo::value<uint32_t>()->default_value(100),
+				"number of blocks buffered before a commit when block-log-flush is count")
+				("block-log-flush-interval-ms", bpo::value<uint32_t>()->default_value(500),
+				"commit period in ms when block-log-flush is interval")
+				("block-log-tail-size", bpo::value<uint64_t>()->default_value(16),
+				"maximum size MB of buffered block log data before a forced commit")
+				("block-log-segment-blocks", bpo::value<uint32_t>()->default_value(10000),
+				"number of blocks per block log segment, used when the block log is created")
+				("block-log-compress", bpo::value<bool>()->default_value(false),
+				"zlib compress blocks in the block log, saves disk at the cost of an inflate per block read")
+				("block-log-retain-blocks", bpo::value<uint32_t>()->default_value(0),
+				"drop block log segments older than this many recent blocks, 0 keeps the whole history")
 				;
 
 		cfg.add_options()
@@ -58,12 +83,47 @@ namespace Xmaxplatform {
 
 		cfg.add_options()
 			("readonly", bpo::value<bool>()->default_value(false), "open data mode")
+			("pending-pool-size", bpo::value<uint64_t>()->default_value(256),
+				"maximum size MB of pending transactions, cheapest transactions are evicted first")
+			("pending-payer-limit", bpo::value<uint32_t>()->default_value(1000),
+				"maximum pending transactions per gas payer, 0 is unlimited")
+			("signature-recovery-threads", bpo::value<uint32_t>()->default_value(4),
+				"worker threads recovering transaction signing keys ahead of apply, 0 recovers on the apply thread")
+			("replay-trusted", bpo::value<bool>()->default_value(false),
+				"skip block and transaction signatures, TaPoS and authority checks while replaying the block log")
+			("replay-checkpoint-blocks", bpo::value<uint32_t>()->default_value(1000),
+				"flush chain state every this many replayed blocks, an interrupted replay resumes from there")
 			("block-state-dir", bpo::value<Basechain::bfs::path>()->default_value("chainstate"),
 				"the location of xmax chain block state memory files (absolute path or relative to application data dir)")
 			("block-state-size", bpo::value<uint64_t>()->default_value(8 * 1024),
 					"Minimum size MB of database block state memory file")
+			("block-state-flush-interval-ms", bpo::value<uint32_t>()->default_value(0),
+				"write block state back to disk in the background every this many ms, 0 only at irreversible blocks")
+			("block-state-flush-durable", bpo::value<bool>()->default_value(false),
+				"background flush waits until block state is on disk, later writes to flushed pages cost a page fault")
+			("block-state-min-free", bpo::value<uint64_t>()->default_value(256),
+				"grow the block state memory file when less than this many MB are free at a block start, 0 never grows")
+			("block-state-grow-size", bpo::value<uint64_t>()->default_value(1024),
+				"size MB the block state memory file grows by")
+			("state-stats-log-blocks", bpo::value<uint32_t>()->default_value(1000),
+				"log block state memory usage and the largest indices every this many irreversible blocks, 0 never")
+			("block-state-huge-pages", bpo::value<bool>()->default_value(false),
+				"ask for transparent huge pages for the block state memory file, takes effect where the file system supports them, e.g. tmpfs")
+			("block-state-prefault", bpo::value<bool>()->default_value(false),
+				"read the whole block state memory file in at startup, the first blocks do not wait for page-in")
+			("block-state-lock", bpo::value<bool>()->default_value(false),
+				"mlock the block state memory file, needs a memlock limit above block-state-size")
 			("fork-state-dir", bpo::value<Basechain::bfs::path>()->default_value("chainstate"),
 						"the location of xmax chain fork memory files (absolute path or relative to application data dir)")
+			("snapshot-dir", bpo::value<bfs::path>()->default_value("snapshots"),
+				"the location create_snapshot writes snapshot files to (absolute path or relative to application data dir)")
+			("wasm-cache-dir", bpo::value<bfs::path>()->default_value("wasmcache"),
+				"the location of contract machine code compiled by earlier runs (absolute path or relative to application data dir)")
+			("wasm-cache-size", bpo::value<uint64_t>()->default_value(512),
+				"maximum size MB of the contract machine code cache, least recently used code is evicted first, 0 disables the cache")
+			("wasm-module-cache-size", bpo::value<uint64_t>()->default_value(512),
+				"maximum size MB of machine code and memory of the contracts kept instantiated, least recently used contracts are freed first. "
+				"up to 256 kept contracts with 192KB or more of memory hold a file descriptor each for their memory image")
 			;
     }
 
@@ -79,6 +139,26 @@ namespace Xmaxplatform {
 			else
 				my->config.block_log_dir = bld;
 		}
+		{
+			auto flush = options.at("block-log-flush").as<std::string>();
+			if (flush == "block")
+				my->config.block_log.durability = Chain::block_log_config::flush_every_block;
+			else if (flush == "count")
+				my->config.block_log.durability = Chain::block_log_config::flush_every_n_blocks;
+			else if (flush == "interval")
+				my->config.block_log.durability = Chain::block_log_config::flush_interval;
+			else if (flush == "demand")
+				my->config.block_log.durability = Chain::block_log_config::flush_on_demand;
+			else
+				FC_THROW("Unknown block-log-flush mode: ${mode}", ("mode", flush));
+
+			my->config.block_log.flush_blocks = options.at("block-log-flush-blocks").as<uint32_t>();
+			my->config.block_log.flush_interval_ms = options.at("block-log-flush-interval-ms").as<uint32_t>();
+			my->config.block_log.max_tail_size = options.at("block-log-tail-size").as<uint64_t>() * size_mb;
+			my->config.block_log.segment_blocks = options.at("block-log-segment-blocks").as<uint32_t>();
+			my->config.block_log.compress = options.at("block-log-compress").as<bool>();
+			my->config.block_log.retain_blocks = options.at("block-log-retain-blocks").as<uint32_t>();
+		}
 
 		my->config.block_memory_dir = app().data_dir() / "chainstate";
 		my->config.fork_memory_dir = app().data_dir() / "chainstate";
@@ -102,7 +182,44 @@ namespace Xmaxplatform {
 		my->config.irreversible_log = options.at("irreversible-log").as<bool>();
 
 		my->config.shared_memory_size = options.at("block-state-size").as<uint64_t>() * size_mb;
+		my->config.flush_interval_ms = options.at("block-state-flush-interval-ms").as<uint32_t>();
+		my->config.flush_durable = options.at("block-state-flush-durable").as<bool>();
+		my->config.shared_memory_min_free = options.at("block-state-min-free").as<uint64_t>() * size_mb;
+		my->config.shared_memory_grow_size = options.at("block-state-grow-size").as<uint64_t>() * size_mb;
+		my->config.state_stats_log_blocks = options.at("state-stats-log-blocks").as<uint32_t>();
+		my->config.state_map.huge_pages = options.at("block-state-huge-pages").as<bool>();
+		my->config.state_map.prefault = options.at("block-state-prefault").as<bool>();
+		my->config.state_map.lock = options.at("block-state-lock").as<bool>();
 		my->config.open_flag = options.at("readonly").as<bool>();
+		my->config.transaction_pool.max_bytes = options.at("pending-pool-size").as<uint64_t>() * size_mb;
+		my->config.transaction_pool.max_per_payer = options.at("pending-payer-limit").as<uint32_t>();
+		my->config.signature_threads = options.at("signature-recovery-threads").as<uint32_t>();
+		my->config.post_apply = [](const std::function<void()>& task) { app().get_io_service().post(task); };
+
+		my->replay = options.at("replay-blockchain").as<bool>();
+		my->replay_options.trusted = options.at("replay-trusted").as<bool>();
+		my->replay_options.checkpoint_blocks = options.at("replay-checkpoint-blocks").as<uint32_t>();
+
+		if (options.count("snapshot")) {
+			my->snapshot = options.at("snapshot").as<bfs::path>();
+			FC_ASSERT(!my->replay, "replay-blockchain and snapshot can not be used together");
+		}
+		{
+			auto sd = options.at("snapshot-dir").as<bfs::path>();
+			if (sd.is_relative())
+				my->snapshot_dir = app().data_dir() / sd;
+			else
+				my->snapshot_dir = sd;
+		}
+		{
+			auto wcd = options.at("wasm-cache-dir").as<bfs::path>();
+			if (wcd.is_relative())
+				my->config.wasm_cache_dir = app().data_dir() / wcd;
+			else
+				my->config.wasm_cache_dir = wcd;
+			my->config.wasm_cache_size = options.at("wasm-cache-size").as<uint64_t>() * size_mb;
+			my->config.wasm_module_cache_size = options.at("wasm-module-cache-size").as<uint64_t>() * size_mb;
+		}
     }
 
 #define CALL(api_name, api_handle, api_namespace, call_name, http_response_code) \
@@ -151,8 +268,22 @@ namespace Xmaxplatform {
 		}
 
 
+		if (my->replay)
+		{
+			Chain::chain_xmax::prepare_replay(my->config);
+		}
+		else if (!my->snapshot.empty())
+		{
+			Chain::chain_xmax::import_snapshot(my->config, my->snapshot);
+		}
+
         my->chain.reset(new Chain::chain_xmax(chainsetup, my->config, finalize_func));
 
+		if (my->replay)
+		{
+			my->chain->replay(my->replay_options);
+		}
+
         register_chain_api();
 
     }
@@ -167,6 +298,7 @@ namespace Xmaxplatform {
                                                         CHAIN_RO_CALL(get_account, 200),
 														CHAIN_RO_CALL(get_table_rows, 200),
 														CHAIN_RO_CALL(get_info, 200),
+														CHAIN_RO_CALL(get_state_stats, 200),
 														CHAIN_RO_CALL(get_block, 200),
 														CHAIN_RO_CALL(get_block_header, 200),
 														CHAIN_RO_CALL(get_code, 200),
@@ -177,7 +309,8 @@ namespace Xmaxplatform {
 														CHAIN_RO_CALL(erc721_ownerof, 200),
 														//---------------Write Apis-------------
 														CHAIN_RW_CALL(push_transaction, 202),
-														CHAIN_RW_CALL(push_transactions, 202)
+														CHAIN_RW_CALL(push_transactions, 202),
+														CHAIN_RW_CALL(create_snapshot, 201)
                                                 });
     }
 
@@ -197,7 +330,7 @@ namespace Xmaxplatform {
 
 	//--------------------------------------------------
 	Xmaxplatform::Chain_APIs::read_write blockchain_plugin::get_read_write_api() { 
-		return Chain_APIs::read_write(getchain(), my->config.skip_flags); }
+		return Chain_APIs::read_write(getchain(), my->config.skip_flags, my->snapshot_dir); }
 
 namespace Chain_APIs{
 
@@ -212,6 +345,15 @@ namespace Chain_APIs{
 	const string read_only::TERTIARY = "tertiary";
 
 	//--------------------------------------------------
+	Xmaxplatform::Chain_APIs::read_only::get_state_stats_results read_only::get_state_stats(const get_state_stats_params& params) const
+	{
+		const auto& db = _chain.get_database();
+		get_state_stats_results result;
+		result.segment = db.get_segment_stats();
+		result.indices = db.get_index_stats();
+		return result;
+	}
+
 	Xmaxplatform::Chain_APIs::read_only::get_info_results read_only::get_info(const get_info_params& params) const {
 		auto itoh = [](uint32_t n, size_t hlen = sizeof(uint32_t) << 1) {
 			static const char* digits = "0123456789abcdef";
@@ -274,12 +416,12 @@ namespace Chain_APIs{
 		const auto& d = _chain.get_database();
 		const auto& accnt = d.get<Chain::account_object, Chain::by_name>(params.account_name);
 
-		if (accnt.contract) {
-			result.wast = Chain::ConvertFromWasmToWast((const uint8_t*)accnt.contract->code.data(), accnt.contract->code.size());
-			result.code_hash = fc::sha256::hash(accnt.contract->code.data(), accnt.contract->code.size());
+		if (const auto* contract = Chain::find_account_code(d, accnt)) {
+			result.wast = Chain::ConvertFromWasmToWast((const uint8_t*)contract->code.data(), contract->code.size());
+			result.code_hash = fc::sha256::hash(contract->code.data(), contract->code.size());
 
 			Xmaxplatform::Basetypes::abi abi;
-			if (Basetypes::abi_serializer::to_abi(accnt.contract->abi, abi)) {
+			if (Basetypes::abi_serializer::to_abi(contract->abi, abi)) {
 				result.abi = std::move(abi);
 			}
 		}
@@ -402,9 +544,9 @@ namespace Chain_APIs{
 		const auto& code_accnt = d.get<Chain::account_object, Chain::by_name>(account);
 
 		Xmaxplatform::Basetypes::abi abi;
-		if (code_accnt.contract)
+		if (const auto* contract = Chain::find_account_code(d, code_accnt))
 		{
-			Basetypes::abi_serializer::to_abi(code_accnt.contract->abi, abi);
+			Basetypes::abi_serializer::to_abi(contract->abi, abi);
 		}
 		return abi;
 	}
@@ -463,7 +605,7 @@ namespace Chain_APIs{
 
 		auto pretty_trx = _chain.transaction_to_variant(*respone);
 		auto pretty_events = _chain.transaction_events_to_variant(*respone);
-		return read_write::push_transaction_results{ request->signed_trx.id(), pretty_trx, pretty_events };
+		return read_write::push_transaction_results{ request->id, pretty_trx, pretty_events };
 	}
 
 	//--------------------------------------------------
@@ -498,5 +640,19 @@ namespace Chain_APIs{
 		return result;
 	}
 
+	//--------------------------------------------------
+	Xmaxplatform::Chain_APIs::read_write::create_snapshot_results read_write::create_snapshot(const create_snapshot_params& params)
+	{
+		create_snapshot_results result;
+		result.block_num = _chain.last_irreversible_block_num();
+		result.block_id = _chain.block_id_from_num(result.block_num);
+
+		fc::create_directories(_snapshot_dir);
+		fc::path file = _snapshot_dir / ("snapshot-" + std::to_string(result.block_num) + ".bin");
+		result.snapshot_size = _chain.export_snapshot(file);
+		result.snapshot_file = file.generic_string();
+		return result;
+	}
+
 }// namespace Chain_APIs
 } // namespace Xmaxplatform
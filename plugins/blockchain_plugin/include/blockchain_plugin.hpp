@@ -62,6 +62,15 @@ namespace Xmaxplatform {
 
 			get_info_results get_info( const get_info_params& params) const;
 
+			using get_state_stats_params = empty;
+
+			struct get_state_stats_results {
+				Basechain::segment_stats			segment;
+				vector<Basechain::index_stats>		indices;
+			};
+
+			get_state_stats_results get_state_stats(const get_state_stats_params& params) const;
+
 
             struct get_account_results {
                 name                       account_name;
@@ -282,10 +291,11 @@ namespace Xmaxplatform {
 		class read_write {
 			Chain::chain_xmax& _chain;
 			uint32_t skip_flags;
+			fc::path _snapshot_dir;
 
 		public:
-			read_write(Chain::chain_xmax& chain, uint32_t skip_flags)
-				: _chain(chain), skip_flags(skip_flags) {}
+			read_write(Chain::chain_xmax& chain, uint32_t skip_flags, const fc::path& snapshot_dir)
+				: _chain(chain), skip_flags(skip_flags), _snapshot_dir(snapshot_dir) {}
 
 			using push_transaction_params = fc::variant_object;
 
@@ -303,6 +313,18 @@ namespace Xmaxplatform {
 			using push_transactions_results = vector<push_transaction_results>;
 			push_transactions_results push_transactions(const push_transactions_params& params);
 
+			using create_snapshot_params = empty;
+
+			// the snapshot holds the state at the last irreversible block.
+			struct create_snapshot_results {
+				uint32_t					block_num;
+				Chain::xmax_type_block_id	block_id;
+				string						snapshot_file;
+				uint64_t					snapshot_size;
+			};
+
+			create_snapshot_results create_snapshot(const create_snapshot_params& params);
+
 		};
 
     } // namespace Chain_APIs
@@ -357,6 +379,11 @@ FC_REFLECT(Xmaxplatform::Chain_APIs::read_only::get_block_header_results, (previ
 FC_REFLECT(Xmaxplatform::Chain_APIs::read_only::get_info_results,
 (server_version)(head_block_num)(last_irreversible_block_num)(head_block_id)(head_block_time))
 FC_REFLECT(Xmaxplatform::Chain_APIs::read_write::push_transaction_results, (transaction_id)(processed)(events))
+FC_REFLECT(Basechain::undo_session_stats, (revision)(new_ids)(old_values)(removed_values))
+FC_REFLECT(Basechain::index_stats, (type_name)(type_id)(object_count)(approx_bytes)(revision)(undo_sessions))
+FC_REFLECT(Basechain::segment_stats, (size)(free)(used)(grow_count))
+FC_REFLECT(Xmaxplatform::Chain_APIs::read_only::get_state_stats_results, (segment)(indices))
+FC_REFLECT(Xmaxplatform::Chain_APIs::read_write::create_snapshot_results, (block_num)(block_id)(snapshot_file)(snapshot_size))
 FC_REFLECT(Xmaxplatform::Chain_APIs::read_only::get_required_keys_params, (transaction)(available_keys))
 FC_REFLECT(Xmaxplatform::Chain_APIs::read_only::get_required_keys_result, (required_keys))
 FC_REFLECT(Xmaxplatform::Chain_APIs::read_only::get_code_results, (account_name)(code_hash)(wast)(abi))
@@ -159,6 +159,7 @@ namespace Xmaxplatform {
 	  Chain::string                        user_agent_name;
       blockchain_plugin*                 chain_plug;
       bool                          send_whole_blocks = false;
+      uint32_t                      sync_send_buffer_size = 0; ///< bytes of sync blocks queued to a peer at a time
       int                           started_sessions = 0;
 
       node_transaction_index        local_txns;
@@ -764,7 +765,7 @@ namespace Xmaxplatform {
          c->sync_requested.reset();
          c->flush_queues();
       } else {
-         c->sync_requested.reset(new sync_state( msg.start_block,msg.end_block,msg.start_block-1));
+         c->sync_requested.reset(new sync_state( msg.start_block,msg.end_block,msg.start_block-1, sync_send_buffer_size));
          c->enqueue_sync_block();
       }
    }
@@ -847,8 +848,11 @@ namespace Xmaxplatform {
 
    void chainnet_plugin_impl::_send_blocklist_impl(connection_ptr c, const request_block_message &msg)
    {
-	   Chain::vector<Chain::signed_block> blockList = app().get_plugin<blockbuilder_plugin>().get_sync_blocklist(msg.last_irreversible_block_num);
-	   c->send_signedblocklist(blockList);
+	   // everything past the peer's last irreversible block, streamed as the peer drains it.
+	   const uint32_t head = chain_plug->getchain().head_block_num();
+	   const uint32_t last = msg.last_irreversible_block_num;
+	   c->sync_requested.reset(new sync_state(last + 1, head, last, sync_send_buffer_size));
+	   c->enqueue_sync_block();
    }
 
    void chainnet_plugin_impl::start_conn_timer( ) {
@@ -1064,6 +1068,7 @@ namespace Xmaxplatform {
 		   ("max-clients", bpo::value<int>()->default_value(def_max_clients), "Maximum clients from which connections are accepted, (0)zero means unlimit")
 		   ("connection-cleanup-period", bpo::value<int>()->default_value(def_conn_retry_wait), "Seconds to wait before cleaning up dead connections")
 		   ("network-version-match", bpo::value<bool>()->default_value(false),"If require exact match of peer network version.")
+		   ("sync-send-buffer-kb", bpo::value<uint32_t>()->default_value(def_send_buffer_size / 1024), "KB of blocks queued to a syncing peer at a time.")
 			   ;
    }
 
@@ -1100,6 +1105,7 @@ namespace Xmaxplatform {
       my->network_version = static_cast<uint16_t>(app().version());
       my->network_version_match = options.at("network-version-match").as<bool>();
       my->send_whole_blocks = def_send_whole_blocks;
+      my->sync_send_buffer_size = options.at("sync-send-buffer-kb").as<uint32_t>() * 1024;
 
       my->connector_period = std::chrono::seconds(options.at("connection-cleanup-period").as<int>());
       my->txn_exp_period = def_txn_expire_wait;
@@ -1362,10 +1368,10 @@ namespace Xmaxplatform {
 	   xmax_type_block_id null_id;
 	   for (auto bid = head_id; bid != null_id && bid != lib_id; ) {
 		   try {
-			   optional<signed_block> b = *cc.block_from_id(bid);
+			   signed_block_ptr b = cc.block_from_id(bid);
 			   if (b) {
 				   bid = b->previous;
-				   bstack.push_back(b);
+				   bstack.push_back(*b);
 			   }
 			   else {
 				   break;
@@ -1394,7 +1400,7 @@ namespace Xmaxplatform {
 	   for (auto &blkid : ids) {
 		   ++count;
 		   try {
-			   optional<signed_block> b = *cc.block_from_id(blkid);
+			   signed_block_ptr b = cc.block_from_id(blkid);
 			   if (b) {
 				   fc_dlog(logger, "get block from id at num ${n}", ("n", b->block_num()));
 				   msg_enqueue(*b);
@@ -1447,7 +1453,7 @@ namespace Xmaxplatform {
 				   return;
 			   }
 			   conn->write_queue.pop_front();
-			   conn->enqueue_sync_block();
+			   conn->enqueue_sync_block(false);
 			   conn->do_queue_write();
 		   }
 		   catch (const std::exception &ex) {
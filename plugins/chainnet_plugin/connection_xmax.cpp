@@ -139,12 +139,6 @@ namespace Xmaxplatform {
 		msg_enqueue(confirm);
 	}
 
-	void connection_xmax::send_signedblocklist(const Chain::vector<Chain::signed_block>& blockList)
-	{
-
-		pending_block_list.assign(blockList.begin(), blockList.end());
-	}
-
 	void connection_xmax::send_pending_block()
 	{
 		if (pending_block_list.empty())
@@ -221,26 +215,49 @@ namespace Xmaxplatform {
 		msg_enqueue(request_message());
 	}
 
-	bool connection_xmax::enqueue_sync_block() {
-		chain_xmax& cc = app().find_plugin<blockchain_plugin>()->getchain();
+	bool connection_xmax::enqueue_sync_block(bool trigger_send) {
 		if (!sync_requested)
 			return false;
-		uint32_t num = ++sync_requested->last;
-		bool trigger_send = num == sync_requested->start_block;
-		if (num == sync_requested->end_block) {
-			sync_requested.reset();
-		}
+
+		// top the write queue up to the window, the write loop calls back here as it drains.
+		size_t queued = 0;
+		for (const queued_write& w : write_queue)
+			queued += w.buff->size();
+		if (queued > 0 && queued >= sync_requested->window_size)
+			return false;
+
+		chain_xmax& cc = app().find_plugin<blockchain_plugin>()->getchain();
+		sync_state_ptr state = sync_requested;
+		const bool idle = write_queue.empty();
+		uint32_t sent = 0;
 		try {
-			fc::optional<signed_block> sb = *cc.block_from_num(num);
-			if (sb) {
-				msg_enqueue(*sb, trigger_send);
-				return true;
-			}
+			sent = cc.for_each_block(state->last + 1, state->end_block, [&](const signed_block_ptr& block) {
+				msg_enqueue(*block, false);
+				state->last = block->block_num();
+				queued += write_queue.back().buff->size();
+				return queued < state->window_size;
+			});
+		}
+		catch (const unknown_block_exception& e) {
+			// this node pruned the start of the range, the peer has to sync from another one.
+			wlog("can not sync blocks ${first} to ${last} to ${p}: ${e}",
+				("first", state->last + 1)("last", state->end_block)("p", peer_name())("e", e.to_string()));
+			sync_requested.reset();
+			msg_enqueue(leave_message(benign_other));
+			return false;
 		}
 		catch (...) {
 			wlog("write loop exception");
 		}
-		return false;
+
+		// done, or the chain does not have the next block any more.
+		if (sync_requested == state && (sent == 0 || state->last >= state->end_block)) {
+			sync_requested.reset();
+		}
+		if (sent > 0 && idle && trigger_send) {
+			do_queue_write();
+		}
+		return sent > 0;
 	}
 
 
@@ -51,13 +51,14 @@ namespace Xmaxplatform {
 	* Index by start_block_num
 	*/
 	struct sync_state {
-		sync_state(uint32_t start = 0, uint32_t end = 0, uint32_t last_acted = 0)
-			:start_block(start), end_block(end), last(last_acted),
+		sync_state(uint32_t start = 0, uint32_t end = 0, uint32_t last_acted = 0, uint32_t window = 0)
+			:start_block(start), end_block(end), last(last_acted), window_size(window),
 			start_time(time_point::now())//, block_cache()
 		{}
 		Chain::xmax_type_block_num     start_block;
 		Chain::xmax_type_block_num     end_block;
 		Chain::xmax_type_block_num     last; ///< last sent or received
+		uint32_t     window_size; ///< bytes of blocks kept in the write queue while sending, 0 for one block at a time
 		time_point   start_time; ///< time request made or received
 	};
 	using sync_state_ptr = shared_ptr< sync_state >;
@@ -209,7 +210,6 @@ namespace Xmaxplatform {
 		void send_handshake();
 		void send_signedblock(const Chain::signed_block &sb);
 		void send_blockconfirm(const Chain::block_confirmation& confirm);
-		void send_signedblocklist(const Chain::vector<Chain::signed_block>& blockList);
 		void send_connection_iplist(const connecting_nodes_message& msg);
 		std::string get_connecting_endpoint();
 		void send_pending_block();
@@ -255,7 +255,7 @@ namespace Xmaxplatform {
 		void cancel_sync(leave_reason);
 		void cancel_fetch();
 		void flush_queues();
-		bool enqueue_sync_block();
+		bool enqueue_sync_block(bool trigger_send = true);
 
 		void cancel_wait();
 		void sync_wait();
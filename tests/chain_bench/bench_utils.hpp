@@ -0,0 +1,77 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+	struct bench_case
+	{
+		std::string				name;
+		std::function<void()>	run;
+	};
+
+	inline std::vector<bench_case>& all_cases()
+	{
+		static std::vector<bench_case> cases;
+		return cases;
+	}
+
+	struct bench_register
+	{
+		bench_register(const char* name, std::function<void()> run)
+		{
+			all_cases().push_back(bench_case{ name, run });
+		}
+	};
+
+	class bench_timer
+	{
+	public:
+		bench_timer()
+			: start(std::chrono::high_resolution_clock::now())
+		{
+		}
+
+		double seconds() const
+		{
+			return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+
+	private:
+		std::chrono::high_resolution_clock::time_point start;
+	};
+
+	inline void report(const std::string& label, uint64_t ops, double seconds)
+	{
+		std::cout << "  " << std::left << std::setw(40) << label
+			<< std::right << std::setw(12) << ops << " ops  "
+			<< std::setw(10) << std::fixed << std::setprecision(3) << seconds << " s  "
+			<< std::setw(14) << std::setprecision(1) << (seconds > 0 ? ops / seconds : 0.0) << " ops/s" << std::endl;
+	}
+
+	// temp directory removed when the bench case ends.
+	struct temp_dir
+	{
+		boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+		~temp_dir()
+		{
+			boost::system::error_code ec;
+			boost::filesystem::remove_all(path, ec);
+		}
+	};
+}
+
+#define XMAX_BENCH_CASE(bench_name) \
+	static void bench_name(); \
+	static bench::bench_register bench_name##_register(#bench_name, &bench_name); \
+	static void bench_name()
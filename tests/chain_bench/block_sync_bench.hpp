@@ -0,0 +1,106 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <deque>
+#include <memory>
+
+#include <chain_stream.hpp>
+
+#include "bench_utils.hpp"
+
+namespace {
+
+	using namespace Xmaxplatform::Chain;
+
+	using sync_buffer = std::shared_ptr<std::vector<char>>;
+
+	// what one node sends and the other appends, a block packed the way it goes on the wire.
+	static sync_buffer pack_sync_block(const signed_block& block)
+	{
+		return std::make_shared<std::vector<char>>(fc::raw::pack(block));
+	}
+
+	static void append_sync_block(chain_stream& target, const std::vector<char>& buff)
+	{
+		target.append_block(std::make_shared<signed_block>(fc::raw::unpack<signed_block>(buff)));
+	}
+}
+
+// a node catching up 100k blocks from a peer's block log, the peer either copies the whole range
+// into a pending list or streams it through a bounded send window that the receiver drains.
+XMAX_BENCH_CASE(block_sync_stream)
+{
+	const uint32_t block_count = 100000;
+	const uint32_t window_size = 4 * 1024 * 1024;
+
+	bench::temp_dir source_dir;
+	chain_stream source(source_dir.path);
+	for (const auto& block : make_bench_blocks(block_count, 20))
+	{
+		source.append_block(block);
+	}
+
+	{
+		bench::temp_dir target_dir;
+		chain_stream target(target_dir.path);
+
+		bench::bench_timer timer;
+		// the whole range is copied out before the first block goes on the wire.
+		std::vector<signed_block_ptr> blocks = source.read_block_range(1, block_count);
+		std::deque<signed_block> pending(blocks.size());
+		uint64_t peak = 0;
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			pending[i] = *blocks[i];
+			peak += fc::raw::pack_size(pending[i]);
+		}
+		blocks.clear();
+
+		uint32_t received = 0;
+		while (!pending.empty())
+		{
+			append_sync_block(target, *pack_sync_block(pending.front()));
+			pending.pop_front();
+			++received;
+		}
+		bench::report("whole range list", received, timer.seconds());
+		std::cout << "  peak send buffer " << peak / 1024 << " KB" << std::endl;
+	}
+
+	{
+		bench::temp_dir target_dir;
+		chain_stream target(target_dir.path);
+
+		bench::bench_timer timer;
+		std::deque<sync_buffer> window;
+		uint64_t queued = 0;
+		uint64_t peak = 0;
+		uint32_t last = 0;
+		uint32_t received = 0;
+		bool more = true;
+		while (more || !window.empty())
+		{
+			// the sender tops the queue up to the window as the receiver drains it.
+			if (more && queued < window_size)
+			{
+				const uint32_t sent = source.for_each_block(last + 1, block_count, [&](const signed_block_ptr& block) {
+					window.push_back(pack_sync_block(*block));
+					queued += window.back()->size();
+					last = block->block_num();
+					return queued < window_size;
+				});
+				more = sent > 0 && last < block_count;
+				peak = std::max(peak, queued);
+			}
+
+			append_sync_block(target, *window.front());
+			queued -= window.front()->size();
+			window.pop_front();
+			++received;
+		}
+		bench::report("windowed stream", received, timer.seconds());
+		std::cout << "  peak send buffer " << peak / 1024 << " KB" << std::endl;
+	}
+}
@@ -0,0 +1,67 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <chain_snapshot.hpp>
+#include <xmax_indexes.hpp>
+#include <objects/key_value_object.hpp>
+#include <objects/transaction_object.hpp>
+
+#include "bench_utils.hpp"
+
+// export and import of a state with many contract rows, against building the same state object by object.
+XMAX_BENCH_CASE(chain_snapshot_export_import)
+{
+	using namespace Xmaxplatform::Chain;
+
+	const uint32_t rows = 200000;
+	const uint32_t trxs = 100000;
+	const uint64_t file_size = 1024ull * 1024 * 1024;
+
+	auto fill = [&](Basechain::database& db) {
+		for (uint32_t i = 0; i < rows; ++i)
+		{
+			db.create<key_value_object>([&](key_value_object& obj) {
+				obj.scope = STN(bench);
+				obj.code = STN(bench);
+				obj.table = STN(rows);
+				obj.primary_key = i;
+				obj.value.assign(64, 'v');
+			});
+		}
+		for (uint64_t seq = 0; seq < trxs; ++seq)
+		{
+			db.create<transaction_object>([&](transaction_object& obj) {
+				obj.trx_id = xmax_type_transaction_id::hash(seq);
+				obj.expiration = fc::time_point_sec(1000000 + seq);
+			});
+		}
+	};
+
+	bench::temp_dir dir;
+	block_pack root;
+	root.block = std::make_shared<signed_block>();
+	root.block_id = root.block->id();
+	snapshot_header header;
+	header.block_id = root.block_id;
+
+	Basechain::database source(dir.path / "source", Basechain::database::read_write, file_size);
+	setup_xmax_indexes(source);
+
+	bench::bench_timer timer;
+	fill(source);
+	bench::report("create objects", rows + trxs, timer.seconds());
+
+	timer = bench::bench_timer();
+	uint64_t size = write_snapshot(dir.path / "state.snapshot", source, header, root);
+	bench::report("export snapshot", rows + trxs, timer.seconds());
+	std::cout << "  snapshot " << size / 1024 << " KB" << std::endl;
+
+	Basechain::database target(dir.path / "target", Basechain::database::read_write, file_size);
+	setup_xmax_indexes(target);
+
+	timer = bench::bench_timer();
+	read_snapshot(dir.path / "state.snapshot", target, root);
+	bench::report("import snapshot", rows + trxs, timer.seconds());
+}
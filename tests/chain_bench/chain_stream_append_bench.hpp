@@ -0,0 +1,43 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <chain_stream.hpp>
+
+#include "bench_utils.hpp"
+#include "chain_stream_bench.hpp"
+
+XMAX_BENCH_CASE(chain_stream_append)
+{
+	const uint32_t block_count = 5000;
+
+	auto blocks = make_bench_blocks(block_count, 20);
+
+	struct policy
+	{
+		std::string name;
+		block_log_config::durability_mode durability;
+	};
+
+	for (const policy& p : { policy{ "block", block_log_config::flush_every_block },
+		policy{ "count", block_log_config::flush_every_n_blocks },
+		policy{ "interval", block_log_config::flush_interval },
+		policy{ "demand", block_log_config::flush_on_demand } })
+	{
+		block_log_config config;
+		config.durability = p.durability;
+
+		bench::temp_dir dir;
+		bench::bench_timer timer;
+		{
+			chain_stream stream(dir.path, config);
+			for (const auto& block : blocks)
+			{
+				stream.append_block(block);
+			}
+			stream.flush();
+		}
+		bench::report("append_block, flush=" + p.name, block_count, timer.seconds());
+	}
+}
@@ -0,0 +1,88 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <atomic>
+#include <random>
+#include <thread>
+
+#include <chain_stream.hpp>
+
+#include "bench_utils.hpp"
+
+namespace {
+
+	using namespace Xmaxplatform::Chain;
+
+	static std::vector<signed_block_ptr> make_bench_blocks(uint32_t count, uint32_t receipts_per_block)
+	{
+		std::vector<signed_block_ptr> blocks;
+		blocks.reserve(count);
+
+		xmax_type_block_id previous;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			signed_block_ptr block = std::make_shared<signed_block>();
+			block->previous = previous;
+			for (uint32_t r = 0; r < receipts_per_block; ++r)
+			{
+				block->receipts.emplace_back(xmax_type_transaction_id::hash(std::to_string(i) + "/" + std::to_string(r)));
+				block->receipts.back().receipt_idx = r;
+			}
+			previous = block->id();
+			blocks.push_back(block);
+		}
+		return blocks;
+	}
+}
+
+XMAX_BENCH_CASE(chain_stream_parallel_read)
+{
+	const uint32_t block_count = 20000;
+	const uint32_t reads_per_thread = 100000;
+
+	bench::temp_dir dir;
+	chain_stream stream(dir.path);
+	for (const auto& block : make_bench_blocks(block_count, 20))
+	{
+		stream.append_block(block);
+	}
+
+	for (uint32_t threads : { 1, 2, 4, 8 })
+	{
+		std::atomic<uint64_t> receipt_total{ 0 };
+		std::vector<std::thread> workers;
+
+		bench::bench_timer timer;
+		for (uint32_t t = 0; t < threads; ++t)
+		{
+			workers.emplace_back([&, t]() {
+				std::mt19937 rng(t);
+				std::uniform_int_distribution<uint32_t> pick(1, block_count);
+				uint64_t receipts = 0;
+				for (uint32_t i = 0; i < reads_per_thread; ++i)
+				{
+					receipts += stream.read_block(pick(rng))->receipts.size();
+				}
+				receipt_total += receipts;
+			});
+		}
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+
+		bench::report("random read_block, threads=" + std::to_string(threads), (uint64_t)threads * reads_per_thread, timer.seconds());
+	}
+
+	{
+		bench::bench_timer timer;
+		uint64_t blocks = 0;
+		for (uint32_t first = 1; first <= block_count; first += 100)
+		{
+			blocks += stream.read_block_range(first, first + 99).size();
+		}
+		bench::report("sequential read_block_range(100)", blocks, timer.seconds());
+	}
+}
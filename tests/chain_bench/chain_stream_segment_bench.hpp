@@ -0,0 +1,73 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <random>
+
+#include <chain_stream.hpp>
+
+#include "bench_utils.hpp"
+#include "chain_stream_bench.hpp"
+
+// raw against zlib segments: append rate, read latency and size on disk.
+XMAX_BENCH_CASE(chain_stream_segment_codec)
+{
+	const uint32_t block_count = 20000;
+	const uint32_t reads = 200000;
+
+	// receipts of distinct transactions barely compress, so also try blocks repeating a few receipts.
+	auto unique_blocks = make_bench_blocks(block_count, 20);
+	auto repeated_blocks = make_bench_blocks(block_count, 0);
+	for (auto& block : repeated_blocks)
+	{
+		for (uint32_t r = 0; r < 20; ++r)
+		{
+			block->receipts.emplace_back(xmax_type_transaction_id::hash(std::to_string(r % 4)));
+		}
+	}
+
+	for (int run = 0; run < 4; ++run)
+	{
+		bool compress = (run % 2) == 1;
+		const auto& blocks = run < 2 ? unique_blocks : repeated_blocks;
+		std::string codec = std::string(compress ? "zlib" : "raw") + (run < 2 ? ", unique" : ", repeated");
+
+		block_log_config config;
+		config.compress = compress;
+		config.durability = block_log_config::flush_every_n_blocks;
+
+		bench::temp_dir dir;
+		chain_stream stream(dir.path, config);
+		{
+			bench::bench_timer timer;
+			for (const auto& block : blocks)
+			{
+				stream.append_block(block);
+			}
+			stream.flush();
+			bench::report("append_block, codec=" + codec, block_count, timer.seconds());
+		}
+
+		uint64_t log_bytes = 0;
+		for (boost::filesystem::directory_iterator it(dir.path), end; it != end; ++it)
+		{
+			if (it->path().extension() == ".log")
+				log_bytes += boost::filesystem::file_size(it->path());
+		}
+		std::cout << "  segment bytes, codec=" << codec << ": " << log_bytes << std::endl;
+
+		{
+			std::mt19937 rng(1);
+			std::uniform_int_distribution<uint32_t> pick(1, block_count);
+			uint64_t receipts = 0;
+
+			bench::bench_timer timer;
+			for (uint32_t i = 0; i < reads; ++i)
+			{
+				receipts += stream.read_block(pick(rng))->receipts.size();
+			}
+			bench::report("random read_block, codec=" + codec, reads, timer.seconds());
+		}
+	}
+}
@@ -0,0 +1,88 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <algorithm>
+#include <random>
+#include <thread>
+
+#include <objects/transaction_object.hpp>
+
+#include "bench_utils.hpp"
+
+// block production time of a node updating 2000 objects per 100ms slot in a 1GB state,
+// flush() before every block against the background flusher at every block, and durable on a cadence.
+XMAX_BENCH_CASE(database_flush_block_latency)
+{
+	using namespace Xmaxplatform::Chain;
+
+	const uint32_t objects = 1000000;
+	const uint32_t blocks = 100;
+	const uint32_t per_block = 2000;
+	const auto slot = std::chrono::milliseconds(100);
+	const uint64_t file_size = 1024ull * 1024 * 1024;
+
+	struct flush_mode
+	{
+		const char*	label;
+		bool		background;
+		uint32_t	interval_ms;
+		bool		durable;
+	};
+
+	for (const flush_mode& mode : {
+		flush_mode{ "blocks, flush before each block", false, 0, false },
+		flush_mode{ "blocks, background at each block", true, 0, false },
+		flush_mode{ "blocks, durable every 1000 ms", true, 1000, true } })
+	{
+		bench::temp_dir dir;
+		Basechain::database db(dir.path, Basechain::database::read_write, file_size);
+		db.add_index<transaction_multi_index>();
+
+		for (uint64_t seq = 0; seq < objects; ++seq)
+		{
+			db.create<transaction_object>([&](transaction_object& obj) {
+				obj.trx_id = xmax_type_transaction_id::hash(seq);
+				obj.expiration = fc::time_point_sec(1000000);
+			});
+		}
+		db.flush();
+		if (mode.background)
+			db.start_background_flush(mode.interval_ms, mode.durable);
+
+		std::mt19937 rng(11);
+		std::uniform_int_distribution<uint32_t> pick(0, objects - 1);
+		std::vector<double> latency;
+		double busy = 0;
+
+		for (uint32_t block = 1; block <= blocks; ++block)
+		{
+			auto slot_end = std::chrono::steady_clock::now() + slot;
+
+			bench::bench_timer timer;
+			if (!mode.background)
+				db.flush();
+
+			auto session = db.start_undo_session(true);
+			for (uint32_t i = 0; i < per_block; ++i)
+			{
+				db.modify(db.get<transaction_object>(transaction_object::id_type(pick(rng))), [&](transaction_object& obj) {
+					obj.expiration = fc::time_point_sec(1000000 + block);
+				});
+			}
+			session.push();
+			db.commit(db.revision());
+			db.request_flush();
+
+			latency.push_back(timer.seconds() * 1000);
+			busy += timer.seconds();
+			std::this_thread::sleep_until(slot_end);
+		}
+		bench::report(mode.label, blocks, busy);
+
+		std::sort(latency.begin(), latency.end());
+		std::cout << "  block ms p50 " << latency[blocks / 2] << ", p99 " << latency[blocks * 99 / 100]
+			<< ", max " << latency.back() << ", flush passes " << db.background_flush_passes() << std::endl;
+	}
+}
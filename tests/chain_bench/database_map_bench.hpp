@@ -0,0 +1,115 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <random>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <objects/transaction_object.hpp>
+
+#include "bench_utils.hpp"
+
+namespace bench {
+
+	// drop the clean pages of file from the page cache, the next open starts cold.
+	inline void evict_file(const boost::filesystem::path& file)
+	{
+#ifndef WIN32
+		int fd = ::open(file.generic_string().c_str(), O_RDONLY);
+		if (fd >= 0)
+		{
+			::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			::close(fd);
+		}
+#endif
+	}
+}
+
+// random find and modify on a 1GB state opened cold, under each way of mapping the segment.
+// the open time includes the prefault or mlock pass.
+XMAX_BENCH_CASE(database_map_modes)
+{
+	using namespace Xmaxplatform::Chain;
+
+	const uint32_t objects = 1000000;
+	const uint32_t ops = 500000;
+	const uint64_t file_size = 1024ull * 1024 * 1024;
+
+	bench::temp_dir dir;
+	{
+		Basechain::database db(dir.path, Basechain::database::read_write, file_size);
+		db.add_index<transaction_multi_index>();
+		for (uint64_t seq = 0; seq < objects; ++seq)
+		{
+			db.create<transaction_object>([&](transaction_object& obj) {
+				obj.trx_id = xmax_type_transaction_id::hash(seq);
+				obj.expiration = fc::time_point_sec(1000000);
+			});
+		}
+	}
+
+	struct map_mode
+	{
+		const char*				label;
+		Basechain::map_options	options;
+		bool					random_hint;
+	};
+
+	Basechain::map_options huge;
+	huge.huge_pages = true;
+	Basechain::map_options prefault;
+	prefault.prefault = true;
+	Basechain::map_options lock;
+	lock.lock = true;
+
+	for (const map_mode& mode : {
+		map_mode{ "default", Basechain::map_options(), false },
+		map_mode{ "random access hint", Basechain::map_options(), true },
+		map_mode{ "huge pages", huge, false },
+		map_mode{ "prefault", prefault, false },
+		map_mode{ "mlock", lock, false } })
+	{
+		bench::evict_file(dir.path / "shared_memory.bin");
+		std::cout << "  " << mode.label << std::endl;
+
+		try
+		{
+			bench::bench_timer timer;
+			Basechain::database db(dir.path, Basechain::database::read_write, file_size, mode.options);
+			db.add_index<transaction_multi_index>();
+			if (mode.random_hint)
+				db.advise(Basechain::database::access_random);
+			bench::report("open", 1, timer.seconds());
+
+			std::mt19937 rng(17);
+			std::uniform_int_distribution<uint64_t> pick(0, objects - 1);
+
+			timer = bench::bench_timer();
+			uint64_t found = 0;
+			for (uint32_t i = 0; i < ops; ++i)
+			{
+				const auto* obj = db.find<transaction_object, by_trx_id>(xmax_type_transaction_id::hash(pick(rng)));
+				found += obj != nullptr;
+			}
+			bench::report("find by trx id", found, timer.seconds());
+
+			timer = bench::bench_timer();
+			for (uint32_t i = 0; i < ops; ++i)
+			{
+				db.modify(db.get<transaction_object>(transaction_object::id_type(pick(rng))), [&](transaction_object& obj) {
+					obj.expiration = fc::time_point_sec(1000000 + i);
+				});
+			}
+			bench::report("modify by id", ops, timer.seconds());
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "  skipped: " << e.what() << std::endl;
+		}
+	}
+}
@@ -0,0 +1,38 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#include "bench_utils.hpp"
+
+#include "chain_stream_bench.hpp"
+#include "chain_stream_append_bench.hpp"
+#include "chain_stream_segment_bench.hpp"
+#include "block_sync_bench.hpp"
+#include "transaction_pool_bench.hpp"
+#include "transaction_request_bench.hpp"
+#include "signature_recovery_bench.hpp"
+#include "transaction_object_bench.hpp"
+#include "chain_snapshot_bench.hpp"
+#include "database_flush_bench.hpp"
+#include "database_map_bench.hpp"
+#include "wasm_code_cache_bench.hpp"
+#include "wasm_metering_bench.hpp"
+#include "wasm_memory_reset_bench.hpp"
+#include "wasm_invoke_bench.hpp"
+
+
+// usage: chain_bench [case name filter]
+int main(int argc, char** argv)
+{
+	std::string filter = argc > 1 ? argv[1] : "";
+
+	for (const auto& c : bench::all_cases())
+	{
+		if (!filter.empty() && c.name.find(filter) == std::string::npos)
+			continue;
+
+		std::cout << c.name << std::endl;
+		c.run();
+	}
+	return 0;
+}
@@ -0,0 +1,54 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <thread>
+
+#include <signature_recovery.hpp>
+
+#include "bench_utils.hpp"
+
+namespace {
+
+	using namespace Xmaxplatform::Chain;
+
+	static std::vector<transaction_request_ptr> make_bench_block(const std::vector<Xmaxplatform::Chain::signed_transaction>& trxs)
+	{
+		std::vector<transaction_request_ptr> requests;
+		requests.reserve(trxs.size());
+		for (const auto& trx : trxs)
+		{
+			requests.push_back(std::make_shared<transaction_request>(trx));
+		}
+		return requests;
+	}
+}
+
+// the signature side of _apply_block: post the block to the workers, then the serial apply asks each
+// transaction for its keys and checks the signer. 0 threads is the old serial path.
+XMAX_BENCH_CASE(signature_recovery_block_apply)
+{
+	const uint32_t count = 2000;
+	const chain_id_type chain_id = fc::sha256::hash(std::string("bench chain"));
+	const auto trxs = make_bench_transfers(count, chain_id);
+	const public_key_type signer = public_key_type(private_key_type::regenerate(fc::sha256::hash(std::string("bench"))).get_public_key());
+
+	std::cout << "  " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+	for (uint32_t threads : { 0, 1, 2, 4, 8 })
+	{
+		signature_recovery recovery(chain_id, threads);
+		auto requests = make_bench_block(trxs);
+
+		uint64_t authorized = 0;
+		bench::bench_timer timer;
+		recovery.post(requests);
+		for (const auto& request : requests)
+		{
+			auto keys = request->get_signature_keys(chain_id);
+			if (keys.find(signer) != keys.end())
+				++authorized;
+		}
+		bench::report("apply " + std::to_string(count) + " trxs, " + std::to_string(threads) + " recovery threads", authorized, timer.seconds());
+	}
+}
@@ -0,0 +1,59 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <chain_utils.hpp>
+#include <objects/transaction_object.hpp>
+
+#include "bench_utils.hpp"
+
+// dedup table of a node taking 200 trxs per 1s block with a 60s lifetime, with and without the sweep.
+XMAX_BENCH_CASE(transaction_object_steady_state)
+{
+	using namespace Xmaxplatform::Chain;
+
+	const uint32_t blocks = 3000;
+	const uint32_t per_block = 200;
+	const uint32_t lifetime_s = 60;
+	const uint64_t file_size = 512ull * 1024 * 1024;
+
+	for (bool prune : { false, true })
+	{
+		bench::temp_dir dir;
+		Basechain::database db(dir.path, Basechain::database::read_write, file_size);
+		db.add_index<transaction_multi_index>();
+		const size_t start_free = db.get_free_memory();
+
+		uint64_t seq = 0;
+		bench::bench_timer timer;
+		for (uint32_t block = 1; block <= blocks; ++block)
+		{
+			fc::time_point_sec now(1000000 + block);
+			auto session = db.start_undo_session(true);
+			for (uint32_t i = 0; i < per_block; ++i, ++seq)
+			{
+				db.create<transaction_object>([&](transaction_object& obj) {
+					obj.trx_id = xmax_type_transaction_id::hash(seq);
+					obj.expiration = now + 1 + seq % lifetime_s;
+				});
+			}
+			if (prune)
+				utils::prune_expired_transactions(db, now, Xmaxplatform::Config::max_transaction_prune_per_block);
+			session.push();
+			db.commit(db.revision());
+		}
+		bench::report(prune ? "blocks, pruned" : "blocks, never pruned", blocks, timer.seconds());
+
+		const auto& idx = db.get_index<transaction_multi_index, by_trx_id>();
+		std::cout << "  records " << idx.size() << ", shared memory used " << (start_free - db.get_free_memory()) / 1024 << " KB" << std::endl;
+
+		timer = bench::bench_timer();
+		uint64_t found = 0;
+		for (uint64_t i = 0; i < 100000; ++i)
+		{
+			found += idx.count(xmax_type_transaction_id::hash(seq - 1 - i % (per_block * lifetime_s)));
+		}
+		bench::report("validate_uniqueness lookups", 100000, timer.seconds());
+	}
+}
@@ -0,0 +1,92 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <random>
+
+#include <transaction_pool.hpp>
+
+#include "bench_utils.hpp"
+
+namespace {
+
+	using namespace Xmaxplatform::Chain;
+
+	static std::vector<transaction_request_ptr> make_bench_transactions(uint32_t count)
+	{
+		std::vector<transaction_request_ptr> requests;
+		requests.reserve(count);
+
+		std::mt19937 rng(7);
+		std::uniform_int_distribution<uint32_t> gas(1, 1000);
+		std::uniform_int_distribution<uint32_t> payer(0, 999);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Xmaxplatform::Chain::signed_transaction trx;
+			trx.ref_block_num = i & 0xffff;
+			trx.ref_block_prefix = i;
+			trx.gas = gas(rng);
+			trx.gas_payer = account_name("payer" + std::to_string(payer(rng)));
+			trx.expiration = fc::time_point(fc::seconds(1000 + i % 600));
+			trx.messages.resize(1);
+			requests.push_back(std::make_shared<transaction_request>(trx));
+		}
+		return requests;
+	}
+}
+
+XMAX_BENCH_CASE(transaction_pool_throughput)
+{
+	const uint32_t count = 200000;
+	auto requests = make_bench_transactions(count);
+
+	transaction_pool_config config;
+	config.max_per_payer = 0;
+	transaction_pool pool(config);
+	{
+		bench::bench_timer timer;
+		for (const auto& request : requests)
+		{
+			pool.add(request);
+		}
+		bench::report("add", count, timer.seconds());
+	}
+	std::cout << "  queued " << pool.size() << " transactions, " << pool.bytes() / 1024 << " KB" << std::endl;
+	{
+		bench::bench_timer timer;
+		for (const auto& request : requests)
+		{
+			pool.add(request);
+		}
+		bench::report("add duplicate", count, timer.seconds());
+	}
+	{
+		bench::bench_timer timer;
+		uint64_t selected = 0;
+		for (int i = 0; i < 100; ++i)
+		{
+			selected += pool.select_by_gas(500).size();
+		}
+		bench::report("select_by_gas(500) from a full pool", selected, timer.seconds());
+	}
+	{
+		bench::bench_timer timer;
+		size_t removed = pool.remove_expired(fc::time_point(fc::seconds(1300)));
+		bench::report("remove_expired", removed, timer.seconds());
+	}
+	{
+		// a byte budget of a quarter of the load keeps evicting the cheapest entries.
+		transaction_pool_config bounded;
+		bounded.max_per_payer = 0;
+		bounded.max_bytes = pool.bytes() / 4;
+		transaction_pool small(bounded);
+
+		bench::bench_timer timer;
+		for (const auto& request : requests)
+		{
+			small.add(request);
+		}
+		bench::report("add with eviction", count, timer.seconds());
+	}
+}
@@ -0,0 +1,93 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <fc/io/raw.hpp>
+
+#include <block.hpp>
+#include <transaction_request.hpp>
+
+#include "bench_utils.hpp"
+
+namespace {
+
+	using namespace Xmaxplatform::Chain;
+
+	static std::vector<Xmaxplatform::Chain::signed_transaction> make_bench_transfers(uint32_t count, const chain_id_type& chain_id)
+	{
+		const private_key_type key = private_key_type::regenerate(fc::sha256::hash(std::string("bench")));
+
+		std::vector<Xmaxplatform::Chain::signed_transaction> trxs;
+		trxs.reserve(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Xmaxplatform::Chain::signed_transaction trx;
+			trx.ref_block_num = i & 0xffff;
+			trx.ref_block_prefix = i;
+			trx.gas = 1;
+			trx.gas_payer = account_name("alice");
+			trx.expiration = fc::time_point(fc::seconds(1000));
+			trx.scope = { account_name("alice"), account_name("bob") };
+			transaction_emplace_serialized_message(trx, account_name("xmax"), func_name("transfer"),
+				Xmaxplatform::Basetypes::vector<Xmaxplatform::Basetypes::account_auth>{ { account_name("alice"), authority_name("active") } },
+				fc::raw::pack(Xmaxplatform::Basetypes::transfer(account_name("alice"), account_name("bob"), i, "bench transfer")));
+			trx.sign(key, chain_id);
+			trxs.push_back(std::move(trx));
+		}
+		return trxs;
+	}
+}
+
+// the hashing and copying one push does per transaction: uniqueness check, signing digest, record,
+// receipt and one owner id per message. key recovery is timed apart since it is the same on both paths.
+XMAX_BENCH_CASE(transaction_request_push_hashing)
+{
+	const uint32_t count = 10000;
+	const chain_id_type chain_id = fc::sha256::hash(std::string("bench chain"));
+	const auto trxs = make_bench_transfers(count, chain_id);
+
+	uint64_t sink = 0;
+	double recompute = 0;
+	{
+		bench::bench_timer timer;
+		for (const auto& trx : trxs)
+		{
+			transaction_package package(trx);
+			Xmaxplatform::Chain::signed_transaction unpacked = package.unpack_trx();
+			sink += unpacked.id()._hash[0];												// validate_uniqueness
+			sink += unpacked.sig_digest(chain_id)._hash[0];								// get_signature_keys
+			for (size_t m = 0; m < unpacked.messages.size(); ++m)
+				sink += unpacked.id()._hash[0];											// message owner id
+			sink += unpacked.id()._hash[0];												// record_transaction
+			sink += transaction_receipt(transaction_package(unpacked)).trx.which();		// receipt
+		}
+		recompute = timer.seconds();
+		bench::report("recomputed per call", count, recompute);
+	}
+	{
+		bench::bench_timer timer;
+		for (const auto& trx : trxs)
+		{
+			transaction_request request(trx);
+			sink += request.id._hash[0];
+			sink += request.sig_digest(chain_id)._hash[0];
+			for (size_t m = 0; m < request.signed_trx.messages.size(); ++m)
+				sink += request.id._hash[0];
+			sink += request.id._hash[0];
+			sink += transaction_receipt(request.package).trx.which();
+		}
+		double cached = timer.seconds();
+		bench::report("cached on transaction_request", count, cached);
+		std::cout << "  saved " << std::setprecision(2) << (recompute - cached) * 1e6 / count << " us per transaction" << std::endl;
+	}
+	{
+		bench::bench_timer timer;
+		for (const auto& trx : trxs)
+		{
+			sink += trx.get_signature_keys(chain_id).size();
+		}
+		bench::report("key recovery, both paths", count, timer.seconds());
+	}
+	std::cout << "  (" << sink % 2 << ")" << std::endl;
+}
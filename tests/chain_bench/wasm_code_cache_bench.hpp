@@ -0,0 +1,94 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <fstream>
+#include <sstream>
+
+#include <Inline/Serialization.h>
+#include <IR/Module.h>
+#include <WASM/WASM.h>
+#include <Runtime/Linker.h>
+#include <Runtime/Runtime.h>
+
+#include <vm_xmax.hpp>
+#include <wast_to_wasm.hpp>
+#include <wasm_code_cache.hpp>
+
+#include "bench_utils.hpp"
+
+namespace {
+
+	static std::vector<uint8_t> load_sample_wasm(const std::string& name)
+	{
+		std::ifstream file(std::string(XMAX_CONTRACT_CODE_DIR) + "/" + name + "/" + name + ".wast");
+		std::stringstream wast;
+		wast << file.rdbuf();
+		return Xmaxplatform::Chain::ConvertFromWastToWasm(wast.str());
+	}
+
+	// what vm_xmax::load does before a contract runs, the module is prepared the same way every time.
+	static double instantiate_sample(const std::vector<uint8_t>& wasm, Xmaxplatform::Chain::wasm_code_cache* cache, const std::string& key)
+	{
+		bench::bench_timer timer;
+		IR::Module* module = new IR::Module();
+		Serialization::MemoryInputStream stream((const U8*)wasm.data(), wasm.size());
+		WASM::serializeWithInjection(stream, *module);
+
+		Runtime::LinkResult link = Runtime::linkModule(*module, Runtime::IntrinsicResolver::singleton);
+		Runtime::ModuleInstance* instance = cache
+			? Runtime::instantiateModule(*module, std::move(link.resolvedImports), cache, key)
+			: Runtime::instantiateModule(*module, std::move(link.resolvedImports));
+		if (!instance)
+			throw std::runtime_error("instantiate failed");
+		return timer.seconds();
+	}
+}
+
+// latency before the first call of the contract_code samples: compiled by llvm with no cache,
+// compiled and stored by an empty cache, and loaded from the cache a restart finds on disk.
+XMAX_BENCH_CASE(wasm_code_cache_first_call)
+{
+	using namespace Xmaxplatform::Chain;
+
+	// registers the intrinsics the samples import.
+	vm_xmax::get();
+	std::cout << "  " << Runtime::getObjectCodeFingerprint() << std::endl;
+
+	const uint32_t rounds = 20;
+	for (const char* name : { "testcontract", "testevent" })
+	{
+		const std::vector<uint8_t> wasm = load_sample_wasm(name);
+		const std::string key = fc::sha256::hash(std::string(name) + Runtime::getObjectCodeFingerprint()).str();
+		std::cout << "  " << name << ", " << wasm.size() << " bytes of wasm" << std::endl;
+
+		double seconds = 0;
+		for (uint32_t i = 0; i < rounds; ++i)
+		{
+			seconds += instantiate_sample(wasm, nullptr, key);
+		}
+		bench::report("no cache", rounds, seconds);
+
+		bench::temp_dir dir;
+		seconds = 0;
+		for (uint32_t i = 0; i < rounds; ++i)
+		{
+			// an empty cache each time, every round compiles and stores.
+			boost::filesystem::remove_all(dir.path);
+			wasm_code_cache cache(dir.path, 64 * 1024 * 1024);
+			seconds += instantiate_sample(wasm, &cache, key);
+		}
+		bench::report("cold cache", rounds, seconds);
+
+		seconds = 0;
+		uint64_t hits = 0;
+		for (uint32_t i = 0; i < rounds; ++i)
+		{
+			wasm_code_cache cache(dir.path, 64 * 1024 * 1024);
+			seconds += instantiate_sample(wasm, &cache, key);
+			hits += cache.stats().hits;
+		}
+		bench::report("warm cache", hits, seconds);
+	}
+}
@@ -0,0 +1,62 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <Inline/Serialization.h>
+#include <IR/Module.h>
+#include <WASM/WASM.h>
+#include <Runtime/Linker.h>
+#include <Runtime/Runtime.h>
+
+#include <vm_xmax.hpp>
+#include <wast_to_wasm.hpp>
+
+#include "bench_utils.hpp"
+
+// the cost of entering a contract for each message: an apply that returns at once,
+// looked up by name with boxed arguments the way vm_call did, and through an invoker resolved at load.
+XMAX_BENCH_CASE(wasm_invoke_entry)
+{
+	const uint32_t calls = 1000000;
+	const uint64_t code = 1, type = 2;
+
+	// initializes the runtime.
+	Xmaxplatform::Chain::vm_xmax::get();
+
+	const std::vector<uint8_t> wasm = Xmaxplatform::Chain::ConvertFromWastToWasm(R"=====(
+(module
+ (export "apply" (func $apply))
+ (func $apply (param $code i64) (param $type i64))
+)
+)=====");
+	IR::Module module;
+	Serialization::MemoryInputStream stream((const U8*)wasm.data(), wasm.size());
+	WASM::serialize(stream, module);
+	Runtime::LinkResult link = Runtime::linkModule(module, Runtime::IntrinsicResolver::singleton);
+	Runtime::ModuleInstance* instance = Runtime::instantiateModule(module, std::move(link.resolvedImports));
+
+	{
+		bench::bench_timer timer;
+		for (uint32_t i = 0; i < calls; ++i)
+		{
+			Runtime::FunctionInstance* apply = Runtime::asFunctionNullable(Runtime::getInstanceExport(instance, "apply"));
+			if (Runtime::getFunctionType(apply)->parameters.size() != 2)
+				return;
+			std::vector<Runtime::Value> args = { Runtime::Value(code), Runtime::Value(type) };
+			Runtime::invokeFunction(apply, args);
+		}
+		bench::report("export lookup and boxed arguments", calls, timer.seconds());
+	}
+
+	{
+		const Runtime::FunctionInvoker apply = Runtime::getFunctionInvoker(Runtime::asFunctionNullable(Runtime::getInstanceExport(instance, "apply")));
+		bench::bench_timer timer;
+		for (uint32_t i = 0; i < calls; ++i)
+		{
+			U64 slots[3] = { code, type, 0 };
+			Runtime::invokeFunction(apply, slots);
+		}
+		bench::report("resolved invoker", calls, timer.seconds());
+	}
+}
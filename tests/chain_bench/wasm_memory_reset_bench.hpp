@@ -0,0 +1,84 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <cstring>
+
+#include <Inline/Serialization.h>
+#include <IR/Module.h>
+#include <WASM/WASM.h>
+#include <Runtime/Linker.h>
+#include <Runtime/Runtime.h>
+
+#include <vm_xmax.hpp>
+#include <wast_to_wasm.hpp>
+
+#include "bench_utils.hpp"
+
+namespace {
+
+	// a contract that stores its two arguments and returns, in a memory of the given number of 64KB pages.
+	static std::string trivial_contract_wast(uint32_t pages)
+	{
+		return "(module\n"
+			" (memory " + std::to_string(pages) + ")\n"
+			" (data (i32.const 16) \"xmax\")\n"
+			" (export \"apply\" (func $apply))\n"
+			" (func $apply (param $code i64) (param $type i64)\n"
+			"  (i64.store (i32.const 64) (get_local $code))\n"
+			"  (i64.store (i32.const 72) (get_local $type)))\n"
+			")\n";
+	}
+}
+
+// calls per second of a trivial contract when each call starts from a fresh memory,
+// rewritten in full before every call, or reset from its snapshot: copied back below three pages,
+// mapped copy-on-write and restored page by page from three pages up.
+XMAX_BENCH_CASE(wasm_memory_reset)
+{
+	// initializes the runtime.
+	Xmaxplatform::Chain::vm_xmax::get();
+
+	const uint32_t calls = 100000;
+	const std::vector<Runtime::Value> args = { Runtime::Value(uint64_t(1)), Runtime::Value(uint64_t(2)) };
+
+	for (uint32_t pages : { 1, 2, 3, 16 })
+	{
+		const std::vector<uint8_t> wasm = Xmaxplatform::Chain::ConvertFromWastToWasm(trivial_contract_wast(pages));
+		IR::Module module;
+		Serialization::MemoryInputStream stream((const U8*)wasm.data(), wasm.size());
+		WASM::serialize(stream, module);
+		Runtime::LinkResult link = Runtime::linkModule(module, Runtime::IntrinsicResolver::singleton);
+		Runtime::ModuleInstance* instance = Runtime::instantiateModule(module, std::move(link.resolvedImports));
+		Runtime::FunctionInstance* apply = Runtime::asFunction(Runtime::getInstanceExport(instance, "apply"));
+		Runtime::MemoryInstance* memory = Runtime::getDefaultMemory(instance);
+		U8* base = Runtime::getMemoryBaseAddress(memory);
+		const uint64_t memory_size = Runtime::getDefaultMemorySize(instance);
+		std::cout << "  " << memory_size / 1024 << " KB memory" << std::endl;
+
+		{
+			const std::vector<U8> init_memory(base, base + memory_size);
+			bench::bench_timer timer;
+			for (uint32_t i = 0; i < calls; ++i)
+			{
+				memcpy(base, init_memory.data(), init_memory.size());
+				Runtime::invokeFunction(apply, args);
+			}
+			bench::report("copy the initial memory", calls, timer.seconds());
+		}
+
+		{
+			Runtime::snapshotMemory(memory);
+			uint64_t restored = 0;
+			bench::bench_timer timer;
+			for (uint32_t i = 0; i < calls; ++i)
+			{
+				restored += Runtime::resetMemory(memory);
+				Runtime::invokeFunction(apply, args);
+			}
+			bench::report("snapshot reset", calls, timer.seconds());
+			std::cout << "  restored " << restored / calls << " bytes per call" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,104 @@
+/**
+*  @file
+*  @copyright defined in xmax/LICENSE
+*/
+#pragma once
+#include <Inline/Serialization.h>
+#include <IR/Module.h>
+#include <WASM/WASM.h>
+#include <Runtime/Intrinsics.h>
+#include <Runtime/Linker.h>
+#include <Runtime/Runtime.h>
+
+#include <vm_xmax.hpp>
+#include <wast_to_wasm.hpp>
+
+#include "bench_utils.hpp"
+
+namespace {
+
+	// what the wall clock checktime did on each call.
+	static void bench_checktime()
+	{
+		volatile int64_t now = fc::time_point::now().time_since_epoch().count();
+		(void)now;
+	}
+	static Intrinsics::Function bench_checktime_function("env.bench_checktime", IR::FunctionType::get(), (void*)&bench_checktime);
+
+	// the same loop bare, with a checktime call at its head the way loops were instrumented before, and left to the metering.
+	static const char* BenchLoopWast = R"=====(
+(module
+ (import "env" "bench_checktime" (func $checktime))
+ (export "sum" (func $sum))
+ (export "sum_checktime" (func $sum_checktime))
+ (func $sum (param $n i64) (result i64) (local $a i64)
+  (block $done
+   (loop $top
+    (br_if $done (i64.eqz (get_local $n)))
+    (set_local $a (i64.add (get_local $a) (i64.mul (get_local $n) (get_local $n))))
+    (set_local $n (i64.sub (get_local $n) (i64.const 1)))
+    (br $top)))
+  (get_local $a))
+ (func $sum_checktime (param $n i64) (result i64) (local $a i64)
+  (block $done
+   (loop $top
+    (call $checktime)
+    (br_if $done (i64.eqz (get_local $n)))
+    (set_local $a (i64.add (get_local $a) (i64.mul (get_local $n) (get_local $n))))
+    (set_local $n (i64.sub (get_local $n) (i64.const 1)))
+    (br $top)))
+  (get_local $a))
+)
+)=====";
+
+	static Runtime::ModuleInstance* instantiate_bench_loop(IR::Module& module, bool metered)
+	{
+		const std::vector<uint8_t> wasm = Xmaxplatform::Chain::ConvertFromWastToWasm(BenchLoopWast);
+		Serialization::MemoryInputStream stream((const U8*)wasm.data(), wasm.size());
+		if (metered)
+			WASM::serializeWithInjection(stream, module, Xmaxplatform::Chain::vm_xmax::default_operator_costs());
+		else
+			WASM::serialize(stream, module);
+
+		Runtime::LinkResult link = Runtime::linkModule(module, Runtime::IntrinsicResolver::singleton);
+		return Runtime::instantiateModule(module, std::move(link.resolvedImports));
+	}
+}
+
+// a tight contract loop of 100M passes, unmetered, checking the clock on every pass, and charged by the injected gas counter.
+XMAX_BENCH_CASE(wasm_metering_loop)
+{
+	using namespace Xmaxplatform::Chain;
+
+	// registers gas_exhausted.
+	vm_xmax::get();
+
+	const uint64_t passes = 100000000;
+	const std::vector<Runtime::Value> args = { Runtime::Value(passes) };
+
+	IR::Module plain_module;
+	Runtime::ModuleInstance* plain = instantiate_bench_loop(plain_module, false);
+	IR::Module metered_module;
+	Runtime::ModuleInstance* metered = instantiate_bench_loop(metered_module, true);
+	Runtime::GlobalInstance* gas = Runtime::getInstanceGlobal(metered, WASM::getGasGlobalIndex(metered_module));
+
+	{
+		bench::bench_timer timer;
+		Runtime::invokeFunction(Runtime::asFunction(Runtime::getInstanceExport(plain, "sum")), args);
+		bench::report("unmetered", passes, timer.seconds());
+	}
+
+	{
+		bench::bench_timer timer;
+		Runtime::invokeFunction(Runtime::asFunction(Runtime::getInstanceExport(plain, "sum_checktime")), args);
+		bench::report("wall clock checktime", passes, timer.seconds());
+	}
+
+	{
+		Runtime::setGlobalValue(gas, Runtime::Value(I64(INT64_MAX)));
+		bench::bench_timer timer;
+		Runtime::invokeFunction(Runtime::asFunction(Runtime::getInstanceExport(metered, "sum")), args);
+		bench::report("gas metered", passes, timer.seconds());
+		std::cout << "  gas used " << INT64_MAX - Runtime::getGlobalValue(gas).i64 << std::endl;
+	}
+}
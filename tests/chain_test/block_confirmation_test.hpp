@@ -0,0 +1,270 @@
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <blockchain_exceptions.hpp>
+#include <confirmation_verifier.hpp>
+#include <forkchain.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	static private_key_type BuilderKey(uint32_t i) {
+		return private_key_type::regenerate(fc::sha256::hash("builder" + std::to_string(i)));
+	}
+
+	static account_name BuilderName(uint32_t i) {
+		return account_name(std::string("bld") + char('a' + i / 26) + char('a' + i % 26));
+	}
+
+	static block_pack_ptr MakeConfirmPack(uint32_t builders) {
+		xmax_builder_infos infos;
+		for (uint32_t i = 0; i < builders; ++i)
+		{
+			infos.emplace_back(BuilderName(i), public_key_type(BuilderKey(i).get_public_key()));
+		}
+
+		block_pack_ptr pack = std::make_shared<block_pack>();
+		pack->block = std::make_shared<signed_block>();
+		pack->block->timestamp = chain_timestamp::create(1000);
+		pack->block_num = pack->block->block_num();
+		pack->block_id = pack->block->id();
+		pack->new_header = *pack->block;
+		pack->main_chain = true;
+		pack->current_builders.set_builders(infos, 1);
+		return pack;
+	}
+
+	static block_confirmation MakeConfirm(const block_pack_ptr& pack, uint32_t builder) {
+		return block_confirmation::make_conf(pack->block_id, BuilderName(builder), BuilderKey(builder));
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(block_confirmation_test_suite)
+
+BOOST_AUTO_TEST_CASE(block_confirmation_threshold) {
+	const uint32_t skip = Xmaxplatform::Config::skip_nothing;
+
+	// no builders: nothing to wait for.
+	BOOST_CHECK(MakeConfirmPack(0)->required_confirmations() == 0);
+	BOOST_CHECK(MakeConfirmPack(0)->enough_confirmation());
+	BOOST_CHECK(MakeConfirmPack(1)->required_confirmations() == 0);
+	BOOST_CHECK(MakeConfirmPack(2)->required_confirmations() == 1);
+	BOOST_CHECK(MakeConfirmPack(3)->required_confirmations() == 2);
+	BOOST_CHECK(MakeConfirmPack(4)->required_confirmations() == 2);
+
+	// 21 builders need 14, the 13th is one short.
+	block_pack_ptr pack = MakeConfirmPack(21);
+	BOOST_REQUIRE(pack->required_confirmations() == 14);
+	for (uint32_t i = 0; i < 13; ++i)
+	{
+		BOOST_CHECK(pack->add_confirmation(MakeConfirm(pack, i), skip));
+		BOOST_CHECK(!pack->enough_confirmation());
+	}
+
+	// repeating a builder does not count, in any position.
+	BOOST_CHECK(!pack->add_confirmation(MakeConfirm(pack, 0), skip));
+	BOOST_CHECK(!pack->add_confirmation(MakeConfirm(pack, 12), skip));
+	BOOST_CHECK(pack->confirmations.size() == 13);
+	BOOST_CHECK(!pack->enough_confirmation());
+
+	BOOST_CHECK(pack->add_confirmation(MakeConfirm(pack, 20), skip));
+	BOOST_CHECK(pack->enough_confirmation());
+	BOOST_CHECK(pack->confirmed_builders.count() == 14);
+	BOOST_CHECK(pack->confirmed_builders.test(20));
+	BOOST_CHECK(!pack->confirmed_builders.test(13));
+}
+
+BOOST_AUTO_TEST_CASE(block_confirmation_rejects) {
+	const uint32_t skip = Xmaxplatform::Config::skip_nothing;
+	block_pack_ptr pack = MakeConfirmPack(3);
+
+	// not a builder of the block.
+	block_confirmation stranger = block_confirmation::make_conf(pack->block_id, STN(stranger), BuilderKey(7));
+	BOOST_CHECK_THROW(pack->add_confirmation(stranger, skip), confirmation_validate_exception);
+
+	// builder 1 signing for builder 0.
+	block_confirmation forged = block_confirmation::make_conf(pack->block_id, BuilderName(0), BuilderKey(1));
+	BOOST_CHECK_THROW(pack->add_confirmation(forged, skip), confirmation_validate_exception);
+	BOOST_CHECK(pack->confirmations.empty());
+
+	// a signer recovered elsewhere is checked the same way.
+	block_confirmation conf = MakeConfirm(pack, 2);
+	BOOST_CHECK_THROW(pack->add_confirmation(conf, public_key_type(BuilderKey(1).get_public_key()), skip), confirmation_validate_exception);
+	BOOST_CHECK(pack->add_confirmation(conf, public_key_type(BuilderKey(2).get_public_key()), skip));
+
+	// skip_confirmation takes the signature on trust, not the builder.
+	BOOST_CHECK(pack->add_confirmation(forged, Xmaxplatform::Config::skip_confirmation));
+	BOOST_CHECK_THROW(pack->add_confirmation(stranger, Xmaxplatform::Config::skip_confirmation), confirmation_validate_exception);
+	BOOST_CHECK(pack->enough_confirmation());
+}
+
+BOOST_AUTO_TEST_CASE(block_confirmation_unpacked) {
+	const uint32_t skip = Xmaxplatform::Config::skip_nothing;
+	block_pack_ptr pack = MakeConfirmPack(4);
+	BOOST_REQUIRE(pack->add_confirmation(MakeConfirm(pack, 1), skip));
+	BOOST_REQUIRE(pack->add_confirmation(MakeConfirm(pack, 3), skip));
+
+	// an older fork db may hold the same builder twice.
+	block_pack copy = *pack;
+	copy.confirmations.push_back(MakeConfirm(pack, 1));
+	std::vector<char> bytes = fc::raw::pack(copy);
+
+	block_pack loaded = fc::raw::unpack<block_pack>(bytes);
+	BOOST_CHECK(loaded.confirmed_builders.size() == 0);
+	BOOST_CHECK(!loaded.add_confirmation(MakeConfirm(pack, 3), skip));
+	BOOST_CHECK(loaded.confirmations.size() == 2);
+	BOOST_CHECK(loaded.confirmed_builders.test(1) && loaded.confirmed_builders.test(3));
+	BOOST_CHECK(loaded.enough_confirmation());
+}
+
+BOOST_AUTO_TEST_CASE(block_confirmation_verifier) {
+	block_pack_ptr pack = MakeConfirmPack(21);
+
+	std::vector<block_confirmation> confs;
+	for (uint32_t i = 0; i < 21; ++i)
+	{
+		confs.push_back(MakeConfirm(pack, i));
+	}
+	confs[5].builder_signature = confs[6].builder_signature;
+
+	for (bool worker : { true, false })
+	{
+		confirmation_verifier verifier(worker);
+		for (const auto& conf : confs)
+		{
+			verifier.post(conf);
+		}
+
+		std::vector<verified_confirmation> verified;
+		for (int wait = 0; verified.size() < confs.size() && wait < 1000; ++wait)
+		{
+			auto batch = verifier.take();
+			verified.insert(verified.end(), batch.begin(), batch.end());
+			if (verified.size() < confs.size())
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		BOOST_REQUIRE(verified.size() == confs.size());
+		BOOST_CHECK(verifier.pending() == 0);
+
+		for (uint32_t i = 0; i < confs.size(); ++i)
+		{
+			BOOST_CHECK(verified[i].conf.verifier == confs[i].verifier);
+			const bool good = verified[i].signer == public_key_type(BuilderKey(i).get_public_key());
+			BOOST_CHECK(good == (i != 5));
+		}
+
+		// the fork db counts the good ones and passes the 2/3 mark once.
+		boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+		{
+			forkdatabase fork_db(temp);
+			block_pack_ptr block = std::make_shared<block_pack>(*pack);
+			fork_db.add_block(block);
+
+			uint32_t rejected = 0;
+			for (const auto& item : verified)
+			{
+				try {
+					fork_db.add_confirmation(item.conf, item.signer, Xmaxplatform::Config::skip_nothing);
+				}
+				catch (const confirmation_validate_exception&) {
+					++rejected;
+				}
+				if (block->confirmations.size() < 14)
+					BOOST_CHECK(block->last_confirmed_num == 0);
+			}
+			BOOST_CHECK(rejected == 1);
+			BOOST_CHECK(block->confirmations.size() == 20);
+			BOOST_CHECK(block->last_confirmed_id == block->block_id);
+		}
+		boost::filesystem::remove_all(temp);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(block_confirmation_verifier_wakes) {
+	block_pack_ptr pack = MakeConfirmPack(4);
+
+	// the worker calls back once a batch is verified, take then returns it without polling.
+	std::mutex mutex;
+	std::condition_variable cond;
+	uint32_t wakes = 0;
+	confirmation_verifier verifier(true, [&]() {
+		std::lock_guard<std::mutex> lock(mutex);
+		++wakes;
+		cond.notify_all();
+	});
+
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		verifier.post(MakeConfirm(pack, i));
+
+		std::unique_lock<std::mutex> lock(mutex);
+		BOOST_REQUIRE(cond.wait_for(lock, std::chrono::seconds(10), [&]() { return wakes > 0; }));
+		wakes = 0;
+		lock.unlock();
+
+		auto verified = verifier.take();
+		BOOST_REQUIRE(verified.size() == 1);
+		BOOST_CHECK(verified[0].conf.verifier == MakeConfirm(pack, i).verifier);
+		BOOST_CHECK(verified[0].signer == public_key_type(BuilderKey(i).get_public_key()));
+		BOOST_CHECK(verifier.pending() == 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(block_confirmation_journal) {
+	const uint32_t skip = Xmaxplatform::Config::skip_nothing;
+	block_pack_ptr pack = MakeConfirmPack(21);
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	boost::filesystem::path journal = temp / "fork_journal.bin";
+
+	{
+		forkdatabase fork_db(temp);
+		fork_db.add_block(std::make_shared<block_pack>(*pack));
+
+		// a confirmation is journaled on its own, not with the whole pack.
+		uint64_t size = boost::filesystem::file_size(journal);
+		for (uint32_t i = 0; i < 10; ++i)
+		{
+			fork_db.add_confirmation(MakeConfirm(pack, i), skip);
+			const uint64_t grown = boost::filesystem::file_size(journal) - size;
+			BOOST_CHECK(grown < 2 * fc::raw::pack_size(MakeConfirm(pack, i)));
+			size += grown;
+		}
+		BOOST_CHECK(fork_db.get_block(pack->block_id)->last_confirmed_num == 0);
+	}
+
+	{
+		forkdatabase fork_db(temp);
+		block_pack_ptr restored = fork_db.get_block(pack->block_id);
+		BOOST_REQUIRE(restored);
+		BOOST_REQUIRE(restored->confirmations.size() == 10);
+		for (uint32_t i = 0; i < 10; ++i)
+		{
+			BOOST_CHECK(restored->confirmations[i].verifier == BuilderName(i));
+		}
+
+		// a replayed confirmation is not counted twice, the 2/3 mark is passed by the 14th builder.
+		BOOST_CHECK_NO_THROW(fork_db.add_confirmation(MakeConfirm(pack, 3), skip));
+		BOOST_CHECK(restored->confirmations.size() == 10);
+		for (uint32_t i = 10; i < 14; ++i)
+		{
+			fork_db.add_confirmation(MakeConfirm(pack, i), skip);
+		}
+		BOOST_CHECK(restored->last_confirmed_id == pack->block_id);
+	}
+
+	{
+		forkdatabase fork_db(temp);
+		block_pack_ptr restored = fork_db.get_block(pack->block_id);
+		BOOST_REQUIRE(restored);
+		BOOST_CHECK(restored->confirmations.size() == 14);
+		BOOST_CHECK(restored->last_confirmed_id == pack->block_id);
+		BOOST_CHECK(restored->last_confirmed_num == pack->block_num);
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
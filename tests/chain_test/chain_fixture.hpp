@@ -0,0 +1,90 @@
+#pragma once
+#include <chain_xmax.hpp>
+#include <native_contract_chain_init.hpp>
+#include <blockchain_config.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	// a whole chain in a temp directory. the genesis has no builders, so xmax builds and confirms every block.
+	struct test_chain
+	{
+		boost::filesystem::path root;
+		Xmaxplatform::Native_contract::genesis_state_type genesis;
+		chain_xmax::xmax_config config;
+		std::unique_ptr<Xmaxplatform::Native_contract::native_contract_chain_init> init;
+		std::unique_ptr<chain_xmax> chain;
+		std::function<void(const signed_block&)> on_block;	// finalize hook of every applied block.
+
+		explicit test_chain(const boost::filesystem::path& dir)
+			: root(dir)
+		{
+			genesis.initial_timestamp = fc::time_point_sec(1523264400);
+			init.reset(new Xmaxplatform::Native_contract::native_contract_chain_init(genesis));
+
+			config.shared_memory_size = 128 * 1024 * 1024;
+			config.block_memory_dir = root / "state";
+			config.fork_memory_dir = root / "state";
+			config.block_log_dir = root / "log";
+			config.chain_id = genesis.compute_chain_id();
+		}
+
+		~test_chain()
+		{
+			close();
+		}
+
+		void open()
+		{
+			finalize_block_func finalize;
+			finalize = [this](const signed_block& block) {
+				if (on_block)
+					on_block(block);
+			};
+			chain.reset(new chain_xmax(*init, config, finalize));
+		}
+
+		void close()
+		{
+			chain.reset();
+		}
+
+		// count blocks in the next slots, each confirmed. a block turns irreversible once the next one is added.
+		block_pack_ptr produce(uint32_t count, const private_key_type& key = Xmaxplatform::Config::xmax_build_private_key)
+		{
+			block_pack_ptr pack;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				pack = chain->build_block(chain->get_delta_slot_time(1), key);
+				chain->push_confirmation(block_confirmation::make_conf(pack->block_id,
+					Xmaxplatform::Config::xmax_contract_name, Xmaxplatform::Config::xmax_build_private_key));
+			}
+			return pack;
+		}
+	};
+
+	static void CopyChainDirectory(const boost::filesystem::path& from, const boost::filesystem::path& to) {
+		boost::filesystem::create_directories(to);
+		for (boost::filesystem::directory_iterator it(from), end; it != end; ++it)
+		{
+			const boost::filesystem::path target = to / it->path().filename();
+			if (boost::filesystem::is_directory(it->path()))
+				CopyChainDirectory(it->path(), target);
+			else
+				boost::filesystem::copy_file(it->path(), target, boost::filesystem::copy_option::overwrite_if_exists);
+		}
+	}
+
+	// object count and revision of every index, two chains with the same history match.
+	static std::vector<std::tuple<std::string, uint64_t, int64_t>> ChainStateCounts(const chain_xmax& chain) {
+		std::vector<std::tuple<std::string, uint64_t, int64_t>> counts;
+		for (const auto& stats : chain.get_database().get_index_stats())
+		{
+			counts.emplace_back(stats.type_name, stats.object_count, stats.revision);
+		}
+		return counts;
+	}
+}
@@ -0,0 +1,249 @@
+#include "chain_fixture.hpp"
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	struct replay_dirs
+	{
+		boost::filesystem::path root = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+		~replay_dirs()
+		{
+			boost::filesystem::remove_all(root);
+		}
+	};
+
+	// a chain of count blocks, its block log ends one block before the head.
+	static uint32_t BuildReplaySource(test_chain& source, uint32_t count) {
+		source.open();
+		source.produce(count);
+		const uint32_t logged = source.chain->confirmed_head_block()->block_num();
+		source.close();
+		return logged;
+	}
+
+	// a node that only has the block log of source.
+	static void PrepareReplayTarget(const test_chain& source, test_chain& target) {
+		CopyChainDirectory(source.config.block_log_dir, target.config.block_log_dir);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(chain_replay_test_suite)
+
+BOOST_AUTO_TEST_CASE(chain_replay_rebuilds_state) {
+	replay_dirs dirs;
+	test_chain source(dirs.root / "source");
+	const uint32_t logged = BuildReplaySource(source, 30);
+
+	test_chain target(dirs.root / "target");
+	PrepareReplayTarget(source, target);
+	BOOST_REQUIRE(!chain_xmax::prepare_replay(target.config));
+	BOOST_REQUIRE(boost::filesystem::exists(target.config.block_memory_dir / "replay.marker"));
+
+	target.open();
+	chain_xmax::replay_options options;
+	options.checkpoint_blocks = 7;
+	BOOST_REQUIRE_EQUAL(target.chain->replay(options), logged - 1);
+	BOOST_REQUIRE(!boost::filesystem::exists(target.config.block_memory_dir / "replay.marker"));
+
+	BOOST_REQUIRE_EQUAL(target.chain->head_block_num(), logged);
+	BOOST_REQUIRE(target.chain->head_block_id() == target.chain->confirmed_head_block()->id());
+	BOOST_REQUIRE_EQUAL(target.chain->last_irreversible_block_num(), logged);
+	BOOST_REQUIRE(target.chain->get_dynamic_states().head_block_id == target.chain->head_block_id());
+	const auto replayed = ChainStateCounts(*target.chain);
+
+	// the replayed node goes on from the end of the log, and so does the state after a restart.
+	target.produce(3);
+	BOOST_REQUIRE_EQUAL(target.chain->head_block_num(), logged + 3);
+	target.close();
+
+	target.open();
+	BOOST_REQUIRE_EQUAL(target.chain->head_block_num(), logged + 3);
+	BOOST_REQUIRE_EQUAL(target.chain->confirmed_head_block()->block_num(), logged + 2);
+
+	// a second replay of the same log ends in the same state.
+	target.close();
+	test_chain again(dirs.root / "again");
+	PrepareReplayTarget(source, again);
+	BOOST_REQUIRE(!chain_xmax::prepare_replay(again.config));
+	again.open();
+	again.chain->replay(options);
+	BOOST_REQUIRE(ChainStateCounts(*again.chain) == replayed);
+}
+
+BOOST_AUTO_TEST_CASE(chain_replay_resume_after_kill) {
+	replay_dirs dirs;
+	test_chain source(dirs.root / "source");
+	const uint32_t logged = BuildReplaySource(source, 30);
+
+	test_chain reference(dirs.root / "reference");
+	PrepareReplayTarget(source, reference);
+	chain_xmax::prepare_replay(reference.config);
+	reference.open();
+	reference.chain->replay(chain_xmax::replay_options());
+	const auto expected = ChainStateCounts(*reference.chain);
+	reference.close();
+
+	const uint32_t kill_at = 20;
+
+	test_chain target(dirs.root / "target");
+	PrepareReplayTarget(source, target);
+	BOOST_REQUIRE(!chain_xmax::prepare_replay(target.config));
+	target.on_block = [&](const signed_block& block) {
+		if (block.block_num() == kill_at)
+			FC_THROW("replay killed at block ${num}", ("num", kill_at));
+	};
+	target.open();
+	chain_xmax::replay_options options;
+	options.checkpoint_blocks = 8;
+	BOOST_REQUIRE_THROW(target.chain->replay(options), fc::exception);
+	BOOST_REQUIRE_EQUAL(target.chain->head_block_num(), kill_at - 1);
+	target.close();
+
+	// the marker is left behind and the state was closed cleanly, the next replay resumes instead of wiping it.
+	BOOST_REQUIRE(boost::filesystem::exists(target.config.block_memory_dir / "replay.marker"));
+	target.on_block = nullptr;
+	BOOST_REQUIRE(chain_xmax::prepare_replay(target.config));
+	target.open();
+	BOOST_REQUIRE_EQUAL(target.chain->head_block_num(), kill_at - 1);
+	BOOST_REQUIRE_EQUAL(target.chain->replay(options), logged - (kill_at - 1));
+	BOOST_REQUIRE_EQUAL(target.chain->head_block_num(), logged);
+	BOOST_REQUIRE(!boost::filesystem::exists(target.config.block_memory_dir / "replay.marker"));
+	BOOST_REQUIRE(ChainStateCounts(*target.chain) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(chain_replay_state_ahead_of_fork_db) {
+	replay_dirs dirs;
+	test_chain source(dirs.root / "source");
+	const uint32_t logged = BuildReplaySource(source, 30);
+
+	test_chain target(dirs.root / "target");
+	PrepareReplayTarget(source, target);
+	chain_xmax::prepare_replay(target.config);
+
+	// keep the fork journal as it was at block 10, the state goes on to be committed up to block 19.
+	const boost::filesystem::path journal = target.config.block_memory_dir / "fork_journal.bin";
+	const boost::filesystem::path saved = dirs.root / "fork_journal.saved";
+	target.on_block = [&](const signed_block& block) {
+		if (block.block_num() == 10)
+			boost::filesystem::copy_file(journal, saved);
+		if (block.block_num() == 20)
+			FC_THROW("replay killed");
+	};
+	target.open();
+	BOOST_REQUIRE_THROW(target.chain->replay(chain_xmax::replay_options()), fc::exception);
+	target.close();
+	boost::filesystem::copy_file(saved, journal, boost::filesystem::copy_option::overwrite_if_exists);
+
+	// initialize_impl finds the committed state past the fork db head and continues from the block log.
+	target.on_block = nullptr;
+	BOOST_REQUIRE(chain_xmax::prepare_replay(target.config));
+	target.open();
+	BOOST_REQUIRE_EQUAL(target.chain->head_block_num(), 19);
+	BOOST_REQUIRE(target.chain->head_block_id() == target.chain->block_from_num(19)->id());
+	BOOST_REQUIRE_EQUAL(target.chain->last_irreversible_block_num(), 19);
+	BOOST_REQUIRE_EQUAL(target.chain->replay(chain_xmax::replay_options()), logged - 19);
+	BOOST_REQUIRE_EQUAL(target.chain->head_block_num(), logged);
+}
+
+BOOST_AUTO_TEST_CASE(chain_replay_trusted) {
+	replay_dirs dirs;
+	const private_key_type forged = private_key_type::regenerate(fc::sha256::hash(std::string("forged")));
+
+	// block 12 is signed by a key that is not the builder's.
+	test_chain source(dirs.root / "source");
+	source.open();
+	source.produce(10);
+	const uint32_t forged_num = source.produce(1, forged)->block_num;
+	source.produce(10);
+	const uint32_t logged = source.chain->confirmed_head_block()->block_num();
+	source.close();
+
+	test_chain checked(dirs.root / "checked");
+	PrepareReplayTarget(source, checked);
+	chain_xmax::prepare_replay(checked.config);
+	checked.open();
+	BOOST_REQUIRE_THROW(checked.chain->replay(chain_xmax::replay_options()), fc::exception);
+	BOOST_REQUIRE_EQUAL(checked.chain->head_block_num(), forged_num - 1);
+
+	// trusted mode takes the log as it is.
+	test_chain trusted(dirs.root / "trusted");
+	PrepareReplayTarget(source, trusted);
+	chain_xmax::prepare_replay(trusted.config);
+	trusted.open();
+	chain_xmax::replay_options options;
+	options.trusted = true;
+	BOOST_REQUIRE_EQUAL(trusted.chain->replay(options), logged - 1);
+	BOOST_REQUIRE_EQUAL(trusted.chain->head_block_num(), logged);
+	BOOST_REQUIRE(trusted.chain->head_block_id() == trusted.chain->confirmed_head_block()->id());
+}
+
+BOOST_AUTO_TEST_CASE(chain_replay_older_state_format) {
+	replay_dirs dirs;
+	test_chain source(dirs.root / "source");
+	const uint32_t logged = BuildReplaySource(source, 10);
+
+	// a state written before the format was kept reads as format 0.
+	{
+		Basechain::database db(source.config.block_memory_dir, Basechain::database::read_write, source.config.shared_memory_size);
+		BOOST_CHECK(!db.created());
+		BOOST_CHECK_EQUAL(db.get_state_version(), Xmaxplatform::Config::chain_state_version);
+		db.set_state_version(0);
+	}
+	BOOST_CHECK_THROW(source.open(), fc::exception);
+
+	// the replay starts from an empty state and stamps the current format.
+	BOOST_REQUIRE(!chain_xmax::prepare_replay(source.config));
+	source.open();
+	BOOST_REQUIRE_EQUAL(source.chain->replay(chain_xmax::replay_options()), logged - 1);
+	BOOST_REQUIRE_EQUAL(source.chain->head_block_num(), logged);
+	source.close();
+	source.open();
+	BOOST_REQUIRE_EQUAL(source.chain->head_block_num(), logged);
+}
+
+BOOST_AUTO_TEST_CASE(chain_for_each_block_pruned) {
+	replay_dirs dirs;
+	test_chain chain(dirs.root / "chain");
+	chain.config.block_log.segment_blocks = 4;
+	chain.config.block_log.retain_blocks = 6;
+	chain.open();
+	chain.produce(20);
+
+	const uint32_t head = chain.chain->head_block_num();
+
+	// a range reaching below the log is refused instead of being cut short.
+	uint32_t visited = 0;
+	auto count = [&](const signed_block_ptr&) { ++visited; return true; };
+	BOOST_CHECK_THROW(chain.chain->for_each_block(1, head, count), unknown_block_exception);
+	BOOST_CHECK(visited == 0);
+
+	// the retained blocks and the reversible ones past the log.
+	uint32_t first = 1;
+	while (first <= head)
+	{
+		try {
+			chain.chain->for_each_block(first, first, count);
+			break;
+		}
+		catch (const unknown_block_exception&) {
+			++first;
+		}
+	}
+	BOOST_REQUIRE(first > 1);
+	BOOST_REQUIRE(first + 6 <= head);
+	BOOST_CHECK(visited == 1);
+
+	visited = 0;
+	BOOST_CHECK(chain.chain->for_each_block(first, head, count) == head - first + 1);
+	BOOST_CHECK(visited == head - first + 1);
+
+	visited = 0;
+	BOOST_CHECK(chain.chain->for_each_block(head, head, count) == 1);
+	BOOST_CHECK(visited == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,411 @@
+
+
+
+#include <fstream>
+#include <chain_snapshot.hpp>
+#include <xmax_indexes.hpp>
+#include <objects/account_object.hpp>
+#include <objects/code_object.hpp>
+#include <objects/authority_object.hpp>
+#include <objects/key_value_object.hpp>
+#include <objects/transaction_object.hpp>
+#include <objects/block_summary_object.hpp>
+#include <chain_stream.hpp>
+#include "chain_fixture.hpp"
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	struct snapshot_dirs
+	{
+		boost::filesystem::path root = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+		boost::filesystem::path source = root / "source";
+		boost::filesystem::path target = root / "target";
+		boost::filesystem::path file = root / "state.snapshot";
+
+		~snapshot_dirs()
+		{
+			boost::filesystem::remove_all(root);
+		}
+	};
+
+	static private_key_type SnapshotKey() {
+		return private_key_type::regenerate(fc::sha256::hash(std::string("alice")));
+	}
+
+	static block_pack MakeSnapshotRoot(uint32_t num) {
+		block_pack root;
+		root.block = std::make_shared<signed_block>();
+		root.block->timestamp = chain_timestamp::create(1000 + num);
+		root.block->builder = Xmaxplatform::Config::xmax_contract_name;
+		root.block_num = num;
+		root.block_id = root.block->id();
+		root.new_header = *root.block;
+		root.irreversible_confirmed = true;
+		return root;
+	}
+
+	static void FillSnapshotSource(Basechain::database& db) {
+		const auto& system = db.create<account_object>([](account_object& obj) {
+			obj.name = Xmaxplatform::Config::xmax_contract_name;
+			obj.creation_date = fc::time_point_sec(1000);
+		});
+		const std::string code(4096, 'c');
+		Xmaxplatform::Basetypes::abi abi;
+		abi.types.emplace_back("amount", "uint64");
+		set_account_code(db, system, code.data(), code.size(), abi);
+
+		db.create<account_object>([](account_object& obj) {
+			obj.name = STN(alice);
+			obj.creation_date = fc::time_point_sec(2000);
+		});
+
+		db.create<authority_object>([](authority_object& obj) {
+			obj.owner_name = STN(alice);
+			obj.auth_name = STN(owner);
+			obj.authoritys.threshold = 2;
+			obj.authoritys.keys.emplace_back(key_permission(1, public_key_type(SnapshotKey().get_public_key())));
+			obj.authoritys.accounts.emplace_back(account_permission(1, STN(bob), STN(active)));
+			obj.last_updated = fc::time_point_sec(3000);
+		});
+
+		for (int i = 0; i < 50; ++i)
+		{
+			db.create<keystr_value_object>([&](keystr_value_object& obj) {
+				obj.scope = STN(alice);
+				obj.code = STN(alice);
+				obj.table = STN(names);
+				std::string key = "key" + std::to_string(i);
+				std::string value(i * 10, 'v');
+				obj.primary_key.assign(key.data(), key.size());
+				obj.value.assign(value.data(), value.size());
+			});
+		}
+
+		for (int i = 0; i < 0x100; ++i)
+		{
+			db.create<block_summary_object>([&](block_summary_object& obj) {
+				obj.block_id = xmax_type_block_id::hash(uint64_t(i));
+			});
+		}
+
+		for (uint64_t seq = 0; seq < 20; ++seq)
+		{
+			db.create<transaction_object>([&](transaction_object& obj) {
+				obj.trx_id = xmax_type_transaction_id::hash(seq);
+				obj.expiration = fc::time_point_sec(5000 + seq);
+			});
+		}
+		// the removed tail leaves next_id ahead of the last id.
+		db.remove(db.get<transaction_object>(transaction_object::id_type(19)));
+		db.remove(db.get<transaction_object>(transaction_object::id_type(18)));
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(chain_snapshot_test_suite)
+
+BOOST_AUTO_TEST_CASE(chain_snapshot_round_trip) {
+	snapshot_dirs dirs;
+
+	snapshot_header header;
+	header.chain_id = chain_id_type::hash(std::string("snapshot test"));
+	block_pack root = MakeSnapshotRoot(42);
+	header.block_num = root.block_num;
+	header.block_id = root.block_id;
+
+	Basechain::database source(dirs.source, Basechain::database::read_write, 64 * 1024 * 1024);
+	setup_xmax_indexes(source);
+	FillSnapshotSource(source);
+
+	uint64_t size = write_snapshot(dirs.file, source, header, root);
+	BOOST_CHECK(size == boost::filesystem::file_size(dirs.file));
+
+	Basechain::database target(dirs.target, Basechain::database::read_write, 64 * 1024 * 1024);
+	setup_xmax_indexes(target);
+
+	block_pack loaded_root;
+	snapshot_header loaded = read_snapshot(dirs.file, target, loaded_root);
+	BOOST_CHECK(loaded.chain_id == header.chain_id);
+	BOOST_CHECK(loaded.block_num == 42);
+	BOOST_CHECK(loaded.index_count == target.index_count());
+	BOOST_CHECK(loaded_root.block_id == root.block_id);
+	BOOST_REQUIRE(loaded_root.block);
+	BOOST_CHECK(loaded_root.block->id() == root.block_id);
+	BOOST_CHECK(loaded_root.irreversible_confirmed);
+
+	// accounts and the contract they refer to.
+	const auto& system = target.get<account_object, by_name>(Xmaxplatform::Config::xmax_contract_name);
+	const code_object* contract = find_account_code(target, system);
+	BOOST_REQUIRE(contract);
+	BOOST_CHECK(contract->code.size() == 4096);
+	BOOST_CHECK(contract->ref_count == 1);
+	BOOST_CHECK(contract->code_hash == make_code_hash(contract->code.data(), contract->code.size(), contract->abi.data(), contract->abi.size()));
+	const auto& alice = target.get<account_object, by_name>(STN(alice));
+	BOOST_CHECK(!alice.has_contract());
+	BOOST_CHECK((alice.id == source.get<account_object, by_name>(STN(alice)).id));
+	BOOST_CHECK(alice.creation_date == fc::time_point(fc::time_point_sec(2000)));
+
+	const auto& auth = target.get<authority_object>(authority_object::id_type(0));
+	BOOST_CHECK(auth.authoritys.threshold == 2);
+	BOOST_REQUIRE(auth.authoritys.keys.size() == 1);
+	BOOST_CHECK(auth.authoritys.keys[0].key == public_key_type(SnapshotKey().get_public_key()));
+	BOOST_REQUIRE(auth.authoritys.accounts.size() == 1);
+	BOOST_CHECK(auth.authoritys.accounts[0].auth.authority == STN(active));
+
+	// every object keeps its id and its secondary indices work.
+	const auto& source_kv = source.get_index<keystr_value_index>().indices();
+	const auto& target_kv = target.get_index<keystr_value_index>().indices();
+	BOOST_REQUIRE(source_kv.size() == target_kv.size());
+	for (auto s = source_kv.begin(), t = target_kv.begin(); s != source_kv.end(); ++s, ++t)
+	{
+		BOOST_CHECK(s->id == t->id);
+		BOOST_CHECK(std::string(s->primary_key.data(), s->primary_key.size()) == std::string(t->primary_key.data(), t->primary_key.size()));
+		BOOST_CHECK(std::string(s->value.data(), s->value.size()) == std::string(t->value.data(), t->value.size()));
+	}
+	BOOST_CHECK(target.get_index<block_summary_multi_index>().indices().size() == 0x100);
+	BOOST_CHECK((target.find<transaction_object, by_trx_id>(xmax_type_transaction_id::hash(uint64_t(17))) != nullptr));
+
+	// ids handed out after the import continue where the source left off.
+	BOOST_CHECK(target.get_index<transaction_multi_index>().next_id() == source.get_index<transaction_multi_index>().next_id());
+	const auto& trx = target.create<transaction_object>([](transaction_object& obj) {
+		obj.trx_id = xmax_type_transaction_id::hash(uint64_t(100));
+	});
+	BOOST_CHECK(trx.id == transaction_object::id_type(20));
+}
+
+BOOST_AUTO_TEST_CASE(chain_snapshot_from_undo_history) {
+	snapshot_dirs dirs;
+	const boost::filesystem::path before = dirs.root / "before.snapshot";
+	const boost::filesystem::path undone = dirs.root / "undone.snapshot";
+
+	block_pack root = MakeSnapshotRoot(42);
+	snapshot_header header;
+	header.block_num = root.block_num;
+	header.block_id = root.block_id;
+
+	Basechain::database source(dirs.source, Basechain::database::read_write, 64 * 1024 * 1024);
+	setup_xmax_indexes(source);
+	FillSnapshotSource(source);
+	source.set_revision(42);
+	write_snapshot(before, source, header, root);
+
+	// two reversible blocks on top of block 42.
+	auto first = source.start_undo_session(true);
+	source.modify(source.get<account_object, by_name>(STN(alice)), [](account_object& obj) {
+		obj.creation_date = fc::time_point_sec(9000);
+	});
+	source.remove(source.get<keystr_value_object>(keystr_value_object::id_type(0)));
+	source.create<transaction_object>([](transaction_object& obj) {
+		obj.trx_id = xmax_type_transaction_id::hash(uint64_t(100));
+	});
+	first.push();
+
+	auto second = source.start_undo_session(true);
+	source.modify(source.get<account_object, by_name>(STN(alice)), [](account_object& obj) {
+		obj.creation_date = fc::time_point_sec(9500);
+	});
+	source.modify(source.get<keystr_value_object>(keystr_value_object::id_type(5)), [](keystr_value_object& obj) {
+		obj.value.clear();
+	});
+	source.remove(source.get<transaction_object>(transaction_object::id_type(20)));
+	source.remove(source.get<transaction_object>(transaction_object::id_type(0)));
+	source.create<block_summary_object>([](block_summary_object& obj) {
+		obj.block_id = xmax_type_block_id::hash(uint64_t(0x100));
+	});
+	second.push();
+
+	// the state of block 42 is read from the undo history, the blocks stay applied.
+	write_snapshot(dirs.file, source, header, root);
+	BOOST_CHECK(source.revision() == 44);
+	BOOST_CHECK((source.get<account_object, by_name>(STN(alice)).creation_date == fc::time_point(fc::time_point_sec(9500))));
+	BOOST_CHECK(source.get_index<block_summary_multi_index>().indices().size() == 0x101);
+
+	std::ifstream written(dirs.file.generic_string().c_str(), std::ios::binary);
+	std::ifstream expected(before.generic_string().c_str(), std::ios::binary);
+	BOOST_CHECK(std::string(std::istreambuf_iterator<char>(written), {}) == std::string(std::istreambuf_iterator<char>(expected), {}));
+
+	// undoing the blocks gives the same state.
+	source.undo_all();
+	BOOST_CHECK(source.revision() == 42);
+	write_snapshot(undone, source, header, root);
+	std::ifstream after_undo(undone.generic_string().c_str(), std::ios::binary);
+	std::ifstream expected_again(before.generic_string().c_str(), std::ios::binary);
+	BOOST_CHECK(std::string(std::istreambuf_iterator<char>(after_undo), {}) == std::string(std::istreambuf_iterator<char>(expected_again), {}));
+}
+
+BOOST_AUTO_TEST_CASE(chain_snapshot_rejects_damage) {
+	snapshot_dirs dirs;
+	boost::filesystem::path damaged = dirs.root / "damaged.snapshot";
+
+	snapshot_header header;
+	block_pack root = MakeSnapshotRoot(7);
+	header.block_num = root.block_num;
+	header.block_id = root.block_id;
+	{
+		Basechain::database source(dirs.source, Basechain::database::read_write, 16 * 1024 * 1024);
+		setup_xmax_indexes(source);
+		FillSnapshotSource(source);
+		write_snapshot(dirs.file, source, header, root);
+	}
+	boost::filesystem::copy_file(dirs.file, damaged);
+
+	// flip one byte in the middle of the objects.
+	{
+		const uint64_t pos = boost::filesystem::file_size(damaged) / 2;
+		std::fstream file(damaged.generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		char c = 0;
+		file.seekg(pos);
+		file.read(&c, 1);
+		c = ~c;
+		file.seekp(pos);
+		file.write(&c, 1);
+	}
+
+	Basechain::database target(dirs.target, Basechain::database::read_write, 16 * 1024 * 1024);
+	setup_xmax_indexes(target);
+	block_pack loaded_root;
+	BOOST_CHECK_THROW(read_snapshot(damaged, target, loaded_root), fc::exception);
+
+	// a loaded index refuses a second snapshot.
+	Basechain::database twice(dirs.root / "twice", Basechain::database::read_write, 16 * 1024 * 1024);
+	setup_xmax_indexes(twice);
+	read_snapshot(dirs.file, twice, loaded_root);
+	BOOST_CHECK(loaded_root.block_num == 7);
+	BOOST_CHECK_THROW(read_snapshot(dirs.file, twice, loaded_root), fc::exception);
+}
+
+BOOST_AUTO_TEST_CASE(chain_snapshot_v1_accounts) {
+	snapshot_dirs dirs;
+
+	block_pack root = MakeSnapshotRoot(3);
+	snapshot_header header;
+	header.version = 1;
+	header.block_num = root.block_num;
+	header.block_id = root.block_id;
+	header.index_count = 1;
+
+	// version 1 wrote the contract inside each account.
+	const std::vector<char> code(1000, 'c');
+	const std::vector<char> abi(10, 'a');
+	boost::filesystem::create_directories(dirs.root);
+	{
+		snapshot_ostream s(dirs.file);
+		fc::raw::pack(s, header);
+		fc::raw::pack(s, root);
+
+		snapshot_section section;
+		section.type_id = account_object::type_id;
+		section.next_id = 3;
+		section.count = 3;
+		fc::raw::pack(s, section);
+		const account_name names[] = { STN(alice), STN(bob), STN(carol) };
+		for (int64_t id = 0; id < 3; ++id)
+		{
+			fc::raw::pack(s, id);
+			fc::raw::pack(s, names[id]);
+			fc::raw::pack(s, account_object::acc_type(0));
+			fc::raw::pack(s, fc::time_point(fc::time_point_sec(1000)));
+			fc::raw::pack(s, id != 2);
+			if (id != 2)
+			{
+				fc::raw::pack(s, fc::sha256::hash(code.data(), code.size()));
+				fc::raw::pack(s, code);
+				fc::raw::pack(s, abi);
+			}
+		}
+		fc::raw::pack(s, snapshot_section());
+		s.finish();
+	}
+
+	Basechain::database target(dirs.target, Basechain::database::read_write, 16 * 1024 * 1024);
+	setup_xmax_indexes(target);
+	block_pack loaded_root;
+	snapshot_header loaded = read_snapshot(dirs.file, target, loaded_root);
+	BOOST_CHECK(loaded.version == 1);
+
+	// both deployments share one code_object.
+	const auto& codes = target.get_index<code_index>().indices();
+	BOOST_REQUIRE(codes.size() == 1);
+	BOOST_CHECK(codes.begin()->ref_count == 2);
+	BOOST_CHECK(codes.begin()->code.size() == code.size());
+	BOOST_CHECK(codes.begin()->abi.size() == abi.size());
+	BOOST_CHECK((target.get<account_object, by_name>(STN(alice)).code_hash == codes.begin()->code_hash));
+	BOOST_CHECK((target.get<account_object, by_name>(STN(bob)).code_hash == codes.begin()->code_hash));
+	BOOST_CHECK((!target.get<account_object, by_name>(STN(carol)).has_contract()));
+	BOOST_CHECK((target.get<account_object, by_name>(STN(carol)).creation_date == fc::time_point(fc::time_point_sec(1000))));
+}
+
+BOOST_AUTO_TEST_CASE(chain_snapshot_at_irreversible_block) {
+	snapshot_dirs dirs;
+
+	// the head of a running chain is one block past the last irreversible one.
+	test_chain source(dirs.source);
+	source.open();
+	source.produce(10);
+	const uint32_t lib = source.chain->last_irreversible_block_num();
+	const uint32_t head = source.chain->head_block_num();
+	const xmax_type_block_id head_id = source.chain->head_block_id();
+	const xmax_type_block_id lib_id = source.chain->block_id_from_num(lib);
+	BOOST_REQUIRE(head > lib);
+
+	source.chain->export_snapshot(dirs.file);
+	block_pack root;
+	{
+		Basechain::database peek(dirs.root / "peek", Basechain::database::read_write, 64 * 1024 * 1024);
+		setup_xmax_indexes(peek);
+		snapshot_header header = read_snapshot(dirs.file, peek, root);
+		BOOST_CHECK(header.block_num == lib);
+		BOOST_CHECK(header.block_id == lib_id);
+		BOOST_CHECK(root.block_id == lib_id);
+		BOOST_CHECK(peek.get<dynamic_states_object>().head_block_number == lib);
+	}
+
+	// the source never left its head and builds on.
+	BOOST_CHECK(source.chain->head_block_num() == head);
+	BOOST_CHECK(source.chain->head_block_id() == head_id);
+	source.produce(2);
+	BOOST_CHECK(source.chain->head_block_num() == head + 2);
+	source.close();
+
+	// a fresh node starts its block log after the snapshot block.
+	test_chain target(dirs.target);
+	BOOST_CHECK(chain_xmax::import_snapshot(target.config, dirs.file) == lib);
+	target.open();
+	BOOST_CHECK(target.chain->head_block_num() == lib);
+	BOOST_CHECK(target.chain->head_block_id() == lib_id);
+	target.produce(3);
+	BOOST_CHECK(target.chain->head_block_num() == lib + 3);
+	target.close();
+	{
+		chain_stream log(target.config.block_log_dir);
+		BOOST_CHECK(log.first_block_num() == lib + 1);
+		BOOST_CHECK(log.last_block_num() == lib + 2);
+		BOOST_CHECK(!log.read_block(lib));
+		BOOST_REQUIRE(log.read_block(lib + 1));
+		BOOST_CHECK(log.read_block(lib + 1)->previous == lib_id);
+	}
+	target.open();
+	BOOST_CHECK(target.chain->head_block_num() == lib + 3);
+	target.close();
+
+	// a log that holds the snapshot block is kept.
+	test_chain kept(dirs.root / "kept");
+	CopyChainDirectory(source.config.block_log_dir, kept.config.block_log_dir);
+	chain_xmax::import_snapshot(kept.config, dirs.file);
+	{
+		chain_stream log(kept.config.block_log_dir);
+		BOOST_CHECK(log.first_block_num() == 1);
+		BOOST_CHECK(log.last_block_num() > lib);
+	}
+
+	// a node whose block log lost the blocks up to its state does not start.
+	test_chain lost(dirs.root / "lost");
+	chain_xmax::import_snapshot(lost.config, dirs.file);
+	boost::filesystem::remove_all(lost.config.block_log_dir);
+	BOOST_CHECK_THROW(lost.open(), fc::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
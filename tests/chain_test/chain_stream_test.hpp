@@ -0,0 +1,489 @@
+#include <boost/filesystem.hpp>
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+#include <chain_stream.hpp>
+#include <chain_utils.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	static std::vector<signed_block_ptr> MakeTestBlocks(uint32_t count, uint32_t receipts = 0) {
+		std::vector<signed_block_ptr> blocks;
+		xmax_type_block_id previous;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			signed_block_ptr block = std::make_shared<signed_block>();
+			block->previous = previous;
+			for (uint32_t r = 0; r < receipts; ++r)
+			{
+				block->receipts.emplace_back(xmax_type_transaction_id::hash(std::string("receipt")));
+			}
+			previous = block->id();
+			blocks.push_back(block);
+		}
+		return blocks;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(chain_stream_test_suite)
+
+BOOST_AUTO_TEST_CASE(chain_stream_read_by_id) {
+	boost::filesystem::path temp = boost::filesystem::unique_path();
+	try {
+		auto blocks = MakeTestBlocks(16);
+		{
+			chain_stream stream(temp);
+			for (const auto& block : blocks)
+			{
+				stream.append_block(block);
+			}
+
+			for (const auto& block : blocks)
+			{
+				signed_block_ptr read = stream.read_by_id(block->id());
+				BOOST_REQUIRE(read);
+				BOOST_CHECK(read->id() == block->id());
+			}
+
+			// unknown number and known number with a wrong hash.
+			BOOST_CHECK(!stream.read_by_id(utils::block_id(xmax_type_summary(), 100)));
+			BOOST_CHECK(!stream.read_by_id(utils::block_id(xmax_type_summary(), 5)));
+		}
+
+		// lost index is rebuilt from the segments on open.
+		boost::filesystem::remove(temp / "blocks.index");
+		{
+			chain_stream stream(temp);
+			BOOST_CHECK(stream.last_block_num() == 16);
+			BOOST_REQUIRE(stream.get_head());
+			BOOST_CHECK(stream.get_head()->id() == blocks.back()->id());
+
+			signed_block_ptr read = stream.read_by_id(blocks[7]->id());
+			BOOST_REQUIRE(read);
+			BOOST_CHECK(read->block_num() == 8);
+		}
+	}
+	catch (...) {
+		boost::filesystem::remove_all(temp);
+		throw;
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(chain_stream_rebuild_index) {
+	boost::filesystem::path temp = boost::filesystem::unique_path();
+	try {
+		auto blocks = MakeTestBlocks(8);
+		{
+			chain_stream stream(temp);
+			for (const auto& block : blocks)
+			{
+				stream.append_block(block);
+			}
+			stream.rebuild_index();
+
+			BOOST_CHECK(stream.last_block_num() == 8);
+			auto indices = stream.read_indices(1, 8);
+			BOOST_REQUIRE(indices.size() == 8);
+			for (uint32_t i = 0; i < indices.size(); ++i)
+			{
+				BOOST_CHECK(indices[i].num == i + 1);
+				BOOST_CHECK(indices[i].id == blocks[i]->id());
+			}
+		}
+	}
+	catch (...) {
+		boost::filesystem::remove_all(temp);
+		throw;
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(chain_stream_concurrent_read) {
+	boost::filesystem::path temp = boost::filesystem::unique_path();
+	try {
+		auto blocks = MakeTestBlocks(256);
+		chain_stream stream(temp);
+		stream.append_block(blocks[0]);
+
+		std::atomic<bool> done{ false };
+		std::atomic<int> errors{ 0 };
+		std::vector<std::thread> readers;
+		for (int t = 0; t < 4; ++t)
+		{
+			readers.emplace_back([&]() {
+				while (!done.load())
+				{
+					uint32_t last = (uint32_t)stream.last_block_num();
+					auto range = stream.read_block_range(1, last);
+					if (range.size() < last)
+						++errors;
+					for (uint32_t i = 0; i < range.size(); ++i)
+					{
+						if (range[i]->id() != blocks[i]->id())
+							++errors;
+					}
+				}
+			});
+		}
+
+		for (uint32_t i = 1; i < blocks.size(); ++i)
+		{
+			stream.append_block(blocks[i]);
+		}
+		done = true;
+		for (auto& reader : readers)
+		{
+			reader.join();
+		}
+
+		BOOST_CHECK(errors.load() == 0);
+		BOOST_CHECK(stream.read_block_range(250, 300).size() == 7);
+		BOOST_CHECK(stream.read_block_range(0, 2).size() == 2);
+		BOOST_CHECK(!stream.read_block(257));
+	}
+	catch (...) {
+		boost::filesystem::remove_all(temp);
+		throw;
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(chain_stream_group_commit) {
+	boost::filesystem::path temp = boost::filesystem::unique_path();
+	try {
+		auto blocks = MakeTestBlocks(10);
+		block_log_config config;
+		config.durability = block_log_config::flush_every_n_blocks;
+		config.flush_blocks = 4;
+		{
+			chain_stream stream(temp, config);
+			for (uint32_t i = 0; i < 6; ++i)
+			{
+				stream.append_block(blocks[i]);
+			}
+
+			// blocks 5 and 6 wait in the tail but are readable.
+			BOOST_CHECK(boost::filesystem::file_size(temp / "blocks.index") == (1 + 4) * sizeof(block_detail::block_index));
+			BOOST_CHECK(stream.last_block_num() == 6);
+			BOOST_REQUIRE(stream.read_by_id(blocks[5]->id()));
+			BOOST_CHECK(stream.read_block_range(1, 10).size() == 6);
+			BOOST_CHECK(stream.read_indices(1, 10).size() == 4);
+
+			stream.flush();
+			BOOST_CHECK(boost::filesystem::file_size(temp / "blocks.index") == (1 + 6) * sizeof(block_detail::block_index));
+			BOOST_CHECK(stream.read_indices(1, 10).size() == 6);
+
+			stream.append_block(blocks[6]);
+		}
+
+		// the tail is committed on close.
+		chain_stream stream(temp, config);
+		BOOST_CHECK(stream.last_block_num() == 7);
+		BOOST_REQUIRE(stream.read_block(7));
+		BOOST_CHECK(stream.read_block(7)->id() == blocks[6]->id());
+		BOOST_CHECK_THROW(stream.append_block(blocks[8]), fc::exception);
+	}
+	catch (...) {
+		boost::filesystem::remove_all(temp);
+		throw;
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(chain_stream_torn_tail) {
+	boost::filesystem::path temp = boost::filesystem::unique_path();
+	try {
+		auto blocks = MakeTestBlocks(8);
+		{
+			chain_stream stream(temp);
+			for (const auto& block : blocks)
+			{
+				stream.append_block(block);
+			}
+		}
+
+		// a crash in the middle of the last record: log cut short, index entry already written.
+		uint64_t log_size = boost::filesystem::file_size(temp / "blocks_0.log");
+		boost::filesystem::resize_file(temp / "blocks_0.log", log_size - 10);
+		{
+			chain_stream stream(temp);
+			BOOST_CHECK(stream.last_block_num() == 7);
+			BOOST_CHECK(boost::filesystem::file_size(temp / "blocks.index") == (1 + 7) * sizeof(block_detail::block_index));
+			BOOST_CHECK(!stream.read_block(8));
+
+			stream.append_block(blocks[7]);
+			BOOST_CHECK(stream.read_by_id(blocks[7]->id()));
+		}
+
+		// index lost its last entries: complete records are indexed again.
+		uint64_t index_size = boost::filesystem::file_size(temp / "blocks.index");
+		boost::filesystem::resize_file(temp / "blocks.index", index_size - sizeof(block_detail::block_index) - 5);
+		{
+			chain_stream stream(temp);
+			BOOST_CHECK(stream.last_block_num() == 8);
+			BOOST_CHECK(stream.read_indices(1, 8).size() == 8);
+			BOOST_REQUIRE(stream.get_head());
+			BOOST_CHECK(stream.get_head()->id() == blocks[7]->id());
+		}
+	}
+	catch (...) {
+		boost::filesystem::remove_all(temp);
+		throw;
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(chain_stream_segments) {
+	boost::filesystem::path temp = boost::filesystem::unique_path();
+	try {
+		auto blocks = MakeTestBlocks(10, 8);
+		block_log_config config;
+		config.segment_blocks = 4;
+		config.compress = true;
+		{
+			chain_stream stream(temp, config);
+			for (const auto& block : blocks)
+			{
+				stream.append_block(block);
+			}
+
+			BOOST_CHECK(boost::filesystem::exists(temp / "blocks_0.log"));
+			BOOST_CHECK(boost::filesystem::exists(temp / "blocks_1.log"));
+			BOOST_CHECK(boost::filesystem::exists(temp / "blocks_2.log"));
+			BOOST_CHECK(!boost::filesystem::exists(temp / "blocks_3.log"));
+
+			// repeated receipts compress well.
+			auto indices = stream.read_indices(1, 10);
+			BOOST_REQUIRE(indices.size() == 10);
+			BOOST_CHECK(indices[0].codec == block_detail::codec_zlib);
+			BOOST_CHECK(indices[0].size < indices[0].raw_size);
+			BOOST_CHECK(indices[4].pos == 0);
+
+			for (const auto& block : blocks)
+			{
+				signed_block_ptr read = stream.read_by_id(block->id());
+				BOOST_REQUIRE(read);
+				BOOST_CHECK(read->receipts.size() == 8);
+			}
+		}
+
+		// segment size is kept from the index header, the segments are scanned again.
+		boost::filesystem::remove(temp / "blocks.index");
+		block_log_config other;
+		other.segment_blocks = 100;
+		other.compress = false;
+		chain_stream stream(temp, other);
+		BOOST_CHECK(stream.last_block_num() == 10);
+		BOOST_CHECK(stream.read_block_range(1, 10).size() == 10);
+
+		// raw and compressed blocks live side by side.
+		auto more = MakeTestBlocks(12, 8);
+		stream.append_block(more[10]);
+		auto indices = stream.read_indices(11, 1);
+		BOOST_REQUIRE(indices.size() == 1);
+		BOOST_CHECK(indices[0].codec == block_detail::codec_raw);
+		BOOST_CHECK(boost::filesystem::exists(temp / "blocks_2.log"));
+		BOOST_REQUIRE(stream.read_block(11));
+		BOOST_CHECK(stream.read_block(11)->id() == more[10]->id());
+	}
+	catch (...) {
+		boost::filesystem::remove_all(temp);
+		throw;
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(chain_stream_for_each_block) {
+	boost::filesystem::path temp = boost::filesystem::unique_path();
+	try {
+		auto blocks = MakeTestBlocks(10);
+		block_log_config config;
+		config.segment_blocks = 4;
+		chain_stream stream(temp, config);
+		for (const auto& block : blocks)
+		{
+			stream.append_block(block);
+		}
+
+		// in order across segments, clamped to the end of the log.
+		std::vector<uint32_t> nums;
+		BOOST_CHECK(stream.for_each_block(3, 20, [&](const signed_block_ptr& block) {
+			nums.push_back(block->block_num());
+			return true;
+		}) == 8);
+		BOOST_REQUIRE(nums.size() == 8);
+		for (uint32_t i = 0; i < nums.size(); ++i)
+		{
+			BOOST_CHECK(nums[i] == i + 3);
+		}
+
+		// the visitor stops the walk, the block it stopped on counts.
+		nums.clear();
+		BOOST_CHECK(stream.for_each_block(1, 10, [&](const signed_block_ptr& block) {
+			nums.push_back(block->block_num());
+			return nums.size() < 5;
+		}) == 5);
+		BOOST_CHECK(nums.back() == 5);
+
+		BOOST_CHECK(stream.for_each_block(11, 20, [](const signed_block_ptr&) { return true; }) == 0);
+	}
+	catch (...) {
+		boost::filesystem::remove_all(temp);
+		throw;
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(chain_stream_prune) {
+	boost::filesystem::path temp = boost::filesystem::unique_path();
+	try {
+		auto blocks = MakeTestBlocks(20);
+		block_log_config config;
+		config.segment_blocks = 4;
+		config.retain_blocks = 6;
+		{
+			chain_stream stream(temp, config);
+			for (const auto& block : blocks)
+			{
+				stream.append_block(block);
+			}
+
+			// blocks 15..20 are retained, whole segments below block 13 are dropped.
+			BOOST_CHECK(stream.first_block_num() == 13);
+			BOOST_CHECK(!boost::filesystem::exists(temp / "blocks_2.log"));
+			BOOST_CHECK(boost::filesystem::exists(temp / "blocks_3.log"));
+
+			BOOST_CHECK(!stream.read_block(12));
+			BOOST_CHECK(!stream.read_by_id(blocks[0]->id()));
+			BOOST_REQUIRE(stream.read_block(13));
+			BOOST_CHECK(stream.read_block_range(1, 20).size() == 8);
+
+			// indices of pruned blocks stay.
+			auto indices = stream.read_indices(1, 20);
+			BOOST_REQUIRE(indices.size() == 20);
+			BOOST_CHECK(indices[0].id == blocks[0]->id());
+		}
+
+		boost::filesystem::remove(temp / "blocks.index");
+		{
+			chain_stream stream(temp, config);
+			BOOST_CHECK(stream.last_block_num() == 20);
+			BOOST_CHECK(stream.first_block_num() == 13);
+			BOOST_CHECK(stream.read_indices(1, 20).size() == 20);
+			BOOST_REQUIRE(stream.read_block(20));
+			BOOST_CHECK(stream.read_block(20)->id() == blocks[19]->id());
+		}
+	}
+	catch (...) {
+		boost::filesystem::remove_all(temp);
+		throw;
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(chain_stream_reset_after) {
+	boost::filesystem::path temp = boost::filesystem::unique_path();
+	try {
+		auto blocks = MakeTestBlocks(20);
+		block_log_config config;
+		config.segment_blocks = 4;
+		{
+			chain_stream stream(temp, config);
+			for (uint32_t i = 0; i < 6; ++i)
+			{
+				stream.append_block(blocks[i]);
+			}
+
+			// a snapshot of block 10 was imported, the log goes on from block 11.
+			stream.reset_after(10);
+			BOOST_CHECK(!stream.get_head());
+			BOOST_CHECK(stream.last_block_num() == 10);
+			BOOST_CHECK(stream.first_block_num() == 11);
+			BOOST_CHECK(!stream.read_block(5));
+			BOOST_CHECK(!stream.read_block(10));
+			BOOST_CHECK(!stream.read_by_id(blocks[0]->id()));
+			BOOST_CHECK_THROW(stream.append_block(blocks[11]), fc::exception);
+
+			for (uint32_t i = 10; i < 20; ++i)
+			{
+				stream.append_block(blocks[i]);
+			}
+			BOOST_CHECK(stream.last_block_num() == 20);
+			BOOST_REQUIRE(stream.read_block(11));
+			BOOST_CHECK(stream.read_block(11)->id() == blocks[10]->id());
+			BOOST_CHECK(stream.read_block_range(1, 20).size() == 10);
+		}
+
+		{
+			chain_stream stream(temp, config);
+			BOOST_CHECK(stream.last_block_num() == 20);
+			BOOST_CHECK(stream.first_block_num() == 11);
+			BOOST_CHECK(!stream.read_block(10));
+			BOOST_CHECK(stream.read_by_id(blocks[15]->id()));
+		}
+
+		// without the index the base is taken from the first block of the first segment.
+		boost::filesystem::remove(temp / "blocks.index");
+		{
+			chain_stream stream(temp, config);
+			BOOST_CHECK(stream.last_block_num() == 20);
+			BOOST_CHECK(stream.first_block_num() == 11);
+			BOOST_CHECK(!stream.read_block(10));
+			BOOST_REQUIRE(stream.read_block(11));
+			BOOST_CHECK(stream.read_block(11)->id() == blocks[10]->id());
+		}
+	}
+	catch (...) {
+		boost::filesystem::remove_all(temp);
+		throw;
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(chain_stream_import_legacy) {
+	boost::filesystem::path temp = boost::filesystem::unique_path();
+	try {
+		auto blocks = MakeTestBlocks(5);
+
+		// single file blocks.log: [block][desc][eof] ...
+		boost::filesystem::create_directories(temp);
+		{
+			std::ofstream legacy((temp / "blocks.log").string(), std::ios::binary);
+			uint64_t pos = 0;
+			for (const auto& block : blocks)
+			{
+				auto data = fc::raw::pack(*block);
+				block_detail::block_desc desc;
+				desc.num = block->block_num();
+				desc.pos = pos;
+				desc.size = data.size();
+
+				legacy.write(data.data(), data.size());
+				legacy.write((const char*)&desc, sizeof(desc));
+				legacy.write((const char*)&block_detail::block_end_eof, sizeof(block_detail::block_end_eof));
+				pos += data.size() + sizeof(desc) + sizeof(block_detail::block_end_eof);
+			}
+		}
+
+		chain_stream stream(temp);
+		BOOST_CHECK(!boost::filesystem::exists(temp / "blocks.log"));
+		BOOST_CHECK(stream.last_block_num() == 5);
+		for (const auto& block : blocks)
+		{
+			BOOST_CHECK(stream.read_by_id(block->id()));
+		}
+	}
+	catch (...) {
+		boost::filesystem::remove_all(temp);
+		throw;
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
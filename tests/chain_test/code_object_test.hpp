@@ -0,0 +1,197 @@
+#include <objects/account_object.hpp>
+#include <objects/code_object.hpp>
+#include <message_context_xmax.hpp>
+#include <xmax_contract.hpp>
+#include <wast_to_wasm.hpp>
+#include "chain_fixture.hpp"
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	static const account_object& CreateCodeAccount(Basechain::database& db, account_name name) {
+		return db.create<account_object>([&](account_object& obj) {
+			obj.name = name;
+		});
+	}
+
+	static void SetCode(Basechain::database& db, account_name name, const std::string& code, const Xmaxplatform::Basetypes::abi& abi = Xmaxplatform::Basetypes::abi()) {
+		set_account_code(db, db.get<account_object, by_name>(name), code.data(), code.size(), abi);
+	}
+
+	typedef void (*setcode_handler)(message_context_xmax&);
+
+	// a setcode message of signer for account, run by handler the way the system contract applies it.
+	static void RunSetCode(test_chain& chain, setcode_handler handler, account_name account, const std::vector<uint8_t>& code,
+		account_name signer = account_name()) {
+		Xmaxplatform::Basetypes::setcode data;
+		data.account = account;
+		data.vm_type = 0;
+		data.vm_version = 0;
+		data.code.assign(code.begin(), code.end());
+
+		Xmaxplatform::Chain::signed_transaction trx;
+		trx.scope = { account };
+		trx.messages.push_back(message_xmax(Xmaxplatform::Config::xmax_contract_name,
+			Xmaxplatform::Basetypes::vector<Xmaxplatform::Basetypes::account_auth>{ { signer == account_name() ? account : signer, Xmaxplatform::Config::xmax_active_name } },
+			"setcode", data));
+
+		message_context_xmax context(*chain.chain, chain.chain->get_mutable_database(), trx, trx.messages[0], 0);
+		handler(context);
+	}
+
+	// setcode through handler: shared code, replaced code, and the refusals that leave the state alone.
+	static void CheckSetCodeHandler(setcode_handler handler, const std::vector<uint8_t>& first, const std::vector<uint8_t>& second) {
+		const boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+		{
+			test_chain chain(temp);
+			chain.open();
+			Basechain::database& db = chain.chain->get_mutable_database();
+			const auto& codes = db.get_index<code_index>().indices();
+			const size_t genesis_codes = codes.size();
+
+			CreateCodeAccount(db, STN(alice));
+			CreateCodeAccount(db, STN(bob));
+
+			RunSetCode(chain, handler, STN(alice), first);
+			RunSetCode(chain, handler, STN(bob), first);
+			BOOST_REQUIRE(codes.size() == genesis_codes + 1);
+			const fc::sha256 first_hash = db.get<account_object, by_name>(STN(alice)).code_hash;
+			BOOST_CHECK((db.get<account_object, by_name>(STN(bob)).code_hash == first_hash));
+			const code_object& shared = db.get<code_object, by_code_hash>(first_hash);
+			BOOST_CHECK(shared.ref_count == 2);
+			BOOST_CHECK(std::vector<uint8_t>(shared.code.begin(), shared.code.end()) == first);
+
+			// bob moves to other code, alice keeps hers.
+			RunSetCode(chain, handler, STN(bob), second);
+			BOOST_CHECK(codes.size() == genesis_codes + 2);
+			BOOST_CHECK((db.get<code_object, by_code_hash>(first_hash).ref_count == 1));
+			const fc::sha256 second_hash = db.get<account_object, by_name>(STN(bob)).code_hash;
+			BOOST_CHECK(second_hash != first_hash);
+			BOOST_CHECK((db.get<code_object, by_code_hash>(second_hash).ref_count == 1));
+
+			// bob can not set alice's code, nothing is written.
+			BOOST_CHECK_THROW(RunSetCode(chain, handler, STN(alice), second, STN(bob)), fc::exception);
+			BOOST_CHECK((db.get<account_object, by_name>(STN(alice)).code_hash == first_hash));
+			BOOST_CHECK((db.get<code_object, by_code_hash>(second_hash).ref_count == 1));
+
+			// code that fails to load is undone with the transaction.
+			{
+				auto session = db.start_undo_session(true);
+				BOOST_CHECK_THROW(RunSetCode(chain, handler, STN(alice), std::vector<uint8_t>(16, 0xff)), fc::exception);
+			}
+			BOOST_CHECK((db.get<account_object, by_name>(STN(alice)).code_hash == first_hash));
+			BOOST_CHECK((db.get<code_object, by_code_hash>(first_hash).ref_count == 1));
+			BOOST_CHECK(codes.size() == genesis_codes + 2);
+		}
+		boost::filesystem::remove_all(temp);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(code_object_test_suite)
+
+BOOST_AUTO_TEST_CASE(code_object_shared_by_accounts) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	{
+		Basechain::database db(temp, Basechain::database::read_write, 16 * 1024 * 1024);
+		db.add_index<account_index>();
+		db.add_index<code_index>();
+		const auto& codes = db.get_index<code_index>().indices();
+
+		CreateCodeAccount(db, STN(alice));
+		CreateCodeAccount(db, STN(bob));
+		CreateCodeAccount(db, STN(carol));
+		BOOST_CHECK((!db.get<account_object, by_name>(STN(alice)).has_contract()));
+		BOOST_CHECK((find_account_code(db, db.get<account_object, by_name>(STN(alice))) == nullptr));
+
+		// the same contract deployed twice is stored once.
+		const std::string token(64 * 1024, 't');
+		SetCode(db, STN(alice), token);
+		SetCode(db, STN(bob), token);
+		BOOST_REQUIRE(codes.size() == 1);
+		BOOST_CHECK(codes.begin()->ref_count == 2);
+		BOOST_CHECK(codes.begin()->code.size() == token.size());
+		BOOST_CHECK((db.get<account_object, by_name>(STN(alice)).code_hash == db.get<account_object, by_name>(STN(bob)).code_hash));
+
+		// the abi is part of the identity of a contract.
+		Xmaxplatform::Basetypes::abi abi;
+		abi.types.emplace_back("amount", "uint64");
+		SetCode(db, STN(carol), token, abi);
+		BOOST_CHECK(codes.size() == 2);
+		const code_object* carol_code = find_account_code(db, db.get<account_object, by_name>(STN(carol)));
+		BOOST_REQUIRE(carol_code);
+		BOOST_CHECK(carol_code->abi.size() == fc::raw::pack_size(abi));
+
+		// setting the code an account already has changes nothing.
+		SetCode(db, STN(alice), token);
+		BOOST_CHECK((db.get<code_object, by_code_hash>(db.get<account_object, by_name>(STN(alice)).code_hash).ref_count == 2));
+
+		// the last user of a contract takes it along.
+		SetCode(db, STN(carol), "other");
+		BOOST_CHECK(codes.size() == 2);
+		SetCode(db, STN(alice), "other");
+		SetCode(db, STN(bob), "other");
+		BOOST_REQUIRE(codes.size() == 1);
+		BOOST_CHECK(codes.begin()->ref_count == 3);
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(code_object_undo) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	{
+		Basechain::database db(temp, Basechain::database::read_write, 16 * 1024 * 1024);
+		db.add_index<account_index>();
+		db.add_index<code_index>();
+		const auto& codes = db.get_index<code_index>().indices();
+
+		CreateCodeAccount(db, STN(alice));
+		SetCode(db, STN(alice), "first");
+		const fc::sha256 first = db.get<account_object, by_name>(STN(alice)).code_hash;
+		{
+			auto session = db.start_undo_session(true);
+			SetCode(db, STN(alice), "second");
+			BOOST_CHECK(codes.size() == 1);
+			BOOST_CHECK((db.find<code_object, by_code_hash>(first) == nullptr));
+		}
+		BOOST_REQUIRE(codes.size() == 1);
+		BOOST_CHECK((db.get<account_object, by_name>(STN(alice)).code_hash == first));
+		const code_object& code = db.get<code_object, by_code_hash>(first);
+		BOOST_CHECK(code.ref_count == 1);
+		BOOST_CHECK(std::string(code.code.data(), code.code.size()) == "first");
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(code_object_setcode_handler) {
+	const std::vector<uint8_t> first = ConvertFromWastToWasm(R"=====(
+(module
+ (memory 1)
+ (export "init" (func $init))
+ (func $init)
+)
+)=====");
+	const std::vector<uint8_t> second = ConvertFromWastToWasm(R"=====(
+(module
+ (memory 1)
+ (export "init" (func $init))
+ (func $init (drop (i32.const 2)))
+)
+)=====");
+	CheckSetCodeHandler(&Xmaxplatform::Native_contract::xmax_system_setcode, first, second);
+}
+
+#ifdef USE_V8
+BOOST_AUTO_TEST_CASE(code_object_setjscode_handler) {
+	// the script is read as a c string.
+	const std::string first = "function init(){} function apply(code,type){} ";
+	const std::string second = "var n = 2; function init(){} function apply(code,type){} ";
+	CheckSetCodeHandler(&Xmaxplatform::Native_contract::xmax_system_setjscode,
+		std::vector<uint8_t>(first.c_str(), first.c_str() + first.size() + 1),
+		std::vector<uint8_t>(second.c_str(), second.c_str() + second.size() + 1));
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
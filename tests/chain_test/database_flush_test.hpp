@@ -0,0 +1,88 @@
+
+
+
+#include <thread>
+#include <objects/transaction_object.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	static bool WaitFlushPasses(const Basechain::database& db, uint64_t passes) {
+		for (int i = 0; i < 500 && db.background_flush_passes() < passes; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return db.background_flush_passes() >= passes;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(database_flush_test_suite)
+
+BOOST_AUTO_TEST_CASE(database_background_flush) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	{
+		Basechain::database db(temp, Basechain::database::read_write, 16 * 1024 * 1024);
+		db.add_index<transaction_multi_index>();
+
+		// on request only.
+		db.start_background_flush(0, false, 1024 * 1024);
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		BOOST_CHECK(db.background_flush_passes() == 0);
+
+		for (uint64_t seq = 0; seq < 1000; ++seq)
+		{
+			db.create<transaction_object>([&](transaction_object& obj) {
+				obj.trx_id = xmax_type_transaction_id::hash(seq);
+				obj.expiration = fc::time_point_sec(1000 + seq);
+			});
+			if (seq % 100 == 0)
+				db.request_flush();
+		}
+		BOOST_CHECK(WaitFlushPasses(db, 1));
+
+		// on a cadence, waiting for the disk.
+		db.start_background_flush(10, true);
+		BOOST_CHECK(WaitFlushPasses(db, 3));
+		db.stop_background_flush();
+		BOOST_CHECK(db.background_flush_passes() == 0);
+	}
+	{
+		Basechain::database db(temp, Basechain::database::read_write);
+		db.add_index<transaction_multi_index>();
+		BOOST_CHECK(db.clean_shutdown());
+		BOOST_CHECK(db.get_index<transaction_multi_index>().indices().size() == 1000);
+	}
+	{
+		Basechain::database db(temp, Basechain::database::read_only);
+		BOOST_CHECK_THROW(db.start_background_flush(10), std::logic_error);
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(database_clean_shutdown_marker) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	{
+		Basechain::database db(temp, Basechain::database::read_write, 4 * 1024 * 1024);
+		BOOST_CHECK(db.clean_shutdown());
+		BOOST_CHECK(!Basechain::database::closed_cleanly(temp));
+	}
+	BOOST_CHECK(Basechain::database::closed_cleanly(temp));
+
+	// a writer that went away without closing leaves the marker behind.
+	std::ofstream((temp / "shared_memory.dirty").generic_string().c_str());
+	BOOST_CHECK(!Basechain::database::closed_cleanly(temp));
+	{
+		Basechain::database db(temp, Basechain::database::read_write);
+		BOOST_CHECK(!db.clean_shutdown());
+	}
+	{
+		Basechain::database db(temp, Basechain::database::read_write);
+		BOOST_CHECK(db.clean_shutdown());
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
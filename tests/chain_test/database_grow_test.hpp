@@ -0,0 +1,67 @@
+#include <objects/transaction_object.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+BOOST_AUTO_TEST_SUITE(database_grow_test_suite)
+
+BOOST_AUTO_TEST_CASE(database_grow_online) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	const uint64_t initial_size = 1024 * 1024;
+	const uint64_t min_free = 256 * 1024;
+	const uint64_t grow_size = 1024 * 1024;
+	uint64_t created = 0;
+	{
+		Basechain::database db(temp, Basechain::database::read_write, initial_size);
+		db.add_index<transaction_multi_index>();
+		db.start_background_flush(0);
+
+		// blocks of 500 transactions, the segment grows at block starts only.
+		for (uint32_t block = 1; block <= 40; ++block)
+		{
+			db.grow_if_needed(min_free, grow_size);
+			db.request_flush();
+
+			auto session = db.start_undo_session(true);
+			for (uint32_t i = 0; i < 500; ++i, ++created)
+			{
+				db.create<transaction_object>([&](transaction_object& obj) {
+					obj.trx_id = xmax_type_transaction_id::hash(created);
+					obj.expiration = fc::time_point_sec(1000 + block);
+				});
+			}
+			session.push();
+			db.commit(db.revision());
+		}
+		BOOST_CHECK(db.grow_count() >= 3);
+		BOOST_CHECK(db.get_segment_size() == initial_size + db.grow_count() * grow_size);
+		BOOST_CHECK(db.get_index<transaction_multi_index>().indices().size() == created);
+
+		// undo works on the remapped indices.
+		db.grow(grow_size);
+		{
+			auto session = db.start_undo_session(true);
+			db.remove(db.get<transaction_object, by_trx_id>(xmax_type_transaction_id::hash(uint64_t(0))));
+			db.create<transaction_object>([&](transaction_object& obj) {
+				obj.trx_id = xmax_type_transaction_id::hash(created);
+			});
+		}
+		BOOST_CHECK(db.get_index<transaction_multi_index>().indices().size() == created);
+		BOOST_CHECK((db.find<transaction_object, by_trx_id>(xmax_type_transaction_id::hash(uint64_t(0))) != nullptr));
+		BOOST_CHECK((db.find<transaction_object, by_trx_id>(xmax_type_transaction_id::hash(created)) == nullptr));
+
+		BOOST_CHECK(!db.grow_if_needed(min_free, grow_size));
+	}
+	{
+		Basechain::database db(temp, Basechain::database::read_write, initial_size);
+		db.add_index<transaction_multi_index>();
+		BOOST_CHECK(db.clean_shutdown());
+		BOOST_CHECK(db.get_segment_size() > initial_size);
+		BOOST_CHECK(db.get_index<transaction_multi_index>().indices().size() == created);
+		BOOST_CHECK((db.find<transaction_object, by_trx_id>(xmax_type_transaction_id::hash(created - 1)) != nullptr));
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
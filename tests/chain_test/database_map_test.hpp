@@ -0,0 +1,45 @@
+#include <objects/transaction_object.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+BOOST_AUTO_TEST_SUITE(database_map_test_suite)
+
+BOOST_AUTO_TEST_CASE(database_map_options) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	{
+		Basechain::database db(temp, Basechain::database::read_write, 16 * 1024 * 1024);
+		db.add_index<transaction_multi_index>();
+		for (uint64_t seq = 0; seq < 1000; ++seq)
+		{
+			db.create<transaction_object>([&](transaction_object& obj) {
+				obj.trx_id = xmax_type_transaction_id::hash(seq);
+				obj.expiration = fc::time_point_sec(1000 + seq);
+			});
+		}
+	}
+
+	// huge pages are a hint and prefault only reads, the state is the same.
+	Basechain::map_options options;
+	options.huge_pages = true;
+	options.prefault = true;
+	{
+		Basechain::database db(temp, Basechain::database::read_write, 16 * 1024 * 1024, options);
+		db.add_index<transaction_multi_index>();
+		BOOST_CHECK(db.clean_shutdown());
+		BOOST_CHECK(db.get_index<transaction_multi_index>().indices().size() == 1000);
+
+		db.advise(Basechain::database::access_random);
+		BOOST_CHECK((db.find<transaction_object, by_trx_id>(xmax_type_transaction_id::hash(uint64_t(999))) != nullptr));
+		db.advise(Basechain::database::access_normal);
+	}
+	{
+		Basechain::database db(temp, Basechain::database::read_only, 0, options);
+		db.add_index<transaction_multi_index>();
+		BOOST_CHECK(db.get_index<transaction_multi_index>().indices().size() == 1000);
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
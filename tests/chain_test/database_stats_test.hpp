@@ -0,0 +1,73 @@
+#include <objects/transaction_object.hpp>
+#include <objects/block_summary_object.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+BOOST_AUTO_TEST_SUITE(database_stats_test_suite)
+
+BOOST_AUTO_TEST_CASE(database_index_stats) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	{
+		Basechain::database db(temp, Basechain::database::read_write, 16 * 1024 * 1024);
+		db.add_index<transaction_multi_index>();
+		db.add_index<block_summary_multi_index>();
+
+		for (uint64_t seq = 0; seq < 100; ++seq)
+		{
+			db.create<transaction_object>([&](transaction_object& obj) {
+				obj.trx_id = xmax_type_transaction_id::hash(seq);
+			});
+		}
+
+		auto first = db.start_undo_session(true);
+		for (uint64_t seq = 100; seq < 110; ++seq)
+		{
+			db.create<transaction_object>([&](transaction_object& obj) {
+				obj.trx_id = xmax_type_transaction_id::hash(seq);
+			});
+		}
+		first.push();
+
+		auto second = db.start_undo_session(true);
+		db.modify(db.get<transaction_object>(transaction_object::id_type(1)), [](transaction_object& obj) {
+			obj.expiration = fc::time_point_sec(5000);
+		});
+		db.remove(db.get<transaction_object>(transaction_object::id_type(2)));
+		db.remove(db.get<transaction_object>(transaction_object::id_type(3)));
+
+		std::vector<Basechain::index_stats> stats = db.get_index_stats();
+		BOOST_REQUIRE(stats.size() == 2);
+
+		const Basechain::index_stats& trxs = stats[0];
+		BOOST_CHECK(trxs.type_id == transaction_object::type_id);
+		BOOST_CHECK(trxs.type_name.find("transaction_object") != std::string::npos);
+		BOOST_CHECK(trxs.object_count == 108);
+		BOOST_CHECK(trxs.approx_bytes > 108 * sizeof(transaction_object));
+		BOOST_CHECK(trxs.revision == 2);
+		BOOST_REQUIRE(trxs.undo_sessions.size() == 2);
+		BOOST_CHECK(trxs.undo_sessions[0].new_ids == 10);
+		BOOST_CHECK(trxs.undo_sessions[1].new_ids == 0);
+		BOOST_CHECK(trxs.undo_sessions[1].old_values == 1);
+		BOOST_CHECK(trxs.undo_sessions[1].removed_values == 2);
+
+		BOOST_CHECK(stats[1].object_count == 0);
+		BOOST_CHECK(stats[1].undo_sessions.size() == 2);
+
+		const Basechain::segment_stats segment = db.get_segment_stats();
+		BOOST_CHECK(segment.size == 16 * 1024 * 1024);
+		BOOST_CHECK(segment.used + segment.free == segment.size);
+		BOOST_CHECK(segment.used > trxs.approx_bytes);
+		BOOST_CHECK(segment.grow_count == 0);
+
+		second.undo();
+		stats = db.get_index_stats();
+		BOOST_CHECK(stats[0].object_count == 110);
+		BOOST_REQUIRE(stats[0].undo_sessions.size() == 1);
+		BOOST_CHECK(stats[0].undo_sessions[0].new_ids == 10);
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,266 @@
+#include <chrono>
+#include <fstream>
+#include <forkchain.hpp>
+#include <chain_utils.hpp>
+#include "chain_fixture.hpp"
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	struct irreversible_counter
+	{
+		uint32_t count = 0;
+
+		void on_irreversible(block_pack_ptr pack)
+		{
+			++count;
+		}
+	};
+
+	// a block on top of prev, confirmations carry over the way init_by_pre_pack does.
+	static block_pack_ptr MakeForkPack(const block_pack_ptr& prev, uint32_t slot) {
+		block_pack_ptr pack = std::make_shared<block_pack>();
+		pack->block = std::make_shared<signed_block>();
+		pack->block->timestamp = chain_timestamp::create(1000 + slot);
+		pack->block->builder = Xmaxplatform::Config::xmax_contract_name;
+		if (prev)
+		{
+			pack->block->previous = prev->block_id;
+			pack->last_confirmed_num = prev->last_confirmed_num;
+			pack->last_confirmed_id = prev->last_confirmed_id;
+		}
+		pack->block_num = pack->block->block_num();
+		pack->block_id = pack->block->id();
+		pack->new_header = *pack->block;
+		pack->main_chain = true;
+		return pack;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(fork_database_test_suite)
+
+BOOST_AUTO_TEST_CASE(fork_database_stays_bounded) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	boost::filesystem::path journal = temp / "fork_journal.bin";
+
+	const uint32_t blocks = 5000;
+	const uint32_t lag = 12;	// blocks between the head and the last irreversible one.
+
+	irreversible_counter counter;
+	std::weak_ptr<block_pack> first;
+	xmax_type_block_id head_id;
+	xmax_type_block_id confirmed_id;
+	uint64_t warmup_journal = 0;
+	uint64_t steady_journal = 0;
+	{
+		forkdatabase fork_db(temp);
+		fork_db.bind_irreversible(&counter, &irreversible_counter::on_irreversible);
+
+		std::vector<xmax_type_block_id> ids;
+		block_pack_ptr prev;
+		for (uint32_t i = 0; i < blocks; ++i)
+		{
+			block_pack_ptr pack = MakeForkPack(prev, i);
+			fork_db.add_block(pack);
+			ids.push_back(pack->block_id);
+			if (i == 0)
+				first = pack;
+
+			if (i >= lag)
+			{
+				const xmax_type_block_id& id = ids[i - lag];
+				fork_db.force_confirm(id, fork_db.get_block(id)->block_num);
+			}
+			BOOST_REQUIRE(fork_db.size() <= lag + 1);
+			BOOST_REQUIRE(fork_db.get_head()->block_id == pack->block_id);
+
+			const uint64_t size = boost::filesystem::file_size(journal);
+			if (i < blocks / 5)
+				warmup_journal = std::max(warmup_journal, size);
+			else
+				steady_journal = std::max(steady_journal, size);
+
+			prev = pack;
+		}
+		head_id = prev->block_id;
+		confirmed_id = ids[blocks - 1 - lag];
+
+		// nothing outside the window keeps a pack alive.
+		BOOST_CHECK(first.expired());
+		BOOST_CHECK(counter.count == blocks - lag);
+	}
+
+	// the journal is compacted, it does not grow with the chain.
+	BOOST_CHECK(steady_journal <= warmup_journal);
+
+	// a restart replays the journal.
+	{
+		forkdatabase fork_db(temp);
+		BOOST_CHECK(fork_db.size() == lag + 1);
+		BOOST_REQUIRE(fork_db.get_head());
+		BOOST_CHECK(fork_db.get_head()->block_id == head_id);
+		BOOST_CHECK(fork_db.get_head()->last_confirmed_id == confirmed_id);
+		BOOST_REQUIRE(fork_db.get_block(confirmed_id));
+		BOOST_CHECK(fork_db.get_block(confirmed_id)->irreversible_confirmed);
+		BOOST_CHECK(!fork_db.get_block(head_id)->irreversible_confirmed);
+	}
+
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(fork_database_journal_restore) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	boost::filesystem::path journal = temp / "fork_journal.bin";
+
+	irreversible_counter counter;
+	xmax_type_block_id main_id;
+	xmax_type_block_id side_id;
+	xmax_type_block_id dropped_id;
+	{
+		forkdatabase fork_db(temp);
+		fork_db.bind_irreversible(&counter, &irreversible_counter::on_irreversible);
+
+		block_pack_ptr root = MakeForkPack(block_pack_ptr(), 0);
+		fork_db.add_block(root);
+		fork_db.force_confirm(root->block_id, root->block_num);
+
+		block_pack_ptr main = MakeForkPack(root, 1);
+		fork_db.add_block(main);
+		main_id = main->block_id;
+
+		// two competing blocks at the same height, one leaves the main chain, one is dropped.
+		block_pack_ptr side = MakeForkPack(root, 2);
+		side->main_chain = false;
+		fork_db.add_block(side);
+		side_id = side->block_id;
+		fork_db.change_main_chain_flag(main_id, false);
+		fork_db.change_main_chain_flag(side_id, true);
+
+		block_pack_ptr dropped = MakeForkPack(side, 3);
+		fork_db.add_block(dropped);
+		dropped_id = dropped->block_id;
+		fork_db.remove_chain(dropped_id);
+		BOOST_CHECK(fork_db.size() == 3);
+	}
+
+	// a crash in the middle of a record leaves a torn tail.
+	const uint64_t good_size = boost::filesystem::file_size(journal);
+	{
+		std::ofstream file(journal.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app);
+		const char torn[] = { 1, 0x7f, 0x7f, 0x7f };
+		file.write(torn, sizeof(torn));
+	}
+
+	{
+		forkdatabase fork_db(temp);
+		BOOST_CHECK(boost::filesystem::file_size(journal) == good_size);
+		BOOST_CHECK(fork_db.size() == 3);
+		BOOST_CHECK(!fork_db.get_block(dropped_id));
+		BOOST_REQUIRE(fork_db.get_block(main_id));
+		BOOST_REQUIRE(fork_db.get_block(side_id));
+		BOOST_CHECK(!fork_db.get_block(main_id)->main_chain);
+		BOOST_CHECK(fork_db.get_block(side_id)->main_chain);
+		BOOST_CHECK(fork_db.get_main_block_by_num(2)->block_id == side_id);
+	}
+
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(fork_database_reorg_reuses_validation) {
+	const boost::filesystem::path root = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	const uint32_t depth = 50;
+
+	// a, b and the receiving node start from the same three confirmed blocks.
+	test_chain a(root / "a");
+	a.open();
+	a.produce(3);
+	a.close();
+	test_chain b(root / "b");
+	test_chain node(root / "node");
+	CopyChainDirectory(a.root, b.root);
+	CopyChainDirectory(a.root, node.root);
+
+	// unconfirmed branches, so the fork point stays reversible. b starts a slot later and ends one block longer.
+	auto build_branch = [](test_chain& chain, uint32_t count, uint32_t first_delta) {
+		std::vector<signed_block_ptr> blocks;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			blocks.push_back(chain.chain->build_block(chain.chain->get_delta_slot_time(i ? 1 : first_delta), Xmaxplatform::Config::xmax_build_private_key)->block);
+		}
+		return blocks;
+	};
+	a.open();
+	b.open();
+	const std::vector<signed_block_ptr> branch_a = build_branch(a, depth, 1);
+	const std::vector<signed_block_ptr> branch_b = build_branch(b, depth + 1, 2);
+
+	// the way blockbuilder_plugin routes a received block.
+	node.open();
+	const uint32_t irreversible = node.chain->last_irreversible_block_num();
+	auto receive = [&](const signed_block_ptr& block) {
+		if (node.chain->head_block_id() == block->previous)
+			node.chain->confirm_block(block);
+		else
+			node.chain->push_fork(block);
+	};
+
+	std::vector<block_pack_ptr> packs_a;
+	for (const auto& block : branch_a)
+	{
+		receive(block);
+		packs_a.push_back(node.chain->head_block_pack());
+		BOOST_REQUIRE(packs_a.back()->block_id == block->id());
+		BOOST_REQUIRE(packs_a.back()->has_validated_cache());
+	}
+
+	// the longer branch b takes over, every block of it is checked on the way.
+	auto start = std::chrono::steady_clock::now();
+	for (const auto& block : branch_b)
+	{
+		receive(block);
+	}
+	const double first_switch = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	BOOST_REQUIRE(node.chain->head_block_id() == b.chain->head_block_id());
+	BOOST_CHECK(node.chain->head_block_pack()->has_validated_cache());
+	BOOST_CHECK(node.chain->get_dynamic_states().head_block_id == b.chain->head_block_id());
+	BOOST_CHECK(node.chain->last_irreversible_block_num() == irreversible);
+	BOOST_CHECK(ChainStateCounts(*node.chain) == ChainStateCounts(*b.chain));
+	for (const auto& pack : packs_a)
+	{
+		BOOST_CHECK(!pack->main_chain);
+		BOOST_CHECK(pack->has_validated_cache());
+	}
+
+	// a grows past b, the node switches back and applies the packs it validated before.
+	const std::vector<signed_block_ptr> tail_a = build_branch(a, 2, 1);
+	start = std::chrono::steady_clock::now();
+	for (const auto& block : tail_a)
+	{
+		receive(block);
+	}
+	const double switch_back = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	BOOST_REQUIRE(node.chain->head_block_id() == a.chain->head_block_id());
+	BOOST_CHECK(node.chain->get_dynamic_states().head_block_id == a.chain->head_block_id());
+	BOOST_CHECK(node.chain->last_irreversible_block_num() == irreversible);
+	BOOST_CHECK(ChainStateCounts(*node.chain) == ChainStateCounts(*a.chain));
+	for (uint32_t i = 0; i < depth; ++i)
+	{
+		// the same packs are back on the main chain, nothing was rebuilt for them.
+		BOOST_CHECK(packs_a[i]->main_chain);
+		BOOST_CHECK(packs_a[i]->has_validated_cache());
+		BOOST_CHECK(node.chain->block_from_num(packs_a[i]->block_num)->id() == branch_a[i]->id());
+	}
+	BOOST_TEST_MESSAGE(depth << " block reorg: " << first_switch * 1000 << " ms to b, " << switch_back * 1000 << " ms back to a");
+
+	node.close();
+	a.close();
+	b.close();
+	boost::filesystem::remove_all(root);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,25 @@
 
 #include "foundation_test.hpp"
 #include "objects_test.hpp"
+#include "chain_stream_test.hpp"
+#include "transaction_pool_test.hpp"
+#include "transaction_request_test.hpp"
+#include "signature_recovery_test.hpp"
+#include "transaction_object_test.hpp"
+#include "code_object_test.hpp"
+#include "chain_snapshot_test.hpp"
+#include "chain_replay_test.hpp"
+#include "database_flush_test.hpp"
+#include "database_map_test.hpp"
+#include "database_grow_test.hpp"
+#include "database_stats_test.hpp"
+#include "fork_database_test.hpp"
+#include "block_confirmation_test.hpp"
+#include "wasm_code_cache_test.hpp"
+#include "wasm_module_cache_test.hpp"
+#include "wasm_metering_test.hpp"
+#include "wasm_memory_image_test.hpp"
+#include "wasm_invoke_test.hpp"
 
 
 
@@ -0,0 +1,46 @@
+#include <signature_recovery.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+BOOST_AUTO_TEST_SUITE(signature_recovery_test_suite)
+
+BOOST_AUTO_TEST_CASE(signature_recovery_workers) {
+	const chain_id_type chain_id = fc::sha256::hash(std::string("recovery test"));
+	const private_key_type key = private_key_type::regenerate(fc::sha256::hash(std::string("alice")));
+
+	std::vector<transaction_request_ptr> requests;
+	for (uint32_t i = 0; i < 64; ++i)
+	{
+		Xmaxplatform::Chain::signed_transaction trx;
+		trx.ref_block_prefix = i;
+		trx.messages.resize(1);
+		trx.sign(key, chain_id);
+		requests.push_back(std::make_shared<transaction_request>(trx));
+	}
+
+	{
+		signature_recovery recovery(chain_id, 3);
+		BOOST_CHECK(recovery.thread_count() == 3);
+		recovery.post(requests);
+
+		// the apply side either takes the cached keys or waits on the worker.
+		for (const auto& request : requests)
+		{
+			auto keys = request->get_signature_keys(chain_id);
+			BOOST_CHECK(keys.size() == 1 && *keys.begin() == public_key_type(key.get_public_key()));
+		}
+	}
+
+	// no workers: post is a no-op and keys are recovered on demand.
+	signature_recovery inline_recovery(chain_id, 0);
+	Xmaxplatform::Chain::signed_transaction trx;
+	trx.sign(key, chain_id);
+	auto request = std::make_shared<transaction_request>(trx);
+	inline_recovery.post(request);
+	BOOST_CHECK(inline_recovery.queued() == 0);
+	BOOST_CHECK(request->get_signature_keys(chain_id) == trx.get_signature_keys(chain_id));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
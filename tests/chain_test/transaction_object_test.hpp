@@ -0,0 +1,86 @@
+#include <chain_utils.hpp>
+#include <objects/transaction_object.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	static void RecordSyntheticTransaction(Basechain::database& db, uint64_t seq, fc::time_point_sec expiration) {
+		db.create<transaction_object>([&](transaction_object& obj) {
+			obj.trx_id = xmax_type_transaction_id::hash(seq);
+			obj.expiration = expiration;
+		});
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(transaction_object_test_suite)
+
+BOOST_AUTO_TEST_CASE(transaction_object_prune_bounded) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	{
+		Basechain::database db(temp, Basechain::database::read_write, 64 * 1024 * 1024);
+		db.add_index<transaction_multi_index>();
+
+		const uint32_t per_block = 40;
+		const uint32_t lifetime_s = 30;
+		const auto& idx = db.get_index<transaction_multi_index, by_expiration>();
+
+		// one block per second, each transaction living up to lifetime_s.
+		uint64_t seq = 0;
+		size_t largest = 0;
+		for (uint32_t block = 1; block <= 3000; ++block)
+		{
+			fc::time_point_sec now(1000000 + block);
+			auto session = db.start_undo_session(true);
+			for (uint32_t i = 0; i < per_block; ++i, ++seq)
+			{
+				RecordSyntheticTransaction(db, seq, now + 1 + seq % lifetime_s);
+			}
+			utils::prune_expired_transactions(db, now, Xmaxplatform::Config::max_transaction_prune_per_block);
+			session.push();
+			db.commit(db.revision());
+
+			largest = std::max(largest, idx.size());
+			BOOST_REQUIRE(idx.empty() || idx.begin()->expiration >= now);
+		}
+		// only the unexpired window is kept, never the whole history.
+		BOOST_CHECK(largest <= per_block * (lifetime_s + 1));
+		BOOST_CHECK(seq == 3000 * per_block);
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_object_prune_limit_and_undo) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	{
+		Basechain::database db(temp, Basechain::database::read_write, 16 * 1024 * 1024);
+		db.add_index<transaction_multi_index>();
+		const auto& idx = db.get_index<transaction_multi_index, by_expiration>();
+
+		for (uint64_t seq = 0; seq < 100; ++seq)
+		{
+			RecordSyntheticTransaction(db, seq, fc::time_point_sec(1000 + seq));
+		}
+
+		{
+			// an undone block puts its pruned records back.
+			auto session = db.start_undo_session(true);
+			BOOST_CHECK(utils::prune_expired_transactions(db, fc::time_point_sec(1050), 1000) == 50);
+			BOOST_CHECK(idx.size() == 50);
+		}
+		BOOST_CHECK(idx.size() == 100);
+		BOOST_CHECK((db.find<transaction_object, by_trx_id>(xmax_type_transaction_id::hash(uint64_t(0))) != nullptr));
+
+		// the limit leaves the rest for later blocks, oldest first.
+		BOOST_CHECK(utils::prune_expired_transactions(db, fc::time_point_sec(1050), 30) == 30);
+		BOOST_CHECK(idx.begin()->expiration == fc::time_point_sec(1030));
+		BOOST_CHECK(utils::prune_expired_transactions(db, fc::time_point_sec(1050), 30) == 20);
+		BOOST_CHECK(utils::prune_expired_transactions(db, fc::time_point_sec(1050), 30) == 0);
+		BOOST_CHECK(idx.size() == 50);
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
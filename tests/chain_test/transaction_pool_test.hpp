@@ -0,0 +1,134 @@
+#include <transaction_pool.hpp>
+#include "chain_fixture.hpp"
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	static transaction_request_ptr MakePoolTransaction(uint32_t seed, uint64 gas, const std::string& payer = "alice",
+		fc::time_point expiration = fc::time_point(fc::seconds(1000)), uint32_t messages = 1) {
+		Xmaxplatform::Chain::signed_transaction trx;
+		trx.ref_block_num = seed & 0xffff;
+		trx.ref_block_prefix = seed;
+		trx.gas = gas;
+		trx.gas_payer = account_name(payer);
+		trx.expiration = expiration;
+		trx.messages.resize(messages);
+		return std::make_shared<transaction_request>(trx);
+	}
+
+	// a transaction of xmax that passes check_trx on chain, seed tells transactions apart.
+	static transaction_request_ptr MakePendingTransaction(const chain_xmax& chain, uint32_t seed, uint64 gas = 10) {
+		Xmaxplatform::Chain::signed_transaction trx;
+		trx.scope = { Xmaxplatform::Config::xmax_contract_name };
+		trx.gas = gas;
+		trx.gas_payer = Xmaxplatform::Config::xmax_contract_name;
+		trx.expiration = chain.head_block_time() + fc::seconds(60 + seed);
+		transaction_set_reference_block(trx, chain.head_block_id());
+		trx.messages.resize(1);
+		trx.messages[0].code = Xmaxplatform::Config::xmax_contract_name;
+		return std::make_shared<transaction_request>(trx);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(transaction_pool_test_suite)
+
+BOOST_AUTO_TEST_CASE(transaction_pool_order_and_dedupe) {
+	transaction_pool pool;
+
+	BOOST_CHECK(pool.add(MakePoolTransaction(1, 10)) == pool_added);
+	BOOST_CHECK(pool.add(MakePoolTransaction(2, 30)) == pool_added);
+	BOOST_CHECK(pool.add(MakePoolTransaction(3, 20)) == pool_added);
+	BOOST_CHECK(pool.add(MakePoolTransaction(4, 30)) == pool_added);
+	BOOST_CHECK(pool.add(MakePoolTransaction(2, 30)) == pool_duplicate);
+	BOOST_CHECK(pool.size() == 4);
+	BOOST_CHECK(pool.contains(MakePoolTransaction(3, 20)->signed_trx.id()));
+
+	// highest gas first, arrival order at equal gas, stops at the message budget.
+	auto selected = pool.select_by_gas(3);
+	BOOST_REQUIRE(selected.size() == 3);
+	BOOST_CHECK(selected[0]->signed_trx.ref_block_prefix == 2);
+	BOOST_CHECK(selected[1]->signed_trx.ref_block_prefix == 4);
+	BOOST_CHECK(selected[2]->signed_trx.ref_block_prefix == 3);
+	BOOST_CHECK(pool.size() == 1);
+
+	pool.clear();
+	BOOST_CHECK(pool.size() == 0);
+	BOOST_CHECK(pool.bytes() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool_limits) {
+	transaction_pool_config config;
+	config.max_per_payer = 2;
+	transaction_pool pool(config);
+
+	BOOST_CHECK(pool.add(MakePoolTransaction(1, 10, "alice")) == pool_added);
+	BOOST_CHECK(pool.add(MakePoolTransaction(2, 10, "alice")) == pool_added);
+	BOOST_CHECK(pool.add(MakePoolTransaction(3, 10, "alice")) == pool_payer_limit);
+	BOOST_CHECK(pool.add(MakePoolTransaction(4, 10, "bob")) == pool_added);
+	BOOST_CHECK(pool.payer_count(account_name("alice")) == 2);
+
+	// byte budget for three transactions: a cheaper one is evicted, an equal one is refused.
+	uint64_t entry_bytes = pool.bytes() / 3;
+	config.max_per_payer = 0;
+	config.max_bytes = entry_bytes * 3;
+	transaction_pool small(config);
+	BOOST_CHECK(small.add(MakePoolTransaction(1, 10)) == pool_added);
+	BOOST_CHECK(small.add(MakePoolTransaction(2, 20)) == pool_added);
+	BOOST_CHECK(small.add(MakePoolTransaction(3, 30)) == pool_added);
+	BOOST_CHECK(small.add(MakePoolTransaction(4, 10)) == pool_full);
+	BOOST_CHECK(small.add(MakePoolTransaction(5, 40)) == pool_added);
+	BOOST_CHECK(small.size() == 3);
+	BOOST_CHECK(!small.contains(MakePoolTransaction(1, 10)->signed_trx.id()));
+	BOOST_CHECK(small.bytes() <= config.max_bytes);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool_block_applied) {
+	transaction_pool pool;
+
+	auto included = MakePoolTransaction(1, 10);
+	auto by_id = MakePoolTransaction(2, 10);
+	BOOST_CHECK(pool.add(included) == pool_added);
+	BOOST_CHECK(pool.add(by_id) == pool_added);
+	BOOST_CHECK(pool.add(MakePoolTransaction(3, 10, "alice", fc::time_point(fc::seconds(10)))) == pool_added);
+	BOOST_CHECK(pool.add(MakePoolTransaction(4, 10, "alice", fc::time_point(fc::seconds(2000)))) == pool_added);
+
+	signed_block block;
+	block.receipts.emplace_back(transaction_package(included->signed_trx));
+	block.receipts.emplace_back(by_id->signed_trx.id());
+	BOOST_CHECK(pool.remove_included(block) == 2);
+
+	BOOST_CHECK(pool.remove_expired(fc::time_point(fc::seconds(100))) == 1);
+	BOOST_CHECK(pool.size() == 1);
+	BOOST_CHECK(pool.remove(MakePoolTransaction(4, 10, "alice", fc::time_point(fc::seconds(2000)))->signed_trx.id()));
+	BOOST_CHECK(pool.size() == 0);
+	BOOST_CHECK(pool.bytes() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_pool_push_rejected) {
+	const boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	{
+		test_chain chain(temp / "limited");
+		chain.config.transaction_pool.max_per_payer = 2;
+		chain.open();
+		chain.produce(2);
+
+		// each refusal of the pool reaches the caller as its own exception.
+		transaction_request_ptr first = MakePendingTransaction(*chain.chain, 1);
+		chain.chain->push_transaction(first);
+		BOOST_CHECK_THROW(chain.chain->push_transaction(std::make_shared<transaction_request>(first->signed_trx)), tx_duplicate);
+		chain.chain->push_transaction(MakePendingTransaction(*chain.chain, 2));
+		BOOST_CHECK_THROW(chain.chain->push_transaction(MakePendingTransaction(*chain.chain, 3)), tx_payer_limit);
+
+		test_chain full(temp / "full");
+		full.config.transaction_pool.max_bytes = 1;
+		full.open();
+		full.produce(2);
+		BOOST_CHECK_THROW(full.chain->push_transaction(MakePendingTransaction(*full.chain, 1)), tx_pool_full);
+	}
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,42 @@
+#include <transaction_request.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+BOOST_AUTO_TEST_SUITE(transaction_request_test_suite)
+
+BOOST_AUTO_TEST_CASE(transaction_request_cached_hashes) {
+	const chain_id_type chain_id = fc::sha256::hash(std::string("request test"));
+	const private_key_type key = private_key_type::regenerate(fc::sha256::hash(std::string("alice")));
+
+	Xmaxplatform::Chain::signed_transaction trx;
+	trx.ref_block_num = 7;
+	trx.ref_block_prefix = 11;
+	trx.gas = 3;
+	trx.gas_payer = account_name("alice");
+	trx.expiration = fc::time_point(fc::seconds(1000));
+	trx.messages.resize(2);
+	trx.sign(key, chain_id);
+
+	transaction_request request(trx);
+	BOOST_CHECK(request.id == trx.id());
+	BOOST_CHECK(&request.signed_trx == &request.package.body);
+	BOOST_CHECK(request.packed_trx == fc::raw::pack(static_cast<const Xmaxplatform::Basetypes::transaction&>(trx)));
+
+	BOOST_CHECK(request.sig_digest(chain_id) == trx.sig_digest(chain_id));
+	BOOST_CHECK(request.sig_digest(chain_id) == trx.sig_digest(chain_id));
+
+	// a different chain is not served from the cache.
+	const chain_id_type other_chain = fc::sha256::hash(std::string("other chain"));
+	BOOST_CHECK(request.sig_digest(other_chain) == trx.sig_digest(other_chain));
+
+	auto keys = request.get_signature_keys(chain_id);
+	BOOST_CHECK(keys == trx.get_signature_keys(chain_id));
+	BOOST_CHECK(keys.size() == 1 && *keys.begin() == public_key_type(key.get_public_key()));
+
+	transaction_request from_package{ transaction_package(trx) };
+	BOOST_CHECK(from_package.id == request.id);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
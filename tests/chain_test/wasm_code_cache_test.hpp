@@ -0,0 +1,209 @@
+#include <ctime>
+#include <fstream>
+#include <Inline/Serialization.h>
+#include <IR/Module.h>
+#include <WASM/WASM.h>
+#include <Runtime/Linker.h>
+#include <Runtime/Runtime.h>
+#include <vm_xmax.hpp>
+#include <wasm_code_cache.hpp>
+#include <wast_to_wasm.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	static std::vector<U8> MakeObjectCode(size_t size, U8 seed) {
+		std::vector<U8> object(size);
+		for (size_t i = 0; i < size; ++i)
+		{
+			object[i] = U8(seed + i * 7);
+		}
+		return object;
+	}
+
+	static std::string CacheKey(uint32_t i) {
+		return fc::sha256::hash("code" + std::to_string(i)).str();
+	}
+
+	// refers to everything the linker binds per instance: its memory, table, globals, signatures and the gas_exhausted import.
+	static const char* CachedCodeWast = R"=====(
+(module
+ (memory 1)
+ (type $unary (func (param i64) (result i64)))
+ (table anyfunc (elem $double $triple))
+ (global $count (mut i64) (i64.const 0))
+ (export "run" (func $run))
+ (func $double (type $unary) (i64.mul (get_local 0) (i64.const 2)))
+ (func $triple (type $unary) (i64.mul (get_local 0) (i64.const 3)))
+ (func $run (param $which i32) (param $value i64) (result i64)
+  (set_global $count (i64.add (get_global $count) (i64.const 1)))
+  (i64.store (i32.const 8) (get_global $count))
+  (call_indirect $unary (get_local $value) (get_local $which)))
+)
+)=====";
+
+	struct cached_instance
+	{
+		IR::Module					module;
+		Runtime::ModuleInstance*	instance = nullptr;
+
+		cached_instance(const std::vector<uint8_t>& wasm, wasm_code_cache& cache, const std::string& key)
+		{
+			Serialization::MemoryInputStream stream((const U8*)wasm.data(), wasm.size());
+			WASM::serializeWithInjection(stream, module);
+			Runtime::LinkResult link = Runtime::linkModule(module, Runtime::IntrinsicResolver::singleton);
+			instance = Runtime::instantiateModule(module, std::move(link.resolvedImports), &cache, key);
+			Runtime::setGlobalValue(Runtime::getInstanceGlobal(instance, WASM::getGasGlobalIndex(module)), Runtime::Value(I64(1000000)));
+		}
+
+		U64 run(U32 which, U64 value)
+		{
+			return Runtime::invokeFunction(Runtime::asFunction(Runtime::getInstanceExport(instance, "run")),
+				{ Runtime::Value(which), Runtime::Value(value) }).u64;
+		}
+
+		U64 count() { return Runtime::memoryRef<U64>(Runtime::getDefaultMemory(instance), 8); }
+	};
+}
+
+BOOST_AUTO_TEST_SUITE(wasm_code_cache_test_suite)
+
+BOOST_AUTO_TEST_CASE(wasm_code_cache_round_trip) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	const std::vector<U8> code = MakeObjectCode(10000, 1);
+	{
+		wasm_code_cache cache(temp, 1024 * 1024);
+		std::vector<U8> object;
+		BOOST_CHECK(!cache.load(CacheKey(0), object));
+		cache.store(CacheKey(0), code);
+		BOOST_CHECK(cache.load(CacheKey(0), object));
+		BOOST_CHECK(object == code);
+		BOOST_CHECK(cache.stats().hits == 1);
+		BOOST_CHECK(cache.stats().misses == 1);
+	}
+
+	// a restart finds the code, a store that never got renamed is dropped, files of others are left alone.
+	{
+		std::ofstream(((temp / CacheKey(1)).generic_string() + ".tmp").c_str()) << "torn";
+		std::ofstream((temp / "notes.txt").generic_string().c_str()) << "not a cache file";
+	}
+	{
+		wasm_code_cache cache(temp, 1024 * 1024);
+		BOOST_CHECK(cache.size() == boost::filesystem::file_size(temp / (CacheKey(0) + ".jit")));
+		BOOST_CHECK(!boost::filesystem::exists(temp / (CacheKey(1) + ".tmp")));
+		BOOST_CHECK(boost::filesystem::exists(temp / "notes.txt"));
+		std::vector<U8> object;
+		BOOST_CHECK(cache.load(CacheKey(0), object));
+		BOOST_CHECK(object == code);
+		BOOST_CHECK(!cache.load(CacheKey(1), object));
+	}
+
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(wasm_code_cache_rejects_damage) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	wasm_code_cache cache(temp, 1024 * 1024);
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		cache.store(CacheKey(i), MakeObjectCode(4096, U8(i)));
+	}
+
+	// one flipped byte in the code.
+	{
+		const boost::filesystem::path file = temp / (CacheKey(0) + ".jit");
+		std::fstream stream(file.generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		char c = 0;
+		stream.seekg(-100, std::ios::end);
+		stream.read(&c, 1);
+		c = ~c;
+		stream.seekp(-100, std::ios::end);
+		stream.write(&c, 1);
+	}
+	// a file cut short.
+	boost::filesystem::resize_file(temp / (CacheKey(1) + ".jit"), 1000);
+	// a file under the name of another key.
+	boost::filesystem::copy_file(temp / (CacheKey(2) + ".jit"), temp / (CacheKey(3) + ".jit"));
+
+	std::vector<U8> object;
+	for (uint32_t i : { 0, 1, 3 })
+	{
+		BOOST_CHECK(!cache.load(CacheKey(i), object));
+		BOOST_CHECK(object.empty());
+		BOOST_CHECK(!boost::filesystem::exists(temp / (CacheKey(i) + ".jit")));
+	}
+	BOOST_CHECK(cache.stats().rejected == 3);
+	BOOST_CHECK(cache.load(CacheKey(2), object));
+	BOOST_CHECK(object == MakeObjectCode(4096, 2));
+
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(wasm_code_cache_evicts_least_recent) {
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	const size_t code_size = 100 * 1024;
+	wasm_code_cache cache(temp, 5 * code_size + 4096);
+
+	const std::time_t now = std::time(nullptr);
+	for (uint32_t i = 0; i < 5; ++i)
+	{
+		cache.store(CacheKey(i), MakeObjectCode(code_size, U8(i)));
+		boost::filesystem::last_write_time(temp / (CacheKey(i) + ".jit"), now - 100 + i);
+	}
+	BOOST_CHECK(cache.stats().evicted == 0);
+
+	// using the oldest makes the second oldest the one to go.
+	std::vector<U8> object;
+	BOOST_REQUIRE(cache.load(CacheKey(0), object));
+	cache.store(CacheKey(5), MakeObjectCode(code_size, 5));
+	BOOST_CHECK(cache.stats().evicted == 1);
+	BOOST_CHECK(cache.size() <= 5 * code_size + 4096);
+	BOOST_CHECK(!cache.load(CacheKey(1), object));
+	for (uint32_t i : { 0, 2, 3, 4, 5 })
+	{
+		BOOST_CHECK(cache.load(CacheKey(i), object));
+	}
+
+	// code larger than the cache is still kept, until the next store.
+	cache.store(CacheKey(6), MakeObjectCode(6 * code_size, 6));
+	BOOST_CHECK(cache.load(CacheKey(6), object));
+	BOOST_CHECK(object.size() == 6 * code_size);
+	BOOST_CHECK(cache.stats().evicted == 6);
+
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_CASE(wasm_code_cache_instances) {
+	// initializes the runtime and registers gas_exhausted.
+	vm_xmax::get();
+
+	boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	const std::vector<uint8_t> wasm = ConvertFromWastToWasm(CachedCodeWast);
+	const std::string key = fc::sha256::hash(std::string(CachedCodeWast) + Runtime::getObjectCodeFingerprint()).str();
+
+	// compiled on a miss, then linked from the file into a second instance after a restart.
+	wasm_code_cache compiled(temp, 1024 * 1024);
+	cached_instance first(wasm, compiled, key);
+	BOOST_CHECK(compiled.stats().misses == 1);
+	BOOST_CHECK(compiled.size() > 0);
+
+	wasm_code_cache restarted(temp, 1024 * 1024);
+	cached_instance second(wasm, restarted, key);
+	BOOST_CHECK(restarted.stats().hits == 1);
+	BOOST_CHECK(Runtime::getMachineCodeSize(second.instance) > 0);
+
+	// the same code, bound to each instance's own memory, table and globals.
+	BOOST_CHECK(first.run(0, 5) == 10);
+	BOOST_CHECK(first.run(1, 5) == 15);
+	BOOST_CHECK(second.run(1, 7) == 21);
+	BOOST_CHECK(first.count() == 2);
+	BOOST_CHECK(second.count() == 1);
+	BOOST_CHECK_THROW(second.run(2, 7), Runtime::Exception);
+
+	boost::filesystem::remove_all(temp);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+#include <Inline/Serialization.h>
+#include <IR/Module.h>
+#include <WASM/WASM.h>
+#include <Runtime/Linker.h>
+#include <Runtime/Runtime.h>
+#include <vm_xmax.hpp>
+#include <wast_to_wasm.hpp>
+
+
+
+namespace {
+
+	static const char* InvokeWast = R"=====(
+(module
+ (memory 1)
+ (export "mix" (func $mix))
+ (export "store" (func $store))
+ (export "trap" (func $trap))
+ (func $mix (param $a i64) (param $b i32) (result i64)
+  (i64.add (i64.mul (get_local $a) (i64.const 3)) (i64.extend_u/i32 (get_local $b))))
+ (func $store (param $v i64)
+  (i64.store (i32.const 8) (get_local $v)))
+ (func $trap (unreachable))
+)
+)=====";
+
+	struct invoke_module
+	{
+		IR::Module					module;
+		Runtime::ModuleInstance*	instance = nullptr;
+
+		invoke_module()
+		{
+			// initializes the runtime.
+			Xmaxplatform::Chain::vm_xmax::get();
+
+			const std::vector<uint8_t> wasm = Xmaxplatform::Chain::ConvertFromWastToWasm(InvokeWast);
+			Serialization::MemoryInputStream stream((const U8*)wasm.data(), wasm.size());
+			WASM::serialize(stream, module);
+			Runtime::LinkResult link = Runtime::linkModule(module, Runtime::IntrinsicResolver::singleton);
+			instance = Runtime::instantiateModule(module, std::move(link.resolvedImports));
+		}
+
+		Runtime::FunctionInvoker invoker(const char* name)
+		{
+			return Runtime::getFunctionInvoker(Runtime::asFunctionNullable(Runtime::getInstanceExport(instance, name)));
+		}
+	};
+}
+
+BOOST_AUTO_TEST_SUITE(wasm_invoke_test_suite)
+
+BOOST_AUTO_TEST_CASE(wasm_invoke_resolved) {
+	invoke_module m;
+
+	const Runtime::FunctionInvoker mix = m.invoker("mix");
+	BOOST_REQUIRE(mix.function && mix.thunk);
+	BOOST_CHECK(mix.type == IR::FunctionType::get(IR::ResultType::i64, { IR::ValueType::i64, IR::ValueType::i32 }));
+
+	// the same result as the generic invoke.
+	U64 slots[3] = { 1000, 7, 0 };
+	const Runtime::Result result = Runtime::invokeFunction(mix, slots);
+	BOOST_CHECK(result.type == IR::ResultType::i64);
+	BOOST_CHECK(result.u64 == 3007);
+	BOOST_CHECK(Runtime::invokeFunction(mix.function, { Runtime::Value(uint64_t(1000)), Runtime::Value(U32(7)) }).u64 == 3007);
+
+	const Runtime::FunctionInvoker store = m.invoker("store");
+	U64 value[2] = { 0x1122334455667788, 0 };
+	BOOST_CHECK(Runtime::invokeFunction(store, value).type == IR::ResultType::none);
+	BOOST_CHECK(Runtime::memoryRef<U64>(Runtime::getDefaultMemory(m.instance), 8) == 0x1122334455667788);
+
+	// not exported.
+	const Runtime::FunctionInvoker missing = m.invoker("apply");
+	BOOST_CHECK(!missing.function && !missing.type && !missing.thunk);
+}
+
+BOOST_AUTO_TEST_CASE(wasm_invoke_trap) {
+	invoke_module m;
+	U64 slots[1] = { 0 };
+	BOOST_CHECK_THROW(Runtime::invokeFunction(m.invoker("trap"), slots), Runtime::Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,237 @@
+#include <cstring>
+#include <Inline/Serialization.h>
+#include <IR/Module.h>
+#include <WASM/WASM.h>
+#include <Platform/Platform.h>
+#include <Runtime/Linker.h>
+#include <Runtime/Runtime.h>
+#include <vm_xmax.hpp>
+#include <wast_to_wasm.hpp>
+
+
+
+namespace {
+
+	struct image_test_pages
+	{
+		const Uptr	page_size = Uptr(1) << Platform::getPageSizeLog2();
+		const Uptr	count;
+		U8*			base;
+
+		explicit image_test_pages(Uptr inCount)
+		: count(inCount)
+		, base(Platform::allocateVirtualPages(inCount))
+		{
+			Platform::commitVirtualPages(base, count);
+			for (Uptr i = 0; i < count * page_size; ++i)
+			{
+				base[i] = U8(i * 7 + i / page_size);
+			}
+		}
+
+		~image_test_pages()
+		{
+			Platform::decommitVirtualPages(base, count);
+			Platform::freeVirtualPages(base, count);
+		}
+
+		bool unchanged() const
+		{
+			for (Uptr i = 0; i < count * page_size; ++i)
+			{
+				if (base[i] != U8(i * 7 + i / page_size))
+					return false;
+			}
+			return true;
+		}
+	};
+
+	// a contract memory of one page that may grow to four, written and grown by the contract itself.
+	static const char* GrowingMemoryWast = R"=====(
+(module
+ (memory 1 4)
+ (data (i32.const 16) "xmax")
+ (export "store" (func $store))
+ (export "load" (func $load))
+ (export "grow" (func $grow))
+ (export "fail" (func $fail))
+ (func $store (param $offset i32) (param $value i64)
+  (i64.store (get_local $offset) (get_local $value)))
+ (func $load (param $offset i32) (result i64)
+  (i64.load (get_local $offset)))
+ (func $grow (param $pages i32) (result i32)
+  (grow_memory (get_local $pages)))
+ (func $fail (param $offset i32)
+  (i64.store (get_local $offset) (i64.const 7))
+  (unreachable))
+)
+)=====";
+
+	struct growing_memory
+	{
+		IR::Module					module;
+		Runtime::ModuleInstance*	instance = nullptr;
+		Runtime::MemoryInstance*	memory = nullptr;
+
+		growing_memory()
+		{
+			// initializes the runtime.
+			Xmaxplatform::Chain::vm_xmax::get();
+
+			const std::vector<uint8_t> wasm = Xmaxplatform::Chain::ConvertFromWastToWasm(GrowingMemoryWast);
+			Serialization::MemoryInputStream stream((const U8*)wasm.data(), wasm.size());
+			WASM::serialize(stream, module);
+			Runtime::LinkResult link = Runtime::linkModule(module, Runtime::IntrinsicResolver::singleton);
+			instance = Runtime::instantiateModule(module, std::move(link.resolvedImports));
+			memory = Runtime::getDefaultMemory(instance);
+		}
+
+		Runtime::Result call(const char* name, const std::vector<Runtime::Value>& args)
+		{
+			return Runtime::invokeFunction(Runtime::asFunction(Runtime::getInstanceExport(instance, name)), args);
+		}
+		void store(U32 offset, U64 value) { call("store", { Runtime::Value(offset), Runtime::Value(value) }); }
+		U64 load(U32 offset) { return call("load", { Runtime::Value(offset) }).u64; }
+		I32 grow(U32 pages) { return call("grow", { Runtime::Value(pages) }).i32; }
+	};
+}
+
+BOOST_AUTO_TEST_SUITE(wasm_memory_image_test_suite)
+
+BOOST_AUTO_TEST_CASE(wasm_memory_image_reset) {
+	image_test_pages pages(256);
+	Platform::MemoryImage* image = Platform::createMemoryImage(pages.base, pages.count);
+	if (!image)
+	{
+		BOOST_TEST_MESSAGE("memory images are not supported here, memories are restored by copying");
+		return;
+	}
+	BOOST_REQUIRE(Platform::mapMemoryImage(image, pages.base));
+	BOOST_CHECK(pages.unchanged());
+
+	// nothing written, nothing to restore.
+	BOOST_CHECK(Platform::resetMemoryImage(image, pages.base) == 0);
+
+	// reading maps pages from the image, only the written ones are restored.
+	volatile U8 read = pages.base[5 * pages.page_size];
+	(void)read;
+	pages.base[3 * pages.page_size + 1] = 0;
+	pages.base[4 * pages.page_size] = 0;
+	pages.base[200 * pages.page_size + 9] = 0;
+	BOOST_CHECK(!pages.unchanged());
+	BOOST_CHECK(Platform::resetMemoryImage(image, pages.base) == 3);
+	BOOST_CHECK(pages.unchanged());
+
+	memset(pages.base, 0, pages.count * pages.page_size);
+	BOOST_CHECK(Platform::resetMemoryImage(image, pages.base) == pages.count);
+	BOOST_CHECK(pages.unchanged());
+
+	// the mapping outlives the image.
+	Platform::destroyMemoryImage(image);
+	BOOST_CHECK(pages.unchanged());
+}
+
+BOOST_AUTO_TEST_CASE(wasm_memory_image_decommit) {
+	image_test_pages pages(16);
+	Platform::MemoryImage* image = Platform::createMemoryImage(pages.base, pages.count);
+	if (!image)
+		return;
+	BOOST_REQUIRE(Platform::mapMemoryImage(image, pages.base));
+
+	// the way a memory shrinks and grows again: the pages come back with the image contents.
+	memset(pages.base + 8 * pages.page_size, 0, 8 * pages.page_size);
+	Platform::decommitVirtualPages(pages.base + 8 * pages.page_size, 8);
+	BOOST_REQUIRE(Platform::commitVirtualPages(pages.base + 8 * pages.page_size, 8));
+	BOOST_CHECK(pages.unchanged());
+	BOOST_CHECK(Platform::resetMemoryImage(image, pages.base) == 0);
+
+	Platform::destroyMemoryImage(image);
+}
+
+// the calls vm_xmax makes: a reset before each call, the contract growing its memory,
+// sbrk shrinking it back at the end, and a reset that finds whatever the call left.
+BOOST_AUTO_TEST_CASE(wasm_memory_reset_grow_shrink) {
+	growing_memory m;
+	const U32 page = IR::numBytesPerPage;
+	const U64 xmax = m.load(16);
+	Runtime::snapshotMemory(m.memory);
+
+	// a memory below three pages is copied back in full.
+	BOOST_CHECK(Runtime::resetMemory(m.memory) == page);
+
+	// grown by the contract, written above the image and in it.
+	m.store(64, 1);
+	BOOST_CHECK(m.grow(2) == 1);
+	m.store(2 * page + 8, 2);
+	BOOST_CHECK(Runtime::getMemoryNumPages(m.memory) == 3);
+	Runtime::resetMemory(m.memory);
+	BOOST_CHECK(Runtime::getMemoryNumPages(m.memory) == 1);
+	BOOST_CHECK(m.load(64) == 0);
+	BOOST_CHECK(m.load(16) == xmax);
+
+	// pages grown again after a reset are zero.
+	BOOST_CHECK(m.grow(2) == 1);
+	BOOST_CHECK(m.load(2 * page + 8) == 0);
+
+	// shrunk part of the way back, the way sbrk gives memory back, then reset.
+	m.store(page + 8, 3);
+	BOOST_CHECK(Runtime::shrinkMemory(m.memory, 1) == 3);
+	Runtime::resetMemory(m.memory);
+	BOOST_CHECK(Runtime::getMemoryNumPages(m.memory) == 1);
+	BOOST_CHECK(m.grow(1) == 1);
+	BOOST_CHECK(m.load(page + 8) == 0);
+	Runtime::resetMemory(m.memory);
+
+	// an image taken at three pages: pages shrunk off it come back with its contents.
+	BOOST_CHECK(m.grow(2) == 1);
+	m.store(2 * page + 8, 4);
+	Runtime::snapshotMemory(m.memory);
+	m.store(2 * page + 8, 5);
+	m.store(16, 6);
+	BOOST_CHECK(Runtime::shrinkMemory(m.memory, 2) == 3);
+	BOOST_CHECK(Runtime::resetMemory(m.memory) > 0);
+	BOOST_CHECK(Runtime::getMemoryNumPages(m.memory) == 3);
+	BOOST_CHECK(m.load(2 * page + 8) == 4);
+	BOOST_CHECK(m.load(16) == xmax);
+
+	// a contract that traps leaves its writes for the next reset.
+	BOOST_CHECK_THROW(m.call("fail", { Runtime::Value(U32(8)) }), Runtime::Exception);
+	BOOST_CHECK(m.load(8) == 7);
+	Runtime::resetMemory(m.memory);
+	BOOST_CHECK(m.load(8) == 0);
+	BOOST_CHECK(Runtime::resetMemory(m.memory) == 0);
+}
+
+// memories of three pages and up are mapped from an image until the process holds the most images it keeps open.
+BOOST_AUTO_TEST_CASE(wasm_memory_image_limit) {
+	// initializes the runtime.
+	Xmaxplatform::Chain::vm_xmax::get();
+	const Uptr page = IR::numBytesPerPage;
+
+	std::vector<Runtime::MemoryInstance*> memories;
+	Uptr mapped = 0;
+	for (int i = 0; i < 300; ++i)
+	{
+		Runtime::MemoryInstance* memory = Runtime::createMemory(IR::MemoryType(false, { 1, 3 }));
+		BOOST_REQUIRE(memory);
+		memories.push_back(memory);
+		BOOST_REQUIRE(Runtime::growMemory(memory, 2) == 1);
+		Runtime::snapshotMemory(memory);
+		if (Runtime::resetMemory(memory) == 0)
+			++mapped;
+		else
+			BOOST_CHECK(Runtime::resetMemory(memory) == 3 * page);
+	}
+	BOOST_CHECK(mapped <= 256);
+	BOOST_CHECK(mapped < memories.size());
+
+	// snapshots of one page give the images back.
+	for (Runtime::MemoryInstance* memory : memories)
+	{
+		BOOST_REQUIRE(Runtime::shrinkMemory(memory, 2) == 3);
+		Runtime::snapshotMemory(memory);
+		BOOST_CHECK(Runtime::resetMemory(memory) == page);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
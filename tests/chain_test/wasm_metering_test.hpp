@@ -0,0 +1,149 @@
+#include <Inline/Serialization.h>
+#include <IR/Module.h>
+#include <IR/Operators.h>
+#include <WASM/WASM.h>
+#include <Runtime/Linker.h>
+#include <Runtime/Runtime.h>
+#include <vm_xmax.hpp>
+#include <wast_to_wasm.hpp>
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	// sums n*n for n down to 1: 7 gas around the loop and 14 for each pass with the default costs.
+	static const char* MeteredLoopWast = R"=====(
+(module
+ (export "sum" (func $sum))
+ (func $sum (param $n i64) (result i64) (local $a i64)
+  (block $done
+   (loop $top
+    (br_if $done (i64.eqz (get_local $n)))
+    (set_local $a (i64.add (get_local $a) (i64.mul (get_local $n) (get_local $n))))
+    (set_local $n (i64.sub (get_local $n) (i64.const 1)))
+    (br $top)))
+  (get_local $a))
+)
+)=====";
+
+	struct metered_module
+	{
+		IR::Module					module;
+		Runtime::ModuleInstance*	instance = nullptr;
+		Runtime::FunctionInstance*	sum = nullptr;
+		Runtime::GlobalInstance*	gas = nullptr;
+
+		explicit metered_module(const WASM::OperatorCosts& costs)
+		{
+			// registers gas_exhausted.
+			vm_xmax::get();
+
+			const std::vector<uint8_t> wasm = ConvertFromWastToWasm(MeteredLoopWast);
+			Serialization::MemoryInputStream stream((const U8*)wasm.data(), wasm.size());
+			WASM::serializeWithInjection(stream, module, costs);
+
+			Runtime::LinkResult link = Runtime::linkModule(module, Runtime::IntrinsicResolver::singleton);
+			instance = Runtime::instantiateModule(module, std::move(link.resolvedImports));
+			sum = Runtime::asFunctionNullable(Runtime::getInstanceExport(instance, "sum"));
+			gas = Runtime::getInstanceGlobal(instance, WASM::getGasGlobalIndex(module));
+		}
+
+		// the gas the call left, below zero when it ran out.
+		I64 run(uint64_t n, I64 limit, uint64_t* result = nullptr)
+		{
+			Runtime::setGlobalValue(gas, Runtime::Value(limit));
+			const Runtime::Result value = Runtime::invokeFunction(sum, { Runtime::Value(n) });
+			if (result)
+				*result = value.u64;
+			return Runtime::getGlobalValue(gas).i64;
+		}
+
+		I64 run_out(uint64_t n, I64 limit)
+		{
+			BOOST_CHECK_THROW(run(n, limit), script_runout);
+			return Runtime::getGlobalValue(gas).i64;
+		}
+	};
+}
+
+BOOST_AUTO_TEST_SUITE(wasm_metering_test_suite)
+
+BOOST_AUTO_TEST_CASE(wasm_metering_injection) {
+	metered_module metered{ WASM::OperatorCosts() };
+
+	// the import and the global come after everything the contract declared.
+	BOOST_REQUIRE(metered.module.functions.imports.size() == 1);
+	BOOST_CHECK(metered.module.functions.imports[0].exportName == "gas_exhausted");
+	BOOST_REQUIRE(metered.module.globals.defs.size() == 1);
+	BOOST_CHECK(metered.module.globals.defs[0].type == IR::GlobalType(IR::ValueType::i64, true));
+	BOOST_CHECK(metered.sum != nullptr);
+
+	// the contract can't reach the gas global. The text format checks global indices,
+	// so the code is written against a second global that is dropped before it is encoded.
+	IR::Module refill;
+	{
+		const std::vector<uint8_t> wast_wasm = ConvertFromWastToWasm(R"=====(
+(module
+ (global $g (mut i32) (i32.const 0))
+ (global $h (mut i64) (i64.const 0))
+ (func $refill (set_global 1 (i64.const 1000000)))
+)
+)=====");
+		Serialization::MemoryInputStream stream((const U8*)wast_wasm.data(), wast_wasm.size());
+		WASM::serialize(stream, refill);
+	}
+	refill.globals.defs.pop_back();
+	Serialization::ArrayOutputStream encoded;
+	WASM::serialize(encoded, refill);
+	const std::vector<U8> wasm = encoded.getBytes();
+
+	IR::Module module;
+	Serialization::MemoryInputStream stream(wasm.data(), wasm.size());
+	BOOST_CHECK_THROW(WASM::serializeWithInjection(stream, module), Serialization::FatalSerializationException);
+}
+
+BOOST_AUTO_TEST_CASE(wasm_metering_deterministic) {
+	metered_module metered{ WASM::OperatorCosts() };
+
+	for (uint64_t n : { 0, 1, 1000 })
+	{
+		uint64_t result = 0;
+		BOOST_CHECK(metered.run(n, 1000000, &result) == I64(1000000 - (14 * n + 7)));
+		BOOST_CHECK(result == n * (n + 1) * (2 * n + 1) / 6);
+	}
+
+	// out of gas at the same operator on every run, one short of what it needs or far short.
+	const I64 needed = 14 * 1000 + 7;
+	for (I64 limit : { needed - 1, I64(1000) })
+	{
+		const I64 first = metered.run_out(1000, limit);
+		BOOST_CHECK(first < 0);
+		for (int i = 0; i < 10; ++i)
+		{
+			BOOST_CHECK(metered.run_out(1000, limit) == first);
+		}
+	}
+	BOOST_CHECK(metered.run(1000, needed) == 0);
+
+	// a second instance of the same code charges the same.
+	metered_module other{ WASM::OperatorCosts() };
+	BOOST_CHECK(other.run(1000, needed) == 0);
+	BOOST_CHECK(other.run_out(1000, 1000) == metered.run_out(1000, 1000));
+}
+
+BOOST_AUTO_TEST_CASE(wasm_metering_costs) {
+	WASM::OperatorCosts costs;
+	costs.costs[IR::Opcode::i64_mul] = 10;
+	metered_module metered{ costs };
+	BOOST_CHECK(metered.run(1000, 1000000) == I64(1000000 - (23 * 1000 + 7)));
+
+	// the contracts vm_xmax loads are charged by its table.
+	const WASM::OperatorCosts& defaults = vm_xmax::get().operator_costs();
+	BOOST_CHECK(defaults.getCost(IR::Opcode::i64_add) == 1);
+	BOOST_CHECK(defaults.getCost(IR::Opcode::i64_mul) > 1);
+	BOOST_CHECK(defaults.getCost(IR::Opcode::call) > 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,196 @@
+#include <fstream>
+#include <wasm_module_cache.hpp>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+
+
+using namespace Xmaxplatform::Chain;
+
+namespace {
+
+	struct cached_test_module
+	{
+		uint32_t			id = 0;
+		std::vector<char>	init_memory;
+	};
+
+	typedef wasm_module_cache<cached_test_module> test_module_cache;
+
+	static fc::sha256 ModuleHash(uint32_t i) {
+		return fc::sha256::hash("module" + std::to_string(i));
+	}
+
+	static account_name ModuleAccount(uint32_t i) {
+		return account_name(std::string("acc") + char('a' + i / 26 % 26) + char('a' + i % 26));
+	}
+
+	static cached_test_module MakeTestModule(uint32_t id, size_t memory) {
+		cached_test_module module;
+		module.id = id;
+		// written, so the pages are resident.
+		module.init_memory.assign(memory, char(id));
+		return module;
+	}
+
+	static uint64_t ResidentBytes() {
+#ifdef __linux__
+		uint64_t size = 0;
+		uint64_t resident = 0;
+		std::ifstream("/proc/self/statm") >> size >> resident;
+		return resident * ::sysconf(_SC_PAGESIZE);
+#else
+		return 0;
+#endif
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(wasm_module_cache_test_suite)
+
+BOOST_AUTO_TEST_CASE(wasm_module_cache_lru) {
+	std::vector<uint32_t> released;
+	test_module_cache cache(3000, [&](std::vector<cached_test_module>& dropped) {
+		for (const auto& module : dropped)
+		{
+			released.push_back(module.id);
+		}
+	});
+
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		BOOST_CHECK(!cache.find(ModuleAccount(i), ModuleHash(i)));
+		cache.insert(ModuleAccount(i), ModuleHash(i), MakeTestModule(i, 10), 1000);
+	}
+	BOOST_CHECK(cache.size() == 3000);
+	BOOST_CHECK(released.empty());
+
+	// a hit makes module 0 the most recent, module 1 goes first.
+	BOOST_REQUIRE(cache.find(ModuleAccount(0), ModuleHash(0)));
+	BOOST_CHECK(cache.find(ModuleAccount(0), ModuleHash(0))->id == 0);
+	cache.insert(ModuleAccount(3), ModuleHash(3), MakeTestModule(3, 10), 1000);
+	BOOST_CHECK(released == std::vector<uint32_t>{ 1 });
+	BOOST_CHECK(!cache.find(ModuleAccount(1), ModuleHash(1)));
+	BOOST_CHECK(cache.count() == 3);
+
+	// a module larger than the limit stays until the next insert.
+	cache.insert(ModuleAccount(4), ModuleHash(4), MakeTestModule(4, 10), 5000);
+	BOOST_CHECK(cache.count() == 1);
+	BOOST_CHECK(cache.find(ModuleAccount(4), ModuleHash(4)));
+
+	const auto& stats = cache.stats();
+	BOOST_CHECK(stats.hits == 3);
+	BOOST_CHECK(stats.misses == 4);
+	BOOST_CHECK(stats.evicted == 4);
+	BOOST_CHECK(stats.replaced == 0);
+}
+
+BOOST_AUTO_TEST_CASE(wasm_module_cache_replaced_code) {
+	std::vector<uint32_t> released;
+	test_module_cache cache(1000000, [&](std::vector<cached_test_module>& dropped) {
+		for (const auto& module : dropped)
+		{
+			released.push_back(module.id);
+		}
+	});
+
+	// two accounts run the same code, one instance.
+	BOOST_CHECK(!cache.find(STN(alice), ModuleHash(0)));
+	cache.insert(STN(alice), ModuleHash(0), MakeTestModule(0, 10), 100);
+	BOOST_REQUIRE(cache.find(STN(bob), ModuleHash(0)));
+	BOOST_CHECK(cache.count() == 1);
+
+	// alice's setcode leaves the module to bob.
+	BOOST_CHECK(!cache.find(STN(alice), ModuleHash(1)));
+	cache.insert(STN(alice), ModuleHash(1), MakeTestModule(1, 10), 100);
+	BOOST_CHECK(released.empty());
+	BOOST_CHECK(cache.count() == 2);
+
+	// bob's frees it.
+	BOOST_CHECK(!cache.find(STN(bob), ModuleHash(2)));
+	BOOST_CHECK(released == std::vector<uint32_t>{ 0 });
+	cache.insert(STN(bob), ModuleHash(2), MakeTestModule(2, 10), 100);
+	BOOST_CHECK(cache.stats().replaced == 1);
+	BOOST_CHECK(cache.size() == 200);
+
+	// eviction drops the bindings with the module, loaded again it is bound as accounts run it.
+	BOOST_CHECK(cache.find(STN(carol), ModuleHash(2)));
+	cache.set_max_size(100);
+	BOOST_CHECK(!cache.find(STN(dave), ModuleHash(3)));
+	cache.insert(STN(dave), ModuleHash(3), MakeTestModule(3, 10), 100);
+	BOOST_CHECK(cache.count() == 1);
+	BOOST_CHECK(!cache.find(STN(carol), ModuleHash(2)));
+	cache.insert(STN(carol), ModuleHash(2), MakeTestModule(2, 10), 100);
+	BOOST_CHECK(!cache.find(STN(bob), ModuleHash(4)));
+	BOOST_CHECK(cache.count() == 1);
+	BOOST_CHECK(cache.find(STN(carol), ModuleHash(2)));
+	BOOST_CHECK(cache.stats().replaced == 1);
+	BOOST_CHECK(cache.account_count() == 1);
+
+	// bob is bound again by running the code, carol leaving keeps it for him.
+	BOOST_CHECK(cache.find(STN(bob), ModuleHash(2)));
+	BOOST_CHECK(!cache.find(STN(carol), ModuleHash(5)));
+	BOOST_CHECK(cache.find(STN(bob), ModuleHash(2)));
+	BOOST_CHECK(cache.stats().replaced == 1);
+}
+
+BOOST_AUTO_TEST_CASE(wasm_module_cache_account_bindings) {
+	uint32_t released = 0;
+	test_module_cache cache(32 * 100, [&](std::vector<cached_test_module>& dropped) {
+		released += dropped.size();
+	});
+
+	// every account runs its own code once, only the accounts of cached modules stay bound.
+	const uint32_t accounts = 1000;
+	for (uint32_t i = 0; i < accounts; ++i)
+	{
+		if (!cache.find(ModuleAccount(i), ModuleHash(i)))
+			cache.insert(ModuleAccount(i), ModuleHash(i), MakeTestModule(i, 10), 100);
+		BOOST_REQUIRE(cache.account_count() == cache.count());
+	}
+	BOOST_CHECK(cache.count() == 32);
+	BOOST_CHECK(released == accounts - 32);
+
+	// a failed instantiation leaves no binding behind.
+	BOOST_CHECK(!cache.find(STN(alice), ModuleHash(accounts)));
+	BOOST_CHECK(cache.account_count() == 32);
+
+	// shared code keeps one binding per account and goes with the last of them.
+	BOOST_REQUIRE(cache.find(ModuleAccount(accounts - 1), ModuleHash(accounts - 1)));
+	BOOST_REQUIRE(cache.find(STN(bob), ModuleHash(accounts - 1)));
+	BOOST_CHECK(cache.account_count() == 33);
+	BOOST_CHECK(!cache.find(STN(bob), ModuleHash(accounts + 1)));
+	BOOST_CHECK(!cache.find(ModuleAccount(accounts - 1), ModuleHash(accounts + 2)));
+	BOOST_CHECK(cache.count() == 31);
+	BOOST_CHECK(cache.account_count() == 31);
+	BOOST_CHECK(cache.stats().replaced == 1);
+}
+
+BOOST_AUTO_TEST_CASE(wasm_module_cache_resident_plateau) {
+	const uint32_t contracts = 400;
+	const size_t memory = 1024 * 1024;
+	test_module_cache cache(32 * memory, [](std::vector<cached_test_module>& dropped) {});
+
+	// every deployment is new code, the cache keeps the last 32.
+	uint64_t warm = 0;
+	uint64_t peak = 0;
+	for (uint32_t i = 0; i < contracts; ++i)
+	{
+		const fc::sha256 hash = ModuleHash(i);
+		if (!cache.find(ModuleAccount(i % 50), hash))
+			cache.insert(ModuleAccount(i % 50), hash, MakeTestModule(i, memory), memory);
+
+		if (i == contracts / 4)
+			warm = ResidentBytes();
+		else if (i > contracts / 4)
+			peak = std::max(peak, ResidentBytes());
+	}
+	BOOST_CHECK(cache.count() == 32);
+	BOOST_CHECK(cache.size() == 32 * memory);
+	BOOST_CHECK(cache.stats().evicted + cache.stats().replaced == contracts - 32);
+	BOOST_TEST_MESSAGE("resident after " << contracts / 4 << " contracts: " << warm / 1024 << " KB, peak after: " << peak / 1024 << " KB");
+	BOOST_CHECK(peak <= warm + 8 * memory);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
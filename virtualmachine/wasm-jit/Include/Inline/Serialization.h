@@ -60,7 +60,11 @@ namespace Serialization
 			end = nullptr;
 			return std::move(bytes);
 		}
-		
+
+		// The number of bytes written so far, and a pointer to them that is valid until the next write.
+		Uptr position() const { return next ? next - bytes.data() : 0; }
+		U8* data() { return bytes.data(); }
+
 	private:
 
 		std::vector<U8> bytes;
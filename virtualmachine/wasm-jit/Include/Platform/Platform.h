@@ -88,6 +88,23 @@ namespace Platform
 	// baseVirtualAddress must be a multiple of the preferred page size.
 	PLATFORM_API void freeVirtualPages(U8* baseVirtualAddress,Uptr numPages);
 
+	// A sealed copy of some pages that can be mapped copy-on-write over committed pages.
+	struct MemoryImage;
+
+	// Copies numPages pages at baseVirtualAddress into a new image.
+	// Returns nullptr if the platform can't map images; callers must copy the pages themselves then.
+	PLATFORM_API MemoryImage* createMemoryImage(const U8* baseVirtualAddress,Uptr numPages);
+
+	// Frees an image. Pages it is mapped at keep their contents until they are decommitted or freed.
+	PLATFORM_API void destroyMemoryImage(MemoryImage* image);
+
+	// Maps an image copy-on-write at baseVirtualAddress, replacing the committed pages there.
+	PLATFORM_API bool mapMemoryImage(MemoryImage* image,U8* baseVirtualAddress);
+
+	// Restores the pages at baseVirtualAddress that were written since the image was mapped there or last reset.
+	// Pages that were only read keep their mapping. Returns the number of pages restored.
+	PLATFORM_API Uptr resetMemoryImage(MemoryImage* image,U8* baseVirtualAddress);
+
 	//
 	// Call stack and exceptions
 	//
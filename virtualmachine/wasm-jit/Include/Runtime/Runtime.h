@@ -132,6 +132,22 @@ namespace Runtime
 	// Returns the type of a FunctionInstance.
 	RUNTIME_API const IR::FunctionType* getFunctionType(FunctionInstance* function);
 
+	// A function with its type and invoke thunk resolved, for callers that invoke the same function many times.
+	struct FunctionInvoker
+	{
+		FunctionInstance* function = nullptr;
+		const IR::FunctionType* type = nullptr;
+		void (*thunk)(void*,U64*) = nullptr;
+	};
+
+	// Resolves the invoke thunk of a function, or returns an empty invoker for nullptr.
+	RUNTIME_API FunctionInvoker getFunctionInvoker(FunctionInstance* function);
+
+	// Invokes a function through its invoker. arguments has a 64-bit slot for each parameter, already holding
+	// a value of the parameter's type, and one more the result is written to. Nothing is checked against the type.
+	// Throws a Runtime::Exception if a trap occurs.
+	RUNTIME_API Result invokeFunction(const FunctionInvoker& invoker,U64* arguments);
+
 	//
 	// Tables
 	//
@@ -171,6 +187,15 @@ namespace Runtime
 	RUNTIME_API Iptr growMemory(MemoryInstance* memory,Uptr numPages);
 	RUNTIME_API Iptr shrinkMemory(MemoryInstance* memory,Uptr numPages);
 
+	// Keeps the current contents and size of a memory as the state resetMemory restores.
+	// Where the platform allows, the contents of a memory of three or more pages are sealed and mapped copy-on-write,
+	// so a reset only touches written pages. Each such image holds a file descriptor while the memory lives, and at
+	// most 256 are kept at once; smaller memories and those past the limit are copied back in full.
+	RUNTIME_API void snapshotMemory(MemoryInstance* memory);
+
+	// Restores a memory to its last snapshot. Returns the number of bytes that had to be restored.
+	RUNTIME_API Uptr resetMemory(MemoryInstance* memory);
+
 	// Validates that an offset range is wholly inside a Memory's virtual address range.
 	RUNTIME_API U8* getValidatedMemoryOffsetRange(MemoryInstance* memory,Uptr offset,Uptr numBytes);
 	
@@ -210,11 +235,35 @@ namespace Runtime
 	// Instantiates a module, bindings its imports to the specified objects. May throw InstantiationException.
 	RUNTIME_API ModuleInstance* instantiateModule(const IR::Module& module,ImportBindings&& imports);
 
+	// A store for the machine code generated for modules.
+	// The code refers to the instance it was generated for only through symbols that are resolved when it is loaded,
+	// so it can be loaded into any instance of the same module by any runtime with the same object code fingerprint.
+	struct ObjectCache
+	{
+		virtual ~ObjectCache() {}
+
+		// Returns false if there is no valid object code for the key.
+		virtual bool load(const std::string& key,std::vector<U8>& outObject) = 0;
+		virtual void store(const std::string& key,const std::vector<U8>& object) = 0;
+	};
+
+	// Identifies the compiler, the target and the way generated code refers to its instance.
+	// Cache keys must include it: object code from a runtime with another fingerprint can't be loaded.
+	RUNTIME_API std::string getObjectCodeFingerprint();
+
+	// Instantiates a module, loading its machine code from the cache if it has it under cacheKey, or generating it and storing it there.
+	RUNTIME_API ModuleInstance* instantiateModule(const IR::Module& module,ImportBindings&& imports,ObjectCache* cache,const std::string& cacheKey);
+
 	// Gets the default table/memory for a ModuleInstance.
 	RUNTIME_API MemoryInstance* getDefaultMemory(ModuleInstance* moduleInstance);
    RUNTIME_API uint64_t getDefaultMemorySize(ModuleInstance* moduleInstance);
+	// Gets the number of bytes the machine code of a ModuleInstance occupies.
+	RUNTIME_API Uptr getMachineCodeSize(ModuleInstance* moduleInstance);
 	RUNTIME_API TableInstance* getDefaultTable(ModuleInstance* moduleInstance);
 
+	// Gets a global of a ModuleInstance by its index in the module, imported globals first.
+	RUNTIME_API GlobalInstance* getInstanceGlobal(ModuleInstance* moduleInstance,Uptr globalIndex);
+
 	// Gets an object exported by a ModuleInstance by name.
 	RUNTIME_API ObjectInstance* getInstanceExport(ModuleInstance* moduleInstance,const std::string& name);
 }
@@ -6,12 +6,32 @@
 
 #include "Inline/BasicTypes.h"
 
-namespace IR { struct Module; struct DisassemblyNames; }
+#include <map>
+
+namespace IR { struct Module; struct DisassemblyNames; enum class Opcode : U16; }
 namespace Serialization { struct InputStream; struct OutputStream; }
 
 namespace WASM
 {
+   // The gas each operator costs in code loaded by serializeWithInjection.
+   // Each straight-line run of operators is charged its total up front from a gas global the loaded module gets;
+   // when the global drops below zero the code calls the imported env.gas_exhausted.
+   struct OperatorCosts
+   {
+      U32 defaultCost = 1;
+      std::map<IR::Opcode,U32> costs;
+
+      U32 getCost(IR::Opcode opcode) const
+      {
+         auto it = costs.find(opcode);
+         return it == costs.end() ? defaultCost : it->second;
+      }
+   };
+
    WEBASSEMBLY_API void serialize(Serialization::InputStream& stream,IR::Module& module);
-   WEBASSEMBLY_API void serializeWithInjection(Serialization::InputStream& stream,IR::Module& module);
+   WEBASSEMBLY_API void serializeWithInjection(Serialization::InputStream& stream,IR::Module& module,const OperatorCosts& costs = OperatorCosts());
    WEBASSEMBLY_API void serialize(Serialization::OutputStream& stream,const IR::Module& module);
+
+   // Gets the index of the mutable i64 gas global serializeWithInjection added to a module.
+   WEBASSEMBLY_API Uptr getGasGlobalIndex(const IR::Module& module);
 }
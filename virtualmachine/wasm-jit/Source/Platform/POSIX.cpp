@@ -26,6 +26,12 @@
 #ifdef __linux__
 	#include <execinfo.h>
 	#include <dlfcn.h>
+	#include <fcntl.h>
+	#include <sys/syscall.h>
+	#ifndef MFD_CLOEXEC
+		#define MFD_CLOEXEC 0x0001U
+		#define MFD_ALLOW_SEALING 0x0002U
+	#endif
 #endif
 
 namespace Platform
@@ -99,6 +105,109 @@ namespace Platform
 		if(munmap(baseVirtualAddress,numPages << getPageSizeLog2())) { Errors::fatal("munmap failed"); }
 	}
 
+	struct MemoryImage
+	{
+		int fd;
+		Uptr numPages;
+	};
+
+	#ifdef __linux__
+		// /proc/self/pagemap has a U64 for each virtual page of the process.
+		// A page written since it was mapped from a file is present and no longer backed by the file.
+		enum : U64
+		{
+			pagemapPresent = 1ull << 63,
+			pagemapSwapped = 1ull << 62,
+			pagemapFileOrShared = 1ull << 61
+		};
+
+		static int openPagemap()
+		{
+			return open("/proc/self/pagemap",O_RDONLY | O_CLOEXEC);
+		}
+
+		MemoryImage* createMemoryImage(const U8* baseVirtualAddress,Uptr numPages)
+		{
+			// memfd_create without relying on a libc new enough to wrap it.
+			const int fd = (int)syscall(SYS_memfd_create,"wavm-memory-image",MFD_CLOEXEC | MFD_ALLOW_SEALING);
+			if(fd < 0) { return nullptr; }
+
+			const Uptr numBytes = numPages << getPageSizeLog2();
+			Uptr numWrittenBytes = 0;
+			while(numWrittenBytes < numBytes)
+			{
+				const ssize_t result = pwrite(fd,baseVirtualAddress + numWrittenBytes,numBytes - numWrittenBytes,numWrittenBytes);
+				if(result <= 0) { close(fd); return nullptr; }
+				numWrittenBytes += result;
+			}
+
+			// Once sealed, no mapping can change what the image restores.
+			if(fcntl(fd,F_ADD_SEALS,F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL))
+			{
+				close(fd);
+				return nullptr;
+			}
+			return new MemoryImage {fd,numPages};
+		}
+
+		void destroyMemoryImage(MemoryImage* image)
+		{
+			close(image->fd);
+			delete image;
+		}
+
+		bool mapMemoryImage(MemoryImage* image,U8* baseVirtualAddress)
+		{
+			errorUnless(isPageAligned(baseVirtualAddress));
+			auto result = mmap(baseVirtualAddress,image->numPages << getPageSizeLog2(),PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_FIXED,image->fd,0);
+			return result != MAP_FAILED;
+		}
+
+		Uptr resetMemoryImage(MemoryImage* image,U8* baseVirtualAddress)
+		{
+			errorUnless(isPageAligned(baseVirtualAddress));
+			const Uptr pageSizeLog2 = getPageSizeLog2();
+
+			// Dropping the private copy of a page maps it from the image again.
+			auto restorePages = [&](Uptr firstPage,Uptr numPages)
+			{
+				if(madvise(baseVirtualAddress + (firstPage << pageSizeLog2),numPages << pageSizeLog2,MADV_DONTNEED)) { Errors::fatal("madvise failed"); }
+			};
+
+			static int pagemap = openPagemap();
+			std::vector<U64> entries(image->numPages);
+			const Uptr entriesOffset = (reinterpret_cast<Uptr>(baseVirtualAddress) >> pageSizeLog2) * sizeof(U64);
+			if(pagemap < 0
+			|| pread(pagemap,entries.data(),entries.size() * sizeof(U64),entriesOffset) != ssize_t(entries.size() * sizeof(U64)))
+			{
+				restorePages(0,image->numPages);
+				return image->numPages;
+			}
+
+			Uptr numRestoredPages = 0;
+			Uptr runBegin = 0;
+			for(Uptr pageIndex = 0;pageIndex <= image->numPages;++pageIndex)
+			{
+				const bool isWritten = pageIndex < image->numPages
+					&& (entries[pageIndex] & (pagemapPresent | pagemapSwapped))
+					&& !(entries[pageIndex] & pagemapFileOrShared);
+				if(isWritten) { continue; }
+				if(pageIndex > runBegin)
+				{
+					restorePages(runBegin,pageIndex - runBegin);
+					numRestoredPages += pageIndex - runBegin;
+				}
+				runBegin = pageIndex + 1;
+			}
+			return numRestoredPages;
+		}
+	#else
+		MemoryImage* createMemoryImage(const U8* baseVirtualAddress,Uptr numPages) { return nullptr; }
+		void destroyMemoryImage(MemoryImage* image) { delete image; }
+		bool mapMemoryImage(MemoryImage* image,U8* baseVirtualAddress) { return false; }
+		Uptr resetMemoryImage(MemoryImage* image,U8* baseVirtualAddress) { return 0; }
+	#endif
+
 	bool describeInstructionPointer(Uptr ip,std::string& outDescription)
 	{
 		#ifdef __linux__
@@ -85,6 +85,13 @@ namespace Platform
 		if(baseVirtualAddress && !result) { Errors::fatal("VirtualFree(MEM_RELEASE) failed"); }
 	}
 
+	// Windows has no copy-on-write mappings of a sealed file, memories are restored by copying.
+	struct MemoryImage {};
+	MemoryImage* createMemoryImage(const U8* baseVirtualAddress,Uptr numPages) { return nullptr; }
+	void destroyMemoryImage(MemoryImage* image) { delete image; }
+	bool mapMemoryImage(MemoryImage* image,U8* baseVirtualAddress) { return false; }
+	Uptr resetMemoryImage(MemoryImage* image,U8* baseVirtualAddress) { return 0; }
+
 	// The interface to the DbgHelp DLL
 	struct DbgHelp
 	{
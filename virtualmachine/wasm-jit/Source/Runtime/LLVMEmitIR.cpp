@@ -61,6 +61,15 @@ namespace LLVMJIT
 		}
 
 		llvm::Module* emit();
+
+		// Emits a constant for an address owned by the module instance or the runtime.
+		// It is a reference to an external symbol that is bound when the object code is linked, see resolveInstanceSymbol.
+		llvm::Constant* emitInstanceSymbol(const std::string& name,llvm::Type* type)
+		{
+			llvm::GlobalVariable* symbol = llvmModule->getNamedGlobal(name);
+			if(!symbol) { symbol = new llvm::GlobalVariable(*llvmModule,llvmI8Type,false,llvm::GlobalValue::ExternalLinkage,nullptr,name); }
+			return type->isPointerTy() ? llvm::ConstantExpr::getPointerCast(symbol,type) : llvm::ConstantExpr::getPtrToInt(symbol,type);
+		}
 	};
 
 	// The context used by functions involved in JITing a single AST function.
@@ -257,7 +266,9 @@ namespace LLVMJIT
 			assert(intrinsicObject);
 			FunctionInstance* intrinsicFunction = asFunction(intrinsicObject);
 			assert(intrinsicFunction->type == intrinsicType);
-			auto intrinsicFunctionPointer = emitLiteralPointer(intrinsicFunction->nativeFunction,asLLVMType(intrinsicType)->getPointerTo());
+			auto intrinsicFunctionPointer = moduleContext.emitInstanceSymbol(
+				getIntrinsicSymbolName(Intrinsics::getDecoratedName(intrinsicName,intrinsicType)),
+				asLLVMType(intrinsicType)->getPointerTo());
 			return irBuilder.CreateCall(intrinsicFunctionPointer,llvm::ArrayRef<llvm::Value*>(args.begin(),args.end()));
 		}
 
@@ -638,7 +649,7 @@ namespace LLVMJIT
 			// Load the type for this table entry.
 			auto functionTypePointerPointer = irBuilder.CreateInBoundsGEP(moduleContext.defaultTablePointer,{functionIndexZExt,emitLiteral((U32)0)});
 			auto functionTypePointer = irBuilder.CreateLoad(functionTypePointerPointer);
-			auto llvmCalleeType = emitLiteralPointer(calleeType,llvmI8PtrType);
+			auto llvmCalleeType = moduleContext.emitInstanceSymbol(getTypeSymbolName(imm.type.index),llvmI8PtrType);
 			
 			// If the function type doesn't match, trap.
 			emitConditionalTrapIntrinsic(
@@ -647,7 +658,7 @@ namespace LLVMJIT
 				FunctionType::get(ResultType::none,{ValueType::i32,ValueType::i64,ValueType::i64}),
 				{	tableElementIndex,
 					irBuilder.CreatePtrToInt(llvmCalleeType,llvmI64Type),
-					emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultTable))	}
+					moduleContext.emitInstanceSymbol(tableObjectSymbolName,llvmI64Type)	}
 				);
 
 			// Call the function loaded from the table.
@@ -701,7 +712,7 @@ namespace LLVMJIT
 		void grow_memory(MemoryImm)
 		{
 			auto deltaNumPages = pop();
-			auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+			auto defaultMemoryObjectAsI64 = moduleContext.emitInstanceSymbol(memoryObjectSymbolName,llvmI64Type);
 			auto previousNumPages = emitRuntimeIntrinsic(
 				"wavmIntrinsics.growMemory",
 				FunctionType::get(ResultType::i32,{ValueType::i32,ValueType::i64}),
@@ -710,7 +721,7 @@ namespace LLVMJIT
 		}
 		void current_memory(MemoryImm)
 		{
-			auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+			auto defaultMemoryObjectAsI64 = moduleContext.emitInstanceSymbol(memoryObjectSymbolName,llvmI64Type);
 			auto currentNumPages = emitRuntimeIntrinsic(
 				"wavmIntrinsics.currentMemory",
 				FunctionType::get(ResultType::i32,{ValueType::i64}),
@@ -1199,7 +1210,7 @@ namespace LLVMJIT
 		{
 			auto numWaiters = pop();
 			auto address = pop();
-			auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+			auto defaultMemoryObjectAsI64 = moduleContext.emitInstanceSymbol(memoryObjectSymbolName,llvmI64Type);
 			push(emitRuntimeIntrinsic(
 				"wavmIntrinsics.wake",
 				FunctionType::get(ResultType::i32,{ValueType::i32,ValueType::i32,ValueType::i64}),
@@ -1210,7 +1221,7 @@ namespace LLVMJIT
 			auto timeout = pop();
 			auto expectedValue = pop();
 			auto address = pop();
-			auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+			auto defaultMemoryObjectAsI64 = moduleContext.emitInstanceSymbol(memoryObjectSymbolName,llvmI64Type);
 			push(emitRuntimeIntrinsic(
 				"wavmIntrinsics.wait",
 				FunctionType::get(ResultType::i32,{ValueType::i32,ValueType::i32,ValueType::f64,ValueType::i64}),
@@ -1221,7 +1232,7 @@ namespace LLVMJIT
 			auto timeout = pop();
 			auto expectedValue = pop();
 			auto address = pop();
-			auto defaultMemoryObjectAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultMemory));
+			auto defaultMemoryObjectAsI64 = moduleContext.emitInstanceSymbol(memoryObjectSymbolName,llvmI64Type);
 			push(emitRuntimeIntrinsic(
 				"wavmIntrinsics.wait",
 				FunctionType::get(ResultType::i32,{ValueType::i32,ValueType::i64,ValueType::f64,ValueType::i64}),
@@ -1234,7 +1245,7 @@ namespace LLVMJIT
 			auto errorFunctionIndex = pop();
 			auto argument = pop();
 			auto functionIndex = pop();
-			auto defaultTableAsI64 = emitLiteral(reinterpret_cast<U64>(moduleContext.moduleInstance->defaultTable));
+			auto defaultTableAsI64 = moduleContext.emitInstanceSymbol(tableObjectSymbolName,llvmI64Type);
 			emitRuntimeIntrinsic(
 				"wavmIntrinsics.launchThread",
 				FunctionType::get(ResultType::none,{ValueType::i32,ValueType::i32,ValueType::i32,ValueType::i64}),
@@ -1541,10 +1552,10 @@ namespace LLVMJIT
 	{
 		Timing::Timer emitTimer;
 
-		// Create literals for the default memory base and mask.
+		// Create constants for the default memory base and mask. The mask only depends on the runtime, not on the instance.
 		if(moduleInstance->defaultMemory)
 		{
-			defaultMemoryBase = emitLiteralPointer(moduleInstance->defaultMemory->baseAddress,llvmI8PtrType);
+			defaultMemoryBase = emitInstanceSymbol(memoryBaseSymbolName,llvmI8PtrType);
 			const Uptr defaultMemoryAddressMaskValue = Uptr(moduleInstance->defaultMemory->endOffset) - 1;
 			defaultMemoryAddressMask = emitLiteral(defaultMemoryAddressMaskValue);
 		}
@@ -1557,7 +1568,7 @@ namespace LLVMJIT
 				llvmI8PtrType,
 				llvmI8PtrType
 				});
-			defaultTablePointer = emitLiteralPointer(moduleInstance->defaultTable->baseAddress,tableElementType->getPointerTo());
+			defaultTablePointer = emitInstanceSymbol(tableBaseSymbolName,tableElementType->getPointerTo());
 			defaultTableEndOffset = emitLiteral((Uptr)moduleInstance->defaultTable->endOffset);
 		}
 		else
@@ -1569,12 +1580,15 @@ namespace LLVMJIT
 		for(Uptr functionIndex = 0;functionIndex < module.functions.imports.size();++functionIndex)
 		{
 			const FunctionInstance* functionInstance = moduleInstance->functions[functionIndex];
-			importedFunctionPointers.push_back(emitLiteralPointer(functionInstance->nativeFunction,asLLVMType(functionInstance->type)->getPointerTo()));
+			importedFunctionPointers.push_back(emitInstanceSymbol(getImportSymbolName(functionIndex),asLLVMType(functionInstance->type)->getPointerTo()));
 		}
 
 		// Create LLVM pointer constants for the module's globals.
-		for(auto global : moduleInstance->globals)
-		{ globalPointers.push_back(emitLiteralPointer(&global->value,asLLVMType(global->type.valueType)->getPointerTo())); }
+		for(Uptr globalIndex = 0;globalIndex < moduleInstance->globals.size();++globalIndex)
+		{
+			const GlobalInstance* global = moduleInstance->globals[globalIndex];
+			globalPointers.push_back(emitInstanceSymbol(getGlobalSymbolName(globalIndex),asLLVMType(global->type.valueType)->getPointerTo()));
+		}
 		
 		// Create the LLVM functions.
 		functionDefs.resize(module.functions.defs.size());
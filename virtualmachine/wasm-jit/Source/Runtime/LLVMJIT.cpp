@@ -1,6 +1,7 @@
 #include "LLVMJIT.h"
 #include "Inline/BasicTypes.h"
 #include "Inline/Timing.h"
+#include "IR/Module.h"
 #include "Logging/Logging.h"
 #include "RuntimePrivate.h"
 
@@ -162,6 +163,7 @@ namespace LLVMJIT
 		}
 
 		U8* getImageBaseAddress() const { return imageBaseAddress; }
+		Uptr getNumImageBytes() const { return numAllocatedImagePages << Platform::getPageSizeLog2(); }
 
 	private:
 		struct Section
@@ -214,6 +216,7 @@ namespace LLVMJIT
 	{
 		JITUnit(bool inShouldLogMetrics = true)
 		: shouldLogMetrics(inShouldLogMetrics)
+		, resolver(this)
 		#ifdef _WIN32
 			, pdataCopy(nullptr)
 		#endif
@@ -230,12 +233,42 @@ namespace LLVMJIT
 			#endif
 		}
 
-		void compile(llvm::Module* llvmModule);
+		// Compiles a module, copying the object code to outObject if it isn't null.
+		void compile(llvm::Module* llvmModule,std::vector<U8>* outObject = nullptr);
+
+		// Links object code produced by an earlier compile. Returns false if it isn't a valid object file.
+		bool load(const std::vector<U8>& object);
 
 		virtual void notifySymbolLoaded(const char* name,Uptr baseAddress,Uptr numBytes,std::map<U32,U32>&& offsetToOpIndexMap) = 0;
 
+		// Binds the external symbols of the unit's code that aren't runtime functions.
+		virtual bool resolveSymbol(const std::string& name,Uptr& outAddress) { return false; }
+
+		Uptr getNumImageBytes() const { return memoryManager.getNumImageBytes(); }
+
 	private:
 		
+		// Resolves the unit's external symbols, then falls back to NullResolver.
+		struct UnitResolver : llvm::JITSymbolResolver
+		{
+			JITUnit* jitUnit;
+			UnitResolver(JITUnit* inJITUnit): jitUnit(inJITUnit) {}
+			virtual llvm::JITSymbol findSymbol(const std::string& name) override;
+			virtual llvm::JITSymbol findSymbolInLogicalDylib(const std::string& name) override;
+		};
+
+		// Keeps a copy of the object code the compile layer produces.
+		struct ObjectCapture : llvm::ObjectCache
+		{
+			std::vector<U8>& object;
+			ObjectCapture(std::vector<U8>& inObject): object(inObject) {}
+			void notifyObjectCompiled(const llvm::Module* llvmModule,llvm::MemoryBufferRef objectBuffer) override
+			{
+				object.assign((const U8*)objectBuffer.getBufferStart(),(const U8*)objectBuffer.getBufferEnd());
+			}
+			std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* llvmModule) override { return nullptr; }
+		};
+		
 		// Functor that receives notifications when an object produced by the JIT is loaded.
 		struct NotifyLoadedFunctor
 		{
@@ -263,6 +296,7 @@ namespace LLVMJIT
 		std::unique_ptr<CompileLayer> compileLayer;
 		CompileLayer::ModuleSetHandleT handle;
 		bool shouldLogMetrics;
+		UnitResolver resolver;
 
 		struct LoadedObject
 		{
@@ -280,11 +314,12 @@ namespace LLVMJIT
 	// The JIT compilation unit for a WebAssembly module instance.
 	struct JITModule : JITUnit, JITModuleBase
 	{
+		const IR::Module& module;	// only used while the module is instantiated.
 		ModuleInstance* moduleInstance;
 
 		std::vector<JITSymbol*> functionDefSymbols;
 
-		JITModule(ModuleInstance* inModuleInstance): moduleInstance(inModuleInstance) {}
+		JITModule(const IR::Module& inModule,ModuleInstance* inModuleInstance): module(inModule), moduleInstance(inModuleInstance) {}
 		~JITModule() override
 		{
 			// Delete the module's symbols, and remove them from the global address-to-symbol map.
@@ -315,6 +350,13 @@ namespace LLVMJIT
 				}
 			}
 		}
+
+		bool resolveSymbol(const std::string& name,Uptr& outAddress) override
+		{
+			return resolveInstanceSymbol(module,moduleInstance,name,outAddress);
+		}
+
+		Uptr getNumMachineCodeBytes() const override { return getNumImageBytes(); }
 	};
 
 	// The JIT compilation unit for a single invoke thunk.
@@ -356,6 +398,51 @@ namespace LLVMJIT
 	}
 	llvm::JITSymbol NullResolver::findSymbolInLogicalDylib(const std::string& name) { return llvm::JITSymbol(nullptr); }
 
+	llvm::JITSymbol JITUnit::UnitResolver::findSymbol(const std::string& name)
+	{
+		Uptr address = 0;
+		if(jitUnit->resolveSymbol(name,address)) { return llvm::JITSymbol(address,llvm::JITSymbolFlags::None); }
+		return NullResolver::singleton.findSymbol(name);
+	}
+	llvm::JITSymbol JITUnit::UnitResolver::findSymbolInLogicalDylib(const std::string& name) { return llvm::JITSymbol(nullptr); }
+
+	bool resolveInstanceSymbol(const IR::Module& module,ModuleInstance* moduleInstance,const std::string& name,Uptr& outAddress)
+	{
+		// Parses the index following a symbol prefix.
+		auto getSymbolIndex = [&name](const char* prefix,Uptr& outIndex)
+		{
+			const Uptr prefixLength = strlen(prefix);
+			if(name.size() <= prefixLength || name.compare(0,prefixLength,prefix)) { return false; }
+			char* numberEnd = nullptr;
+			outIndex = std::strtoull(name.c_str() + prefixLength,&numberEnd,10);
+			return *numberEnd == 0;
+		};
+
+		Uptr index = 0;
+		if(name == memoryObjectSymbolName && moduleInstance->defaultMemory)
+		{ outAddress = reinterpret_cast<Uptr>(moduleInstance->defaultMemory); }
+		else if(name == memoryBaseSymbolName && moduleInstance->defaultMemory)
+		{ outAddress = reinterpret_cast<Uptr>(moduleInstance->defaultMemory->baseAddress); }
+		else if(name == tableObjectSymbolName && moduleInstance->defaultTable)
+		{ outAddress = reinterpret_cast<Uptr>(moduleInstance->defaultTable); }
+		else if(name == tableBaseSymbolName && moduleInstance->defaultTable)
+		{ outAddress = reinterpret_cast<Uptr>(moduleInstance->defaultTable->baseAddress); }
+		else if(getSymbolIndex(importSymbolPrefix,index) && index < module.functions.imports.size())
+		{ outAddress = reinterpret_cast<Uptr>(moduleInstance->functions[index]->nativeFunction); }
+		else if(getSymbolIndex(globalSymbolPrefix,index) && index < moduleInstance->globals.size())
+		{ outAddress = reinterpret_cast<Uptr>(&moduleInstance->globals[index]->value); }
+		else if(getSymbolIndex(typeSymbolPrefix,index) && index < module.types.size())
+		{ outAddress = reinterpret_cast<Uptr>(module.types[index]); }
+		else if(!name.compare(0,strlen(intrinsicSymbolPrefix),intrinsicSymbolPrefix))
+		{
+			FunctionInstance* intrinsicFunction = Intrinsics::findFunction(name.substr(strlen(intrinsicSymbolPrefix)));
+			if(!intrinsicFunction) { return false; }
+			outAddress = reinterpret_cast<Uptr>(intrinsicFunction->nativeFunction);
+		}
+		else { return false; }
+		return true;
+	}
+
 	void JITUnit::NotifyLoadedFunctor::operator()(
 		const llvm::orc::ObjectLinkingLayerBase::ObjSetHandleT& objectSetHandle,
 		const std::vector<std::unique_ptr<llvm::object::OwningBinary<llvm::object::ObjectFile>>>& objectSet,
@@ -476,7 +563,7 @@ namespace LLVMJIT
 		Log::printf(Log::Category::debug,"Dumped LLVM module to: %s\n",augmentedFilename.c_str());
 	}
 
-	void JITUnit::compile(llvm::Module* llvmModule)
+	void JITUnit::compile(llvm::Module* llvmModule,std::vector<U8>* outObject)
 	{
 		// Get a target machine object for this host, and set the module to use its data layout.
 		llvmModule->setDataLayout(targetMachine->createDataLayout());
@@ -513,12 +600,19 @@ namespace LLVMJIT
 
 		if(DUMP_OPTIMIZED_MODULE) { printModule(llvmModule,"llvmOptimizedDump"); }
 
-		// Pass the module to the JIT compiler.
+		// Pass the module to the JIT compiler, capturing the object code it produces if asked.
 		Timing::Timer machineCodeTimer;
+		std::unique_ptr<ObjectCapture> objectCapture;
+		if(outObject)
+		{
+			objectCapture = llvm::make_unique<ObjectCapture>(*outObject);
+			compileLayer->setObjectCache(objectCapture.get());
+		}
 		handle = compileLayer->addModuleSet(
 			std::vector<llvm::Module*>{llvmModule},
 			&memoryManager,
-			&NullResolver::singleton);
+			&resolver);
+		compileLayer->setObjectCache(nullptr);
 		compileLayer->emitAndFinalize(handle);
 
 		if(shouldLogMetrics)
@@ -529,17 +623,56 @@ namespace LLVMJIT
 		delete llvmModule;
 	}
 
-	void instantiateModule(const IR::Module& module,ModuleInstance* moduleInstance)
+	bool JITUnit::load(const std::vector<U8>& object)
 	{
-		// Emit LLVM IR for the module.
-		auto llvmModule = emitModule(module,moduleInstance);
+		Timing::Timer loadTimer;
+
+		auto objectBuffer = llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef((const char*)object.data(),object.size()));
+		auto objectFile = llvm::object::ObjectFile::createObjectFile(objectBuffer->getMemBufferRef());
+		if(!objectFile)
+		{
+			Log::printf(Log::Category::error,"Cached object code is not an object file: %s\n",llvm::toString(objectFile.takeError()).c_str());
+			return false;
+		}
 
+		// Link the object as the compile layer would have: the unit's resolver binds its external symbols.
+		std::vector<std::unique_ptr<llvm::object::OwningBinary<llvm::object::ObjectFile>>> objectSet;
+		objectSet.push_back(llvm::make_unique<llvm::object::OwningBinary<llvm::object::ObjectFile>>(std::move(*objectFile),std::move(objectBuffer)));
+		handle = objectLayer->addObjectSet(std::move(objectSet),&memoryManager,&resolver);
+		objectLayer->emitAndFinalize(handle);
+
+		if(shouldLogMetrics) { Timing::logTimer("Loaded cached machine code",loadTimer); }
+		return true;
+	}
+
+	void instantiateModule(const IR::Module& module,ModuleInstance* moduleInstance,ObjectCache* cache,const std::string& cacheKey)
+	{
 		// Construct the JIT compilation pipeline for this module.
-		auto jitModule = new JITModule(moduleInstance);
+		auto jitModule = new JITModule(module,moduleInstance);
 		moduleInstance->jitModule = jitModule;
 
-		// Compile the module.
-		jitModule->compile(llvmModule);
+		// Use the machine code the cache has for the module, bound to this instance.
+		std::vector<U8> object;
+		if(cache && cache->load(cacheKey,object) && jitModule->load(object)) { return; }
+
+		// Emit LLVM IR for the module.
+		auto llvmModule = emitModule(module,moduleInstance);
+
+		// Compile the module, and keep the object code for the next instance.
+		jitModule->compile(llvmModule,cache ? &object : nullptr);
+		if(cache && object.size()) { cache->store(cacheKey,object); }
+	}
+
+	std::string getObjectCodeFingerprint()
+	{
+		// Bump when generated code changes the way it refers to its instance or the runtime.
+		const U32 objectCodeVersion = 1;
+		return "WAVM object code " + std::to_string(objectCodeVersion)
+			+ ", LLVM " + LLVM_VERSION_STRING
+			+ ", " + targetMachine->getTargetTriple().str()
+			+ ", " + targetMachine->getTargetCPU().str()
+			+ ", " + targetMachine->getTargetFeatureString().str()
+			+ (HAS_64BIT_ADDRESS_SPACE ? ", 64-bit address space" : ", 32-bit address space");
 	}
 
 	std::string getExternalFunctionName(ModuleInstance* moduleInstance,Uptr functionDefIndex)
@@ -25,6 +25,7 @@
 
 #include "llvm/Analysis/Passes.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
 #include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
@@ -42,11 +43,13 @@
 #include "llvm/IR/DebugLoc.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/SymbolSize.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/IR/DIBuilder.h"
 #include "llvm/DebugInfo/DIContext.h"
@@ -129,6 +132,24 @@ namespace LLVMJIT
 	std::string getExternalFunctionName(ModuleInstance* moduleInstance,Uptr functionDefIndex);
 	bool getFunctionIndexFromExternalName(const char* externalName,Uptr& outFunctionDefIndex);
 
+	// Names of the symbols generated code uses for addresses owned by its module instance or the runtime.
+	// They are bound when the object code is linked, so the same object code can be loaded into any instance of the module.
+	static const char memoryObjectSymbolName[] = "wavmMemory";
+	static const char memoryBaseSymbolName[] = "wavmMemoryBase";
+	static const char tableObjectSymbolName[] = "wavmTable";
+	static const char tableBaseSymbolName[] = "wavmTableBase";
+	static const char importSymbolPrefix[] = "wavmImport";
+	static const char globalSymbolPrefix[] = "wavmGlobal";
+	static const char typeSymbolPrefix[] = "wavmType";
+	static const char intrinsicSymbolPrefix[] = "wavmIntrinsic ";
+	inline std::string getImportSymbolName(Uptr importIndex) { return importSymbolPrefix + std::to_string(importIndex); }
+	inline std::string getGlobalSymbolName(Uptr globalIndex) { return globalSymbolPrefix + std::to_string(globalIndex); }
+	inline std::string getTypeSymbolName(Uptr typeIndex) { return typeSymbolPrefix + std::to_string(typeIndex); }
+	inline std::string getIntrinsicSymbolName(const std::string& decoratedName) { return intrinsicSymbolPrefix + decoratedName; }
+
+	// Finds the address an instance symbol is bound to in a module instance.
+	bool resolveInstanceSymbol(const IR::Module& module,ModuleInstance* moduleInstance,const std::string& name,Uptr& outAddress);
+
 	// Emits LLVM IR for a module.
 	llvm::Module* emitModule(const IR::Module& module,ModuleInstance* moduleInstance);
 }
@@ -8,6 +8,22 @@ namespace Runtime
 	// Global lists of memories; used to query whether an address is reserved by one of them.
 	std::vector<MemoryInstance*> memories;
 
+	// Below this many pages, copying the whole memory back is cheaper than finding and dropping the written pages.
+	static const Uptr minMemoryImagePages = 3;
+
+	// Each image keeps a file descriptor open for the life of its memory. Past this many, memories are copied back instead,
+	// so a large module cache can't take all of the process's descriptors.
+	static const Uptr maxMemoryImages = 256;
+	static std::atomic<Uptr> numMemoryImages(0);
+
+	static void destroyImage(MemoryInstance* memory)
+	{
+		if(!memory->image) { return; }
+		Platform::destroyMemoryImage(memory->image);
+		memory->image = nullptr;
+		--numMemoryImages;
+	}
+
 	static Uptr getPlatformPagesPerWebAssemblyPageLog2()
 	{
 		errorUnless(Platform::getPageSizeLog2() <= IR::numBytesPerPageLog2);
@@ -51,6 +67,8 @@ namespace Runtime
 
 	MemoryInstance::~MemoryInstance()
 	{
+		destroyImage(this);
+
 		// Decommit all default memory pages.
 		if(numPages > 0) { Platform::decommitVirtualPages(baseAddress,numPages << getPlatformPagesPerWebAssemblyPageLog2()); }
 
@@ -122,6 +140,47 @@ namespace Runtime
 		return previousNumPages;
 	}
 
+	void snapshotMemory(MemoryInstance* memory)
+	{
+		destroyImage(memory);
+		memory->imageCopy.clear();
+
+		const Uptr numPlatformPages = memory->numPages << getPlatformPagesPerWebAssemblyPageLog2();
+		memory->imageNumPages = memory->numPages;
+		if(memory->numPages >= minMemoryImagePages)
+		{
+			// The slot is taken before the image is created, so memories snapshotted concurrently stay under the limit.
+			if(++numMemoryImages <= maxMemoryImages)
+			{
+				memory->image = Platform::createMemoryImage(memory->baseAddress,numPlatformPages);
+				if(memory->image && !Platform::mapMemoryImage(memory->image,memory->baseAddress))
+				{
+					Platform::destroyMemoryImage(memory->image);
+					memory->image = nullptr;
+				}
+			}
+			if(!memory->image) { --numMemoryImages; }
+		}
+		if(!memory->image)
+		{
+			memory->imageCopy.assign(memory->baseAddress,memory->baseAddress + (memory->numPages << IR::numBytesPerPageLog2));
+		}
+	}
+
+	Uptr resetMemory(MemoryInstance* memory)
+	{
+		// Pages shrunk off the image come back with its contents, pages grown past it are decommitted.
+		if(memory->numPages > memory->imageNumPages) { shrinkMemory(memory,memory->numPages - memory->imageNumPages); }
+		else if(memory->numPages < memory->imageNumPages) { errorUnless(growMemory(memory,memory->imageNumPages - memory->numPages) != -1); }
+
+		if(memory->image)
+		{
+			return Platform::resetMemoryImage(memory->image,memory->baseAddress) << Platform::getPageSizeLog2();
+		}
+		memcpy(memory->baseAddress,memory->imageCopy.data(),memory->imageCopy.size());
+		return memory->imageCopy.size();
+	}
+
 	U8* getMemoryBaseAddress(MemoryInstance* memory)
 	{
 		return memory->baseAddress;
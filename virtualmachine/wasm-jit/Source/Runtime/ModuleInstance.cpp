@@ -29,6 +29,11 @@ namespace Runtime
 	}
 
 	ModuleInstance* instantiateModule(const IR::Module& module,ImportBindings&& imports)
+	{
+		return instantiateModule(module,std::move(imports),nullptr,std::string());
+	}
+
+	ModuleInstance* instantiateModule(const IR::Module& module,ImportBindings&& imports,ObjectCache* cache,const std::string& cacheKey)
 	{
 		ModuleInstance* moduleInstance = new ModuleInstance(
 			std::move(imports.functions),
@@ -144,8 +149,8 @@ namespace Runtime
 			moduleInstance->functions.push_back(functionInstance);
 		}
 
-		// Generate machine code for the module.
-		LLVMJIT::instantiateModule(module,moduleInstance);
+		// Generate machine code for the module, or load it from the cache.
+		LLVMJIT::instantiateModule(module,moduleInstance,cache,cacheKey);
 
 		// Set up the instance's exports.
 		for(const Export& exportIt : module.exports)
@@ -191,6 +196,8 @@ namespace Runtime
 		return moduleInstance;
 	}
 
+	std::string getObjectCodeFingerprint() { return LLVMJIT::getObjectCodeFingerprint(); }
+
 	ModuleInstance::~ModuleInstance()
 	{
 		delete jitModule;
@@ -198,7 +205,13 @@ namespace Runtime
 
 	MemoryInstance* getDefaultMemory(ModuleInstance* moduleInstance) { return moduleInstance->defaultMemory; }
 	uint64_t getDefaultMemorySize(ModuleInstance* moduleInstance) { return moduleInstance->defaultMemory->numPages << IR::numBytesPerPageLog2; }
+	Uptr getMachineCodeSize(ModuleInstance* moduleInstance) { return moduleInstance->jitModule ? moduleInstance->jitModule->getNumMachineCodeBytes() : 0; }
 	TableInstance* getDefaultTable(ModuleInstance* moduleInstance) { return moduleInstance->defaultTable; }
+	GlobalInstance* getInstanceGlobal(ModuleInstance* moduleInstance,Uptr globalIndex)
+	{
+		assert(globalIndex < moduleInstance->globals.size());
+		return moduleInstance->globals[globalIndex];
+	}
 	
 	ObjectInstance* getInstanceExport(ModuleInstance* moduleInstance,const std::string& name)
 	{
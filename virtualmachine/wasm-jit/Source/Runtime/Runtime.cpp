@@ -131,6 +131,41 @@ namespace Runtime
 		else { handleHardwareTrap(trapType,std::move(trapCallStack),trapOperand); }
 	}
 
+	FunctionInvoker getFunctionInvoker(FunctionInstance* function)
+	{
+		FunctionInvoker invoker;
+		if(function)
+		{
+			invoker.function = function;
+			invoker.type = function->type;
+			invoker.thunk = LLVMJIT::getInvokeThunk(function->type);
+		}
+		return invoker;
+	}
+
+	Result invokeFunction(const FunctionInvoker& invoker,U64* arguments)
+	{
+		// Capturing a single reference keeps the lambda within std::function's inline storage.
+		struct Call { const FunctionInvoker& invoker; U64* arguments; } call { invoker, arguments };
+
+		Platform::CallStack trapCallStack;
+		Uptr trapOperand;
+		const Platform::HardwareTrapType trapType = Platform::catchHardwareTraps(trapCallStack,trapOperand,
+			[&call]
+			{
+				(*call.invoker.thunk)(call.invoker.function->nativeFunction,call.arguments);
+			});
+		if(trapType != Platform::HardwareTrapType::none) { handleHardwareTrap(trapType,std::move(trapCallStack),trapOperand); }
+
+		Result result;
+		if(invoker.type->ret != ResultType::none)
+		{
+			result.type = invoker.type->ret;
+			result.i64 = arguments[invoker.type->parameters.size()];
+		}
+		return result;
+	}
+
 	const FunctionType* getFunctionType(FunctionInstance* function)
 	{
 		return function->type;
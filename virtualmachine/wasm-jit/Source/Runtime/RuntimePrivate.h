@@ -17,10 +17,14 @@ namespace LLVMJIT
 	struct JITModuleBase
 	{
 		virtual ~JITModuleBase() {}
+
+		// The number of bytes of memory the module's machine code and data occupy.
+		virtual Uptr getNumMachineCodeBytes() const = 0;
 	};
 
 	void init();
-	void instantiateModule(const IR::Module& module,Runtime::ModuleInstance* moduleInstance);
+	void instantiateModule(const IR::Module& module,Runtime::ModuleInstance* moduleInstance,Runtime::ObjectCache* cache,const std::string& cacheKey);
+	std::string getObjectCodeFingerprint();
 	bool describeInstructionPointer(Uptr ip,std::string& outDescription);
 	
 	typedef void (*InvokeFunctionPointer)(void*,U64*);
@@ -88,7 +92,12 @@ namespace Runtime
 		U8* reservedBaseAddress;
 		Uptr reservedNumPlatformPages;
 
-		MemoryInstance(const MemoryType& inType): GCObject(ObjectKind::memory), type(inType), baseAddress(nullptr), numPages(0), endOffset(0), reservedBaseAddress(nullptr), reservedNumPlatformPages(0) {}
+		// The contents resetMemory restores: mapped copy-on-write from image, or copied from imageCopy.
+		Platform::MemoryImage* image;
+		std::vector<U8> imageCopy;
+		Uptr imageNumPages;
+
+		MemoryInstance(const MemoryType& inType): GCObject(ObjectKind::memory), type(inType), baseAddress(nullptr), numPages(0), endOffset(0), reservedBaseAddress(nullptr), reservedNumPlatformPages(0), image(nullptr), imageNumPages(0) {}
 		~MemoryInstance() override;
 	};
 
@@ -154,3 +163,12 @@ namespace Runtime
 	// Adds GC roots from WASM threads to the provided array.
 	void getThreadGCRoots(std::vector<ObjectInstance*>& outGCRoots);
 }
+
+namespace Intrinsics
+{
+	// The name an intrinsic is registered under: its name decorated with its type.
+	std::string getDecoratedName(const std::string& name,const IR::ObjectType& type);
+
+	// Finds an intrinsic function by its decorated name.
+	Runtime::FunctionInstance* findFunction(const std::string& decoratedName);
+}
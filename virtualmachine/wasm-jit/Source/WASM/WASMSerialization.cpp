@@ -178,120 +178,6 @@ namespace IR
 
 using namespace IR;
 
-class ChecktimeInjection
-{
-public:
-   ChecktimeInjection()
-   : typeSlot(-1)
-   {}
-
-
-   void addCall(const Module& module, Serialization::OutputStream& inByteStream)
-   {
-      OpcodeAndImm<CallImm>* encodedOperator = (OpcodeAndImm<CallImm>*)inByteStream.advance(sizeof(OpcodeAndImm<CallImm>));
-      encodedOperator->opcode = Opcode::call;
-      // checktime will be the last defined import
-      encodedOperator->imm.functionIndex = checktimeIndex(module);
-   }
-
-   static U32 checktimeIndex(const Module& module)
-   {
-      return module.functions.imports.size() - 1;
-   }
-
-   void setTypeSlot(const Module& module, ResultType returnType, const std::vector<ValueType>& parameterTypes)
-   {
-      if (returnType == ResultType::none && !parameterTypes.size() )
-        typeSlot = module.types.size() - 1;
-   }
-
-   void addTypeSlot(Module& module)
-   {
-      if (typeSlot < 0)
-      {
-         // add a type for void func(void)
-         typeSlot = module.types.size();
-         module.types.push_back(FunctionType::get(ResultType::none));
-      }
-   }
-
-   void addImport(Module& module)
-   {
-	   const U32 functionTypeIndex = typeSlot;
-#if WIN32
-	   module.functions.imports.push_back({ { functionTypeIndex },(u8"env"), (u8"checktime") });
-	 
-#else
-	  module.functions.imports.push_back({ { functionTypeIndex },std::move(u8"env"),std::move(u8"checktime") });
-#endif
-	  if (module.startFunctionIndex != (UINTPTR_MAX) && module.startFunctionIndex>checktimeIndex(module))
-	  {
-		  module.startFunctionIndex++;
-	  }
-
-   }
-   void adjustStartFooIndex(Module& module) {
-	   if (module.startFunctionIndex!=(UINTPTR_MAX)&& module.startFunctionIndex>checktimeIndex(module))
-	   {
-		   module.startFunctionIndex++;
-	   }
-   }
-   void conditionallyAddCall(Opcode opcode, const ControlStructureImm& imm, const Module& module, Serialization::OutputStream& inByteStream)
-   {
-      switch(opcode)
-      {
-      case Opcode::loop:
-      case Opcode::block:
-         addCall(module, inByteStream);
-      default:
-         break;
-      };
-   }
-
-   template<typename Imm>
-   void conditionallyAddCall(Opcode , const Imm& , const Module& , Serialization::OutputStream& )
-   {
-   }
-
-   void adjustExportIndex(Module& module)
-   {
-      // all function exports need to have their index increased to account for inserted definition
-      for (auto& exportDef : module.exports)
-      {
-         if (exportDef.kind == ObjectKind::function)
-            ++exportDef.index;
-      }
-   }
-
-   void adjustCallIndex(const Module& module, CallImm& imm)
-   {
-      if (imm.functionIndex >= checktimeIndex(module))
-         ++imm.functionIndex;
-   }
-
-   template<typename Imm>
-   void adjustCallIndex(const Module& , Imm& )
-   {
-   }
-
-private:
-   int typeSlot;
-};
-
-struct NoOpInjection
-{
-   void addCall(const Module& , Serialization::OutputStream& ) {}
-   void setTypeSlot(const Module& , ResultType , const std::vector<ValueType>& ) {}
-   void addTypeSlot(Module& ) {}
-   void addImport(Module& ) {}
-   template<typename Imm>
-   void conditionallyAddCall(Opcode , const Imm& , const Module& , Serialization::OutputStream& ) {}
-   void adjustExportIndex(Module& ) {}
-   template<typename Imm>
-   void adjustCallIndex(const Module& , Imm& ) {}
-   void adjustStartFooIndex(Module&) {}
-};
-
 namespace WASM
 {
    using namespace IR;
@@ -559,11 +445,205 @@ namespace WASM
 		FunctionDef& functionDef;
 	};
 
+   // Meters the loaded code: every straight-line run of operators starts by charging its cost to a gas global,
+   // and calls the imported env.gas_exhausted once the global drops below zero.
+   // A run ends at each operator that may transfer control, so a loop pays for its body on every iteration.
+   class MeteringInjection
+   {
+   public:
+      MeteringInjection(const OperatorCosts& inCosts = OperatorCosts())
+      : costs(inCosts)
+      , typeSlot(-1)
+      , exhaustedIndex(UINTPTR_MAX)
+      , gasIndex(UINTPTR_MAX)
+      , chargeOpen(false)
+      , chargeOffset(0)
+      , chargeCost(0)
+      {}
+
+      void setTypeSlot(const Module& module, ResultType returnType, const std::vector<ValueType>& parameterTypes)
+      {
+         if (returnType == ResultType::none && !parameterTypes.size() )
+           typeSlot = module.types.size() - 1;
+      }
+
+      void addTypeSlot(Module& module)
+      {
+         if (typeSlot < 0)
+         {
+            // add a type for void func(void)
+            typeSlot = module.types.size();
+            module.types.push_back(FunctionType::get(ResultType::none));
+         }
+      }
+
+      // The import and the global are added once the sections that declare them are read,
+      // before anything that refers to function or global indices.
+      void beginSection(Module& module, SectionType sectionType)
+      {
+         if (sectionType > SectionType::import && exhaustedIndex == UINTPTR_MAX) { addImport(module); }
+         if (sectionType > SectionType::global && gasIndex == UINTPTR_MAX) { addGlobal(module); }
+      }
+
+      void finishModule(Module& module)
+      {
+         beginSection(module, SectionType::data);
+      }
+
+      // gas_exhausted is the last function import, the functions defined after it move up by one.
+      void adjustFunctionIndex(Uptr& functionIndex) const
+      {
+         if (functionIndex >= exhaustedIndex)
+            ++functionIndex;
+      }
+
+      void adjustImm(const Module& module, CallImm& imm)
+      {
+         Uptr functionIndex = imm.functionIndex;
+         adjustFunctionIndex(functionIndex);
+         imm.functionIndex = U32(functionIndex);
+      }
+
+      // the gas global is not there for the code that was loaded.
+      template<bool isGlobal>
+      void adjustImm(const Module& module, GetOrSetVariableImm<isGlobal>& imm)
+      {
+         if (isGlobal && imm.variableIndex >= gasIndex)
+            throw FatalSerializationException("invalid global index");
+      }
+
+      template<typename Imm>
+      void adjustImm(const Module& , Imm& )
+      {
+      }
+
+      void adjustExportIndex(Module& module)
+      {
+         for (auto& exportDef : module.exports)
+         {
+            if (exportDef.kind == ObjectKind::function)
+               adjustFunctionIndex(exportDef.index);
+            else if (exportDef.kind == ObjectKind::global && exportDef.index >= gasIndex)
+               throw FatalSerializationException("invalid global export index");
+         }
+      }
+
+      void adjustStartFunctionIndex(Module& module)
+      {
+         if (module.startFunctionIndex != UINTPTR_MAX)
+            adjustFunctionIndex(module.startFunctionIndex);
+      }
+
+      void adjustTableSegments(Module& module)
+      {
+         for (auto& tableSegment : module.tableSegments)
+         {
+            for (auto& functionIndex : tableSegment.indices)
+               adjustFunctionIndex(functionIndex);
+         }
+      }
+
+      // Opens a run with the code that charges it, its cost is patched in when the run ends.
+      void beginOperator(const Module& module, ArrayOutputStream& irCodeByteStream)
+      {
+         if (chargeOpen)
+            return;
+
+         const U32 gasGlobal = U32(gasIndex);
+         OperatorEncoderStream encoder(irCodeByteStream);
+         encoder.get_global({gasGlobal});
+         chargeOffset = irCodeByteStream.position();
+         encoder.i64_const({0});
+         encoder.i64_sub();
+         encoder.set_global({gasGlobal});
+         encoder.get_global({gasGlobal});
+         encoder.i64_const({0});
+         encoder.i64_lt_s();
+         encoder.if_({ResultType::none});
+         encoder.call({U32(exhaustedIndex)});
+         encoder.end();
+
+         chargeOpen = true;
+         chargeCost = 0;
+      }
+
+      void endOperator(Opcode opcode, ArrayOutputStream& irCodeByteStream)
+      {
+         chargeCost += costs.getCost(opcode);
+         switch(opcode)
+         {
+         case Opcode::block:
+         case Opcode::loop:
+         case Opcode::if_:
+         case Opcode::else_:
+         case Opcode::end:
+         case Opcode::br:
+         case Opcode::br_if:
+         case Opcode::br_table:
+         case Opcode::return_:
+         case Opcode::unreachable:
+         {
+            OpcodeAndImm<LiteralImm<I64>>* charge = (OpcodeAndImm<LiteralImm<I64>>*)(irCodeByteStream.data() + chargeOffset);
+            charge->imm.value = I64(chargeCost);
+            chargeOpen = false;
+            break;
+         }
+         default:
+            break;
+         };
+      }
+
+   private:
+      void addImport(Module& module)
+      {
+         addTypeSlot(module);
+         const U32 functionTypeIndex = typeSlot;
+         exhaustedIndex = module.functions.imports.size();
+   #if WIN32
+         module.functions.imports.push_back({ { functionTypeIndex },(u8"env"), (u8"gas_exhausted") });
+   #else
+         module.functions.imports.push_back({ { functionTypeIndex },std::move(u8"env"),std::move(u8"gas_exhausted") });
+   #endif
+      }
+
+      void addGlobal(Module& module)
+      {
+         gasIndex = module.globals.size();
+         module.globals.defs.push_back({ GlobalType(ValueType::i64, true), InitializerExpression(I64(0)) });
+      }
+
+      OperatorCosts costs;
+      int typeSlot;
+      Uptr exhaustedIndex;
+      Uptr gasIndex;
+      bool chargeOpen;
+      Uptr chargeOffset;
+      U64 chargeCost;
+   };
+
+   struct NoOpInjection
+   {
+      void setTypeSlot(const Module& , ResultType , const std::vector<ValueType>& ) {}
+      void addTypeSlot(Module& ) {}
+      void beginSection(Module& , SectionType ) {}
+      void finishModule(Module& ) {}
+      template<typename Imm>
+      void adjustImm(const Module& , Imm& ) {}
+      void adjustExportIndex(Module& ) {}
+      void adjustStartFunctionIndex(Module&) {}
+      void adjustTableSegments(Module& ) {}
+      void beginOperator(const Module& , ArrayOutputStream& ) {}
+      void endOperator(Opcode , ArrayOutputStream& ) {}
+   };
+
 	template<typename Injection>
    struct WasmSerializationImpl
    {
       Injection injection;
 
+      WasmSerializationImpl() {}
+      WasmSerializationImpl(const Injection& inInjection): injection(inInjection) {}
+
       void serializeFunctionBody(OutputStream& sectionStream,Module& module,FunctionDef& functionDef)
       {
          ArrayOutputStream bodyStream;
@@ -621,8 +701,6 @@ namespace WASM
          // Deserialize the function code, validate it, and re-encode it in the IR format.
          ArrayOutputStream irCodeByteStream;
 
-         injection.addCall(module, irCodeByteStream);
-
          OperatorEncoderStream irEncoderStream(irCodeByteStream);
          CodeValidationStream codeValidationStream(module,functionDef);
          while(bodyStream.capacity())
@@ -636,10 +714,11 @@ namespace WASM
                { \
                   Imm imm; \
                   serialize(bodyStream,imm,functionDef); \
-                  injection.adjustCallIndex(module, imm); \
+                  injection.adjustImm(module, imm); \
                   codeValidationStream.name(imm); \
+                  injection.beginOperator(module, irCodeByteStream); \
                   irEncoderStream.name(imm); \
-                  injection.conditionallyAddCall(opcode, imm, module, irCodeByteStream); \
+                  injection.endOperator(opcode, irCodeByteStream); \
                   break; \
                }
             ENUM_NONFLOAT_OPERATORS(VISIT_OPCODE)
@@ -691,8 +770,7 @@ namespace WASM
       template<typename Stream>
       void serializeImportSection(Stream& moduleStream,Module& module)
       {
-         Injection& localInjection = injection;
-         serializeSection(moduleStream,SectionType::import,[&module,&localInjection](Stream& sectionStream)
+         serializeSection(moduleStream,SectionType::import,[&module](Stream& sectionStream)
          {
             Uptr size = module.functions.imports.size()
                + module.tables.imports.size()
@@ -748,7 +826,6 @@ namespace WASM
                   default: throw FatalSerializationException("invalid ObjectKind");
                   }
                }
-               localInjection.addImport(module);
             }
             else
             {
@@ -864,7 +941,7 @@ namespace WASM
          {
             serializeVarUInt32(sectionStream,module.startFunctionIndex);
          });
-		 injection.adjustStartFooIndex(module);
+         injection.adjustStartFunctionIndex(module);
       }
 
       template<typename Stream>
@@ -874,6 +951,8 @@ namespace WASM
          {
             serialize(sectionStream,module.tableSegments);
          });
+
+         injection.adjustTableSegments(module);
       }
 
       template<typename Stream>
@@ -933,6 +1012,7 @@ namespace WASM
             {
                if(sectionType > lastKnownSectionType) { lastKnownSectionType = sectionType; }
                else { throw FatalSerializationException("incorrect order for known section"); }
+               injection.beginSection(module,sectionType);
             }
             switch(sectionType)
             {
@@ -956,6 +1036,7 @@ namespace WASM
             default: throw FatalSerializationException("unknown section ID");
             };
          };
+         injection.finishModule(module);
       }
    };
 
@@ -965,12 +1046,17 @@ namespace WASM
       impl.serializeModule(stream,module);
       IR::validateDefinitions(module);
    }
-   void serializeWithInjection(Serialization::InputStream& stream,Module& module)
+   void serializeWithInjection(Serialization::InputStream& stream,Module& module,const OperatorCosts& costs)
    {
-      WasmSerializationImpl<ChecktimeInjection> impl;
+      WasmSerializationImpl<MeteringInjection> impl((MeteringInjection(costs)));
       impl.serializeModule(stream,module);
       IR::validateDefinitions(module);
    }
+   Uptr getGasGlobalIndex(const Module& module)
+   {
+      // the gas global is the last one defined.
+      return module.globals.size() - 1;
+   }
    void serialize(Serialization::OutputStream& stream,const Module& module)
    {
       WasmSerializationImpl<NoOpInjection> impl;